@@ -30,4 +30,6 @@ $(TEST)_SRC += $(patsubst $(ROOTDIR)/%,%,$(wildcard $(TEST_PATH)/*.cpp))
 
 $(TEST)_DEFS=$(TMK_COMMON_DEFS) $(OPT_DEFS)
 $(TEST)_CONFIG=$(TEST_PATH)/config.h
-VPATH+=$(TOP_DIR)/tests/test_common
\ No newline at end of file
+VPATH+=$(TOP_DIR)/tests/test_common
+# For code that includes config.h, as in a keyboard build
+VPATH+=$(TOP_DIR)/$(TEST_PATH)
\ No newline at end of file
@@ -174,6 +174,7 @@ ifeq ($(strip $(LED_MATRIX_ENABLE)), IS31FL3731)
     OPT_DEFS += -DIS31FL3731
     COMMON_VPATH += $(DRIVER_PATH)/issi
     SRC += is31fl3731-simple.c
+    SRC += issi_queue.c
     QUANTUM_LIB_SRC += i2c_master.c
 endif
 
@@ -203,6 +204,7 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), IS31FL3731)
     OPT_DEFS += -DIS31FL3731 -DSTM32_I2C -DHAL_USE_I2C=TRUE
     COMMON_VPATH += $(DRIVER_PATH)/issi
     SRC += is31fl3731.c
+    SRC += issi_queue.c
     QUANTUM_LIB_SRC += i2c_master.c
 endif
 
@@ -210,6 +212,7 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), IS31FL3733)
     OPT_DEFS += -DIS31FL3733 -DSTM32_I2C -DHAL_USE_I2C=TRUE
     COMMON_VPATH += $(DRIVER_PATH)/issi
     SRC += is31fl3733.c
+    SRC += issi_queue.c
     QUANTUM_LIB_SRC += i2c_master.c
 endif
 
@@ -217,6 +220,7 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), IS31FL3737)
     OPT_DEFS += -DIS31FL3737 -DSTM32_I2C -DHAL_USE_I2C=TRUE
     COMMON_VPATH += $(DRIVER_PATH)/issi
     SRC += is31fl3737.c
+    SRC += issi_queue.c
     QUANTUM_LIB_SRC += i2c_master.c
 endif
 
@@ -224,6 +228,7 @@ ifeq ($(strip $(RGB_MATRIX_ENABLE)), IS31FL3741)
     OPT_DEFS += -DIS31FL3741 -DSTM32_I2C -DHAL_USE_I2C=TRUE
     COMMON_VPATH += $(DRIVER_PATH)/issi
     SRC += is31fl3741.c
+    SRC += issi_queue.c
     QUANTUM_LIB_SRC += i2c_master.c
 endif
 
@@ -324,6 +329,10 @@ ifeq ($(strip $(WS2812_DRIVER_REQUIRED)), yes)
             ifeq ($(strip $(WS2812_DRIVER)), pwm)
                 OPT_DEFS += -DSTM32_DMA_REQUIRED=TRUE
             endif
+
+            ifneq ($(filter $(WS2812_DRIVER),pwm spi),)
+                SRC += ws2812_encode.c
+            endif
         endif
     endif
 
@@ -384,11 +393,21 @@ ifeq ($(strip $(DYNAMIC_KEYMAP_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/dynamic_keymap.c
 endif
 
+ifeq ($(strip $(SEND_STRING_ASYNC_ENABLE)), yes)
+    OPT_DEFS += -DSEND_STRING_ASYNC_ENABLE
+    SRC += $(QUANTUM_DIR)/send_string_async.c
+endif
+
 ifeq ($(strip $(DIP_SWITCH_ENABLE)), yes)
     OPT_DEFS += -DDIP_SWITCH_ENABLE
     SRC += $(QUANTUM_DIR)/dip_switch.c
 endif
 
+ifeq ($(strip $(MATRIX_IDLE_ENABLE)), yes)
+    OPT_DEFS += -DMATRIX_IDLE_ENABLE
+    SRC += $(QUANTUM_DIR)/matrix_idle.c
+endif
+
 VALID_CUSTOM_MATRIX_TYPES:= yes lite no
 
 CUSTOM_MATRIX ?= no
@@ -439,7 +458,8 @@ ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
 
     # Determine which (if any) transport files are required
     ifneq ($(strip $(SPLIT_TRANSPORT)), custom)
-        QUANTUM_SRC += $(QUANTUM_DIR)/split_common/transport.c
+        QUANTUM_SRC += $(QUANTUM_DIR)/split_common/transport.c \
+                       $(QUANTUM_DIR)/split_common/split_sync.c
         # Functions added via QUANTUM_LIB_SRC are only included in the final binary if they're called.
         # Unused functions are pruned away, which is why we can add multiple drivers here without bloat.
         ifeq ($(PLATFORM),AVR)
@@ -26,7 +26,7 @@
 
 volatile uint8_t i2c_slave_reg[I2C_SLAVE_REG_COUNT];
 
-static volatile uint8_t buffer_address;
+static volatile uint16_t buffer_address;
 static volatile bool    slave_has_register_set = false;
 
 void i2c_slave_init(uint8_t address) {
@@ -61,17 +61,24 @@ ISR(TWI_vect) {
                     buffer_address = 0;
                 }
                 slave_has_register_set = true;  // address has been receaved now fill in buffer
-            } else {
+            } else if (buffer_address < I2C_SLAVE_REG_COUNT) {
                 i2c_slave_reg[buffer_address] = TWDR;
                 buffer_address++;
+            } else {
+                // past the end of the registers, dont ack
+                ack = 0;
             }
             break;
 
         case TW_ST_SLA_ACK:
         case TW_ST_DATA_ACK:
             // This device is a slave transmitter and master has requested data
-            TWDR = i2c_slave_reg[buffer_address];
-            buffer_address++;
+            if (buffer_address < I2C_SLAVE_REG_COUNT) {
+                TWDR = i2c_slave_reg[buffer_address];
+                buffer_address++;
+            } else {
+                TWDR = 0;
+            }
             break;
 
         case TW_BUS_ERROR:
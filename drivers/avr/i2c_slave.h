@@ -23,7 +23,10 @@
 #ifndef I2C_SLAVE_H
 #define I2C_SLAVE_H
 
-#define I2C_SLAVE_REG_COUNT 30
+// Register addresses are one byte, so at most 256
+#ifndef I2C_SLAVE_REG_COUNT
+#    define I2C_SLAVE_REG_COUNT 30
+#endif
 
 extern volatile uint8_t i2c_slave_reg[I2C_SLAVE_REG_COUNT];
 
@@ -45,6 +45,16 @@ static const I2CConfig i2cconfig = {
 #endif
 };
 
+// Other threads (the ISSI queue, the OLED render thread) may use the bus, so each transfer holds
+// it from i2cStart() to the end of the transfer
+#if I2C_USE_MUTUAL_EXCLUSION == TRUE
+#    define I2C_ACQUIRE() i2cAcquireBus(&I2C_DRIVER)
+#    define I2C_RELEASE() i2cReleaseBus(&I2C_DRIVER)
+#else
+#    define I2C_ACQUIRE()
+#    define I2C_RELEASE()
+#endif
+
 static i2c_status_t chibios_to_qmk(const msg_t* status) {
     switch (*status) {
         case I2C_NO_ERROR:
@@ -73,44 +83,57 @@ __attribute__((weak)) void i2c_init(void) {
 }
 
 i2c_status_t i2c_start(uint8_t address) {
+    I2C_ACQUIRE();
     i2c_address = address;
     i2cStart(&I2C_DRIVER, &i2cconfig);
+    I2C_RELEASE();
     return I2C_STATUS_SUCCESS;
 }
 
 i2c_status_t i2c_transmit(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout) {
+    I2C_ACQUIRE();
     i2c_address = address;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, 0, 0, TIME_MS2I(timeout));
+    I2C_RELEASE();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_receive(uint8_t address, uint8_t* data, uint16_t length, uint16_t timeout) {
+    I2C_ACQUIRE();
     i2c_address = address;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterReceiveTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, TIME_MS2I(timeout));
+    I2C_RELEASE();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t* data, uint16_t length, uint16_t timeout) {
-    i2c_address = devaddr;
-    i2cStart(&I2C_DRIVER, &i2cconfig);
-
     uint8_t complete_packet[length + 1];
     for (uint8_t i = 0; i < length; i++) {
         complete_packet[i + 1] = data[i];
     }
     complete_packet[0] = regaddr;
 
+    I2C_ACQUIRE();
+    i2c_address = devaddr;
+    i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), complete_packet, length + 1, 0, 0, TIME_MS2I(timeout));
+    I2C_RELEASE();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_readReg(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout) {
+    I2C_ACQUIRE();
     i2c_address = devaddr;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), &regaddr, 1, data, length, TIME_MS2I(timeout));
+    I2C_RELEASE();
     return chibios_to_qmk(&status);
 }
 
-void i2c_stop(void) { i2cStop(&I2C_DRIVER); }
+void i2c_stop(void) {
+    I2C_ACQUIRE();
+    i2cStop(&I2C_DRIVER);
+    I2C_RELEASE();
+}
@@ -0,0 +1,6 @@
+CHIBIOS_TESTS_PATH := $(DRIVER_PATH)/chibios/tests
+
+chibios_ws2812_encode_INC := $(DRIVER_PATH)/chibios
+chibios_ws2812_encode_SRC := \
+	$(CHIBIOS_TESTS_PATH)/ws2812_encode_tests.cpp \
+	$(DRIVER_PATH)/chibios/ws2812_encode.c
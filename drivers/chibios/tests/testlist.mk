@@ -0,0 +1,2 @@
+TEST_LIST +=\
+	chibios_ws2812_encode
@@ -0,0 +1,154 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include "ws2812_encode.h"
+}
+
+// The per-bit encoding the SPI driver used before the lookup table
+static uint8_t get_protocol_eq(uint8_t data, int pos) {
+    uint8_t eq = 0;
+    if (data & (1 << (2 * (3 - pos))))
+        eq = 0b1110;
+    else
+        eq = 0b1000;
+    if (data & (2 << (2 * (3 - pos))))
+        eq += 0b11100000;
+    else
+        eq += 0b10000000;
+    return eq;
+}
+
+static void reference_encode_spi(uint8_t *dst, const LED_TYPE *leds, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        for (int j = 0; j < 4; j++) *dst++ = get_protocol_eq(leds[i].g, j);
+        for (int j = 0; j < 4; j++) *dst++ = get_protocol_eq(leds[i].r, j);
+        for (int j = 0; j < 4; j++) *dst++ = get_protocol_eq(leds[i].b, j);
+    }
+}
+
+static const uint32_t duty[2] = {29, 67};
+
+static std::vector<LED_TYPE> make_strip(uint16_t count) {
+    std::vector<LED_TYPE> leds(count);
+    for (uint16_t i = 0; i < count; i++) {
+        leds[i].r = i * 7;
+        leds[i].g = i * 13 + 1;
+        leds[i].b = 255 - i * 3;
+    }
+    return leds;
+}
+
+TEST(WS2812Encode, SpiEncodesEveryByteLikeReference) {
+    LED_TYPE led;
+    uint8_t  expected[WS2812_SPI_BYTES_PER_LED];
+    uint8_t  actual[WS2812_SPI_BYTES_PER_LED];
+
+    for (int value = 0; value < 256; value++) {
+        led.r = value;
+        led.g = 255 - value;
+        led.b = value ^ 0x5A;
+        reference_encode_spi(expected, &led, 1);
+        ws2812_encode_spi(actual, &led, 1);
+        ASSERT_EQ(0, memcmp(expected, actual, sizeof(expected))) << "value " << value;
+    }
+}
+
+TEST(WS2812Encode, SpiSendsGreenRedBlueMsbFirst) {
+    LED_TYPE led;
+    led.r = 0x00;
+    led.g = 0xF0;
+    led.b = 0x81;
+    uint8_t actual[WS2812_SPI_BYTES_PER_LED];
+    ws2812_encode_spi(actual, &led, 1);
+
+    const uint8_t expected[] = {
+        0xEE, 0xEE, 0x88, 0x88,  // green
+        0x88, 0x88, 0x88, 0x88,  // red
+        0xE8, 0x88, 0x88, 0x8E,  // blue
+    };
+    EXPECT_EQ(0, memcmp(expected, actual, sizeof(expected)));
+}
+
+TEST(WS2812Encode, SpiWritesOnlyRequestedLeds) {
+    auto                 leds = make_strip(8);
+    std::vector<uint8_t> actual(WS2812_SPI_BYTES_PER_LED * 9, 0xA5);
+    std::vector<uint8_t> expected(WS2812_SPI_BYTES_PER_LED * 8);
+
+    ws2812_encode_spi(actual.data(), leds.data(), 8);
+    reference_encode_spi(expected.data(), leds.data(), 8);
+    EXPECT_EQ(0, memcmp(expected.data(), actual.data(), expected.size()));
+    for (size_t i = expected.size(); i < actual.size(); i++) {
+        EXPECT_EQ(0xA5, actual[i]);
+    }
+}
+
+TEST(WS2812Encode, PwmUsesDutyPerBit) {
+    auto                  leds = make_strip(4);
+    std::vector<uint32_t> actual(WS2812_PWM_WORDS_PER_LED * 4);
+    ws2812_encode_pwm(actual.data(), leds.data(), 4, duty);
+
+    for (int i = 0; i < 4; i++) {
+        const uint8_t bytes[3] = {leds[i].g, leds[i].r, leds[i].b};
+        for (int byte = 0; byte < 3; byte++) {
+            for (int bit = 7; bit >= 0; bit--) {
+                uint32_t expected = (bytes[byte] >> bit) & 1 ? duty[1] : duty[0];
+                EXPECT_EQ(expected, actual[WS2812_PWM_WORDS_PER_LED * i + 8 * byte + (7 - bit)]);
+            }
+        }
+    }
+}
+
+template <typename F>
+static double ns_per_led(uint16_t count, F encode) {
+    const int rounds = 2000;
+    auto      start  = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        encode();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+    return elapsed.count() / rounds / count;
+}
+
+TEST(WS2812Encode, Benchmark) {
+    const uint16_t       count = 128;
+    auto                 leds  = make_strip(count);
+    std::vector<uint8_t> spi(WS2812_SPI_BYTES_PER_LED * count);
+    std::vector<uint32_t> pwm(WS2812_PWM_WORDS_PER_LED * count);
+    volatile uint8_t     sink = 0;
+
+    double reference = ns_per_led(count, [&] {
+        reference_encode_spi(spi.data(), leds.data(), count);
+        sink = sink + spi[count];
+    });
+    double lut = ns_per_led(count, [&] {
+        ws2812_encode_spi(spi.data(), leds.data(), count);
+        sink = sink + spi[count];
+    });
+    double pwm_ns = ns_per_led(count, [&] {
+        ws2812_encode_pwm(pwm.data(), leds.data(), count, duty);
+        sink = sink + pwm[count];
+    });
+
+    std::cout << "[   INFO   ] spi encode: " << lut << " ns/led, " << reference << " ns/led per bit" << std::endl;
+    std::cout << "[   INFO   ] pwm encode: " << pwm_ns << " ns/led" << std::endl;
+}
@@ -0,0 +1,65 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ws2812_encode.h"
+
+/*
+ * SPI symbols for each nibble of a color byte. Every data bit is four SPI
+ * bits, so one nibble fills two output bytes, high bits first.
+ */
+#define WS2812_SPI_BIT(v, b) (((v) & (b)) ? 0b1110 : 0b1000)
+#define WS2812_SPI_PAIR(v, hi, lo) ((WS2812_SPI_BIT(v, hi) << 4) | WS2812_SPI_BIT(v, lo))
+#define WS2812_SPI_NIBBLE(v) \
+    { WS2812_SPI_PAIR(v, 8, 4), WS2812_SPI_PAIR(v, 2, 1) }
+
+static const uint8_t ws2812_spi_lut[16][2] = {
+    WS2812_SPI_NIBBLE(0x0), WS2812_SPI_NIBBLE(0x1), WS2812_SPI_NIBBLE(0x2), WS2812_SPI_NIBBLE(0x3), WS2812_SPI_NIBBLE(0x4), WS2812_SPI_NIBBLE(0x5), WS2812_SPI_NIBBLE(0x6), WS2812_SPI_NIBBLE(0x7),
+    WS2812_SPI_NIBBLE(0x8), WS2812_SPI_NIBBLE(0x9), WS2812_SPI_NIBBLE(0xA), WS2812_SPI_NIBBLE(0xB), WS2812_SPI_NIBBLE(0xC), WS2812_SPI_NIBBLE(0xD), WS2812_SPI_NIBBLE(0xE), WS2812_SPI_NIBBLE(0xF),
+};
+
+static inline uint8_t *encode_spi_byte(uint8_t *dst, uint8_t value) {
+    const uint8_t *hi = ws2812_spi_lut[value >> 4];
+    const uint8_t *lo = ws2812_spi_lut[value & 0x0F];
+
+    *dst++ = hi[0];
+    *dst++ = hi[1];
+    *dst++ = lo[0];
+    *dst++ = lo[1];
+    return dst;
+}
+
+void ws2812_encode_spi(uint8_t *dst, const LED_TYPE *leds, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        dst = encode_spi_byte(dst, leds[i].g);
+        dst = encode_spi_byte(dst, leds[i].r);
+        dst = encode_spi_byte(dst, leds[i].b);
+    }
+}
+
+static inline uint32_t *encode_pwm_byte(uint32_t *dst, uint8_t value, const uint32_t duty[2]) {
+    for (int8_t bit = 7; bit >= 0; bit--) {
+        *dst++ = duty[(value >> bit) & 0x01];
+    }
+    return dst;
+}
+
+void ws2812_encode_pwm(uint32_t *dst, const LED_TYPE *leds, uint16_t count, const uint32_t duty[2]) {
+    for (uint16_t i = 0; i < count; i++) {
+        dst = encode_pwm_byte(dst, leds[i].g, duty);
+        dst = encode_pwm_byte(dst, leds[i].r, duty);
+        dst = encode_pwm_byte(dst, leds[i].b, duty);
+    }
+}
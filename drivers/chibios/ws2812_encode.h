@@ -0,0 +1,45 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "quantum/color.h"
+
+/*
+ * Frame encoders shared by the DMA based WS2812 drivers.
+ *
+ * Both produce the bit stream for a whole strip in GRB order, so the
+ * drivers only have to hand the result to the DMA engine.
+ */
+
+/* Bytes of SPI output per LED: every data bit becomes a nibble on the wire */
+#define WS2812_SPI_BYTES_PER_LED 12
+
+/* Words of PWM duty cycles per LED: one compare value per data bit */
+#define WS2812_PWM_WORDS_PER_LED 24
+
+/*
+ * Encode leds into WS2812_SPI_BYTES_PER_LED * count bytes at dst.
+ * A data bit of 1 is sent as 0b1110 and a 0 as 0b1000, MSB first.
+ */
+void ws2812_encode_spi(uint8_t *dst, const LED_TYPE *leds, uint16_t count);
+
+/*
+ * Encode leds into WS2812_PWM_WORDS_PER_LED * count words at dst,
+ * using duty[0] for a data bit of 0 and duty[1] for a 1.
+ */
+void ws2812_encode_pwm(uint32_t *dst, const LED_TYPE *leds, uint16_t count, const uint32_t duty[2]);
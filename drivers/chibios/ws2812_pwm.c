@@ -1,4 +1,5 @@
 #include "ws2812.h"
+#include "ws2812_encode.h"
 #include "quantum.h"
 #include "hal.h"
 
@@ -147,6 +148,8 @@
 
 static uint32_t ws2812_frame_buffer[WS2812_BIT_N + 1]; /**< Buffer for a frame */
 
+static const uint32_t ws2812_duty[2] = {WS2812_DUTYCYCLE_0, WS2812_DUTYCYCLE_1}; /**< Compare values for a zero and a one */
+
 /* --- PUBLIC FUNCTIONS ----------------------------------------------------- */
 /*
  * Gedanke: Double-buffer type transactions: double buffer transfers using two memory pointers for
@@ -220,7 +223,6 @@ void ws2812_setleds(LED_TYPE* ledarray, uint16_t leds) {
         s_init = true;
     }
 
-    for (uint16_t i = 0; i < leds; i++) {
-        ws2812_write_led(i, ledarray[i].r, ledarray[i].g, ledarray[i].b);
-    }
+    // The circular DMA picks up the new frame on its next pass, so there is nothing to start or wait for
+    ws2812_encode_pwm(ws2812_frame_buffer, ledarray, leds, ws2812_duty);
 }
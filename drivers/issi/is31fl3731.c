@@ -18,6 +18,9 @@
 #include "is31fl3731.h"
 #include "i2c_master.h"
 #include "wait.h"
+#ifdef ISSI_ASYNC_FLUSH
+#    include "issi_queue.h"
+#endif
 
 // This is a 7-bit address, that gets left-shifted and bit 0
 // set to 0 for write, 1 for read (as per I2C protocol)
@@ -64,6 +67,10 @@ uint8_t g_twi_transfer_buffer[20];
 uint8_t g_pwm_buffer[DRIVER_COUNT][144];
 bool    g_pwm_buffer_update_required[DRIVER_COUNT] = {false};
 
+// One bit per 16 byte block of g_pwm_buffer, set when the block has changed
+// since it was last sent. Only these blocks are transferred.
+uint16_t g_pwm_buffer_dirty_blocks[DRIVER_COUNT] = {0};
+
 uint8_t g_led_control_registers[DRIVER_COUNT][18]             = {{0}};
 bool    g_led_control_registers_update_required[DRIVER_COUNT] = {false};
 
@@ -82,6 +89,9 @@ bool    g_led_control_registers_update_required[DRIVER_COUNT] = {false};
 // 0x10 - R16,R15,R14,R13,R12,R11,R10,R09
 
 void IS31FL3731_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
+#ifdef ISSI_ASYNC_FLUSH
+    issi_queue_flush();
+#endif
     g_twi_transfer_buffer[0] = reg;
     g_twi_transfer_buffer[1] = data;
 
@@ -94,14 +104,17 @@ void IS31FL3731_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
-void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+static void IS31FL3731_write_pwm_blocks(uint8_t addr, uint8_t *pwm_buffer, uint16_t blocks) {
     // assumes bank is already selected
 
-    // transmit PWM registers in 9 transfers of 16 bytes
+    // transmit PWM registers in up to 9 transfers of 16 bytes
     // g_twi_transfer_buffer[] is 20 bytes
 
     // iterate over the pwm_buffer contents at 16 byte intervals
     for (int i = 0; i < 144; i += 16) {
+        if (!(blocks & (1 << (i / 16)))) {
+            continue;
+        }
         // set the first register, e.g. 0x24, 0x34, 0x44, etc.
         g_twi_transfer_buffer[0] = 0x24 + i;
         // copy the data from i to i+15
@@ -121,6 +134,8 @@ void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     }
 }
 
+void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) { IS31FL3731_write_pwm_blocks(addr, pwm_buffer, 0x01FF); }
+
 void IS31FL3731_init(uint8_t addr) {
     // In order to avoid the LEDs being driven with garbage data
     // in the LED driver's PWM registers, first enable software shutdown,
@@ -173,15 +188,22 @@ void IS31FL3731_init(uint8_t addr) {
     IS31FL3731_write_register(addr, ISSI_COMMANDREGISTER, 0);
 }
 
+static void IS31FL3731_set_pwm(uint8_t driver, uint8_t index, uint8_t value) {
+    if (g_pwm_buffer[driver][index] != value) {
+        g_pwm_buffer[driver][index] = value;
+        g_pwm_buffer_dirty_blocks[driver] |= 1 << (index / 16);
+        g_pwm_buffer_update_required[driver] = true;
+    }
+}
+
 void IS31FL3731_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         is31_led led = g_is31_leds[index];
 
         // Subtract 0x24 to get the second index of g_pwm_buffer
-        g_pwm_buffer[led.driver][led.r - 0x24]   = red;
-        g_pwm_buffer[led.driver][led.g - 0x24]   = green;
-        g_pwm_buffer[led.driver][led.b - 0x24]   = blue;
-        g_pwm_buffer_update_required[led.driver] = true;
+        IS31FL3731_set_pwm(led.driver, led.r - 0x24, red);
+        IS31FL3731_set_pwm(led.driver, led.g - 0x24, green);
+        IS31FL3731_set_pwm(led.driver, led.b - 0x24, blue);
     }
 }
 
@@ -221,10 +243,31 @@ void IS31FL3731_set_led_control_register(uint8_t index, bool red, bool green, bo
 }
 
 void IS31FL3731_update_pwm_buffers(uint8_t addr, uint8_t index) {
+#ifdef ISSI_ASYNC_FLUSH
+    // A queued write failed, resend every block
+    if (issi_queue_take_failed(addr)) {
+        g_pwm_buffer_update_required[index] = true;
+        g_pwm_buffer_dirty_blocks[index]    = 0x01FF;
+    }
+#endif
     if (g_pwm_buffer_update_required[index]) {
-        IS31FL3731_write_pwm_buffer(addr, g_pwm_buffer[index]);
+#ifdef ISSI_ASYNC_FLUSH
+        uint16_t blocks = g_pwm_buffer_dirty_blocks[index];
+        // If the whole frame does not fit, keep it dirty for the next flush.
+        if (issi_queue_space() < __builtin_popcount(blocks)) {
+            return;
+        }
+        for (int i = 0; i < 144; i += 16) {
+            if (blocks & (1 << (i / 16))) {
+                issi_queue_write(addr, 0x24 + i, &g_pwm_buffer[index][i], 16);
+            }
+        }
+#else
+        IS31FL3731_write_pwm_blocks(addr, g_pwm_buffer[index], g_pwm_buffer_dirty_blocks[index]);
+#endif
     }
     g_pwm_buffer_update_required[index] = false;
+    g_pwm_buffer_dirty_blocks[index]    = 0;
 }
 
 void IS31FL3731_update_led_control_registers(uint8_t addr, uint8_t index) {
@@ -19,6 +19,9 @@
 #include "is31fl3733.h"
 #include "i2c_master.h"
 #include "wait.h"
+#ifdef ISSI_ASYNC_FLUSH
+#    include "issi_queue.h"
+#endif
 
 // This is a 7-bit address, that gets left-shifted and bit 0
 // set to 0 for write, 1 for read (as per I2C protocol)
@@ -68,10 +71,17 @@ uint8_t g_twi_transfer_buffer[20];
 uint8_t g_pwm_buffer[DRIVER_COUNT][192];
 bool    g_pwm_buffer_update_required[DRIVER_COUNT] = {false};
 
+// One bit per 16 byte block of g_pwm_buffer, set when the block has changed
+// since it was last sent. Only these blocks are transferred.
+uint16_t g_pwm_buffer_dirty_blocks[DRIVER_COUNT] = {0};
+
 uint8_t g_led_control_registers[DRIVER_COUNT][24]             = {{0}, {0}};
 bool    g_led_control_registers_update_required[DRIVER_COUNT] = {false};
 
 bool IS31FL3733_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
+#ifdef ISSI_ASYNC_FLUSH
+    issi_queue_flush();
+#endif
     // If the transaction fails function returns false.
     g_twi_transfer_buffer[0] = reg;
     g_twi_transfer_buffer[1] = data;
@@ -90,14 +100,17 @@ bool IS31FL3733_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
     return true;
 }
 
-bool IS31FL3733_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+static bool IS31FL3733_write_pwm_blocks(uint8_t addr, uint8_t *pwm_buffer, uint16_t blocks) {
     // Assumes PG1 is already selected.
     // If any of the transactions fails function returns false.
-    // Transmit PWM registers in 12 transfers of 16 bytes.
+    // Transmit PWM registers in up to 12 transfers of 16 bytes.
     // g_twi_transfer_buffer[] is 20 bytes
 
     // Iterate over the pwm_buffer contents at 16 byte intervals.
     for (int i = 0; i < 192; i += 16) {
+        if (!(blocks & (1 << (i / 16)))) {
+            continue;
+        }
         g_twi_transfer_buffer[0] = i;
         // Copy the data from i to i+15.
         // Device will auto-increment register for data after the first byte
@@ -121,6 +134,8 @@ bool IS31FL3733_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     return true;
 }
 
+bool IS31FL3733_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) { return IS31FL3733_write_pwm_blocks(addr, pwm_buffer, 0x0FFF); }
+
 void IS31FL3733_init(uint8_t addr, uint8_t sync) {
     // In order to avoid the LEDs being driven with garbage data
     // in the LED driver's PWM registers, shutdown is enabled last.
@@ -163,14 +178,21 @@ void IS31FL3733_init(uint8_t addr, uint8_t sync) {
     wait_ms(10);
 }
 
+static void IS31FL3733_set_pwm(uint8_t driver, uint8_t reg, uint8_t value) {
+    if (g_pwm_buffer[driver][reg] != value) {
+        g_pwm_buffer[driver][reg] = value;
+        g_pwm_buffer_dirty_blocks[driver] |= 1 << (reg / 16);
+        g_pwm_buffer_update_required[driver] = true;
+    }
+}
+
 void IS31FL3733_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         is31_led led = g_is31_leds[index];
 
-        g_pwm_buffer[led.driver][led.r]          = red;
-        g_pwm_buffer[led.driver][led.g]          = green;
-        g_pwm_buffer[led.driver][led.b]          = blue;
-        g_pwm_buffer_update_required[led.driver] = true;
+        IS31FL3733_set_pwm(led.driver, led.r, red);
+        IS31FL3733_set_pwm(led.driver, led.g, green);
+        IS31FL3733_set_pwm(led.driver, led.b, blue);
     }
 }
 
@@ -209,6 +231,35 @@ void IS31FL3733_set_led_control_register(uint8_t index, bool red, bool green, bo
     g_led_control_registers_update_required[led.driver] = true;
 }
 
+#ifdef ISSI_ASYNC_FLUSH
+void IS31FL3733_update_pwm_buffers(uint8_t addr, uint8_t index) {
+    // A queued write failed and may have gone to PG0, refresh page 0 and
+    // resend every block
+    if (issi_queue_take_failed(addr)) {
+        g_led_control_registers_update_required[index] = true;
+        g_pwm_buffer_update_required[index]            = true;
+        g_pwm_buffer_dirty_blocks[index]               = 0x0FFF;
+    }
+    if (g_pwm_buffer_update_required[index]) {
+        uint16_t blocks = g_pwm_buffer_dirty_blocks[index];
+        // If the whole frame does not fit, keep it dirty for the next flush.
+        if (issi_queue_space() < 2 + __builtin_popcount(blocks)) {
+            return;
+        }
+
+        // Firstly we need to unlock the command register and select PG1.
+        issi_queue_write_register(addr, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
+        issi_queue_write_register(addr, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM);
+        for (int i = 0; i < 192; i += 16) {
+            if (blocks & (1 << (i / 16))) {
+                issi_queue_write(addr, i, &g_pwm_buffer[index][i], 16);
+            }
+        }
+    }
+    g_pwm_buffer_update_required[index] = false;
+    g_pwm_buffer_dirty_blocks[index]    = 0;
+}
+#else
 void IS31FL3733_update_pwm_buffers(uint8_t addr, uint8_t index) {
     if (g_pwm_buffer_update_required[index]) {
         // Firstly we need to unlock the command register and select PG1.
@@ -216,13 +267,18 @@ void IS31FL3733_update_pwm_buffers(uint8_t addr, uint8_t index) {
         IS31FL3733_write_register(addr, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM);
 
         // If any of the transactions fail we risk writing dirty PG0,
-        // refresh page 0 just in case.
-        if (!IS31FL3733_write_pwm_buffer(addr, g_pwm_buffer[index])) {
+        // refresh page 0 just in case, and resend every block next time.
+        if (!IS31FL3733_write_pwm_blocks(addr, g_pwm_buffer[index], g_pwm_buffer_dirty_blocks[index])) {
             g_led_control_registers_update_required[index] = true;
+            g_pwm_buffer_update_required[index]            = false;
+            g_pwm_buffer_dirty_blocks[index]               = 0x0FFF;
+            return;
         }
     }
     g_pwm_buffer_update_required[index] = false;
+    g_pwm_buffer_dirty_blocks[index]    = 0;
 }
+#endif
 
 void IS31FL3733_update_led_control_registers(uint8_t addr, uint8_t index) {
     if (g_led_control_registers_update_required[index]) {
@@ -17,6 +17,9 @@
 #include "is31fl3736.h"
 #include "i2c_master.h"
 #include "wait.h"
+#ifdef ISSI_ASYNC_FLUSH
+#    include "issi_queue.h"
+#endif
 
 // This is a 7-bit address, that gets left-shifted and bit 0
 // set to 0 for write, 1 for read (as per I2C protocol)
@@ -66,10 +69,17 @@ uint8_t g_twi_transfer_buffer[20];
 uint8_t g_pwm_buffer[DRIVER_COUNT][192];
 bool    g_pwm_buffer_update_required = false;
 
+// One bit per 16 byte block of g_pwm_buffer, set when the block has changed
+// since it was last sent. Only these blocks are transferred.
+uint16_t g_pwm_buffer_dirty_blocks[DRIVER_COUNT] = {0};
+
 uint8_t g_led_control_registers[DRIVER_COUNT][24] = {{0}, {0}};
 bool    g_led_control_registers_update_required   = false;
 
 void IS31FL3736_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
+#ifdef ISSI_ASYNC_FLUSH
+    issi_queue_flush();
+#endif
     g_twi_transfer_buffer[0] = reg;
     g_twi_transfer_buffer[1] = data;
 
@@ -82,14 +92,17 @@ void IS31FL3736_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
-void IS31FL3736_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+static void IS31FL3736_write_pwm_blocks(uint8_t addr, uint8_t *pwm_buffer, uint16_t blocks) {
     // assumes PG1 is already selected
 
-    // transmit PWM registers in 12 transfers of 16 bytes
+    // transmit PWM registers in up to 12 transfers of 16 bytes
     // g_twi_transfer_buffer[] is 20 bytes
 
     // iterate over the pwm_buffer contents at 16 byte intervals
     for (int i = 0; i < 192; i += 16) {
+        if (!(blocks & (1 << (i / 16)))) {
+            continue;
+        }
         g_twi_transfer_buffer[0] = i;
         // copy the data from i to i+15
         // device will auto-increment register for data after the first byte
@@ -108,6 +121,8 @@ void IS31FL3736_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     }
 }
 
+void IS31FL3736_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) { IS31FL3736_write_pwm_blocks(addr, pwm_buffer, 0x0FFF); }
+
 void IS31FL3736_init(uint8_t addr) {
     // In order to avoid the LEDs being driven with garbage data
     // in the LED driver's PWM registers, shutdown is enabled last.
@@ -149,14 +164,21 @@ void IS31FL3736_init(uint8_t addr) {
     wait_ms(10);
 }
 
+static void IS31FL3736_set_pwm(uint8_t driver, uint8_t reg, uint8_t value) {
+    if (g_pwm_buffer[driver][reg] != value) {
+        g_pwm_buffer[driver][reg] = value;
+        g_pwm_buffer_dirty_blocks[driver] |= 1 << (reg / 16);
+        g_pwm_buffer_update_required = true;
+    }
+}
+
 void IS31FL3736_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         is31_led led = g_is31_leds[index];
 
-        g_pwm_buffer[led.driver][led.r] = red;
-        g_pwm_buffer[led.driver][led.g] = green;
-        g_pwm_buffer[led.driver][led.b] = blue;
-        g_pwm_buffer_update_required    = true;
+        IS31FL3736_set_pwm(led.driver, led.r, red);
+        IS31FL3736_set_pwm(led.driver, led.g, green);
+        IS31FL3736_set_pwm(led.driver, led.b, blue);
     }
 }
 
@@ -213,9 +235,7 @@ void IS31FL3736_mono_set_brightness(int index, uint8_t value) {
     if (index >= 0 && index < 96) {
         // Index in range 0..95 -> A1..A8, B1..B8, etc.
         // Map index 0..95 to registers 0x00..0xBE (interleaved)
-        uint8_t pwm_register          = index * 2;
-        g_pwm_buffer[0][pwm_register] = value;
-        g_pwm_buffer_update_required  = true;
+        IS31FL3736_set_pwm(0, index * 2, value);
     }
 }
 
@@ -244,15 +264,42 @@ void IS31FL3736_mono_set_led_control_register(uint8_t index, bool enabled) {
 }
 
 void IS31FL3736_update_pwm_buffers(uint8_t addr1, uint8_t addr2) {
+#ifdef ISSI_ASYNC_FLUSH
+    // A queued write failed and may have gone to PG0, refresh page 0 and
+    // resend every block
+    if (issi_queue_take_failed(addr1)) {
+        g_led_control_registers_update_required = true;
+        g_pwm_buffer_update_required            = true;
+        g_pwm_buffer_dirty_blocks[0]            = 0x0FFF;
+    }
+#endif
     if (g_pwm_buffer_update_required) {
+        uint16_t blocks = g_pwm_buffer_dirty_blocks[0];
+#ifdef ISSI_ASYNC_FLUSH
+        // If the whole frame does not fit, keep it dirty for the next flush.
+        if (issi_queue_space() < 2 + __builtin_popcount(blocks)) {
+            return;
+        }
+
+        // Firstly we need to unlock the command register and select PG1
+        issi_queue_write_register(addr1, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
+        issi_queue_write_register(addr1, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM);
+        for (int i = 0; i < 192; i += 16) {
+            if (blocks & (1 << (i / 16))) {
+                issi_queue_write(addr1, i, &g_pwm_buffer[0][i], 16);
+            }
+        }
+#else
         // Firstly we need to unlock the command register and select PG1
         IS31FL3736_write_register(addr1, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
         IS31FL3736_write_register(addr1, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM);
 
-        IS31FL3736_write_pwm_buffer(addr1, g_pwm_buffer[0]);
+        IS31FL3736_write_pwm_blocks(addr1, g_pwm_buffer[0], blocks);
         // IS31FL3736_write_pwm_buffer(addr2, g_pwm_buffer[1]);
+#endif
     }
     g_pwm_buffer_update_required = false;
+    g_pwm_buffer_dirty_blocks[0] = 0;
 }
 
 void IS31FL3736_update_led_control_registers(uint8_t addr1, uint8_t addr2) {
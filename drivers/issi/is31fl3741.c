@@ -23,6 +23,9 @@
 #include <string.h>
 #include "i2c_master.h"
 #include "progmem.h"
+#ifdef ISSI_ASYNC_FLUSH
+#    include "issi_queue.h"
+#endif
 
 // This is a 7-bit address, that gets left-shifted and bit 0
 // set to 0 for write, 1 for read (as per I2C protocol)
@@ -63,6 +66,13 @@
 
 #define ISSI_MAX_LEDS 351
 
+// PWM registers are sent in blocks of 18 bytes, the last one is 9 bytes.
+// Blocks 0-9 are on PG0, blocks 10-19 on PG1.
+#define ISSI_PWM_BLOCK_SIZE 18
+#define ISSI_PWM_PAGE_SIZE 180
+#define ISSI_PWM_BLOCKS_PG0 0x000003FFUL
+#define ISSI_PWM_BLOCKS_ALL 0x000FFFFFUL
+
 // Transfer buffer for TWITransmitData()
 uint8_t g_twi_transfer_buffer[20] = {0xFF};
 
@@ -76,9 +86,16 @@ uint8_t g_pwm_buffer[DRIVER_COUNT][ISSI_MAX_LEDS];
 bool    g_pwm_buffer_update_required                      = false;
 bool    g_scaling_registers_update_required[DRIVER_COUNT] = {false};
 
+// One bit per block of g_pwm_buffer, set when the block has changed since it
+// was last sent. Only these blocks are transferred.
+uint32_t g_pwm_buffer_dirty_blocks[DRIVER_COUNT] = {0};
+
 uint8_t g_scaling_registers[DRIVER_COUNT][ISSI_MAX_LEDS];
 
 void IS31FL3741_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
+#ifdef ISSI_ASYNC_FLUSH
+    issi_queue_flush();
+#endif
     g_twi_transfer_buffer[0] = reg;
     g_twi_transfer_buffer[1] = data;
 
@@ -91,53 +108,44 @@ void IS31FL3741_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
-bool IS31FL3741_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
-    // unlock the command register and select PG2
-    IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
-    IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM0);
+static bool IS31FL3741_write_pwm_blocks(uint8_t addr, uint8_t *pwm_buffer, uint32_t blocks) {
+    uint8_t page = 0xFF;
 
-    for (int i = 0; i < 342; i += 18) {
-        if (i == 180) {
-            // unlock the command register and select PG2
+    for (int i = 0; i < ISSI_MAX_LEDS; i += ISSI_PWM_BLOCK_SIZE) {
+        if (!(blocks & (1UL << (i / ISSI_PWM_BLOCK_SIZE)))) {
+            continue;
+        }
+        uint8_t block_page = i < ISSI_PWM_PAGE_SIZE ? ISSI_PAGE_PWM0 : ISSI_PAGE_PWM1;
+        if (block_page != page) {
+            // unlock the command register and select PG0 or PG1
             IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
-            IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM1);
+            IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER, block_page);
+            page = block_page;
         }
 
-        g_twi_transfer_buffer[0] = i % 180;
-        memcpy(g_twi_transfer_buffer + 1, pwm_buffer + i, 18);
+        // the last block is 9 bytes, as the total number is 351
+        uint8_t length           = ISSI_MAX_LEDS - i < ISSI_PWM_BLOCK_SIZE ? ISSI_MAX_LEDS - i : ISSI_PWM_BLOCK_SIZE;
+        g_twi_transfer_buffer[0] = i % ISSI_PWM_PAGE_SIZE;
+        memcpy(g_twi_transfer_buffer + 1, pwm_buffer + i, length);
 
 #if ISSI_PERSISTENCE > 0
         for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 19, ISSI_TIMEOUT) != 0) {
+            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, ISSI_TIMEOUT) != 0) {
                 return false;
             }
         }
 #else
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 19, ISSI_TIMEOUT) != 0) {
+        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, length + 1, ISSI_TIMEOUT) != 0) {
             return false;
         }
 #endif
     }
 
-    // transfer the left cause the total number is 351
-    g_twi_transfer_buffer[0] = 162;
-    memcpy(g_twi_transfer_buffer + 1, pwm_buffer + 342, 9);
-
-#if ISSI_PERSISTENCE > 0
-    for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 10, ISSI_TIMEOUT) != 0) {
-            return false;
-        }
-    }
-#else
-    if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 10, ISSI_TIMEOUT) != 0) {
-        return false;
-    }
-#endif
-
     return true;
 }
 
+bool IS31FL3741_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) { return IS31FL3741_write_pwm_blocks(addr, pwm_buffer, ISSI_PWM_BLOCKS_ALL); }
+
 void IS31FL3741_init(uint8_t addr) {
     // In order to avoid the LEDs being driven with garbage data
     // in the LED driver's PWM registers, shutdown is enabled last.
@@ -165,14 +173,21 @@ void IS31FL3741_init(uint8_t addr) {
     wait_ms(10);
 }
 
+static void IS31FL3741_set_pwm(uint8_t driver, uint16_t reg, uint8_t value) {
+    if (g_pwm_buffer[driver][reg] != value) {
+        g_pwm_buffer[driver][reg] = value;
+        g_pwm_buffer_dirty_blocks[driver] |= 1UL << (reg / ISSI_PWM_BLOCK_SIZE);
+        g_pwm_buffer_update_required = true;
+    }
+}
+
 void IS31FL3741_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         is31_led led = g_is31_leds[index];
 
-        g_pwm_buffer[led.driver][led.r] = red;
-        g_pwm_buffer[led.driver][led.g] = green;
-        g_pwm_buffer[led.driver][led.b] = blue;
-        g_pwm_buffer_update_required    = true;
+        IS31FL3741_set_pwm(led.driver, led.r, red);
+        IS31FL3741_set_pwm(led.driver, led.g, green);
+        IS31FL3741_set_pwm(led.driver, led.b, blue);
     }
 }
 
@@ -206,20 +221,60 @@ void IS31FL3741_set_led_control_register(uint8_t index, bool red, bool green, bo
     g_scaling_registers_update_required[led.driver] = true;
 }
 
+#ifdef ISSI_ASYNC_FLUSH
+void IS31FL3741_update_pwm_buffers(uint8_t addr1, uint8_t addr2) {
+    // A queued write failed, resend every block
+    if (issi_queue_take_failed(addr1)) {
+        g_pwm_buffer_update_required = true;
+        g_pwm_buffer_dirty_blocks[0] = ISSI_PWM_BLOCKS_ALL;
+    }
+    if (g_pwm_buffer_update_required) {
+        uint32_t blocks = g_pwm_buffer_dirty_blocks[0];
+        // If the whole frame does not fit, keep it dirty for the next flush.
+        uint8_t needed = __builtin_popcountl(blocks) + ((blocks & ISSI_PWM_BLOCKS_PG0) ? 2 : 0) + ((blocks & ~ISSI_PWM_BLOCKS_PG0) ? 2 : 0);
+        if (issi_queue_space() < needed) {
+            return;
+        }
+
+        uint8_t page = 0xFF;
+        for (int i = 0; i < ISSI_MAX_LEDS; i += ISSI_PWM_BLOCK_SIZE) {
+            if (!(blocks & (1UL << (i / ISSI_PWM_BLOCK_SIZE)))) {
+                continue;
+            }
+            uint8_t block_page = i < ISSI_PWM_PAGE_SIZE ? ISSI_PAGE_PWM0 : ISSI_PAGE_PWM1;
+            if (block_page != page) {
+                issi_queue_write_register(addr1, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
+                issi_queue_write_register(addr1, ISSI_COMMANDREGISTER, block_page);
+                page = block_page;
+            }
+            uint8_t length = ISSI_MAX_LEDS - i < ISSI_PWM_BLOCK_SIZE ? ISSI_MAX_LEDS - i : ISSI_PWM_BLOCK_SIZE;
+            issi_queue_write(addr1, i % ISSI_PWM_PAGE_SIZE, &g_pwm_buffer[0][i], length);
+        }
+    }
+
+    g_pwm_buffer_update_required = false;
+    g_pwm_buffer_dirty_blocks[0] = 0;
+}
+#else
 void IS31FL3741_update_pwm_buffers(uint8_t addr1, uint8_t addr2) {
     if (g_pwm_buffer_update_required) {
-        IS31FL3741_write_pwm_buffer(addr1, g_pwm_buffer[0]);
+        // Resend every block next time if any of the transactions fail
+        if (!IS31FL3741_write_pwm_blocks(addr1, g_pwm_buffer[0], g_pwm_buffer_dirty_blocks[0])) {
+            g_pwm_buffer_update_required = false;
+            g_pwm_buffer_dirty_blocks[0] = ISSI_PWM_BLOCKS_ALL;
+            return;
+        }
     }
 
     g_pwm_buffer_update_required = false;
+    g_pwm_buffer_dirty_blocks[0] = 0;
 }
+#endif
 
 void IS31FL3741_set_pwm_buffer(const is31_led *pled, uint8_t red, uint8_t green, uint8_t blue) {
-    g_pwm_buffer[pled->driver][pled->r] = red;
-    g_pwm_buffer[pled->driver][pled->g] = green;
-    g_pwm_buffer[pled->driver][pled->b] = blue;
-
-    g_pwm_buffer_update_required = true;
+    IS31FL3741_set_pwm(pled->driver, pled->r, red);
+    IS31FL3741_set_pwm(pled->driver, pled->g, green);
+    IS31FL3741_set_pwm(pled->driver, pled->b, blue);
 }
 
 void IS31FL3741_update_led_control_registers(uint8_t addr, uint8_t index) {
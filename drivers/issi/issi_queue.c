@@ -0,0 +1,177 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef ISSI_ASYNC_FLUSH
+
+#    include <string.h>
+#    include "issi_queue.h"
+#    include "i2c_master.h"
+
+#    ifdef PROTOCOL_CHIBIOS
+#        include "ch.h"
+#        include "hal.h"
+#        if !defined(I2C_USE_MUTUAL_EXCLUSION) || I2C_USE_MUTUAL_EXCLUSION != TRUE
+#            error "ISSI_ASYNC_FLUSH sends from its own thread and needs I2C_USE_MUTUAL_EXCLUSION set to TRUE in halconf.h"
+#        endif
+#        define ISSI_QUEUE_LOCK() chSysLock()
+#        define ISSI_QUEUE_UNLOCK() chSysUnlock()
+#    else
+#        define ISSI_QUEUE_LOCK()
+#        define ISSI_QUEUE_UNLOCK()
+#    endif
+
+#    ifndef ISSI_TIMEOUT
+#        define ISSI_TIMEOUT 100
+#    endif
+
+#    ifndef ISSI_PERSISTENCE
+#        define ISSI_PERSISTENCE 0
+#    endif
+
+_Static_assert(ISSI_QUEUE_SIZE <= 255, "ISSI_QUEUE_SIZE must be at most 255");
+
+typedef struct {
+    uint8_t addr;
+    uint8_t length;
+    uint8_t data[ISSI_QUEUE_TRANSFER_SIZE];
+} issi_transfer_t;
+
+// One slot is kept free to tell a full queue from an empty one
+static issi_transfer_t  issi_queue[ISSI_QUEUE_SIZE + 1];
+static volatile uint8_t issi_queue_head;
+static volatile uint8_t issi_queue_tail;
+
+// One bit per 7-bit device address with a failed write
+static volatile uint8_t issi_queue_failed[128 / 8];
+
+static uint8_t issi_queue_next(uint8_t index) { return index == ISSI_QUEUE_SIZE ? 0 : index + 1; }
+
+uint8_t issi_queue_space(void) {
+    ISSI_QUEUE_LOCK();
+    uint8_t used = issi_queue_head >= issi_queue_tail ? issi_queue_head - issi_queue_tail : ISSI_QUEUE_SIZE + 1 - issi_queue_tail + issi_queue_head;
+    ISSI_QUEUE_UNLOCK();
+    return ISSI_QUEUE_SIZE - used;
+}
+
+bool issi_queue_busy(void) {
+    ISSI_QUEUE_LOCK();
+    bool busy = issi_queue_head != issi_queue_tail;
+    ISSI_QUEUE_UNLOCK();
+    return busy;
+}
+
+// Sends the oldest write. It is only removed from the queue once sent, so
+// that issi_queue_busy() stays true while the bus is in use.
+static void issi_queue_send_next(void) {
+    issi_transfer_t *transfer = &issi_queue[issi_queue_tail];
+
+    i2c_status_t     status   = I2C_STATUS_ERROR;
+
+#    if ISSI_PERSISTENCE > 0
+    for (uint8_t i = 0; i < ISSI_PERSISTENCE && status != I2C_STATUS_SUCCESS; i++) {
+        status = i2c_transmit(transfer->addr << 1, transfer->data, transfer->length, ISSI_TIMEOUT);
+    }
+#    else
+    status = i2c_transmit(transfer->addr << 1, transfer->data, transfer->length, ISSI_TIMEOUT);
+#    endif
+
+    ISSI_QUEUE_LOCK();
+    if (status != I2C_STATUS_SUCCESS) {
+        issi_queue_failed[(transfer->addr & 0x7F) / 8] |= 1 << (transfer->addr % 8);
+    }
+    issi_queue_tail = issi_queue_next(issi_queue_tail);
+    ISSI_QUEUE_UNLOCK();
+}
+
+bool issi_queue_take_failed(uint8_t addr) {
+    uint8_t mask = 1 << (addr % 8);
+    ISSI_QUEUE_LOCK();
+    bool failed = issi_queue_failed[(addr & 0x7F) / 8] & mask;
+    issi_queue_failed[(addr & 0x7F) / 8] &= ~mask;
+    ISSI_QUEUE_UNLOCK();
+    return failed;
+}
+
+#    ifdef PROTOCOL_CHIBIOS
+static binary_semaphore_t issi_queue_pending;
+static bool               issi_queue_started = false;
+
+static THD_WORKING_AREA(waIssiQueueThread, 128);
+static THD_FUNCTION(IssiQueueThread, arg) {
+    (void)arg;
+    chRegSetThreadName("issi_queue");
+    while (true) {
+        chBSemWait(&issi_queue_pending);
+        while (issi_queue_busy()) {
+            issi_queue_send_next();
+        }
+    }
+}
+
+// Above the main thread, so that a write is started as soon as it is queued.
+// The thread then sleeps until the I2C driver completes the transfer.
+static void issi_queue_start(void) {
+    if (!issi_queue_started) {
+        chBSemObjectInit(&issi_queue_pending, true);
+        chThdCreateStatic(waIssiQueueThread, sizeof(waIssiQueueThread), NORMALPRIO + 1, IssiQueueThread, NULL);
+        issi_queue_started = true;
+    }
+}
+#    endif
+
+bool issi_queue_write(uint8_t addr, uint8_t reg, const uint8_t *data, uint8_t length) {
+    if (length + 1 > ISSI_QUEUE_TRANSFER_SIZE || issi_queue_space() == 0) {
+        return false;
+    }
+
+    issi_transfer_t *transfer = &issi_queue[issi_queue_head];
+    transfer->addr            = addr;
+    transfer->length          = length + 1;
+    transfer->data[0]         = reg;
+    memcpy(transfer->data + 1, data, length);
+
+    ISSI_QUEUE_LOCK();
+    issi_queue_head = issi_queue_next(issi_queue_head);
+    ISSI_QUEUE_UNLOCK();
+
+#    ifdef PROTOCOL_CHIBIOS
+    issi_queue_start();
+    chBSemSignal(&issi_queue_pending);
+#    endif
+    return true;
+}
+
+bool issi_queue_write_register(uint8_t addr, uint8_t reg, uint8_t data) { return issi_queue_write(addr, reg, &data, 1); }
+
+void issi_queue_task(void) {
+#    ifndef PROTOCOL_CHIBIOS
+    for (uint8_t i = 0; i < ISSI_QUEUE_WRITES_PER_TASK && issi_queue_busy(); i++) {
+        issi_queue_send_next();
+    }
+#    endif
+}
+
+void issi_queue_flush(void) {
+    while (issi_queue_busy()) {
+#    ifdef PROTOCOL_CHIBIOS
+        chThdSleepMilliseconds(1);
+#    else
+        issi_queue_send_next();
+#    endif
+    }
+}
+
+#endif
@@ -0,0 +1,74 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Queue of register writes for the ISSI drivers, used by their
+// *_update_pwm_buffers() functions when ISSI_ASYNC_FLUSH is defined.
+// Each write is copied, so the PWM buffers can be changed again straight away.
+// On ChibiOS a worker thread sends the queue while the main loop carries on;
+// elsewhere issi_queue_task() sends a few writes per call.
+
+// Writes in a full frame for one driver: the page select writes plus one
+// write per PWM block
+#if defined(IS31FL3741)
+#    define ISSI_QUEUE_FRAME_WRITES (4 + 20)
+#elif defined(IS31FL3731)
+#    define ISSI_QUEUE_FRAME_WRITES 9
+#else
+#    define ISSI_QUEUE_FRAME_WRITES (2 + 12)
+#endif
+
+// Number of writes that can be queued, by default a full frame for every
+// driver. At most 255.
+#ifndef ISSI_QUEUE_SIZE
+#    if defined(DRIVER_COUNT)
+#        define ISSI_QUEUE_SIZE (DRIVER_COUNT * ISSI_QUEUE_FRAME_WRITES)
+#    elif defined(LED_DRIVER_COUNT)
+#        define ISSI_QUEUE_SIZE (LED_DRIVER_COUNT * ISSI_QUEUE_FRAME_WRITES)
+#    else
+#        define ISSI_QUEUE_SIZE ISSI_QUEUE_FRAME_WRITES
+#    endif
+#endif
+
+// Writes sent per issi_queue_task() call when there is no worker thread
+#ifndef ISSI_QUEUE_WRITES_PER_TASK
+#    define ISSI_QUEUE_WRITES_PER_TASK 2
+#endif
+
+// Register address plus the largest PWM block (IS31FL3741)
+#define ISSI_QUEUE_TRANSFER_SIZE 19
+
+uint8_t issi_queue_space(void);
+bool    issi_queue_busy(void);
+
+// Queues a write of `length` bytes starting at register `reg`.
+// Returns false, queueing nothing, if the queue is full.
+bool issi_queue_write(uint8_t addr, uint8_t reg, const uint8_t *data, uint8_t length);
+bool issi_queue_write_register(uint8_t addr, uint8_t reg, uint8_t data);
+
+// Returns true, and clears the flag, if a queued write to `addr` failed since
+// the last call. The drivers then resend the whole frame.
+bool issi_queue_take_failed(uint8_t addr);
+
+void issi_queue_task(void);
+
+// Blocks until every queued write has been sent. Synchronous register writes
+// call this first, so that they never overtake queued ones.
+void issi_queue_flush(void);
@@ -0,0 +1,62 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Host-side stand-in for the platform i2c_master, for the ISSI driver tests.
+ * It models each device as pages of registers selected through the command
+ * register 0xFD, with auto-incrementing writes, and counts the traffic.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int16_t i2c_status_t;
+
+#define I2C_STATUS_SUCCESS (0)
+#define I2C_STATUS_ERROR (-1)
+#define I2C_STATUS_TIMEOUT (-2)
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout);
+
+#define I2C_MOCK_DEVICES 4
+#define I2C_MOCK_PAGES 16
+
+typedef struct {
+    uint8_t address;  // 7-bit, 0 when unused
+    uint8_t page;
+    uint8_t fail;  // number of upcoming transactions to NACK
+    uint8_t registers[I2C_MOCK_PAGES][256];
+} i2c_mock_device_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;  // including the address byte of each transaction
+} i2c_mock_stats_t;
+
+extern i2c_mock_device_t I2cDevices[I2C_MOCK_DEVICES];
+extern i2c_mock_stats_t  I2cStats;
+
+void     i2c_mock_reset(void);
+uint8_t* i2c_mock_registers(uint8_t address, uint8_t page);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,65 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "i2c_master.h"
+
+i2c_mock_device_t I2cDevices[I2C_MOCK_DEVICES];
+i2c_mock_stats_t  I2cStats;
+
+#define ISSI_COMMANDREGISTER 0xFD
+
+void i2c_mock_reset(void) {
+    memset(I2cDevices, 0, sizeof(I2cDevices));
+    memset(&I2cStats, 0, sizeof(I2cStats));
+}
+
+static i2c_mock_device_t* i2c_mock_device(uint8_t address) {
+    for (uint8_t i = 0; i < I2C_MOCK_DEVICES; i++) {
+        if (I2cDevices[i].address == address || I2cDevices[i].address == 0) {
+            I2cDevices[i].address = address;
+            return &I2cDevices[i];
+        }
+    }
+    return NULL;
+}
+
+uint8_t* i2c_mock_registers(uint8_t address, uint8_t page) { return i2c_mock_device(address)->registers[page]; }
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout) {
+    i2c_mock_device_t* device = i2c_mock_device(address >> 1);
+    if (!device || length == 0) {
+        return I2C_STATUS_ERROR;
+    }
+
+    I2cStats.transactions++;
+    I2cStats.bytes += 1 + length;
+
+    if (device->fail) {
+        device->fail--;
+        return I2C_STATUS_ERROR;
+    }
+
+    uint8_t reg = data[0];
+    if (reg == ISSI_COMMANDREGISTER && length == 2) {
+        device->page = data[1] % I2C_MOCK_PAGES;
+        return I2C_STATUS_SUCCESS;
+    }
+    for (uint16_t i = 1; i < length; i++) {
+        device->registers[device->page][reg++] = data[i];
+    }
+    return I2C_STATUS_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include <iostream>
+
+extern "C" {
+#include "i2c_master.h"
+#include "is31fl3733.h"
+#ifdef ISSI_ASYNC_FLUSH
+#    include "issi_queue.h"
+#endif
+
+void wait_ms(uint32_t ms) {}
+
+extern uint8_t  g_pwm_buffer[DRIVER_COUNT][192];
+extern bool     g_pwm_buffer_update_required[DRIVER_COUNT];
+extern uint16_t g_pwm_buffer_dirty_blocks[DRIVER_COUNT];
+
+// 32 RGB LEDs per driver on PWM registers 0x00-0x5F, i.e. the first 6 blocks
+#define LED(i) \
+    { (i) / 32, ((i) % 32) * 3, ((i) % 32) * 3 + 1, ((i) % 32) * 3 + 2 }
+#define LED4(i) LED(i), LED(i + 1), LED(i + 2), LED(i + 3)
+#define LED16(i) LED4(i), LED4(i + 4), LED4(i + 8), LED4(i + 12)
+const is31_led g_is31_leds[DRIVER_LED_TOTAL] = {LED16(0), LED16(16), LED16(32), LED16(48)};
+}
+
+#define ADDR_1 0x50
+#define ADDR_2 0x53
+#define ISSI_PAGE_PWM 0x01
+
+class IS31FL3733 : public testing::Test {
+   public:
+    IS31FL3733() {
+        i2c_mock_reset();
+        IS31FL3733_init(ADDR_1, 0);
+        IS31FL3733_init(ADDR_2, 0);
+        // init clears the PWM registers, match that
+        IS31FL3733_set_color_all(0, 0, 0);
+        flush();
+        I2cStats = {};
+    }
+
+    // What rgb_matrix_drivers.c does every frame, then waits for the writes
+    static void flush(void) {
+        IS31FL3733_update_pwm_buffers(ADDR_1, 0);
+        IS31FL3733_update_pwm_buffers(ADDR_2, 1);
+#ifdef ISSI_ASYNC_FLUSH
+        issi_queue_flush();
+#endif
+    }
+
+    static void expect_pwm_registers_match(void) {
+        EXPECT_EQ(memcmp(i2c_mock_registers(ADDR_1, ISSI_PAGE_PWM), g_pwm_buffer[0], 192), 0);
+        EXPECT_EQ(memcmp(i2c_mock_registers(ADDR_2, ISSI_PAGE_PWM), g_pwm_buffer[1], 192), 0);
+    }
+};
+
+TEST_F(IS31FL3733, OnlyChangedBlocksAreSent) {
+    IS31FL3733_set_color_all(10, 20, 30);
+    flush();
+    // Page select plus the 6 used blocks, per driver
+    EXPECT_EQ(I2cStats.transactions, 2u * (2 + 6));
+    expect_pwm_registers_match();
+}
+
+TEST_F(IS31FL3733, UnchangedFrameSendsNothing) {
+    IS31FL3733_set_color_all(10, 20, 30);
+    flush();
+    I2cStats = {};
+    IS31FL3733_set_color_all(10, 20, 30);
+    flush();
+    EXPECT_EQ(I2cStats.transactions, 0u);
+}
+
+TEST_F(IS31FL3733, SingleLedSendsOneBlock) {
+    IS31FL3733_set_color(40, 1, 2, 3);
+    flush();
+    EXPECT_EQ(I2cStats.transactions, 2u + 1);
+    expect_pwm_registers_match();
+}
+
+TEST_F(IS31FL3733, LedAcrossBlocksSendsBothBlocks) {
+    // LED 5 sits on registers 0x0F-0x11
+    IS31FL3733_set_color(5, 1, 2, 3);
+    flush();
+    EXPECT_EQ(I2cStats.transactions, 2u + 2);
+    expect_pwm_registers_match();
+}
+
+TEST_F(IS31FL3733, BytesPerFrame) {
+    // Before dirty tracking every update sent the page select and 12 blocks
+    const uint32_t before = DRIVER_COUNT * (2 * (1 + 2) + 12 * (1 + 17));
+    const uint32_t frames = 256;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        // A reactive effect: one key lit at a time
+        IS31FL3733_set_color_all(0, 0, 0);
+        IS31FL3733_set_color(frame % DRIVER_LED_TOTAL, 255, 255, 255);
+        flush();
+    }
+    expect_pwm_registers_match();
+    std::cout << "[   INFO   ] reactive frame: " << I2cStats.bytes / frames << " bytes, " << before << " before dirty tracking" << std::endl;
+    EXPECT_LT(I2cStats.bytes / frames, before / 4);
+
+    I2cStats = {};
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        // A full matrix effect: every LED changes every frame
+        IS31FL3733_set_color_all(frame, 255 - frame, frame / 2);
+        flush();
+    }
+    expect_pwm_registers_match();
+    std::cout << "[   INFO   ] full matrix frame: " << I2cStats.bytes / frames << " bytes, " << before << " before dirty tracking" << std::endl;
+    EXPECT_LE(I2cStats.bytes / frames, before);
+}
+
+#ifdef ISSI_ASYNC_FLUSH
+TEST_F(IS31FL3733, UpdateDoesNotBlock) {
+    IS31FL3733_set_color_all(10, 20, 30);
+    IS31FL3733_update_pwm_buffers(ADDR_1, 0);
+    IS31FL3733_update_pwm_buffers(ADDR_2, 1);
+    EXPECT_EQ(I2cStats.transactions, 0u);
+    EXPECT_TRUE(issi_queue_busy());
+
+    // Changing the buffer does not affect writes already queued
+    IS31FL3733_set_color_all(40, 50, 60);
+    for (uint8_t i = 0; i < 8 && issi_queue_busy(); i++) {
+        issi_queue_task();
+        EXPECT_EQ(I2cStats.transactions, (i + 1u) * ISSI_QUEUE_WRITES_PER_TASK);
+    }
+    EXPECT_EQ(i2c_mock_registers(ADDR_1, ISSI_PAGE_PWM)[0], 10);
+
+    flush();
+    expect_pwm_registers_match();
+}
+
+TEST_F(IS31FL3733, FrameThatDoesNotFitStaysDirty) {
+    uint8_t filler = 0;
+    while (issi_queue_space() > 4) {
+        issi_queue_write(ADDR_1, ISSI_PAGE_PWM, &filler, 0);
+    }
+    IS31FL3733_set_color_all(10, 20, 30);
+    IS31FL3733_update_pwm_buffers(ADDR_1, 0);
+    EXPECT_EQ(issi_queue_space(), 4);
+
+    issi_queue_flush();
+    flush();
+    expect_pwm_registers_match();
+}
+
+TEST_F(IS31FL3733, SynchronousWritesWaitForTheQueue) {
+    IS31FL3733_set_color_all(10, 20, 30);
+    IS31FL3733_update_pwm_buffers(ADDR_1, 0);
+    IS31FL3733_write_register(ADDR_1, 0xFD, 0x00);
+    EXPECT_FALSE(issi_queue_busy());
+    EXPECT_EQ(I2cDevices[0].page, 0);
+    EXPECT_EQ(i2c_mock_registers(ADDR_1, ISSI_PAGE_PWM)[0], 10);
+}
+
+TEST_F(IS31FL3733, FailedWriteIsResent) {
+    IS31FL3733_set_color_all(10, 20, 30);
+    flush();
+    I2cDevices[0].fail = 3;
+    IS31FL3733_set_color(0, 40, 50, 60);
+    flush();
+    EXPECT_NE(i2c_mock_registers(ADDR_1, ISSI_PAGE_PWM)[0], 40);
+
+    // The next update sends the whole frame again
+    I2cStats = {};
+    flush();
+    EXPECT_EQ(I2cStats.transactions, 2u + 12);
+    expect_pwm_registers_match();
+}
+
+TEST_F(IS31FL3733, QueueHoldsAFullFrameForEveryDriver) {
+    for (uint8_t i = 0; i < DRIVER_COUNT; i++) {
+        g_pwm_buffer_update_required[i] = true;
+        g_pwm_buffer_dirty_blocks[i]    = 0x0FFF;
+    }
+    IS31FL3733_update_pwm_buffers(ADDR_1, 0);
+    IS31FL3733_update_pwm_buffers(ADDR_2, 1);
+    EXPECT_EQ(I2cStats.transactions, 0u);
+    EXPECT_EQ(issi_queue_space(), ISSI_QUEUE_SIZE - DRIVER_COUNT * (2 + 12));
+
+    issi_queue_flush();
+    EXPECT_EQ(I2cStats.transactions, DRIVER_COUNT * (2u + 12));
+}
+#endif
@@ -0,0 +1,14 @@
+ISSI_TESTS_PATH := $(DRIVER_PATH)/issi/tests
+
+issi_is31fl3733_DEFS := -DDRIVER_COUNT=2 -DDRIVER_LED_TOTAL=64
+issi_is31fl3733_INC := $(ISSI_TESTS_PATH) $(DRIVER_PATH)/issi
+issi_is31fl3733_SRC := \
+	$(ISSI_TESTS_PATH)/is31fl3733_tests.cpp \
+	$(ISSI_TESTS_PATH)/i2c_master_mock.c \
+	$(DRIVER_PATH)/issi/is31fl3733.c
+
+issi_is31fl3733_async_DEFS := $(issi_is31fl3733_DEFS) -DISSI_ASYNC_FLUSH
+issi_is31fl3733_async_INC := $(issi_is31fl3733_INC)
+issi_is31fl3733_async_SRC := \
+	$(issi_is31fl3733_SRC) \
+	$(DRIVER_PATH)/issi/issi_queue.c
@@ -24,6 +24,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "progmem.h"
 
+#ifdef OLED_RENDER_ASYNC
+#    ifndef PROTOCOL_CHIBIOS
+#        error "OLED_RENDER_ASYNC requires ChibiOS"
+#    endif
+#    include "ch.h"
+#    include "hal.h"
+// The render thread shares the bus with the main thread, i2c_master takes it per transfer
+#    if !defined(I2C_USE_MUTUAL_EXCLUSION) || I2C_USE_MUTUAL_EXCLUSION != TRUE
+#        error "OLED_RENDER_ASYNC needs I2C_USE_MUTUAL_EXCLUSION set to TRUE in halconf.h"
+#    endif
+static void render_wait(void);
+#endif
+
 // Used commands from spec sheet: https://cdn-shop.adafruit.com/datasheets/SSD1306.pdf
 // for SH1106: https://www.velleman.eu/downloads/29/infosheets/sh1106_datasheet.pdf
 
@@ -89,10 +102,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define I2C_DATA 0x40
 #if defined(__AVR__)
 #    define I2C_TRANSMIT_P(data) i2c_transmit_P((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT)
+#elif defined(OLED_RENDER_ASYNC)
+// Commands wait for the render thread to release the bus
+#    define I2C_TRANSMIT_P(data) (render_wait(), i2c_transmit((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT))
 #else  // defined(__AVR__)
 #    define I2C_TRANSMIT_P(data) i2c_transmit((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT)
 #endif  // defined(__AVR__)
-#define I2C_TRANSMIT(data) i2c_transmit((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT)
+#ifdef OLED_RENDER_ASYNC
+#    define I2C_TRANSMIT(data) (render_wait(), i2c_transmit((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT))
+#else
+#    define I2C_TRANSMIT(data) i2c_transmit((OLED_DISPLAY_ADDRESS << 1), &data[0], sizeof(data), OLED_I2C_TIMEOUT)
+#endif
 #define I2C_WRITE_REG(mode, data, size) i2c_writeReg((OLED_DISPLAY_ADDRESS << 1), mode, data, size, OLED_I2C_TIMEOUT)
 
 #define HAS_FLAGS(bits, flags) ((bits & flags) == flags)
@@ -118,6 +138,9 @@ uint32_t oled_timeout;
 #if OLED_SCROLL_TIMEOUT > 0
 uint32_t oled_scroll_timeout;
 #endif
+#ifdef OLED_RENDER_BATCH
+static volatile uint16_t render_time = 0;
+#endif
 
 // Internal variables to reduce math instructions
 
@@ -221,13 +244,14 @@ void oled_clear(void) {
     oled_dirty  = OLED_ALL_BLOCKS_MASK;
 }
 
-static void calc_bounds(uint8_t update_start, uint8_t *cmd_array) {
+static void calc_bounds(uint8_t update_start, uint8_t update_count, uint8_t *cmd_array) {
     // Calculate commands to set memory addressing bounds.
     uint8_t start_page   = OLED_BLOCK_SIZE * update_start / OLED_DISPLAY_WIDTH;
     uint8_t start_column = OLED_BLOCK_SIZE * update_start % OLED_DISPLAY_WIDTH;
 #if (OLED_IC == OLED_IC_SH1106)
     // Commands for Page Addressing Mode. Sets starting page and column; has no end bound.
     // Column value must be split into high and low nybble and sent as two commands.
+    (void)update_count;
     cmd_array[0] = PAM_PAGE_ADDR | start_page;
     cmd_array[1] = PAM_SETCOLUMN_LSB | ((OLED_COLUMN_OFFSET + start_column) & 0x0f);
     cmd_array[2] = PAM_SETCOLUMN_MSB | ((OLED_COLUMN_OFFSET + start_column) >> 4 & 0x0f);
@@ -236,10 +260,12 @@ static void calc_bounds(uint8_t update_start, uint8_t *cmd_array) {
     cmd_array[5] = NOP;
 #else
     // Commands for use in Horizontal Addressing mode.
-    cmd_array[1] = start_column;
-    cmd_array[4] = start_page;
-    cmd_array[2] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) % OLED_DISPLAY_WIDTH + cmd_array[1];
-    cmd_array[5] = (OLED_BLOCK_SIZE + OLED_DISPLAY_WIDTH - 1) / OLED_DISPLAY_WIDTH - 1;
+    // A window either stays within one page or covers whole pages.
+    uint16_t update_size = (uint16_t)OLED_BLOCK_SIZE * update_count;
+    cmd_array[1]         = start_column;
+    cmd_array[4]         = start_page;
+    cmd_array[2]         = update_size >= OLED_DISPLAY_WIDTH ? OLED_DISPLAY_WIDTH - 1 : start_column + update_size - 1;
+    cmd_array[5]         = start_page + (update_size + OLED_DISPLAY_WIDTH - 1) / OLED_DISPLAY_WIDTH - 1;
 #endif
 }
 
@@ -251,21 +277,40 @@ static void calc_bounds_90(uint8_t update_start, uint8_t *cmd_array) {
     cmd_array[5] = (OLED_BLOCK_SIZE + OLED_DISPLAY_HEIGHT - 1) % OLED_DISPLAY_HEIGHT / 8;
 }
 
-uint8_t crot(uint8_t a, int8_t n) {
-    const uint8_t mask = 0x7;
-    n &= mask;
-    return a << n | a >> (-n & mask);
-}
+// Spreads the 4 bits of a nibble into bit 0 of 4 consecutive bytes
+#define SPREAD(n) ((uint32_t)((n)&1) | (uint32_t)((n) >> 1 & 1) << 8 | (uint32_t)((n) >> 2 & 1) << 16 | (uint32_t)((n) >> 3 & 1) << 24)
+static const uint32_t PROGMEM nibble_spread[16] = {
+    SPREAD(0), SPREAD(1), SPREAD(2), SPREAD(3), SPREAD(4), SPREAD(5), SPREAD(6), SPREAD(7), SPREAD(8), SPREAD(9), SPREAD(10), SPREAD(11), SPREAD(12), SPREAD(13), SPREAD(14), SPREAD(15),
+};
 
+// Transposes an 8x8 pixel tile: bit i of src[j] becomes bit 7 - j of dest[i]
 static void rotate_90(const uint8_t *src, uint8_t *dest) {
-    for (uint8_t i = 0, shift = 7; i < 8; ++i, --shift) {
-        uint8_t selector = (1 << i);
-        for (uint8_t j = 0; j < 8; ++j) {
-            dest[i] |= crot(src[j] & selector, shift - (int8_t)j);
-        }
+    uint32_t low = 0, high = 0;
+    for (uint8_t j = 0; j < 8; ++j) {
+        low |= pgm_read_dword(&nibble_spread[src[j] & 0x0F]) << (7 - j);
+        high |= pgm_read_dword(&nibble_spread[src[j] >> 4]) << (7 - j);
+    }
+    for (uint8_t i = 0; i < 4; ++i) {
+        dest[i]     = low >> (8 * i);
+        dest[i + 4] = high >> (8 * i);
     }
 }
 
+// Returns the render data for a 90 degree rotated block
+static const uint8_t *render_block_90(uint8_t update_start) {
+    // Rotate the render chunks
+    const static uint8_t source_map[] = OLED_SOURCE_MAP;
+    const static uint8_t target_map[] = OLED_TARGET_MAP;
+
+    static uint8_t temp_buffer[OLED_BLOCK_SIZE];
+    memset(temp_buffer, 0, sizeof(temp_buffer));
+    for (uint8_t i = 0; i < sizeof(source_map); ++i) {
+        rotate_90(&oled_buffer[OLED_BLOCK_SIZE * update_start + source_map[i]], &temp_buffer[target_map[i]]);
+    }
+    return temp_buffer;
+}
+
+#ifndef OLED_RENDER_BATCH
 void oled_render(void) {
     // Do we have work to do?
     oled_dirty &= OLED_ALL_BLOCKS_MASK;
@@ -282,7 +327,7 @@ void oled_render(void) {
     // Set column & page position
     static uint8_t display_start[] = {I2C_CMD, COLUMN_ADDR, 0, OLED_DISPLAY_WIDTH - 1, PAGE_ADDR, 0, OLED_DISPLAY_HEIGHT / 8 - 1};
     if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
-        calc_bounds(update_start, &display_start[1]);  // Offset from I2C_CMD byte at the start
+        calc_bounds(update_start, 1, &display_start[1]);  // Offset from I2C_CMD byte at the start
     } else {
         calc_bounds_90(update_start, &display_start[1]);  // Offset from I2C_CMD byte at the start
     }
@@ -300,18 +345,8 @@ void oled_render(void) {
             return;
         }
     } else {
-        // Rotate the render chunks
-        const static uint8_t source_map[] = OLED_SOURCE_MAP;
-        const static uint8_t target_map[] = OLED_TARGET_MAP;
-
-        static uint8_t temp_buffer[OLED_BLOCK_SIZE];
-        memset(temp_buffer, 0, sizeof(temp_buffer));
-        for (uint8_t i = 0; i < sizeof(source_map); ++i) {
-            rotate_90(&oled_buffer[OLED_BLOCK_SIZE * update_start + source_map[i]], &temp_buffer[target_map[i]]);
-        }
-
         // Send render data chunk after rotating
-        if (I2C_WRITE_REG(I2C_DATA, &temp_buffer[0], OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
+        if (I2C_WRITE_REG(I2C_DATA, render_block_90(update_start), OLED_BLOCK_SIZE) != I2C_STATUS_SUCCESS) {
             print("oled_render90 data failed\n");
             return;
         }
@@ -323,6 +358,180 @@ void oled_render(void) {
     // Clear dirty flag
     oled_dirty &= ~((OLED_BLOCK_TYPE)1 << update_start);
 }
+#else
+// Finds the first dirty block and the number of dirty blocks following it
+// that can be written through the same addressing window
+static uint8_t render_window(OLED_BLOCK_TYPE dirty, uint8_t *update_start) {
+    uint8_t first = 0;
+    while (!(dirty & ((OLED_BLOCK_TYPE)1 << first))) {
+        ++first;
+    }
+    *update_start = first;
+
+    // Rotated blocks are columns of the display, they are not contiguous in its memory
+    if (HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
+        return 1;
+    }
+
+    uint8_t last = first;
+    while (last + 1 < OLED_BLOCK_COUNT && (dirty & ((OLED_BLOCK_TYPE)1 << (last + 1)))) {
+        ++last;
+    }
+
+    uint16_t start = (uint16_t)OLED_BLOCK_SIZE * first;
+    uint16_t end   = (uint16_t)OLED_BLOCK_SIZE * (last + 1);
+    uint16_t page  = (start / OLED_DISPLAY_WIDTH + 1) * OLED_DISPLAY_WIDTH;
+#    if (OLED_IC == OLED_IC_SH1106)
+    // Page addressing mode does not wrap to the next page
+    if (end > page) {
+        end = page < start + OLED_BLOCK_SIZE ? start + OLED_BLOCK_SIZE : page;
+    }
+#    else
+    if (start % OLED_DISPLAY_WIDTH) {
+        // Unaligned start, stay within the page
+        if (end > page) end = page;
+    } else if (end - start > OLED_DISPLAY_WIDTH && end % OLED_DISPLAY_WIDTH) {
+        // Whole pages only, the remainder gets its own window
+        end -= end % OLED_DISPLAY_WIDTH;
+    }
+#    endif
+    return (end - start) / OLED_BLOCK_SIZE;
+}
+
+#    if defined(__AVR__)
+// Streams the data straight from the buffer
+static i2c_status_t render_data(const uint8_t *data, uint16_t size) {
+    i2c_status_t status = i2c_start((OLED_DISPLAY_ADDRESS << 1) | I2C_WRITE, OLED_I2C_TIMEOUT);
+    if (status >= 0) {
+        status = i2c_write(I2C_DATA, OLED_I2C_TIMEOUT);
+    }
+
+    for (uint16_t i = 0; i < size && status >= 0; i++) {
+        status = i2c_write(data[i], OLED_I2C_TIMEOUT);
+    }
+
+    i2c_stop();
+
+    return status;
+}
+#    else
+// Largest possible window, prefixed with its control byte
+static uint8_t render_packet[OLED_MATRIX_SIZE + 1];
+
+static i2c_status_t render_data(const uint8_t *data, uint16_t size) {
+    render_packet[0] = I2C_DATA;
+    memcpy(&render_packet[1], data, size);
+    return i2c_transmit((OLED_DISPLAY_ADDRESS << 1), render_packet, size + 1, OLED_I2C_TIMEOUT);
+}
+#    endif
+
+// Sends every dirty block, returns the blocks that were sent
+static OLED_BLOCK_TYPE render_dirty(OLED_BLOCK_TYPE dirty) {
+    OLED_BLOCK_TYPE rendered = 0;
+    while (dirty) {
+        uint8_t update_start;
+        uint8_t update_count = render_window(dirty, &update_start);
+
+        // Set column & page position
+        uint8_t display_start[] = {I2C_CMD, COLUMN_ADDR, 0, OLED_DISPLAY_WIDTH - 1, PAGE_ADDR, 0, OLED_DISPLAY_HEIGHT / 8 - 1};
+        if (!HAS_FLAGS(oled_rotation, OLED_ROTATION_90)) {
+            calc_bounds(update_start, update_count, &display_start[1]);
+        } else {
+            calc_bounds_90(update_start, &display_start[1]);
+        }
+
+        if (i2c_transmit((OLED_DISPLAY_ADDRESS << 1), display_start, sizeof(display_start), OLED_I2C_TIMEOUT) != I2C_STATUS_SUCCESS) {
+            break;
+        }
+
+        const uint8_t *data = HAS_FLAGS(oled_rotation, OLED_ROTATION_90) ? render_block_90(update_start) : &oled_buffer[OLED_BLOCK_SIZE * update_start];
+        if (render_data(data, (uint16_t)OLED_BLOCK_SIZE * update_count) != I2C_STATUS_SUCCESS) {
+            break;
+        }
+
+        OLED_BLOCK_TYPE window = (((OLED_BLOCK_TYPE)1 << (update_count - 1) << 1) - 1) << update_start;
+        dirty &= ~window;
+        rendered |= window;
+    }
+    return rendered;
+}
+
+#    ifdef OLED_RENDER_ASYNC
+static binary_semaphore_t       render_pending;
+static volatile bool            render_active = false;
+static volatile OLED_BLOCK_TYPE render_blocks;
+static volatile OLED_BLOCK_TYPE render_failed;
+static uint32_t                 render_start;
+
+static THD_WORKING_AREA(waOledRenderThread, 256);
+static THD_FUNCTION(OledRenderThread, arg) {
+    (void)arg;
+    chRegSetThreadName("oled_render");
+    while (true) {
+        chBSemWait(&render_pending);
+        render_failed = render_blocks & ~render_dirty(render_blocks);
+        render_time   = timer_elapsed32(render_start);
+        render_active = false;
+    }
+}
+
+static void render_wait(void) {
+    while (render_active) {
+        chThdSleepMilliseconds(1);
+    }
+}
+#    endif
+
+void oled_render(void) {
+#    ifdef OLED_RENDER_ASYNC
+    static bool render_started = false;
+    if (!render_started) {
+        chBSemObjectInit(&render_pending, true);
+        chThdCreateStatic(waOledRenderThread, sizeof(waOledRenderThread), NORMALPRIO + 1, OledRenderThread, NULL);
+        render_started = true;
+    }
+
+    // The previous frame is still being sent, blocks changed since then stay dirty
+    if (render_active) {
+        return;
+    }
+
+    // Blocks the last frame failed to send
+    oled_dirty |= render_failed;
+    render_failed = 0;
+#    endif
+
+    // Do we have work to do?
+    oled_dirty &= OLED_ALL_BLOCKS_MASK;
+    if (!oled_dirty || oled_scrolling) {
+        return;
+    }
+
+    // Turn on display if it is off
+    oled_on();
+
+    uint32_t start = timer_read32();
+#    ifdef OLED_RENDER_ASYNC
+    // Blocks are sent from oled_buffer, a block changed mid transfer is sent again by the next frame
+    render_start  = start;
+    render_blocks = oled_dirty;
+    oled_dirty    = 0;
+    render_active = true;
+    chBSemSignal(&render_pending);
+#    else
+    OLED_BLOCK_TYPE rendered = render_dirty(oled_dirty);
+    if (rendered != oled_dirty) {
+        print("oled_render failed\n");
+    }
+    oled_dirty &= ~rendered;
+    render_time = timer_elapsed32(start);
+#    endif
+}
+#endif
+
+#ifdef OLED_RENDER_BATCH
+uint16_t oled_render_time(void) { return render_time; }
+#endif
 
 void oled_set_cursor(uint8_t col, uint8_t line) {
     uint16_t index = line * oled_rotation_width + col * OLED_FONT_WIDTH;
@@ -19,6 +19,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdint.h>
 #include <stdbool.h>
 
+#if defined(OLED_RENDER_ASYNC) && !defined(OLED_RENDER_BATCH)
+#    define OLED_RENDER_BATCH
+#endif
+
 // an enumeration of the chips this driver supports
 #define OLED_IC_SSD1306 0
 #define OLED_IC_SH1106 1
@@ -182,6 +186,12 @@ void oled_clear(void);
 // Renders the dirty chunks of the buffer to oled display
 void oled_render(void);
 
+#ifdef OLED_RENDER_BATCH
+// Returns how long the last frame took to render in milliseconds
+// Only available with OLED_RENDER_BATCH or OLED_RENDER_ASYNC
+uint16_t oled_render_time(void);
+#endif
+
 // Moves cursor to character position indicated by column and line, wraps if out of bounds
 // Max column denoted by 'oled_max_chars()' and max lines by 'oled_max_lines()' functions
 void oled_set_cursor(uint8_t col, uint8_t line);
@@ -0,0 +1,66 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Host-side stand-in for the platform i2c_master, for the OLED driver tests.
+ * It models the display memory of an SSD1306/SH1106, follows the addressing
+ * commands the driver sends, and counts the traffic and bus time.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int16_t i2c_status_t;
+
+#define I2C_STATUS_SUCCESS (0)
+#define I2C_STATUS_ERROR (-1)
+#define I2C_STATUS_TIMEOUT (-2)
+
+void         i2c_init(void);
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout);
+i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t* data, uint16_t length, uint16_t timeout);
+
+#define I2C_MOCK_PAGES 8
+#define I2C_MOCK_COLUMNS 132
+
+typedef struct {
+    bool    horizontal;  // horizontal addressing mode, page addressing otherwise
+    uint8_t column, column_start, column_end;
+    uint8_t page, page_start, page_end;
+    uint8_t ram[I2C_MOCK_PAGES][I2C_MOCK_COLUMNS];
+} i2c_mock_display_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;  // including the address byte of each transaction
+} i2c_mock_stats_t;
+
+extern i2c_mock_display_t I2cDisplay;
+extern i2c_mock_stats_t   I2cStats;
+
+// Transactions fail from this one on, 0 never fails
+extern uint32_t I2cFailAt;
+
+void i2c_mock_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
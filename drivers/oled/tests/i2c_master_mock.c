@@ -0,0 +1,123 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "i2c_master.h"
+#include "timer.h"
+
+void advance_time(uint32_t ms);
+
+i2c_mock_display_t I2cDisplay;
+i2c_mock_stats_t   I2cStats;
+uint32_t           I2cFailAt;
+
+// 9 clocks per byte at 400kHz
+#define I2C_MOCK_NS_PER_BYTE 22500
+static uint32_t bus_ns;
+
+void i2c_mock_reset(void) {
+    memset(&I2cDisplay, 0, sizeof(I2cDisplay));
+    I2cDisplay.column_end = I2C_MOCK_COLUMNS - 1;
+    I2cDisplay.page_end   = I2C_MOCK_PAGES - 1;
+    I2cStats              = (i2c_mock_stats_t){0};
+    I2cFailAt             = 0;
+    bus_ns                = 0;
+}
+
+void i2c_init(void) {}
+
+static void write_data(uint8_t data) {
+    I2cDisplay.ram[I2cDisplay.page % I2C_MOCK_PAGES][I2cDisplay.column % I2C_MOCK_COLUMNS] = data;
+    if (!I2cDisplay.horizontal) {
+        I2cDisplay.column++;
+    } else if (I2cDisplay.column++ == I2cDisplay.column_end) {
+        I2cDisplay.column = I2cDisplay.column_start;
+        if (I2cDisplay.page++ == I2cDisplay.page_end) {
+            I2cDisplay.page = I2cDisplay.page_start;
+        }
+    }
+}
+
+// Returns the number of argument bytes consumed
+static uint8_t write_command(const uint8_t *cmd, uint16_t remaining) {
+    switch (cmd[0]) {
+        case 0x20:  // MEMORY_MODE
+            I2cDisplay.horizontal = remaining > 1 && cmd[1] == 0x00;
+            return 1;
+        case 0x21:  // COLUMN_ADDR
+            I2cDisplay.column = I2cDisplay.column_start = cmd[1];
+            I2cDisplay.column_end                       = cmd[2];
+            return 2;
+        case 0x22:  // PAGE_ADDR
+            I2cDisplay.page = I2cDisplay.page_start = cmd[1];
+            I2cDisplay.page_end                     = cmd[2];
+            return 2;
+        case 0x26:  // SCROLL_RIGHT
+        case 0x27:  // SCROLL_LEFT
+            return 6;
+        case 0x81:  // CONTRAST
+        case 0xA8:  // MULTIPLEX_RATIO
+        case 0xD3:  // DISPLAY_OFFSET
+        case 0xD5:  // DISPLAY_CLOCK
+        case 0xD9:  // PRE_CHARGE_PERIOD
+        case 0xDA:  // COM_PINS
+        case 0xDB:  // VCOM_DETECT
+        case 0x8D:  // CHARGE_PUMP
+            return 1;
+    }
+    if (cmd[0] >= 0xB0 && cmd[0] <= 0xB7) {  // PAM_PAGE_ADDR
+        I2cDisplay.page = cmd[0] & 0x07;
+    } else if (cmd[0] <= 0x0F) {  // PAM_SETCOLUMN_LSB
+        I2cDisplay.column = (I2cDisplay.column & 0xF0) | cmd[0];
+    } else if (cmd[0] <= 0x1F) {  // PAM_SETCOLUMN_MSB
+        I2cDisplay.column = (I2cDisplay.column & 0x0F) | (cmd[0] & 0x0F) << 4;
+    }
+    return 0;
+}
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    I2cStats.transactions++;
+    I2cStats.bytes += length + 1;
+
+    bus_ns += (length + 1) * I2C_MOCK_NS_PER_BYTE;
+    advance_time(bus_ns / 1000000);
+    bus_ns %= 1000000;
+
+    if (I2cFailAt && I2cStats.transactions >= I2cFailAt) {
+        return I2C_STATUS_ERROR;
+    }
+
+    if (length == 0) {
+        return I2C_STATUS_SUCCESS;
+    }
+    if (data[0] == 0x40) {
+        for (uint16_t i = 1; i < length; i++) {
+            write_data(data[i]);
+        }
+    } else {
+        for (uint16_t i = 1; i < length; i++) {
+            i += write_command(&data[i], length - i);
+        }
+    }
+    return I2C_STATUS_SUCCESS;
+}
+
+i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    uint8_t packet[length + 1];
+    packet[0] = regaddr;
+    memcpy(&packet[1], data, length);
+    return i2c_transmit(devaddr, packet, length + 1, timeout);
+}
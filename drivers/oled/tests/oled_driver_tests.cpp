@@ -0,0 +1,213 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include <iostream>
+
+extern "C" {
+#include "i2c_master.h"
+#include "oled_driver.h"
+#include "timer.h"
+
+extern uint8_t         oled_buffer[OLED_MATRIX_SIZE];
+extern OLED_BLOCK_TYPE oled_dirty;
+}
+
+#define PAGES (OLED_DISPLAY_HEIGHT / 8)
+
+// The rotation the driver used before the table-driven transpose
+static uint8_t crot(uint8_t a, int8_t n) {
+    const uint8_t mask = 0x7;
+    n &= mask;
+    return a << n | a >> (-n & mask);
+}
+
+static void reference_rotate_90(const uint8_t *src, uint8_t *dest) {
+    for (uint8_t i = 0, shift = 7; i < 8; ++i, --shift) {
+        uint8_t selector = (1 << i);
+        for (uint8_t j = 0; j < 8; ++j) {
+            dest[i] |= crot(src[j] & selector, shift - (int8_t)j);
+        }
+    }
+}
+
+class OledDriver : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        i2c_mock_reset();
+        timer_clear();
+    }
+
+    void init(oled_rotation_t rotation) {
+        ASSERT_TRUE(oled_init(rotation));
+        render_frame();
+    }
+
+    // Calls oled_render() until nothing is dirty, returns the number of calls
+    int render_frame() {
+        int calls = 0;
+        while (oled_dirty && calls < 64) {
+            oled_render();
+            calls++;
+        }
+        return calls;
+    }
+
+    void expect_display_matches() {
+        for (uint8_t page = 0; page < PAGES; page++) {
+            for (uint8_t column = 0; column < OLED_DISPLAY_WIDTH; column++) {
+                ASSERT_EQ(oled_buffer[page * OLED_DISPLAY_WIDTH + column], I2cDisplay.ram[page][column]) << "page " << (int)page << " column " << (int)column;
+            }
+        }
+    }
+
+    // Display memory as the previous one block per call renderer produced it in 90 degree rotation
+    void expect_display_matches_90() {
+        const uint8_t source_map[] = OLED_SOURCE_MAP;
+        const uint8_t target_map[] = OLED_TARGET_MAP;
+
+        for (uint8_t block = 0; block < OLED_BLOCK_COUNT; block++) {
+            uint8_t rotated[OLED_BLOCK_SIZE] = {0};
+            for (uint8_t i = 0; i < sizeof(source_map); ++i) {
+                reference_rotate_90(&oled_buffer[OLED_BLOCK_SIZE * block + source_map[i]], &rotated[target_map[i]]);
+            }
+
+            uint8_t first_column = OLED_BLOCK_SIZE * block / OLED_DISPLAY_HEIGHT * 8;
+            for (uint8_t i = 0; i < OLED_BLOCK_SIZE; i++) {
+                ASSERT_EQ(rotated[i], I2cDisplay.ram[i / 8][first_column + i % 8]) << "block " << (int)block << " byte " << (int)i;
+            }
+        }
+    }
+
+    void draw(uint8_t seed) {
+        for (uint16_t i = 0; i < OLED_MATRIX_SIZE; i++) {
+            oled_write_raw_byte((char)(i * 31 + seed), i);
+        }
+    }
+};
+
+TEST_F(OledDriver, RendersFullFrame) {
+    init(OLED_ROTATION_0);
+    draw(1);
+    render_frame();
+    expect_display_matches();
+}
+
+TEST_F(OledDriver, RendersText) {
+    init(OLED_ROTATION_0);
+    oled_set_cursor(3, 1);
+    oled_write("Layer: Lower", false);
+    oled_set_cursor(20, 2);
+    oled_write("wraps across pages", true);
+    render_frame();
+    expect_display_matches();
+}
+
+// 90 degree rotation relies on horizontal addressing, which the SH1106 lacks
+#if (OLED_IC != OLED_IC_SH1106)
+TEST_F(OledDriver, RendersRotated) {
+    init(OLED_ROTATION_90);
+    draw(7);
+    render_frame();
+    expect_display_matches_90();
+
+    oled_write_pixel(3, 100, true);
+    oled_write_pixel(30, 5, true);
+    render_frame();
+    expect_display_matches_90();
+}
+#endif
+
+#ifdef OLED_RENDER_BATCH
+TEST_F(OledDriver, FullFrameIsOneWindow) {
+    init(OLED_ROTATION_0);
+    draw(3);
+
+    I2cStats = {};
+    EXPECT_EQ(1, render_frame());
+#    if (OLED_IC == OLED_IC_SH1106)
+    // Page addressing does not wrap, so one window per page
+    EXPECT_EQ(2u * PAGES, I2cStats.transactions);
+#    else
+    // Addressing command plus a single data transfer
+    EXPECT_EQ(2u, I2cStats.transactions);
+#    endif
+    expect_display_matches();
+}
+
+TEST_F(OledDriver, SplitsWindowsAtPages) {
+    init(OLED_ROTATION_0);
+
+    // From the last block of page 0 to the middle of page 2
+    for (uint16_t i = 3 * OLED_BLOCK_SIZE; i < 10 * OLED_BLOCK_SIZE; i++) {
+        oled_write_raw_byte((char)(i + 1), i);
+    }
+    // A separate run on the last page
+    oled_write_raw_byte(0x55, OLED_MATRIX_SIZE - 1);
+
+    I2cStats = {};
+    EXPECT_EQ(1, render_frame());
+    // Tail of page 0, page 1, head of page 2, then the last block
+    EXPECT_EQ(8u, I2cStats.transactions);
+    expect_display_matches();
+}
+
+TEST_F(OledDriver, FailedWindowStaysDirty) {
+    init(OLED_ROTATION_0);
+    draw(5);
+
+    I2cStats  = {};
+    I2cFailAt = 2;
+    oled_render();
+    EXPECT_EQ(OLED_BLOCK_TYPE(~0), oled_dirty);
+
+    I2cFailAt = 0;
+    render_frame();
+    expect_display_matches();
+}
+
+TEST_F(OledDriver, Benchmark) {
+    init(OLED_ROTATION_0);
+    draw(9);
+    I2cStats = {};
+    render_frame();
+    std::cout << "[   INFO   ] full frame: " << I2cStats.transactions << " transactions, " << I2cStats.bytes << " bytes, " << oled_render_time() << " ms" << std::endl;
+
+    oled_set_cursor(0, 0);
+    oled_write("42", false);
+    I2cStats = {};
+    render_frame();
+    std::cout << "[   INFO   ] two characters: " << I2cStats.transactions << " transactions, " << I2cStats.bytes << " bytes, " << oled_render_time() << " ms" << std::endl;
+
+#    if (OLED_IC != OLED_IC_SH1106)
+    init(OLED_ROTATION_90);
+    draw(11);
+    I2cStats = {};
+    render_frame();
+    std::cout << "[   INFO   ] rotated full frame: " << I2cStats.transactions << " transactions, " << I2cStats.bytes << " bytes, " << oled_render_time() << " ms" << std::endl;
+#    endif
+}
+#else
+TEST_F(OledDriver, RendersOneBlockPerCall) {
+    init(OLED_ROTATION_0);
+    draw(3);
+
+    I2cStats = {};
+    EXPECT_EQ(OLED_BLOCK_COUNT, render_frame());
+    EXPECT_EQ(2u * OLED_BLOCK_COUNT, I2cStats.transactions);
+    std::cout << "[   INFO   ] full frame: " << OLED_BLOCK_COUNT << " oled_render() calls, " << I2cStats.transactions << " transactions, " << I2cStats.bytes << " bytes" << std::endl;
+}
+#endif
@@ -0,0 +1,17 @@
+OLED_TESTS_PATH := $(DRIVER_PATH)/oled/tests
+
+oled_driver_DEFS := -DNO_PRINT
+oled_driver_INC := $(OLED_TESTS_PATH) $(DRIVER_PATH)/oled
+oled_driver_SRC := \
+	$(OLED_TESTS_PATH)/oled_driver_tests.cpp \
+	$(OLED_TESTS_PATH)/i2c_master_mock.c \
+	$(TMK_PATH)/common/test/timer.c \
+	$(DRIVER_PATH)/oled/oled_driver.c
+
+oled_driver_batch_DEFS := $(oled_driver_DEFS) -DOLED_RENDER_BATCH
+oled_driver_batch_INC := $(oled_driver_INC)
+oled_driver_batch_SRC := $(oled_driver_SRC)
+
+oled_driver_sh1106_DEFS := $(oled_driver_batch_DEFS) -DOLED_IC=OLED_IC_SH1106
+oled_driver_sh1106_INC := $(oled_driver_INC)
+oled_driver_sh1106_SRC := $(oled_driver_SRC)
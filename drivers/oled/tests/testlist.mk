@@ -0,0 +1,4 @@
+TEST_LIST +=\
+	oled_driver\
+	oled_driver_batch\
+	oled_driver_sh1106
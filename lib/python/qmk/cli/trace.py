@@ -0,0 +1,41 @@
+"""Decode an event trace captured from the keyboard's console.
+"""
+import sys
+
+from milc import cli
+
+import qmk.path
+import qmk.trace
+
+
+@cli.argument('filename', arg_only=True, help='Capture of the console output, - for stdin')
+@cli.subcommand('Decode the event trace of a keyboard built with TRACE_ENABLE.', hidden=False if cli.config.user.developer else True)
+def trace(cli):
+    """Print the records of a trace capture with their timestamps, and any text printed in between.
+
+    The time since the previous record is shown after the timestamp, so for example the latency from a key press to its report can be read off directly.
+    """
+    if cli.args.filename == '-':
+        capture = sys.stdin.buffer.read()
+    else:
+        path = qmk.path.normpath(cli.args.filename)
+
+        if not path.exists():
+            cli.log.error('Capture file does not exist: %s', path)
+            return False
+
+        capture = path.read_bytes()
+
+    last_time = None
+
+    for item in qmk.trace.decode(capture):
+        if isinstance(item, str):
+            for line in item.splitlines():
+                print('# ' + line)
+            continue
+
+        delta = 0 if last_time is None else (item.time - last_time) & 0xFFFFFFFF
+        last_time = item.time
+        print('%10d ms %+6d ms  %s' % (item.time, delta, qmk.trace.describe(item)))
+
+    return True
@@ -0,0 +1,34 @@
+import qmk.trace
+
+# The record tmk_core/common/test/console_buffer_tests.cpp expects from trace_event(TRACE_KEY_PRESS, 0x0203) at 0x01020304 ms
+KEY_PRESS_RECORD = bytes([0x1E, 0x81, 0x86, 0x88, 0xA0, 0xB0, 0xC0, 0xC0, 0x80])
+
+
+def test_decode_firmware_record():
+    assert list(qmk.trace.decode(KEY_PRESS_RECORD)) == [qmk.trace.TraceRecord(qmk.trace.KEY_PRESS, 0x0203, 0x01020304)]
+
+
+def test_encode_matches_firmware():
+    assert qmk.trace.encode(qmk.trace.KEY_PRESS, 0x0203, 0x01020304) == KEY_PRESS_RECORD
+
+
+def test_decode_round_trip():
+    records = [qmk.trace.TraceRecord(t, d, time) for t, d, time in [(1, 0, 0), (4, 0xFFFF, 0xFFFFFFFF), (0x85, 0x1234, 123456)]]
+    capture = b''.join(qmk.trace.encode(*record) for record in records)
+    assert list(qmk.trace.decode(capture)) == records
+
+
+def test_decode_keeps_text_and_drops_padding():
+    capture = b'hello\n\0\0\0' + qmk.trace.encode(qmk.trace.LAYER, 0x0102, 5) + b'wor' + b'\0' * 29 + b'ld\n'
+    assert list(qmk.trace.decode(capture)) == ['hello\n', qmk.trace.TraceRecord(qmk.trace.LAYER, 0x0102, 5), 'world\n']
+
+
+def test_decode_text_that_looks_like_sync():
+    # A record separator in text is only a record when 8 high bytes follow
+    assert list(qmk.trace.decode(b'a\x1eb')) == ['a\x1eb']
+
+
+def test_describe():
+    assert qmk.trace.describe(qmk.trace.TraceRecord(qmk.trace.KEY_PRESS, 0x0203, 0)) == 'key press row 2 col 3'
+    assert qmk.trace.describe(qmk.trace.TraceRecord(qmk.trace.REPORT, 0x0402, 0)) == 'report mods 0x02 key 0x04'
+    assert qmk.trace.describe(qmk.trace.TraceRecord(qmk.trace.USER + 1, 7, 0)) == 'user 1 data 0x0007'
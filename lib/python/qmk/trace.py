@@ -0,0 +1,72 @@
+"""Decode the event trace written to the console by firmware built with `TRACE_ENABLE = yes`.
+
+The record format is documented in tmk_core/common/trace.h.
+"""
+from collections import namedtuple
+
+TRACE_SYNC = 0x1E
+RECORD_SIZE = 9
+
+KEY_PRESS = 1
+KEY_RELEASE = 2
+LAYER = 3
+REPORT = 4
+USER = 0x80
+
+TraceRecord = namedtuple('TraceRecord', ['type', 'data', 'time'])
+
+
+def encode(type, data, time):
+    """Returns the bytes trace_event() writes for a record, for tests.
+    """
+    value = type | data << 8 | time << 24
+    return bytes([TRACE_SYNC] + [0x80 | (value >> (7 * i)) & 0x7F for i in range(RECORD_SIZE - 1)])
+
+
+def decode(capture):
+    """Split a capture of the console output into text and trace records.
+
+    Yields a str for each run of text in between records, and a TraceRecord for each record. The zero bytes console reports are padded with are dropped.
+    """
+    text = bytearray()
+    i = 0
+
+    while i < len(capture):
+        record = capture[i + 1:i + RECORD_SIZE]
+
+        if capture[i] == TRACE_SYNC and len(record) == RECORD_SIZE - 1 and all(b & 0x80 for b in record):
+            if text:
+                yield text.decode('utf-8', errors='replace')
+                text = bytearray()
+
+            value = sum((b & 0x7F) << (7 * n) for n, b in enumerate(record))
+            yield TraceRecord(value & 0xFF, (value >> 8) & 0xFFFF, value >> 24)
+            i += RECORD_SIZE
+
+        else:
+            if capture[i]:
+                text.append(capture[i])
+            i += 1
+
+    if text:
+        yield text.decode('utf-8', errors='replace')
+
+
+def describe(record):
+    """Returns a human readable description of a TraceRecord.
+    """
+    high, low = record.data >> 8, record.data & 0xFF
+
+    if record.type in (KEY_PRESS, KEY_RELEASE):
+        return 'key %s row %d col %d' % ('press' if record.type == KEY_PRESS else 'release', high, low)
+
+    if record.type == LAYER:
+        return 'layer %d default %d' % (low, high)
+
+    if record.type == REPORT:
+        return 'report mods 0x%02X key 0x%02X' % (low, high)
+
+    if record.type >= USER:
+        return 'user %d data 0x%04X' % (record.type - USER, record.data)
+
+    return 'unknown type %d data 0x%04X' % (record.type, record.data)
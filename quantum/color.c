@@ -106,6 +106,120 @@ RGB hsv_to_rgb(HSV hsv) {
 
 RGB hsv_to_rgb_nocie(HSV hsv) { return hsv_to_rgb_impl(hsv, false); }
 
+// clang-format off
+
+// The region (high byte) and remainder (low byte) hsv_to_rgb_impl() works out for each hue,
+// with region 6 folded into region 0 as both give the same channel order
+static const uint16_t hsv_hue_regions[256] PROGMEM = {
+    0x000, 0x006, 0x00C, 0x012, 0x018, 0x01E, 0x024, 0x02A,
+    0x030, 0x036, 0x03C, 0x042, 0x048, 0x04E, 0x054, 0x05A,
+    0x060, 0x066, 0x06C, 0x072, 0x078, 0x07E, 0x084, 0x08A,
+    0x090, 0x096, 0x09C, 0x0A2, 0x0A8, 0x0AE, 0x0B4, 0x0BA,
+    0x0C0, 0x0C6, 0x0CC, 0x0D2, 0x0D8, 0x0DE, 0x0E4, 0x0EA,
+    0x0F0, 0x0F6, 0x0FC, 0x103, 0x109, 0x10F, 0x115, 0x11B,
+    0x121, 0x127, 0x12D, 0x133, 0x139, 0x13F, 0x145, 0x14B,
+    0x151, 0x157, 0x15D, 0x163, 0x169, 0x16F, 0x175, 0x17B,
+    0x181, 0x187, 0x18D, 0x193, 0x199, 0x19F, 0x1A5, 0x1AB,
+    0x1B1, 0x1B7, 0x1BD, 0x1C3, 0x1C9, 0x1CF, 0x1D5, 0x1DB,
+    0x1E1, 0x1E7, 0x1ED, 0x1F3, 0x1F9, 0x200, 0x206, 0x20C,
+    0x212, 0x218, 0x21E, 0x224, 0x22A, 0x230, 0x236, 0x23C,
+    0x242, 0x248, 0x24E, 0x254, 0x25A, 0x260, 0x266, 0x26C,
+    0x272, 0x278, 0x27E, 0x284, 0x28A, 0x290, 0x296, 0x29C,
+    0x2A2, 0x2A8, 0x2AE, 0x2B4, 0x2BA, 0x2C0, 0x2C6, 0x2CC,
+    0x2D2, 0x2D8, 0x2DE, 0x2E4, 0x2EA, 0x2F0, 0x2F6, 0x2FC,
+    0x303, 0x309, 0x30F, 0x315, 0x31B, 0x321, 0x327, 0x32D,
+    0x333, 0x339, 0x33F, 0x345, 0x34B, 0x351, 0x357, 0x35D,
+    0x363, 0x369, 0x36F, 0x375, 0x37B, 0x381, 0x387, 0x38D,
+    0x393, 0x399, 0x39F, 0x3A5, 0x3AB, 0x3B1, 0x3B7, 0x3BD,
+    0x3C3, 0x3C9, 0x3CF, 0x3D5, 0x3DB, 0x3E1, 0x3E7, 0x3ED,
+    0x3F3, 0x3F9, 0x400, 0x406, 0x40C, 0x412, 0x418, 0x41E,
+    0x424, 0x42A, 0x430, 0x436, 0x43C, 0x442, 0x448, 0x44E,
+    0x454, 0x45A, 0x460, 0x466, 0x46C, 0x472, 0x478, 0x47E,
+    0x484, 0x48A, 0x490, 0x496, 0x49C, 0x4A2, 0x4A8, 0x4AE,
+    0x4B4, 0x4BA, 0x4C0, 0x4C6, 0x4CC, 0x4D2, 0x4D8, 0x4DE,
+    0x4E4, 0x4EA, 0x4F0, 0x4F6, 0x4FC, 0x503, 0x509, 0x50F,
+    0x515, 0x51B, 0x521, 0x527, 0x52D, 0x533, 0x539, 0x53F,
+    0x545, 0x54B, 0x551, 0x557, 0x55D, 0x563, 0x569, 0x56F,
+    0x575, 0x57B, 0x581, 0x587, 0x58D, 0x593, 0x599, 0x59F,
+    0x5A5, 0x5AB, 0x5B1, 0x5B7, 0x5BD, 0x5C3, 0x5C9, 0x5CF,
+    0x5D5, 0x5DB, 0x5E1, 0x5E7, 0x5ED, 0x5F3, 0x5F9, 0x000,
+};
+
+// clang-format on
+
+static inline RGB hsv_to_rgb_region(HSV hsv, uint8_t v) {
+    RGB      rgb;
+    uint16_t entry     = pgm_read_word(&hsv_hue_regions[hsv.h]);
+    uint8_t  region    = entry >> 8;
+    uint8_t  remainder = entry & 0xFF;
+    uint8_t  p, q, t;
+
+    p = (v * (255 - hsv.s)) >> 8;
+#ifdef __AVR__
+    q = (v * (255 - ((hsv.s * remainder) >> 8))) >> 8;
+    t = (v * (255 - ((hsv.s * (255 - remainder)) >> 8))) >> 8;
+#else
+    // Work out q and t together, one in each half of a 32 bit word, every product fits in 16 bits
+    uint32_t lanes = (((uint32_t)(255 - remainder) << 16) | remainder) * hsv.s;
+    lanes          = 0x00FF00FF - ((lanes >> 8) & 0x00FF00FF);
+    lanes          = ((lanes * v) >> 8) & 0x00FF00FF;
+    q              = lanes;
+    t              = lanes >> 16;
+#endif
+
+    switch (region) {
+        case 0:
+            rgb.r = v;
+            rgb.g = t;
+            rgb.b = p;
+            break;
+        case 1:
+            rgb.r = q;
+            rgb.g = v;
+            rgb.b = p;
+            break;
+        case 2:
+            rgb.r = p;
+            rgb.g = v;
+            rgb.b = t;
+            break;
+        case 3:
+            rgb.r = p;
+            rgb.g = q;
+            rgb.b = v;
+            break;
+        case 4:
+            rgb.r = t;
+            rgb.g = p;
+            rgb.b = v;
+            break;
+        default:
+            rgb.r = v;
+            rgb.g = p;
+            rgb.b = q;
+            break;
+    }
+
+    return rgb;
+}
+
+void hsv_to_rgb_batch(const HSV *hsv, RGB *rgb, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+#ifdef USE_CIE1931_CURVE
+        uint8_t v = pgm_read_byte(&CIE1931_CURVE[hsv[i].v]);
+#else
+        uint8_t v = hsv[i].v;
+#endif
+        if (hsv[i].s == 0) {
+            rgb[i].r = v;
+            rgb[i].g = v;
+            rgb[i].b = v;
+        } else {
+            rgb[i] = hsv_to_rgb_region(hsv[i], v);
+        }
+    }
+}
+
 #ifdef RGBW
 #    ifndef MIN
 #        define MIN(a, b) ((a) < (b) ? (a) : (b))
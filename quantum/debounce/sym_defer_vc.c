@@ -0,0 +1,95 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Symmetric per-key algorithm using vertical counters, see vertical_counter.h.
+Behaves like sym_defer_pk: when no state changes have occured on a key for
+DEBOUNCE milliseconds, its state is pushed. Counter RAM is a fixed
+VC_PLANES words per row and no heap is used.
+*/
+
+#include "matrix.h"
+#include "timer.h"
+#include "quantum.h"
+#include "vertical_counter.h"
+#include <string.h>
+
+#if DEBOUNCE > 0
+static matrix_row_t debounce_counters[MATRIX_ROWS][VC_PLANES];
+static bool         counters_need_update;
+static uint16_t     last_time;
+
+// we use num_rows rather than MATRIX_ROWS to support split keyboards
+void debounce_init(uint8_t num_rows) {
+    memset(debounce_counters, 0, sizeof(debounce_counters));
+    counters_need_update = false;
+    last_time            = timer_read();
+}
+
+static void update_debounce_counters_and_transfer_if_expired(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, uint8_t ticks) {
+    counters_need_update = false;
+    for (uint8_t row = 0; row < num_rows; row++) {
+        matrix_row_t active = vertical_counter_active(debounce_counters[row]);
+        if (!active) {
+            continue;
+        }
+        matrix_row_t expired = vertical_counter_add(debounce_counters[row], active, ticks);
+        if (expired) {
+            vertical_counter_stop(debounce_counters[row], expired);
+            cooked[row] = (cooked[row] & ~expired) | (raw[row] & expired);
+        }
+        if (active & ~expired) {
+            counters_need_update = true;
+        }
+    }
+}
+
+static void start_debounce_counters(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows) {
+    for (uint8_t row = 0; row < num_rows; row++) {
+        matrix_row_t delta  = raw[row] ^ cooked[row];
+        matrix_row_t active = vertical_counter_active(debounce_counters[row]);
+        vertical_counter_stop(debounce_counters[row], ~delta);
+        vertical_counter_start(debounce_counters[row], delta & ~active);
+        if (delta) {
+            counters_need_update = true;
+        }
+    }
+}
+
+void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    uint16_t now     = timer_read();
+    uint16_t elapsed = TIMER_DIFF_16(now, last_time);
+    last_time        = now;
+
+    if (counters_need_update) {
+        update_debounce_counters_and_transfer_if_expired(raw, cooked, num_rows, elapsed > DEBOUNCE ? DEBOUNCE : elapsed);
+    }
+
+    if (changed) {
+        start_debounce_counters(raw, cooked, num_rows);
+    }
+}
+#else  // no debouncing.
+void debounce_init(uint8_t num_rows) {}
+
+void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    for (int i = 0; i < num_rows; i++) {
+        cooked[i] = raw[i];
+    }
+}
+#endif
+
+bool debounce_active(void) { return true; }
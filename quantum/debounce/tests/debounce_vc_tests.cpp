@@ -0,0 +1,211 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <random>
+
+extern "C" {
+#include "matrix.h"
+#include "debounce.h"
+#include "timer.h"
+
+void reference_debounce_init(uint8_t num_rows);
+void reference_debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed);
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+// Generates raw matrix scans where keys are pressed and released at random,
+// bouncing for a random number of scans around every transition.
+class BounceTrace {
+   public:
+    explicit BounceTrace(uint32_t seed) : rng(seed) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            state[row] = 0;
+            raw[row]   = 0;
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                bouncing[row][col] = 0;
+            }
+        }
+    }
+
+    // Produces the next scan, returns whether it differs from the previous one
+    bool next(void) {
+        bool changed = false;
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            matrix_row_t previous = raw[row];
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                matrix_row_t mask = MATRIX_ROW_SHIFTER << col;
+                if (bouncing[row][col]) {
+                    bouncing[row][col]--;
+                    raw[row] = (raw[row] & ~mask) | (rng() & 1 ? mask : 0);
+                    if (!bouncing[row][col]) {
+                        raw[row] = (raw[row] & ~mask) | (state[row] & mask);
+                    }
+                } else if (rng() % 64 == 0) {
+                    state[row] ^= mask;
+                    bouncing[row][col] = rng() % (DEBOUNCE * 2 + 2);
+                    raw[row]           = (raw[row] & ~mask) | (state[row] & mask);
+                }
+            }
+            changed |= raw[row] != previous;
+        }
+        return changed;
+    }
+
+    // Milliseconds until the next scan, scans are often faster than the timer
+    uint8_t gap(void) { return rng() % 3; }
+
+    matrix_row_t raw[MATRIX_ROWS];
+
+   private:
+    std::mt19937 rng;
+    matrix_row_t state[MATRIX_ROWS];
+    uint8_t      bouncing[MATRIX_ROWS][MATRIX_COLS];
+};
+
+class DebounceVC : public testing::Test {
+   protected:
+    void SetUp() override {
+        set_time(0);
+        debounce_init(MATRIX_ROWS);
+        reference_debounce_init(MATRIX_ROWS);
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            raw[row]       = 0;
+            cooked[row]    = 0;
+            reference[row] = 0;
+        }
+    }
+
+    void scan(bool changed) {
+        debounce(raw, cooked, MATRIX_ROWS, changed);
+        reference_debounce(raw, reference, MATRIX_ROWS, changed);
+    }
+
+    matrix_row_t raw[MATRIX_ROWS];
+    matrix_row_t cooked[MATRIX_ROWS];
+    matrix_row_t reference[MATRIX_ROWS];
+};
+
+TEST_F(DebounceVC, MatchesReferenceOnRandomBounceTraces) {
+    for (uint32_t seed = 1; seed <= 8; seed++) {
+        SetUp();
+        BounceTrace trace(seed);
+        for (uint32_t i = 0; i < 20000; i++) {
+            bool changed = trace.next();
+            for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                raw[row] = trace.raw[row];
+            }
+            scan(changed);
+            for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                ASSERT_EQ(reference[row], cooked[row]) << "seed " << seed << " scan " << i << " row " << (int)row;
+            }
+            advance_time(trace.gap());
+        }
+    }
+}
+
+TEST_F(DebounceVC, LongIdleGapsDoNotWrap) {
+    raw[3] = 0x0100;
+    scan(true);
+    advance_time(70000);
+    scan(false);
+    EXPECT_EQ(0x0100, cooked[3]);
+    EXPECT_EQ(reference[3], cooked[3]);
+}
+
+#ifdef DEBOUNCE_EAGER
+TEST_F(DebounceVC, PressIsReportedImmediatelyAndLocked) {
+    raw[0] = 0x0001;
+    scan(true);
+    EXPECT_EQ(0x0001, cooked[0]);
+
+    // Bounces inside the lock out window are ignored
+    advance_time(DEBOUNCE - 1);
+    raw[0] = 0;
+    scan(true);
+    EXPECT_EQ(0x0001, cooked[0]);
+
+    // and picked up once it has passed
+    advance_time(1);
+    scan(false);
+    EXPECT_EQ(0, cooked[0]);
+}
+#else
+TEST_F(DebounceVC, PressIsReportedAfterDebounce) {
+    raw[0] = 0x0001;
+    scan(true);
+    advance_time(DEBOUNCE - 1);
+    scan(false);
+    EXPECT_EQ(0, cooked[0]);
+
+    advance_time(1);
+    scan(false);
+    EXPECT_EQ(0x0001, cooked[0]);
+}
+
+TEST_F(DebounceVC, BounceRestartsTheCounter) {
+    raw[0] = 0x0001;
+    scan(true);
+    advance_time(DEBOUNCE - 1);
+    raw[0] = 0;
+    scan(true);
+    raw[0] = 0x0001;
+    scan(true);
+    advance_time(DEBOUNCE - 1);
+    scan(false);
+    EXPECT_EQ(0, cooked[0]);
+
+    advance_time(1);
+    scan(false);
+    EXPECT_EQ(0x0001, cooked[0]);
+}
+#endif
+
+TEST_F(DebounceVC, Benchmark) {
+    const uint32_t scans = 200000;
+    matrix_row_t   trace_raw[256][MATRIX_ROWS];
+    bool           trace_changed[256];
+    BounceTrace    trace(42);
+    for (uint16_t i = 0; i < 256; i++) {
+        trace_changed[i] = trace.next();
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            trace_raw[i][row] = trace.raw[row];
+        }
+    }
+
+    auto run = [&](void (*algorithm)(matrix_row_t[], matrix_row_t[], uint8_t, bool)) {
+        SetUp();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < scans; i++) {
+            algorithm(trace_raw[i & 0xFF], cooked, MATRIX_ROWS, trace_changed[i & 0xFF]);
+            advance_time(i & 1);
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / scans;
+    };
+
+    double vertical = run(debounce);
+    double byte     = run(reference_debounce);
+    printf("[   INFO   ] %ux%u matrix, busy trace: vertical counters %.1f ns/scan, byte counters %.1f ns/scan\n", MATRIX_ROWS, MATRIX_COLS, vertical, byte);
+}
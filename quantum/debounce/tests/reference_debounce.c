@@ -0,0 +1,32 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Builds the byte counter algorithm the vertical counter one is checked
+// against under different names, so both can be linked into one test.
+
+#define debounce reference_debounce
+#define debounce_init reference_debounce_init
+#define debounce_active reference_debounce_active
+#define update_debounce_counters reference_update_debounce_counters
+#define update_debounce_counters_and_transfer_if_expired reference_update_debounce_counters_and_transfer_if_expired
+#define start_debounce_counters reference_start_debounce_counters
+#define transfer_matrix_values reference_transfer_matrix_values
+
+#ifdef DEBOUNCE_EAGER
+#    include "sym_eager_pk.c"
+#else
+#    include "sym_defer_pk.c"
+#endif
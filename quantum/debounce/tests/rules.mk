@@ -0,0 +1,17 @@
+DEBOUNCE_TESTS_PATH := $(QUANTUM_PATH)/debounce/tests
+
+debounce_sym_defer_vc_DEFS := -DNO_PRINT -DMATRIX_ROWS=8 -DMATRIX_COLS=16
+debounce_sym_defer_vc_INC := $(DEBOUNCE_TESTS_PATH) $(QUANTUM_PATH)/debounce
+debounce_sym_defer_vc_SRC := \
+	$(DEBOUNCE_TESTS_PATH)/debounce_vc_tests.cpp \
+	$(DEBOUNCE_TESTS_PATH)/reference_debounce.c \
+	$(TMK_PATH)/common/test/timer.c \
+	$(QUANTUM_PATH)/debounce/sym_defer_vc.c
+
+debounce_sym_eager_vc_DEFS := $(debounce_sym_defer_vc_DEFS) -DDEBOUNCE_EAGER
+debounce_sym_eager_vc_INC := $(debounce_sym_defer_vc_INC)
+debounce_sym_eager_vc_SRC := \
+	$(DEBOUNCE_TESTS_PATH)/debounce_vc_tests.cpp \
+	$(DEBOUNCE_TESTS_PATH)/reference_debounce.c \
+	$(TMK_PATH)/common/test/timer.c \
+	$(QUANTUM_PATH)/debounce/sym_eager_vc.c
@@ -0,0 +1,3 @@
+TEST_LIST +=\
+	debounce_sym_defer_vc\
+	debounce_sym_eager_vc
@@ -0,0 +1,91 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+Vertical counters for the *_vc debounce algorithms.
+Bit n of every key's counter is kept in plane n, one matrix_row_t per plane,
+so a whole row of counters is advanced with a few bitwise operations.
+A counter is idle at zero. It starts at 2^VC_PLANES - DEBOUNCE and carries
+out of the top plane once DEBOUNCE milliseconds have been added to it.
+*/
+
+#pragma once
+
+#include "matrix.h"
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+#if DEBOUNCE < 2
+#    define VC_PLANES 1
+#elif DEBOUNCE < 4
+#    define VC_PLANES 2
+#elif DEBOUNCE < 8
+#    define VC_PLANES 3
+#elif DEBOUNCE < 16
+#    define VC_PLANES 4
+#elif DEBOUNCE < 32
+#    define VC_PLANES 5
+#elif DEBOUNCE < 64
+#    define VC_PLANES 6
+#elif DEBOUNCE < 128
+#    define VC_PLANES 7
+#elif DEBOUNCE < 256
+#    define VC_PLANES 8
+#else
+#    error "DEBOUNCE must be below 256 for vertical counters"
+#endif
+
+#define VC_START ((1 << VC_PLANES) - DEBOUNCE)
+
+// Keys of the row whose counter is running
+static inline matrix_row_t vertical_counter_active(const matrix_row_t planes[]) {
+    matrix_row_t active = 0;
+    for (uint8_t i = 0; i < VC_PLANES; i++) {
+        active |= planes[i];
+    }
+    return active;
+}
+
+// Adds ticks, at most DEBOUNCE, to the counters in mask and returns the ones that expired
+static inline matrix_row_t vertical_counter_add(matrix_row_t planes[], matrix_row_t mask, uint8_t ticks) {
+    matrix_row_t carry = 0;
+    for (uint8_t i = 0; i < VC_PLANES; i++) {
+        matrix_row_t addend = (ticks & (1 << i)) ? mask : 0;
+        matrix_row_t sum    = planes[i] ^ addend;
+        matrix_row_t next   = (planes[i] & addend) | (carry & sum);
+        planes[i]           = sum ^ carry;
+        carry               = next;
+    }
+    return carry;
+}
+
+static inline void vertical_counter_start(matrix_row_t planes[], matrix_row_t mask) {
+    for (uint8_t i = 0; i < VC_PLANES; i++) {
+        if (VC_START & (1 << i)) {
+            planes[i] |= mask;
+        } else {
+            planes[i] &= ~mask;
+        }
+    }
+}
+
+static inline void vertical_counter_stop(matrix_row_t planes[], matrix_row_t mask) {
+    for (uint8_t i = 0; i < VC_PLANES; i++) {
+        planes[i] &= ~mask;
+    }
+}
@@ -77,14 +77,59 @@
 #    define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + 1)
 #endif
 
+// Optional RAM copy of the lowest layers, so keycode lookups on the hot path
+// don't go to EEPROM. Layers that don't fit in DYNAMIC_KEYMAP_CACHE_SIZE bytes
+// are still read from EEPROM.
+#ifdef DYNAMIC_KEYMAP_CACHE_SIZE
+#    define DYNAMIC_KEYMAP_LAYER_SIZE (MATRIX_ROWS * MATRIX_COLS * 2)
+#    if DYNAMIC_KEYMAP_CACHE_SIZE / DYNAMIC_KEYMAP_LAYER_SIZE < DYNAMIC_KEYMAP_LAYER_COUNT
+#        define DYNAMIC_KEYMAP_CACHE_LAYERS (DYNAMIC_KEYMAP_CACHE_SIZE / DYNAMIC_KEYMAP_LAYER_SIZE)
+#    else
+#        define DYNAMIC_KEYMAP_CACHE_LAYERS DYNAMIC_KEYMAP_LAYER_COUNT
+#    endif
+#    if DYNAMIC_KEYMAP_CACHE_LAYERS == 0
+#        error DYNAMIC_KEYMAP_CACHE_SIZE is too small to hold a single layer
+#    endif
+
+static uint16_t dynamic_keymap_cache[DYNAMIC_KEYMAP_CACHE_LAYERS][MATRIX_ROWS][MATRIX_COLS];
+
+static uint16_t dynamic_keymap_read_keycode(uint8_t layer, uint8_t row, uint8_t column);
+
+void dynamic_keymap_init(void) {
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_CACHE_LAYERS; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t column = 0; column < MATRIX_COLS; column++) {
+                dynamic_keymap_cache[layer][row][column] = dynamic_keymap_read_keycode(layer, row, column);
+            }
+        }
+    }
+}
+
+// Applies a byte of the big-endian EEPROM buffer to the cache
+static void dynamic_keymap_cache_update_byte(uint16_t offset, uint8_t data) {
+    if (offset < DYNAMIC_KEYMAP_CACHE_LAYERS * DYNAMIC_KEYMAP_LAYER_SIZE) {
+        uint16_t *keycode = &dynamic_keymap_cache[0][0][0] + offset / 2;
+        if (offset & 1) {
+            *keycode = (*keycode & 0xFF00) | data;
+        } else {
+            *keycode = (*keycode & 0x00FF) | (data << 8);
+        }
+    }
+}
+#else
+void dynamic_keymap_init(void) {}
+#endif
+
 uint8_t dynamic_keymap_get_layer_count(void) { return DYNAMIC_KEYMAP_LAYER_COUNT; }
 
+uint16_t dynamic_keymap_get_buffer_size(void) { return DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2; }
+
 void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column) {
     // TODO: optimize this with some left shifts
     return ((void *)DYNAMIC_KEYMAP_EEPROM_ADDR) + (layer * MATRIX_ROWS * MATRIX_COLS * 2) + (row * MATRIX_COLS * 2) + (column * 2);
 }
 
-uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column) {
+static uint16_t dynamic_keymap_read_keycode(uint8_t layer, uint8_t row, uint8_t column) {
     void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
     // Big endian, so we can read/write EEPROM directly from host if we want
     uint16_t keycode = eeprom_read_byte(address) << 8;
@@ -92,11 +137,26 @@ uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column)
     return keycode;
 }
 
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column) {
+#ifdef DYNAMIC_KEYMAP_CACHE_SIZE
+    if (layer < DYNAMIC_KEYMAP_CACHE_LAYERS) {
+        return dynamic_keymap_cache[layer][row][column];
+    }
+#endif
+    return dynamic_keymap_read_keycode(layer, row, column);
+}
+
 void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode) {
     void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
     // Big endian, so we can read/write EEPROM directly from host if we want
     eeprom_update_byte(address, (uint8_t)(keycode >> 8));
     eeprom_update_byte(address + 1, (uint8_t)(keycode & 0xFF));
+#ifdef DYNAMIC_KEYMAP_CACHE_SIZE
+    if (layer < DYNAMIC_KEYMAP_CACHE_LAYERS) {
+        dynamic_keymap_cache[layer][row][column] = keycode;
+    }
+#endif
+    invalidate_resolved_layers_cache();
 }
 
 void dynamic_keymap_reset(void) {
@@ -114,7 +174,7 @@ void dynamic_keymap_reset(void) {
 
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   source                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
+    void *   source                     = ((void *)DYNAMIC_KEYMAP_EEPROM_ADDR) + offset;
     uint8_t *target                     = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < dynamic_keymap_eeprom_size) {
@@ -129,15 +189,20 @@ void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
 
 void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   target                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
-    uint8_t *source                     = data;
+    if (offset >= dynamic_keymap_eeprom_size) {
+        return;
+    }
+    if (size > dynamic_keymap_eeprom_size - offset) {
+        size = dynamic_keymap_eeprom_size - offset;
+    }
+    // A single block update, so EEPROM drivers only compare and write once per buffer
+    eeprom_update_block(data, ((void *)DYNAMIC_KEYMAP_EEPROM_ADDR) + offset, size);
+#ifdef DYNAMIC_KEYMAP_CACHE_SIZE
     for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < dynamic_keymap_eeprom_size) {
-            eeprom_update_byte(target, *source);
-        }
-        source++;
-        target++;
+        dynamic_keymap_cache_update_byte(offset + i, data[i]);
     }
+#endif
+    invalidate_resolved_layers_cache();
 }
 
 // This overrides the one in quantum/keymap_common.c
@@ -154,7 +219,7 @@ uint8_t dynamic_keymap_macro_get_count(void) { return DYNAMIC_KEYMAP_MACRO_COUNT
 uint16_t dynamic_keymap_macro_get_buffer_size(void) { return DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE; }
 
 void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   source = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
+    void *   source = ((void *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR) + offset;
     uint8_t *target = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
@@ -168,7 +233,7 @@ void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *da
 }
 
 void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   target = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
+    void *   target = ((void *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR) + offset;
     uint8_t *source = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
@@ -188,6 +253,40 @@ void dynamic_keymap_macro_reset(void) {
     }
 }
 
+#ifdef SEND_STRING_ASYNC_ENABLE
+// Queues the macro starting at p as a single send_string_async() string.
+// Returns false if it does not fit, so that the caller can type it blocking.
+static bool dynamic_keymap_macro_send_async(void *p) {
+    char     data[SEND_STRING_ASYNC_BUFFER_SIZE];
+    uint16_t length = 0;
+    while (1) {
+        char c = eeprom_read_byte(p++);
+        if (c == 0) {
+            break;
+        }
+        if (c == SS_TAP_CODE || c == SS_DOWN_CODE || c == SS_UP_CODE) {
+            char keycode = eeprom_read_byte(p++);
+            if (keycode == 0) {
+                break;
+            }
+            if (length + 3 >= sizeof(data)) {
+                return false;
+            }
+            data[length++] = SS_QMK_PREFIX;
+            data[length++] = c;
+            data[length++] = keycode;
+        } else {
+            if (length + 1 >= sizeof(data)) {
+                return false;
+            }
+            data[length++] = c;
+        }
+    }
+    data[length] = 0;
+    return send_string_async(data, 0, NULL);
+}
+#endif
+
 void dynamic_keymap_macro_send(uint8_t id) {
     if (id >= DYNAMIC_KEYMAP_MACRO_COUNT) {
         return;
@@ -219,6 +318,18 @@ void dynamic_keymap_macro_send(uint8_t id) {
         ++p;
     }
 
+#ifdef SEND_STRING_ASYNC_ENABLE
+    if (dynamic_keymap_macro_send_async(p)) {
+        return;
+    }
+    // Too long for the queue, or the queue is full. Either way it must not
+    // overtake the strings already queued.
+    send_string_async_flush();
+    if (dynamic_keymap_macro_send_async(p)) {
+        return;
+    }
+#endif
+
     // Send the macro string one or three chars at a time
     // by making temporary 1 or 3 char strings
     char data[4] = {0, 0, 0, 0};
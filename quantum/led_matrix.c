@@ -26,6 +26,9 @@
 #include "eeprom.h"
 #include <string.h>
 #include <math.h>
+#ifdef ISSI_ASYNC_FLUSH
+#    include "issi_queue.h"
+#endif
 
 led_config_t led_matrix_config;
 
@@ -148,6 +151,11 @@ void led_matrix_uniform_brightness(void) { led_matrix_set_index_value_all(LED_MA
 void led_matrix_custom(void) {}
 
 void led_matrix_task(void) {
+#ifdef ISSI_ASYNC_FLUSH
+    // Keep sending the writes queued by the last flush
+    issi_queue_task();
+#endif
+
     if (!led_matrix_config.enable) {
         led_matrix_all_off();
         led_matrix_indicators();
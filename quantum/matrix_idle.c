@@ -0,0 +1,171 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "matrix_idle.h"
+#include "deadline.h"
+#include "timer.h"
+
+static bool     matrix_idle;
+static uint16_t matrix_idle_timer;
+
+bool matrix_idle_update(bool active) {
+    if (active) {
+        matrix_idle_timer = timer_read();
+        return false;
+    }
+    return timer_elapsed(matrix_idle_timer) >= MATRIX_IDLE_GRACE_MS;
+}
+
+void matrix_idle_enter(const pin_t *pins, uint8_t count) {
+    matrix_idle_arm_pins(pins, count);
+    matrix_idle = true;
+}
+
+void matrix_idle_leave(void) {
+    matrix_idle_disarm_pins();
+    matrix_idle       = false;
+    matrix_idle_timer = timer_read();
+}
+
+bool matrix_is_idle(void) { return matrix_idle; }
+
+void matrix_idle_wait(void) {
+    uint32_t timeout = deadline_next();
+    if (timeout > MATRIX_IDLE_MAX_SLEEP) {
+        timeout = MATRIX_IDLE_MAX_SLEEP;
+    }
+    if (timeout) {
+        matrix_idle_sleep(timeout);
+    }
+}
+
+#if defined(__AVR__)
+#    include <avr/interrupt.h>
+#    include <avr/sleep.h>
+
+/* Idle sleep keeps USB and the 1ms timer running, so the MCU wakes at
+ * least once per millisecond. Inputs on port B also wake it right away
+ * through PCINT0, other ports are picked up on the next tick.
+ */
+static volatile bool matrix_idle_woken;
+
+#    if defined(PCMSK0) && defined(PCINT0_vect)
+static uint8_t matrix_idle_pcint_mask;
+
+ISR(PCINT0_vect) { matrix_idle_woken = true; }
+#    endif
+
+void matrix_idle_arm_pins(const pin_t *pins, uint8_t count) {
+    matrix_idle_woken = false;
+#    if defined(PCMSK0) && defined(PCINT0_vect)
+    matrix_idle_pcint_mask = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (pins[i] != NO_PIN && (pins[i] >> PORT_SHIFTER) == (B0 >> PORT_SHIFTER)) {
+            matrix_idle_pcint_mask |= _BV(pins[i] & 0xF);
+        }
+    }
+    // Leave pin change interrupts that someone else enabled to their owner
+    matrix_idle_pcint_mask &= ~PCMSK0;
+    if (matrix_idle_pcint_mask) {
+        PCIFR = _BV(PCIF0);
+        PCMSK0 |= matrix_idle_pcint_mask;
+        PCICR |= _BV(PCIE0);
+    }
+#    endif
+}
+
+void matrix_idle_disarm_pins(void) {
+#    if defined(PCMSK0) && defined(PCINT0_vect)
+    PCMSK0 &= ~matrix_idle_pcint_mask;
+    if (!PCMSK0) {
+        PCICR &= ~_BV(PCIE0);
+    }
+#    endif
+}
+
+void matrix_idle_sleep(uint32_t timeout_ms) {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    if (!matrix_idle_woken) {
+        sleep_enable();
+        // sei() takes effect after the next instruction, so a wake up cannot slip in before sleeping
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+    sei();
+    matrix_idle_woken = false;
+}
+
+#elif defined(PROTOCOL_CHIBIOS)
+
+#    if PAL_USE_CALLBACKS
+#        define MATRIX_IDLE_EVENT EVENT_MASK(0)
+
+static thread_t *   matrix_idle_thread;
+static const pin_t *matrix_idle_pins;
+static uint8_t      matrix_idle_pin_count;
+
+static void matrix_idle_pin_cb(void *arg) {
+    chSysLockFromISR();
+    chEvtSignalI(matrix_idle_thread, MATRIX_IDLE_EVENT);
+    chSysUnlockFromISR();
+}
+
+/* On STM32 each EXTI line is shared by the same pin number on every port,
+ * so only one of e.g. A3 and B3 can wake the matrix. Lines that are already
+ * taken, by another matrix pin or by a driver such as the split soft serial,
+ * are left alone and their pins are only polled after each sleep.
+ */
+static uint16_t matrix_idle_lines;
+
+void matrix_idle_arm_pins(const pin_t *pins, uint8_t count) {
+    matrix_idle_thread    = chThdGetSelfX();
+    matrix_idle_pins      = pins;
+    matrix_idle_pin_count = count;
+    matrix_idle_lines     = 0;
+    chEvtGetAndClearEvents(MATRIX_IDLE_EVENT);
+    for (uint8_t i = 0; i < count; i++) {
+        if (pins[i] == NO_PIN || (matrix_idle_lines & (1 << PAL_PAD(pins[i]))) || palIsLineEventEnabled(pins[i])) {
+            continue;
+        }
+        palEnableLineEvent(pins[i], PAL_EVENT_MODE_FALLING_EDGE);
+        palSetLineCallback(pins[i], matrix_idle_pin_cb, NULL);
+        matrix_idle_lines |= 1 << PAL_PAD(pins[i]);
+    }
+}
+
+// The first pin on each owned line is the one that was armed
+void matrix_idle_disarm_pins(void) {
+    for (uint8_t i = 0; i < matrix_idle_pin_count; i++) {
+        if (matrix_idle_pins[i] != NO_PIN && (matrix_idle_lines & (1 << PAL_PAD(matrix_idle_pins[i])))) {
+            palDisableLineEvent(matrix_idle_pins[i]);
+            matrix_idle_lines &= ~(1 << PAL_PAD(matrix_idle_pins[i]));
+        }
+    }
+    matrix_idle_pin_count = 0;
+}
+
+void matrix_idle_sleep(uint32_t timeout_ms) { chEvtWaitAnyTimeout(MATRIX_IDLE_EVENT, TIME_MS2I(timeout_ms)); }
+
+#    else
+// Without PAL callbacks nothing can wake the MCU, so the idle matrix only polls its driven inputs
+void matrix_idle_arm_pins(const pin_t *pins, uint8_t count) {}
+void matrix_idle_disarm_pins(void) {}
+void matrix_idle_sleep(uint32_t timeout_ms) {}
+#    endif
+
+#endif
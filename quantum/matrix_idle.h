@@ -0,0 +1,55 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+/* Matrix idle mode
+ *
+ * Once no key has been down for MATRIX_IDLE_GRACE_MS the matrix drives all
+ * of its outputs at once, arms wake interrupts on its inputs and sleeps in
+ * matrix_scan() instead of scanning. Any key press then pulls an input low,
+ * which wakes the MCU and brings back full rate scanning in the same call.
+ * Inputs that cannot get a wake interrupt of their own are only read after
+ * each sleep, so their first press can take up to MATRIX_IDLE_MAX_SLEEP ms.
+ */
+
+// Must be longer than the debounce time, so that no debounce is pending when the matrix goes idle
+#ifndef MATRIX_IDLE_GRACE_MS
+#    define MATRIX_IDLE_GRACE_MS 50
+#endif
+
+// Longest sleep per matrix_scan(), also bounded by the next deadline
+#ifndef MATRIX_IDLE_MAX_SLEEP
+#    define MATRIX_IDLE_MAX_SLEEP 10
+#endif
+
+// Call after every full scan, returns true once the matrix has been inactive for the grace period
+bool matrix_idle_update(bool active);
+
+// The matrix drives all of its outputs before entering, pins are the inputs to wake on
+void matrix_idle_enter(const pin_t *pins, uint8_t count);
+void matrix_idle_leave(void);
+bool matrix_is_idle(void);
+
+// Sleeps until a wake pin goes low, MATRIX_IDLE_MAX_SLEEP ms or the next deadline
+void matrix_idle_wait(void);
+
+// Platform hooks, NO_PIN entries are skipped
+void matrix_idle_arm_pins(const pin_t *pins, uint8_t count);
+void matrix_idle_disarm_pins(void);
+void matrix_idle_sleep(uint32_t timeout_ms);
@@ -81,20 +81,28 @@ static inline void dump_key_buffer(bool emit) {
         combo->state &= ~(1 << key); \
     } while (0)
 
-static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *record) {
-    uint8_t  count = 0;
-    uint16_t index = -1;
-    /* Find index of keycode and number of combo keys */
-    for (const uint16_t *keys = combo->keys;; ++count) {
-        uint16_t key = pgm_read_word(&keys[count]);
-        if (keycode == key) index = count;
-        if (COMBO_END == key) break;
-    }
-
-    /* Continue processing if not a combo key */
-    if (-1 == (int8_t)index) return false;
+#ifdef COMBO_INDEX_SIZE
+/* Reverse index from keycode to the combos containing it, sorted by keycode
+ * and then combo index, so combos are still processed in declaration order.
+ * Entries are 4 bytes, the key position is looked up again in PROGMEM.
+ */
+typedef struct {
+    uint16_t keycode;
+    uint16_t combo_index;
+} combo_index_entry_t;
+
+static combo_index_entry_t combo_index[COMBO_INDEX_SIZE];
+static uint16_t            combo_index_size  = 0;
+static bool                combo_index_built = false;
+static bool                combo_index_valid = false;
+static uint16_t            combos_with_keys_down = 0;
+#endif
 
+static bool process_combo_key(combo_t *combo, uint8_t index, uint8_t count, keyrecord_t *record) {
     bool is_combo_active = is_active;
+#ifdef COMBO_INDEX_SIZE
+    bool had_keys_down = combo->state != 0;
+#endif
 
     if (record->event.pressed) {
         KEY_STATE_DOWN(index);
@@ -116,9 +124,98 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
         KEY_STATE_UP(index);
     }
 
+#ifdef COMBO_INDEX_SIZE
+    if (had_keys_down != (combo->state != 0)) {
+        combos_with_keys_down += had_keys_down ? -1 : 1;
+    }
+#endif
     return is_combo_active;
 }
 
+static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *record) {
+    uint8_t  count = 0;
+    uint16_t index = -1;
+    /* Find index of keycode and number of combo keys */
+    for (const uint16_t *keys = combo->keys;; ++count) {
+        uint16_t key = pgm_read_word(&keys[count]);
+        if (keycode == key) index = count;
+        if (COMBO_END == key) break;
+    }
+
+    /* Continue processing if not a combo key */
+    if (-1 == (int8_t)index) return false;
+
+    return process_combo_key(combo, index, count, record);
+}
+
+#ifdef COMBO_INDEX_SIZE
+#    ifndef COMBO_VARIABLE_LEN
+#        define COMBO_LEN COMBO_COUNT
+#    endif
+
+void combo_index_init(void) {
+    combo_index_built     = true;
+    combo_index_valid     = true;
+    combo_index_size      = 0;
+    combos_with_keys_down = 0;
+
+    for (uint16_t i = 0; i < COMBO_LEN; ++i) {
+        combo_t *combo = &key_combos[i];
+        uint8_t  count = 0;
+        while (pgm_read_word(&combo->keys[count]) != COMBO_END) {
+            ++count;
+        }
+        if (combo->state) {
+            ++combos_with_keys_down;
+        }
+        for (uint8_t key_index = 0; key_index < count; ++key_index) {
+            uint16_t keycode   = pgm_read_word(&combo->keys[key_index]);
+            bool     duplicate = false;
+            /* like the linear scan, only the last occurrence of a keycode counts */
+            for (uint8_t later = key_index + 1; later < count; ++later) {
+                duplicate |= pgm_read_word(&combo->keys[later]) == keycode;
+            }
+            if (duplicate) {
+                continue;
+            }
+            if (combo_index_size >= COMBO_INDEX_SIZE) {
+                /* doesn't fit, keep scanning every combo instead */
+                combo_index_valid = false;
+                return;
+            }
+            /* insertion sort, combos are visited in order so ties stay in order */
+            uint16_t pos = combo_index_size++;
+            while (pos > 0 && combo_index[pos - 1].keycode > keycode) {
+                combo_index[pos] = combo_index[pos - 1];
+                --pos;
+            }
+            combo_index[pos] = (combo_index_entry_t){.keycode = keycode, .combo_index = i};
+        }
+    }
+}
+
+static bool process_indexed_combos(uint16_t keycode, keyrecord_t *record) {
+    bool     is_combo_key = false;
+    uint16_t low = 0, high = combo_index_size;
+
+    /* find the first entry for this keycode */
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if (combo_index[mid].keycode < keycode) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    for (; low < combo_index_size && combo_index[low].keycode == keycode; ++low) {
+        current_combo_index = combo_index[low].combo_index;
+        is_combo_key |= process_single_combo(&key_combos[current_combo_index], keycode, record);
+    }
+    return is_combo_key;
+}
+#endif
+
 #define NO_COMBO_KEYS_ARE_DOWN (0 == combo->state)
 
 bool process_combo(uint16_t keycode, keyrecord_t *record) {
@@ -144,14 +241,25 @@ bool process_combo(uint16_t keycode, keyrecord_t *record) {
     if (!is_combo_enabled()) {
         return true;
     }
+#ifdef COMBO_INDEX_SIZE
+    if (!combo_index_built) {
+        combo_index_init();
+    }
+    if (combo_index_valid) {
+        is_combo_key          = process_indexed_combos(keycode, record);
+        no_combo_keys_pressed = combos_with_keys_down == 0;
+    } else
+#endif
+    {
 #ifndef COMBO_VARIABLE_LEN
-    for (current_combo_index = 0; current_combo_index < COMBO_COUNT; ++current_combo_index) {
+        for (current_combo_index = 0; current_combo_index < COMBO_COUNT; ++current_combo_index) {
 #else
-    for (current_combo_index = 0; current_combo_index < COMBO_LEN; ++current_combo_index) {
+        for (current_combo_index = 0; current_combo_index < COMBO_LEN; ++current_combo_index) {
 #endif
-        combo_t *combo = &key_combos[current_combo_index];
-        is_combo_key |= process_single_combo(combo, keycode, record);
-        no_combo_keys_pressed = no_combo_keys_pressed && NO_COMBO_KEYS_ARE_DOWN;
+            combo_t *combo = &key_combos[current_combo_index];
+            is_combo_key |= process_single_combo(combo, keycode, record);
+            no_combo_keys_pressed = no_combo_keys_pressed && NO_COMBO_KEYS_ARE_DOWN;
+        }
     }
 
     if (drop_buffer) {
@@ -58,6 +58,11 @@ bool process_combo(uint16_t keycode, keyrecord_t *record);
 void matrix_scan_combo(void);
 void process_combo_event(uint16_t combo_index, bool pressed);
 
+#ifdef COMBO_INDEX_SIZE
+/* (Re)builds the keycode to combo index, call it after changing key_combos at runtime */
+void combo_index_init(void);
+#endif
+
 void combo_enable(void);
 void combo_disable(void);
 void combo_toggle(void);
@@ -15,13 +15,60 @@
  */
 #include "quantum.h"
 #include "action_tapping.h"
+#include "deadline.h"
 
 #ifndef NO_ACTION_ONESHOT
 uint8_t get_oneshot_mods(void);
 #endif
 
+#ifndef TAP_DANCE_MAX_ACTIVE
+#    define TAP_DANCE_MAX_ACTIVE 8
+#endif
+
 static uint16_t last_td;
-static int8_t   highest_td = -1;
+
+// Dances with taps in flight, ordered by the time their tapping term runs out,
+// so that only these are looked at on each key press. A single deadline is
+// kept at the first of them that can still time out.
+static uint8_t          active_td[TAP_DANCE_MAX_ACTIVE];
+static uint16_t         active_td_deadline[TAP_DANCE_MAX_ACTIVE];
+static uint8_t          active_td_count;
+static deadline_token_t active_td_token;
+
+static uint32_t tap_dance_timeout(uint32_t trigger_time, void *arg);
+
+static void update_tap_dance_deadline(void) {
+    for (uint8_t i = 0; i < active_td_count; i++) {
+        // Dances that finished while held wait for their release
+        if (tap_dance_actions[active_td[i]].state.finished) {
+            continue;
+        }
+        int16_t delay = active_td_deadline[i] - timer_read();
+        if (delay < 0) {
+            delay = 0;
+        }
+        if (!deadline_extend(active_td_token, delay)) {
+            active_td_token = deadline_schedule(delay, tap_dance_timeout, NULL);
+        }
+        return;
+    }
+    deadline_cancel(active_td_token);
+    active_td_token = 0;
+}
+
+static void unschedule_tap_dance(uint8_t idx) {
+    for (uint8_t i = 0; i < active_td_count; i++) {
+        if (active_td[i] == idx) {
+            active_td_count--;
+            for (; i < active_td_count; i++) {
+                active_td[i]          = active_td[i + 1];
+                active_td_deadline[i] = active_td_deadline[i + 1];
+            }
+            update_tap_dance_deadline();
+            return;
+        }
+    }
+}
 
 void qk_tap_dance_pair_on_each_tap(qk_tap_dance_state_t *state, void *user_data) {
     qk_tap_dance_pair_t *pair = (qk_tap_dance_pair_t *)user_data;
@@ -96,6 +143,34 @@ static inline void process_tap_dance_action_on_dance_finished(qk_tap_dance_actio
     _process_tap_dance_action_fn(&action->state, action->user_data, action->fn.on_dance_finished);
 }
 
+static void schedule_tap_dance(uint8_t idx, uint16_t deadline) {
+    unschedule_tap_dance(idx);
+
+    if (active_td_count == TAP_DANCE_MAX_ACTIVE) {
+        // Make room by dropping a held dance that has already finished, as it has no timeout left,
+        // or failing that by finishing the dance closest to timing out
+        uint8_t drop = active_td[0];
+        for (uint8_t i = 0; i < active_td_count; i++) {
+            if (tap_dance_actions[active_td[i]].state.finished) {
+                drop = active_td[i];
+                break;
+            }
+        }
+        process_tap_dance_action_on_dance_finished(&tap_dance_actions[drop]);
+        reset_tap_dance(&tap_dance_actions[drop].state);
+        unschedule_tap_dance(drop);
+    }
+
+    uint8_t i = active_td_count++;
+    for (; i > 0 && (int16_t)(active_td_deadline[i - 1] - deadline) > 0; i--) {
+        active_td[i]          = active_td[i - 1];
+        active_td_deadline[i] = active_td_deadline[i - 1];
+    }
+    active_td[i]          = idx;
+    active_td_deadline[i] = deadline;
+    update_tap_dance_deadline();
+}
+
 static inline void process_tap_dance_action_on_reset(qk_tap_dance_action_t *action) {
     _process_tap_dance_action_fn(&action->state, action->user_data, action->fn.on_reset);
     del_mods(action->state.oneshot_mods);
@@ -108,17 +183,18 @@ void preprocess_tap_dance(uint16_t keycode, keyrecord_t *record) {
 
     if (!record->event.pressed) return;
 
-    if (highest_td == -1) return;
-
-    for (int i = 0; i <= highest_td; i++) {
-        action = &tap_dance_actions[i];
-        if (action->state.count) {
-            if (keycode == action->state.keycode && keycode == last_td) continue;
-            action->state.interrupted          = true;
-            action->state.interrupting_keycode = keycode;
-            process_tap_dance_action_on_dance_finished(action);
-            reset_tap_dance(&action->state);
+    for (uint8_t i = 0; i < active_td_count;) {
+        action = &tap_dance_actions[active_td[i]];
+        if (keycode == action->state.keycode && keycode == last_td) {
+            i++;
+            continue;
         }
+        action->state.interrupted          = true;
+        action->state.interrupting_keycode = keycode;
+        process_tap_dance_action_on_dance_finished(action);
+        reset_tap_dance(&action->state);
+        // Dances that are still held stay in the list
+        if (action->state.count) i++;
     }
 }
 
@@ -128,7 +204,6 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 
     switch (keycode) {
         case QK_TAP_DANCE ... QK_TAP_DANCE_MAX:
-            if ((int16_t)idx > highest_td) highest_td = idx;
             action = &tap_dance_actions[idx];
 
             action->state.pressed = record->event.pressed;
@@ -136,6 +211,9 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
                 action->state.keycode = keycode;
                 action->state.count++;
                 action->state.timer = timer_read();
+                // The dance finishes once more than its tapping term has passed without another tap
+                uint16_t tapping_term = action->custom_tapping_term > 0 ? action->custom_tapping_term : get_tapping_term(keycode, NULL);
+                schedule_tap_dance(idx, action->state.timer + tapping_term + 1);
 #ifndef NO_ACTION_ONESHOT
                 action->state.oneshot_mods = get_oneshot_mods();
 #else
@@ -158,21 +236,35 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
     return true;
 }
 
-void matrix_scan_tap_dance() {
-    if (highest_td == -1) return;
-    uint16_t tap_user_defined;
-
-    for (uint8_t i = 0; i <= highest_td; i++) {
-        qk_tap_dance_action_t *action = &tap_dance_actions[i];
-        if (action->custom_tapping_term > 0) {
-            tap_user_defined = action->custom_tapping_term;
-        } else {
-            tap_user_defined = get_tapping_term(action->state.keycode, NULL);
-        }
-        if (action->state.count && timer_elapsed(action->state.timer) > tap_user_defined) {
-            process_tap_dance_action_on_dance_finished(action);
-            reset_tap_dance(&action->state);
+static void finish_timed_out_tap_dances(void) {
+    uint16_t now = timer_read();
+
+    for (uint8_t i = 0; i < active_td_count;) {
+        qk_tap_dance_action_t *action = &tap_dance_actions[active_td[i]];
+        if (action->state.finished) {
+            i++;
+            continue;
         }
+        if (!timer_expired(now, active_td_deadline[i])) break;
+
+        process_tap_dance_action_on_dance_finished(action);
+        reset_tap_dance(&action->state);
+        if (action->state.count) i++;
+    }
+}
+
+static uint32_t tap_dance_timeout(uint32_t trigger_time, void *arg) {
+    // This deadline ends here, the next one is scheduled for whatever is left
+    active_td_token = 0;
+    finish_timed_out_tap_dances();
+    update_tap_dance_deadline();
+    return 0;
+}
+
+void matrix_scan_tap_dance() {
+    // Only polls if every deadline slot was taken
+    if (!active_td_token && active_td_count) {
+        finish_timed_out_tap_dances();
     }
 }
 
@@ -190,4 +282,5 @@ void reset_tap_dance(qk_tap_dance_state_t *state) {
     state->finished             = false;
     state->interrupting_keycode = 0;
     last_td                     = 0;
+    unschedule_tap_dance(state->keycode - QK_TAP_DANCE);
 }
@@ -17,6 +17,7 @@
 #include "process_unicode_common.h"
 #include "eeprom.h"
 #include <ctype.h>
+#include <stdio.h>
 #include <string.h>
 
 unicode_config_t unicode_config;
@@ -265,6 +266,148 @@ void send_unicode_string(const char *str) {
     }
 }
 
+#ifdef SEND_STRING_ASYNC_ENABLE
+// The input sequences of a whole string, queued as one send_string_async() job
+typedef struct {
+    char     data[SEND_STRING_ASYNC_BUFFER_SIZE];
+    uint16_t length;
+    bool     overflow;
+} unicode_async_sequence_t;
+
+static void unicode_async_put(unicode_async_sequence_t *seq, char c) {
+    // Keep room for the terminator
+    if (seq->length + 1 < sizeof(seq->data)) {
+        seq->data[seq->length++] = c;
+    } else {
+        seq->overflow = true;
+    }
+}
+
+static void unicode_async_code(unicode_async_sequence_t *seq, uint8_t action, uint8_t keycode) {
+    unicode_async_put(seq, SS_QMK_PREFIX);
+    unicode_async_put(seq, action);
+    unicode_async_put(seq, keycode);
+}
+
+// Equivalent of tap_code16(): modifiers held in the upper byte are pressed
+// around the tap of the basic keycode.
+static void unicode_async_code16(unicode_async_sequence_t *seq, uint16_t code) {
+    uint8_t mods  = (code >> 8) & 0x1F;
+    uint8_t first = (mods & 0x10) ? KC_RCTRL : KC_LCTRL;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (mods & (1 << i)) unicode_async_code(seq, SS_DOWN_CODE, first + i);
+    }
+    unicode_async_code(seq, SS_TAP_CODE, code & 0xFF);
+    for (int8_t i = 3; i >= 0; i--) {
+        if (mods & (1 << i)) unicode_async_code(seq, SS_UP_CODE, first + i);
+    }
+}
+
+// Same digits as register_hex32()
+static void unicode_async_hex32(unicode_async_sequence_t *seq, uint32_t hex) {
+    bool onzerostart = true;
+    for (int i = 7; i >= 0; i--) {
+        if (i <= 3) {
+            onzerostart = false;
+        }
+        uint8_t digit = ((hex >> (i * 4)) & 0xF);
+        if (digit != 0 || !onzerostart) {
+            unicode_async_code(seq, SS_TAP_CODE, hex_to_keycode(digit));
+            onzerostart = false;
+        }
+    }
+}
+
+// Appends what register_unicode() types, without the mods handling, which
+// send_string_async_clear_mods() does once for the whole job
+static bool unicode_async_append(unicode_async_sequence_t *seq, uint32_t code_point) {
+    if (code_point > 0x10FFFF || (code_point > 0xFFFF && unicode_config.input_mode == UC_WIN)) {
+        // Code point out of range, do nothing
+        return false;
+    }
+
+    switch (unicode_config.input_mode) {
+        case UC_MAC:
+            unicode_async_code(seq, SS_DOWN_CODE, UNICODE_KEY_MAC);
+            break;
+        case UC_LNX:
+            unicode_async_code16(seq, UNICODE_KEY_LNX);
+            break;
+        case UC_WIN:
+            unicode_async_code(seq, SS_DOWN_CODE, KC_LALT);
+            unicode_async_code(seq, SS_TAP_CODE, KC_PPLS);
+            break;
+        case UC_WINC:
+            unicode_async_code(seq, SS_TAP_CODE, UNICODE_KEY_WINC);
+            unicode_async_code(seq, SS_TAP_CODE, KC_U);
+            break;
+    }
+
+    char delay[8];
+    snprintf(delay, sizeof(delay), "%u|", UNICODE_TYPE_DELAY);
+    unicode_async_put(seq, SS_QMK_PREFIX);
+    unicode_async_put(seq, SS_DELAY_CODE);
+    for (char *c = delay; *c; c++) {
+        unicode_async_put(seq, *c);
+    }
+
+    if (code_point > 0xFFFF && unicode_config.input_mode == UC_MAC) {
+        // Convert code point to UTF-16 surrogate pair on macOS
+        code_point -= 0x10000;
+        uint32_t lo = code_point & 0x3FF, hi = (code_point & 0xFFC00) >> 10;
+        unicode_async_hex32(seq, hi + 0xD800);
+        unicode_async_hex32(seq, lo + 0xDC00);
+    } else {
+        unicode_async_hex32(seq, code_point);
+    }
+
+    switch (unicode_config.input_mode) {
+        case UC_MAC:
+            unicode_async_code(seq, SS_UP_CODE, UNICODE_KEY_MAC);
+            break;
+        case UC_LNX:
+            unicode_async_code(seq, SS_TAP_CODE, KC_SPC);
+            break;
+        case UC_WIN:
+            unicode_async_code(seq, SS_UP_CODE, KC_LALT);
+            break;
+        case UC_WINC:
+            unicode_async_code(seq, SS_TAP_CODE, KC_ENTER);
+            break;
+    }
+    return true;
+}
+
+static bool unicode_async_send(unicode_async_sequence_t *seq, send_string_async_callback_t callback) {
+    if (seq->overflow || !seq->length) {
+        return false;
+    }
+    seq->data[seq->length] = 0;
+    return send_string_async_clear_mods(seq->data, 0, callback);
+}
+
+bool register_unicode_async(uint32_t code_point, send_string_async_callback_t callback) {
+    unicode_async_sequence_t seq = {.length = 0, .overflow = false};
+    return unicode_async_append(&seq, code_point) && unicode_async_send(&seq, callback);
+}
+
+bool send_unicode_string_async(const char *str, send_string_async_callback_t callback) {
+    if (!str) {
+        return false;
+    }
+
+    unicode_async_sequence_t seq = {.length = 0, .overflow = false};
+    while (*str) {
+        int32_t code_point = 0;
+        str                = decode_utf8(str, &code_point);
+        if (code_point >= 0) {
+            unicode_async_append(&seq, code_point);
+        }
+    }
+    return unicode_async_send(&seq, callback);
+}
+#endif
+
 // clang-format off
 
 static void audio_helper(void) {
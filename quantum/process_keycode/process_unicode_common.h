@@ -94,6 +94,11 @@ void register_unicode(uint32_t code_point);
 void send_unicode_hex_string(const char *str);
 void send_unicode_string(const char *str);
 
+#ifdef SEND_STRING_ASYNC_ENABLE
+bool register_unicode_async(uint32_t code_point, send_string_async_callback_t callback);
+bool send_unicode_string_async(const char *str, send_string_async_callback_t callback);
+#endif
+
 bool process_unicode_common(uint16_t keycode, keyrecord_t *record);
 
 #define UC_BSPC UC(0x0008)
@@ -177,6 +177,74 @@ void post_process_record_quantum(keyrecord_t *record) {
     post_process_record_kb(keycode, record);
 }
 
+// Ids of the handlers that only act on their own keycode ranges
+enum process_record_route {
+    PROCESS_RECORD_ROUTE_NONE,
+#define PROCESS_RECORD_ALL(handler)
+#define PROCESS_RECORD_KEYCODES(handler) PROCESS_RECORD_ROUTE_##handler,
+#define PROCESS_RECORD_RANGE(handler, first, last)
+#include "process_keycode/process_record_handlers.inc"
+#undef PROCESS_RECORD_ALL
+#undef PROCESS_RECORD_KEYCODES
+#undef PROCESS_RECORD_RANGE
+};
+
+#ifdef PROCESS_RECORD_COUNT_CALLS
+uint32_t process_record_handler_calls;
+
+const uint8_t process_record_handler_count = 0
+#    define PROCESS_RECORD_ALL(handler) +1
+#    define PROCESS_RECORD_KEYCODES(handler) +1
+#    define PROCESS_RECORD_RANGE(handler, first, last)
+#    include "process_keycode/process_record_handlers.inc"
+#    undef PROCESS_RECORD_ALL
+#    undef PROCESS_RECORD_KEYCODES
+#    undef PROCESS_RECORD_RANGE
+    ;
+
+#    define PROCESS_RECORD_CALL(handler) (process_record_handler_calls++, handler(keycode, record))
+#else
+#    define PROCESS_RECORD_CALL(handler) handler(keycode, record)
+#endif
+
+// Finds the one ranged handler that acts on keycode, if any
+static uint8_t process_record_route(uint16_t keycode) {
+    switch (keycode) {
+#define PROCESS_RECORD_ALL(handler)
+#define PROCESS_RECORD_KEYCODES(handler)
+#define PROCESS_RECORD_RANGE(handler, first, last) \
+    case first ... last:                           \
+        return PROCESS_RECORD_ROUTE_##handler;
+#include "process_keycode/process_record_handlers.inc"
+#undef PROCESS_RECORD_ALL
+#undef PROCESS_RECORD_KEYCODES
+#undef PROCESS_RECORD_RANGE
+    }
+    return PROCESS_RECORD_ROUTE_NONE;
+}
+
+// Runs the handlers in order, skipping the ranged ones that keycode is not routed to
+static bool process_record_handlers(uint16_t keycode, keyrecord_t *record) {
+    uint8_t route = process_record_route(keycode);
+    (void)route;
+
+#define PROCESS_RECORD_ALL(handler)      \
+    if (!PROCESS_RECORD_CALL(handler)) { \
+        return false;                    \
+    }
+#define PROCESS_RECORD_KEYCODES(handler)                                            \
+    if (route == PROCESS_RECORD_ROUTE_##handler && !PROCESS_RECORD_CALL(handler)) { \
+        return false;                                                                \
+    }
+#define PROCESS_RECORD_RANGE(handler, first, last)
+#include "process_keycode/process_record_handlers.inc"
+#undef PROCESS_RECORD_ALL
+#undef PROCESS_RECORD_KEYCODES
+#undef PROCESS_RECORD_RANGE
+
+    return true;
+}
+
 /* Core keycode function, hands off handling to other functions,
     then processes internal quantum keycodes, and then processes
     ACTIONs.                                                      */
@@ -212,75 +280,7 @@ bool process_record_quantum(keyrecord_t *record) {
             // Must run first to be able to mask key_up events.
             process_key_lock(&keycode, record) &&
 #endif
-#if defined(DYNAMIC_MACRO_ENABLE) && !defined(DYNAMIC_MACRO_USER_CALL)
-            // Must run asap to ensure all keypresses are recorded.
-            process_dynamic_macro(keycode, record) &&
-#endif
-#if defined(AUDIO_ENABLE) && defined(AUDIO_CLICKY)
-            process_clicky(keycode, record) &&
-#endif  // AUDIO_CLICKY
-#ifdef HAPTIC_ENABLE
-            process_haptic(keycode, record) &&
-#endif  // HAPTIC_ENABLE
-#if defined(RGB_MATRIX_ENABLE)
-            process_rgb_matrix(keycode, record) &&
-#endif
-#if defined(VIA_ENABLE)
-            process_record_via(keycode, record) &&
-#endif
-            process_record_kb(keycode, record) &&
-#if defined(MIDI_ENABLE) && defined(MIDI_ADVANCED)
-            process_midi(keycode, record) &&
-#endif
-#ifdef AUDIO_ENABLE
-            process_audio(keycode, record) &&
-#endif
-#ifdef BACKLIGHT_ENABLE
-            process_backlight(keycode, record) &&
-#endif
-#ifdef STENO_ENABLE
-            process_steno(keycode, record) &&
-#endif
-#if (defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))) && !defined(NO_MUSIC_MODE)
-            process_music(keycode, record) &&
-#endif
-#ifdef TAP_DANCE_ENABLE
-            process_tap_dance(keycode, record) &&
-#endif
-#if defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE) || defined(UCIS_ENABLE)
-            process_unicode_common(keycode, record) &&
-#endif
-#ifdef LEADER_ENABLE
-            process_leader(keycode, record) &&
-#endif
-#ifdef COMBO_ENABLE
-            process_combo(keycode, record) &&
-#endif
-#ifdef PRINTING_ENABLE
-            process_printer(keycode, record) &&
-#endif
-#ifdef AUTO_SHIFT_ENABLE
-            process_auto_shift(keycode, record) &&
-#endif
-#ifdef TERMINAL_ENABLE
-            process_terminal(keycode, record) &&
-#endif
-#ifdef SPACE_CADET_ENABLE
-            process_space_cadet(keycode, record) &&
-#endif
-#ifdef MAGIC_KEYCODE_ENABLE
-            process_magic(keycode, record) &&
-#endif
-#ifdef GRAVE_ESC_ENABLE
-            process_grave_esc(keycode, record) &&
-#endif
-#if defined(RGBLIGHT_ENABLE) || defined(RGB_MATRIX_ENABLE)
-            process_rgb(keycode, record) &&
-#endif
-#ifdef JOYSTICK_ENABLE
-            process_joystick(keycode, record) &&
-#endif
-            true)) {
+            process_record_handlers(keycode, record))) {
         return false;
     }
 
@@ -646,11 +646,13 @@ void matrix_scan_quantum() {
 #endif
 
 #ifdef RGB_MATRIX_ENABLE
+    PROFILER_BEGIN(rgb_matrix);
     rgb_matrix_task();
+    PROFILER_END(PROFILER_RGB_MATRIX, rgb_matrix);
 #endif
 
-#ifdef WPM_ENABLE
-    decay_wpm();
+#ifdef SEND_STRING_ASYNC_ENABLE
+    send_string_async_task();
 #endif
 
 #ifdef HAPTIC_ENABLE
@@ -56,12 +56,17 @@
 #include "config_common.h"
 #include "led.h"
 #include "action_util.h"
+#include "profiler.h"
 #include "print.h"
 #include "send_string_keycodes.h"
 #include "suspend.h"
 #include <stddef.h>
 #include <stdlib.h>
 
+#ifdef SEND_STRING_ASYNC_ENABLE
+#    include "send_string_async.h"
+#endif
+
 extern layer_state_t default_layer_state;
 
 #ifndef NO_ACTION_LAYER
@@ -271,6 +276,12 @@ bool     process_record_user(uint16_t keycode, keyrecord_t *record);
 void     post_process_record_kb(uint16_t keycode, keyrecord_t *record);
 void     post_process_record_user(uint16_t keycode, keyrecord_t *record);
 
+#ifdef PROCESS_RECORD_COUNT_CALLS
+// Calls made by process_record_quantum() into the handlers of process_record_handlers.inc
+extern uint32_t      process_record_handler_calls;
+extern const uint8_t process_record_handler_count;
+#endif
+
 #ifndef BOOTMAGIC_LITE_COLUMN
 #    define BOOTMAGIC_LITE_COLUMN 0
 #endif
@@ -20,20 +20,94 @@
 #include "progmem.h"
 #include "config.h"
 #include "eeprom.h"
+#include "deadline.h"
 #include <string.h>
 #include <math.h>
 
 #include "lib/lib8tion/lib8tion.h"
 
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+#    include "profiler.h"
+#endif
+
 #ifndef RGB_MATRIX_CENTER
 const point_t k_rgb_matrix_center = {112, 32};
 #else
 const point_t k_rgb_matrix_center = RGB_MATRIX_CENTER;
 #endif
 
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+led_geometry_t g_led_geometry[DRIVER_LED_TOTAL];
+#endif
+
+// Per LED geometry for the effect runners, either read from the cache or worked out on the spot
+static inline int16_t rgb_matrix_led_dx(uint8_t i) {
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+    return g_led_geometry[i].dx;
+#else
+    return g_led_config.point[i].x - k_rgb_matrix_center.x;
+#endif
+}
+
+static inline int16_t rgb_matrix_led_dy(uint8_t i) {
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+    return g_led_geometry[i].dy;
+#else
+    return g_led_config.point[i].y - k_rgb_matrix_center.y;
+#endif
+}
+
+static inline uint8_t rgb_matrix_led_dist(uint8_t i) {
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+    return g_led_geometry[i].dist;
+#else
+    int16_t dx = rgb_matrix_led_dx(i);
+    int16_t dy = rgb_matrix_led_dy(i);
+    return sqrt16(dx * dx + dy * dy);
+#endif
+}
+
+static inline uint8_t rgb_matrix_led_angle(uint8_t i) {
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+    return g_led_geometry[i].angle;
+#else
+    return atan2_8(rgb_matrix_led_dy(i), rgb_matrix_led_dx(i));
+#endif
+}
+
+#ifndef RGB_MATRIX_HSV_BATCH_SIZE
+#    define RGB_MATRIX_HSV_BATCH_SIZE 16
+#endif
+
+// Collects the colors a runner works out so that they are converted to RGB together
+typedef struct {
+    uint8_t count;
+    uint8_t led[RGB_MATRIX_HSV_BATCH_SIZE];
+    HSV     hsv[RGB_MATRIX_HSV_BATCH_SIZE];
+} rgb_matrix_hsv_batch_t;
+
+static void rgb_matrix_hsv_batch_flush(rgb_matrix_hsv_batch_t *batch) {
+    RGB rgb[RGB_MATRIX_HSV_BATCH_SIZE];
+    hsv_to_rgb_batch(batch->hsv, rgb, batch->count);
+    for (uint8_t j = 0; j < batch->count; j++) {
+        rgb_matrix_set_color(batch->led[j], rgb[j].r, rgb[j].g, rgb[j].b);
+    }
+    batch->count = 0;
+}
+
+static inline void rgb_matrix_hsv_batch_add(rgb_matrix_hsv_batch_t *batch, uint8_t led, HSV hsv) {
+    batch->led[batch->count] = led;
+    batch->hsv[batch->count] = hsv;
+    if (++batch->count == RGB_MATRIX_HSV_BATCH_SIZE) {
+        rgb_matrix_hsv_batch_flush(batch);
+    }
+}
+
 // Generic effect runners
 #include "rgb_matrix_runners/effect_runner_dx_dy_dist.h"
 #include "rgb_matrix_runners/effect_runner_dx_dy.h"
+#include "rgb_matrix_runners/effect_runner_angle.h"
+#include "rgb_matrix_runners/effect_runner_dist_angle.h"
 #include "rgb_matrix_runners/effect_runner_i.h"
 #include "rgb_matrix_runners/effect_runner_sin_cos_i.h"
 #include "rgb_matrix_runners/effect_runner_reactive.h"
@@ -131,8 +205,18 @@ static uint8_t         rgb_last_enable   = UINT8_MAX;
 static uint8_t         rgb_last_effect   = UINT8_MAX;
 static effect_params_t rgb_effect_params = {0, 0xFF};
 static rgb_task_states rgb_task_state    = SYNCING;
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+static uint32_t rgb_render_budget;
+#endif  // RGB_MATRIX_RENDER_BUDGET_US
+#if RGB_DISABLE_TIMEOUT > 0
+static bool             rgb_timed_out;
+static deadline_token_t rgb_anykey_token;
+#endif  // RGB_DISABLE_TIMEOUT > 0
+static deadline_token_t rgb_sync_token;
+
+static void rgb_task_timers(void);
 #if RGB_DISABLE_TIMEOUT > 0
-static uint32_t rgb_anykey_timer;
+static void rgb_anykey_hit(void);
 #endif  // RGB_DISABLE_TIMEOUT > 0
 
 // double buffers
@@ -185,7 +269,7 @@ void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) { rgb_ma
 bool process_rgb_matrix(uint16_t keycode, keyrecord_t *record) {
 #if RGB_DISABLE_TIMEOUT > 0
     if (record->event.pressed) {
-        rgb_anykey_timer = 0;
+        rgb_anykey_hit();
     }
 #endif  // RGB_DISABLE_TIMEOUT > 0
 
@@ -202,6 +286,9 @@ bool process_rgb_matrix(uint16_t keycode, keyrecord_t *record) {
         led_count = rgb_matrix_map_row_column_to_led(record->event.key.row, record->event.key.col, led);
     }
 
+    // Age the earlier hits up to now, the timers only run once per frame
+    rgb_task_timers();
+
     if (last_hit_buffer.count + led_count > LED_HITS_TO_REMEMBER) {
         memcpy(&last_hit_buffer.x[0], &last_hit_buffer.x[led_count], LED_HITS_TO_REMEMBER - led_count);
         memcpy(&last_hit_buffer.y[0], &last_hit_buffer.y[led_count], LED_HITS_TO_REMEMBER - led_count);
@@ -263,22 +350,11 @@ static bool rgb_matrix_none(effect_params_t *params) {
 }
 
 static void rgb_task_timers(void) {
-#if defined(RGB_MATRIX_KEYREACTIVE_ENABLED) || RGB_DISABLE_TIMEOUT > 0
+#ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
     uint32_t deltaTime = timer_elapsed32(rgb_timer_buffer);
-#endif  // defined(RGB_MATRIX_KEYREACTIVE_ENABLED) || RGB_DISABLE_TIMEOUT > 0
+#endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
     rgb_timer_buffer = timer_read32();
 
-    // Update double buffer timers
-#if RGB_DISABLE_TIMEOUT > 0
-    if (rgb_anykey_timer < UINT32_MAX) {
-        if (UINT32_MAX - deltaTime < rgb_anykey_timer) {
-            rgb_anykey_timer = UINT32_MAX;
-        } else {
-            rgb_anykey_timer += deltaTime;
-        }
-    }
-#endif  // RGB_DISABLE_TIMEOUT > 0
-
     // Update double buffer last hit timers
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
     uint8_t count = last_hit_buffer.count;
@@ -292,12 +368,44 @@ static void rgb_task_timers(void) {
 #endif  // RGB_MATRIX_KEYREACTIVE_ENABLED
 }
 
-static void rgb_task_sync(void) {
-    // next task
-    if (timer_elapsed32(g_rgb_timer) >= RGB_MATRIX_LED_FLUSH_LIMIT) rgb_task_state = STARTING;
+#if RGB_DISABLE_TIMEOUT > 0
+static uint32_t rgb_anykey_timeout(uint32_t trigger_time, void *arg) {
+    rgb_timed_out    = true;
+    rgb_anykey_token = 0;
+    return 0;
+}
+
+static void rgb_anykey_hit(void) {
+    rgb_timed_out = false;
+    if (!deadline_extend(rgb_anykey_token, RGB_DISABLE_TIMEOUT)) {
+        rgb_anykey_token = deadline_schedule(RGB_DISABLE_TIMEOUT, rgb_anykey_timeout, NULL);
+    }
+}
+#endif  // RGB_DISABLE_TIMEOUT > 0
+
+static uint32_t rgb_task_sync(uint32_t trigger_time, void *arg) {
+    rgb_sync_token = 0;
+    if (rgb_task_state == SYNCING) rgb_task_state = STARTING;
+    return 0;
+}
+
+// The next frame starts from a deadline, so the main loop doesn't have to poll for it
+static void rgb_task_wait(void) {
+    uint32_t elapsed = timer_elapsed32(g_rgb_timer);
+    rgb_task_state   = SYNCING;
+    if (!rgb_sync_token) {
+        rgb_sync_token = deadline_schedule(elapsed < RGB_MATRIX_LED_FLUSH_LIMIT ? RGB_MATRIX_LED_FLUSH_LIMIT - elapsed : 0, rgb_task_sync, NULL);
+    }
 }
 
 static void rgb_task_start(void) {
+    // A forced restart leaves the wait for the old frame behind
+    if (rgb_sync_token) {
+        deadline_cancel(rgb_sync_token);
+        rgb_sync_token = 0;
+    }
+    rgb_task_timers();
+
     // reset iter
     rgb_effect_params.iter = 0;
 
@@ -362,7 +470,7 @@ static void rgb_task_render(uint8_t effect) {
         rgb_task_state = FLUSHING;
         if (!rgb_effect_params.init && effect == RGB_MATRIX_NONE) {
             // We only need to flush once if we are RGB_MATRIX_NONE
-            rgb_task_state = SYNCING;
+            rgb_task_wait();
         }
     }
 }
@@ -376,11 +484,14 @@ static void rgb_task_flush(uint8_t effect) {
     rgb_matrix_update_pwm_buffers();
 
     // next task
-    rgb_task_state = SYNCING;
+    rgb_task_wait();
 }
 
 void rgb_matrix_task(void) {
-    rgb_task_timers();
+#ifdef ISSI_ASYNC_FLUSH
+    // Keep sending the writes queued by the last flush
+    issi_queue_task();
+#endif
 
     // Ideally we would also stop sending zeros to the LED driver PWM buffers
     // while suspended and just do a software shutdown. This is a cheap hack for now.
@@ -389,7 +500,7 @@ void rgb_matrix_task(void) {
         g_suspend_state ||
 #endif  // RGB_DISABLE_WHEN_USB_SUSPENDED == true
 #if RGB_DISABLE_TIMEOUT > 0
-        (rgb_anykey_timer > (uint32_t)RGB_DISABLE_TIMEOUT) ||
+        rgb_timed_out ||
 #endif  // RGB_DISABLE_TIMEOUT > 0
         false;
 
@@ -399,14 +510,26 @@ void rgb_matrix_task(void) {
         case STARTING:
             rgb_task_start();
             break;
-        case RENDERING:
+        case RENDERING: {
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+            // Render as many chunks as fit in the budget, the frame is still only published by the flush
+            uint32_t start = profiler_counter();
+            do {
+                rgb_task_render(effect);
+            } while (rgb_task_state == RENDERING && profiler_counter() - start < rgb_render_budget);
+#else
             rgb_task_render(effect);
+#endif  // RGB_MATRIX_RENDER_BUDGET_US
             break;
+        }
         case FLUSHING:
             rgb_task_flush(effect);
             break;
         case SYNCING:
-            rgb_task_sync();
+            // Only polls before the first frame, or if no deadline slot was free
+            if (!rgb_sync_token && timer_elapsed32(g_rgb_timer) >= RGB_MATRIX_LED_FLUSH_LIMIT) {
+                rgb_task_state = STARTING;
+            }
             break;
     }
 
@@ -424,9 +547,35 @@ __attribute__((weak)) void rgb_matrix_indicators_kb(void) {}
 
 __attribute__((weak)) void rgb_matrix_indicators_user(void) {}
 
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+static void rgb_matrix_init_geometry(void) {
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        int16_t dx = g_led_config.point[i].x - k_rgb_matrix_center.x;
+        int16_t dy = g_led_config.point[i].y - k_rgb_matrix_center.y;
+
+        g_led_geometry[i].dx    = dx;
+        g_led_geometry[i].dy    = dy;
+        g_led_geometry[i].dist  = sqrt16(dx * dx + dy * dy);
+        g_led_geometry[i].angle = atan2_8(dy, dx);
+    }
+}
+#endif  // RGB_MATRIX_GEOMETRY_CACHE
+
 void rgb_matrix_init(void) {
     rgb_matrix_driver.init();
 
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+    rgb_matrix_init_geometry();
+#endif  // RGB_MATRIX_GEOMETRY_CACHE
+
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+    rgb_render_budget = (uint32_t)RGB_MATRIX_RENDER_BUDGET_US * (profiler_counter_frequency() / 1000) / 1000;
+#endif  // RGB_MATRIX_RENDER_BUDGET_US
+
+#if RGB_DISABLE_TIMEOUT > 0
+    rgb_anykey_hit();
+#endif  // RGB_DISABLE_TIMEOUT > 0
+
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
     g_last_hit_tracker.count = 0;
     for (uint8_t i = 0; i < LED_HITS_TO_REMEMBER; ++i) {
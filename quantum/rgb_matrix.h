@@ -38,6 +38,10 @@
 #    include "ws2812.h"
 #endif
 
+#ifdef ISSI_ASYNC_FLUSH
+#    include "issi_queue.h"
+#endif
+
 #ifndef RGB_MATRIX_LED_FLUSH_LIMIT
 #    define RGB_MATRIX_LED_FLUSH_LIMIT 16
 #endif
@@ -209,6 +213,9 @@ extern rgb_config_t rgb_matrix_config;
 extern bool         g_suspend_state;
 extern uint32_t     g_rgb_timer;
 extern led_config_t g_led_config;
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+extern led_geometry_t g_led_geometry[DRIVER_LED_TOTAL];
+#endif
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 extern last_hit_t g_last_hit_tracker;
 #endif
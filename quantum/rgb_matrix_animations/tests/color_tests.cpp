@@ -0,0 +1,76 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <random>
+
+extern "C" {
+#include "color.h"
+}
+
+TEST(Color, BatchMatchesSingleConversion) {
+    HSV hsv[256];
+    RGB rgb[256];
+    for (uint16_t h = 0; h < 256; h++) {
+        for (uint16_t s = 0; s < 256; s++) {
+            for (uint16_t v = 0; v < 256; v++) {
+                hsv[v] = (HSV){(uint8_t)h, (uint8_t)s, (uint8_t)v};
+            }
+            hsv_to_rgb_batch(hsv, rgb, 256);
+            for (uint16_t v = 0; v < 256; v++) {
+                RGB expected = hsv_to_rgb(hsv[v]);
+                ASSERT_EQ(expected.r, rgb[v].r) << "h " << h << " s " << s << " v " << v;
+                ASSERT_EQ(expected.g, rgb[v].g) << "h " << h << " s " << s << " v " << v;
+                ASSERT_EQ(expected.b, rgb[v].b) << "h " << h << " s " << s << " v " << v;
+            }
+        }
+    }
+}
+
+TEST(Color, Benchmark) {
+    const uint16_t count  = 1024;
+    const uint32_t rounds = 2000;
+
+    std::mt19937 generator(42);
+    HSV          hsv[count];
+    RGB          rgb[count];
+    for (uint16_t i = 0; i < count; i++) {
+        hsv[i] = (HSV){(uint8_t)generator(), (uint8_t)generator(), (uint8_t)generator()};
+    }
+
+    uint32_t checksum = 0;
+    auto     start    = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (uint16_t i = 0; i < count; i++) {
+            rgb[i] = hsv_to_rgb(hsv[i]);
+        }
+        checksum += rgb[round % count].r;
+    }
+    auto   end    = std::chrono::steady_clock::now();
+    double single = std::chrono::duration<double, std::nano>(end - start).count() / (count * rounds);
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < rounds; round++) {
+        hsv_to_rgb_batch(hsv, rgb, count);
+        checksum += rgb[round % count].r;
+    }
+    end          = std::chrono::steady_clock::now();
+    double batch = std::chrono::duration<double, std::nano>(end - start).count() / (count * rounds);
+
+    printf("[   INFO   ] hsv_to_rgb() %.2f ns/LED, hsv_to_rgb_batch() %.2f ns/LED (checksum %u)\n", single, batch, checksum);
+}
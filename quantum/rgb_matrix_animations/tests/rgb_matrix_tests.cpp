@@ -0,0 +1,180 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+
+extern "C" {
+#include "config.h"
+#include "rgb_matrix.h"
+#include "timer.h"
+#include "deadline.h"
+#include "lib/lib8tion/lib8tion.h"
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+
+extern const point_t k_rgb_matrix_center;
+led_config_t         g_led_config;
+
+// Keeps the buffer the effects draw into apart from the one the flush publishes
+static RGB      back_buffer[DRIVER_LED_TOTAL];
+static RGB      front_buffer[DRIVER_LED_TOTAL];
+static uint32_t flushes;
+
+static void mock_init(void) {}
+
+static void mock_set_color(int index, uint8_t r, uint8_t g, uint8_t b) { back_buffer[index] = (RGB){r, g, b}; }
+
+static void mock_set_color_all(uint8_t r, uint8_t g, uint8_t b) {
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        back_buffer[i] = (RGB){r, g, b};
+    }
+}
+
+static void mock_flush(void) {
+    memcpy(front_buffer, back_buffer, sizeof(front_buffer));
+    flushes++;
+}
+
+extern const rgb_matrix_driver_t rgb_matrix_driver = {mock_init, mock_set_color, mock_set_color_all, mock_flush};
+
+bool eeconfig_is_enabled(void) { return true; }
+void eeconfig_init(void) {}
+}
+
+static const char *effect_names[] = {
+    "NONE",
+#define RGB_MATRIX_EFFECT(name, ...) #name,
+#include "rgb_matrix_animations/rgb_matrix_effects.inc"
+#undef RGB_MATRIX_EFFECT
+};
+
+class RgbMatrix : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        // Rows are staggered like a keyboard and spread over the 224x64 coordinate space
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                uint8_t i                        = row * MATRIX_COLS + col;
+                g_led_config.matrix_co[row][col] = i;
+                g_led_config.point[i].x          = (col * 216) / (MATRIX_COLS - 1) + (row & 1) * 8;
+                g_led_config.point[i].y          = (row * 64) / (MATRIX_ROWS - 1);
+                g_led_config.flags[i]            = LED_FLAG_KEYLIGHT;
+            }
+        }
+        set_time(0);
+        rgb_matrix_init();
+        rgb_matrix_set_speed_noeeprom(UINT8_MAX / 2);
+        rgb_matrix_sethsv_noeeprom(0, UINT8_MAX, UINT8_MAX);
+        flushes = 0;
+    }
+
+    // Runs the task until the next frame has been published, returns the number of calls it took
+    uint32_t frame(void) {
+        uint32_t calls = 0;
+        uint32_t start = flushes;
+        advance_time(RGB_MATRIX_LED_FLUSH_LIMIT);
+        while (flushes == start) {
+            deadline_task();
+            rgb_matrix_task();
+            calls++;
+        }
+        return calls;
+    }
+};
+
+TEST_F(RgbMatrix, FrameIsPublishedWhole) {
+    rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_COLOR);
+    frame();
+    RGB red = front_buffer[0];
+
+    rgb_matrix_sethsv_noeeprom(HSV_BLUE);
+    advance_time(RGB_MATRIX_LED_FLUSH_LIMIT);
+    uint32_t start = flushes;
+    while (flushes == start) {
+        for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+            ASSERT_EQ(red.b, front_buffer[i].b) << "LED " << (int)i << " changed before the frame was flushed";
+        }
+        deadline_task();
+        rgb_matrix_task();
+    }
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        EXPECT_EQ(UINT8_MAX, front_buffer[i].b);
+        EXPECT_EQ(0, front_buffer[i].r);
+    }
+}
+
+TEST_F(RgbMatrix, NextFrameWaitsForDeadline) {
+    rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_COLOR);
+    frame();
+    EXPECT_EQ((uint32_t)RGB_MATRIX_LED_FLUSH_LIMIT, deadline_next());
+
+    uint32_t start = flushes;
+    for (uint8_t i = 0; i < 10; i++) {
+        deadline_task();
+        rgb_matrix_task();
+    }
+    EXPECT_EQ(start, flushes);
+
+    frame();
+    EXPECT_EQ(start + 1, flushes);
+}
+
+#ifdef RGB_MATRIX_GEOMETRY_CACHE
+TEST_F(RgbMatrix, GeometryMatchesLayout) {
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        int16_t dx = g_led_config.point[i].x - k_rgb_matrix_center.x;
+        int16_t dy = g_led_config.point[i].y - k_rgb_matrix_center.y;
+        EXPECT_EQ(dx, g_led_geometry[i].dx);
+        EXPECT_EQ(dy, g_led_geometry[i].dy);
+        EXPECT_EQ(sqrt16(dx * dx + dy * dy), g_led_geometry[i].dist);
+        EXPECT_EQ(atan2_8(dy, dx), g_led_geometry[i].angle);
+    }
+}
+#endif
+
+#ifdef RGB_MATRIX_RENDER_BUDGET_US
+TEST_F(RgbMatrix, BudgetRendersSeveralChunksPerCall) {
+    rgb_matrix_mode_noeeprom(RGB_MATRIX_CYCLE_SPIRAL);
+    // The test clock stands still, so the whole frame fits in the budget: start, render, flush
+    EXPECT_EQ(3u, frame());
+}
+#else
+TEST_F(RgbMatrix, FrameIsRenderedInChunks) {
+    rgb_matrix_mode_noeeprom(RGB_MATRIX_CYCLE_SPIRAL);
+    uint32_t limit  = RGB_MATRIX_LED_PROCESS_LIMIT;
+    uint32_t chunks = (DRIVER_LED_TOTAL + limit - 1) / limit;
+    // Start, one call per chunk, flush
+    EXPECT_EQ(chunks + 2, frame());
+}
+#endif
+
+TEST_F(RgbMatrix, Benchmark) {
+    const uint32_t frames = 2000;
+    for (uint8_t effect = 1; effect < RGB_MATRIX_EFFECT_MAX; effect++) {
+        rgb_matrix_mode_noeeprom(effect);
+        frame();
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < frames; i++) {
+            frame();
+        }
+        auto end = std::chrono::steady_clock::now();
+        printf("[   INFO   ] %-22s %3u LEDs: %.2f us/frame\n", effect_names[effect], DRIVER_LED_TOTAL, std::chrono::duration<double, std::micro>(end - start).count() / frames);
+    }
+}
@@ -0,0 +1,39 @@
+RGB_MATRIX_TESTS_PATH := $(QUANTUM_PATH)/rgb_matrix_animations/tests
+
+rgb_matrix_84_DEFS := -DNO_PRINT -DNO_DEBUG -DRGB_MATRIX_ENABLE -DDRIVER_LED_TOTAL=84
+rgb_matrix_84_CONFIG := $(RGB_MATRIX_TESTS_PATH)/config.h
+rgb_matrix_84_INC := $(RGB_MATRIX_TESTS_PATH) $(QUANTUM_PATH)
+rgb_matrix_84_SRC := \
+	$(RGB_MATRIX_TESTS_PATH)/rgb_matrix_tests.cpp \
+	$(QUANTUM_PATH)/rgb_matrix.c \
+	$(QUANTUM_PATH)/color.c \
+	$(LIB_PATH)/lib8tion/lib8tion.c \
+	$(TMK_PATH)/common/test/eeprom.c \
+	$(TMK_PATH)/common/test/timer.c \
+	$(TMK_PATH)/common/deadline.c \
+	$(TMK_PATH)/common/profiler_counter.c
+
+rgb_matrix_84_cache_DEFS := $(rgb_matrix_84_DEFS) -DRGB_MATRIX_GEOMETRY_CACHE -DRGB_MATRIX_RENDER_BUDGET_US=500
+rgb_matrix_84_cache_CONFIG := $(RGB_MATRIX_TESTS_PATH)/config.h
+rgb_matrix_84_cache_INC := $(rgb_matrix_84_INC)
+rgb_matrix_84_cache_SRC := $(rgb_matrix_84_SRC)
+
+rgb_matrix_120_DEFS := -DNO_PRINT -DNO_DEBUG -DRGB_MATRIX_ENABLE -DDRIVER_LED_TOTAL=120
+rgb_matrix_120_CONFIG := $(RGB_MATRIX_TESTS_PATH)/config.h
+rgb_matrix_120_INC := $(rgb_matrix_84_INC)
+rgb_matrix_120_SRC := $(rgb_matrix_84_SRC)
+
+rgb_matrix_120_cache_DEFS := $(rgb_matrix_120_DEFS) -DRGB_MATRIX_GEOMETRY_CACHE -DRGB_MATRIX_RENDER_BUDGET_US=500
+rgb_matrix_120_cache_CONFIG := $(RGB_MATRIX_TESTS_PATH)/config.h
+rgb_matrix_120_cache_INC := $(rgb_matrix_84_INC)
+rgb_matrix_120_cache_SRC := $(rgb_matrix_84_SRC)
+
+color_DEFS := -DNO_PRINT -DNO_DEBUG
+color_INC := $(QUANTUM_PATH)
+color_SRC := \
+	$(RGB_MATRIX_TESTS_PATH)/color_tests.cpp \
+	$(QUANTUM_PATH)/color.c
+
+color_cie_DEFS := $(color_DEFS) -DUSE_CIE1931_CURVE
+color_cie_INC := $(color_INC)
+color_cie_SRC := $(color_SRC) $(QUANTUM_PATH)/led_tables.c
@@ -0,0 +1,7 @@
+TEST_LIST +=\
+	rgb_matrix_84\
+	rgb_matrix_84_cache\
+	rgb_matrix_120\
+	rgb_matrix_120_cache\
+	color\
+	color_cie
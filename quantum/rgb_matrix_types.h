@@ -66,6 +66,14 @@ typedef struct PACKED {
     uint8_t flags[DRIVER_LED_TOTAL];
 } led_config_t;
 
+// Position of an LED relative to the matrix center, see RGB_MATRIX_GEOMETRY_CACHE
+typedef struct PACKED {
+    int16_t dx;
+    int16_t dy;
+    uint8_t dist;
+    uint8_t angle;
+} led_geometry_t;
+
 typedef union {
     uint32_t raw;
     struct PACKED {
@@ -0,0 +1,296 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <ctype.h>
+#include "quantum.h"
+#include "send_string_async.h"
+
+#if SEND_STRING_ASYNC_BUFFER_SIZE > 255
+typedef uint16_t ss_index_t;
+#else
+typedef uint8_t ss_index_t;
+#endif
+
+typedef struct {
+    uint8_t                      interval;
+    bool                         clear_mods;
+    send_string_async_callback_t callback;
+} ss_job_t;
+
+/* Report transitions of the token being typed, e.g. Shift down, key down,
+ * key up, Shift up for a shifted character.
+ */
+typedef struct {
+    uint8_t keycode;
+    bool    pressed;
+} ss_step_t;
+
+#define SS_MAX_STEPS 6
+
+static char       ss_buffer[SEND_STRING_ASYNC_BUFFER_SIZE];
+static ss_index_t ss_head;
+static ss_index_t ss_count;
+
+static ss_job_t ss_jobs[SEND_STRING_ASYNC_JOBS];
+static uint8_t  ss_jobs_head;
+static uint8_t  ss_jobs_count;
+
+static ss_step_t ss_steps[SS_MAX_STEPS];
+static uint8_t   ss_step_index;
+static uint8_t   ss_step_count;
+
+static uint32_t ss_deadline;
+static bool     ss_waiting;
+
+// Whether the current job has started typing, and the mods it released
+static bool    ss_job_started;
+static uint8_t ss_saved_mods;
+
+// One bit per keycode the engine has registered and not unregistered yet
+static uint8_t ss_held[256 / 8];
+
+static bool send_string_async_enqueue(const char *str, bool progmem, uint8_t interval, bool clear_mods, send_string_async_callback_t callback) {
+    size_t length = 0;
+    while (progmem ? pgm_read_byte(str + length) : str[length]) {
+        length++;
+    }
+    if (ss_jobs_count == SEND_STRING_ASYNC_JOBS || length + 1 > (size_t)(SEND_STRING_ASYNC_BUFFER_SIZE - ss_count)) {
+        return false;
+    }
+
+    ss_index_t tail = (ss_head + ss_count) % SEND_STRING_ASYNC_BUFFER_SIZE;
+    for (size_t i = 0; i <= length; i++) {
+        ss_buffer[tail] = progmem ? pgm_read_byte(str + i) : str[i];
+        tail            = (tail + 1) % SEND_STRING_ASYNC_BUFFER_SIZE;
+    }
+    ss_count += length + 1;
+
+    ss_job_t *job = &ss_jobs[(ss_jobs_head + ss_jobs_count) % SEND_STRING_ASYNC_JOBS];
+    job->interval   = interval;
+    job->clear_mods = clear_mods;
+    job->callback   = callback;
+    ss_jobs_count++;
+    return true;
+}
+
+bool send_string_async(const char *str, uint8_t interval, send_string_async_callback_t callback) { return send_string_async_enqueue(str, false, interval, false, callback); }
+
+bool send_string_async_P(const char *str, uint8_t interval, send_string_async_callback_t callback) { return send_string_async_enqueue(str, true, interval, false, callback); }
+
+bool send_string_async_clear_mods(const char *str, uint8_t interval, send_string_async_callback_t callback) { return send_string_async_enqueue(str, false, interval, true, callback); }
+
+bool send_string_async_busy(void) { return ss_jobs_count > 0 || ss_step_index < ss_step_count; }
+
+static char ss_peek(void) { return ss_count ? ss_buffer[ss_head] : 0; }
+
+static char ss_pop(void) {
+    char c = ss_peek();
+    if (ss_count) {
+        ss_head = (ss_head + 1) % SEND_STRING_ASYNC_BUFFER_SIZE;
+        ss_count--;
+    }
+    return c;
+}
+
+// Consumes the job's terminator if it comes next, so that a string cut short
+// after SS_QMK_PREFIX doesn't eat it as part of the escape
+static bool ss_at_end(void) {
+    if (ss_peek()) {
+        return false;
+    }
+    ss_pop();
+    return true;
+}
+
+static void ss_add_step(uint8_t keycode, bool pressed) {
+    ss_steps[ss_step_count].keycode = keycode;
+    ss_steps[ss_step_count].pressed = pressed;
+    ss_step_count++;
+}
+
+static void ss_wait(uint32_t ms) {
+    if (ms) {
+        ss_deadline = timer_read32() + ms;
+        ss_waiting  = true;
+    }
+}
+
+static void ss_start_job(void) {
+    ss_job_started = true;
+    if (ss_jobs[ss_jobs_head].clear_mods) {
+        // Released with the first report of the job, like unicode_input_start()
+        ss_saved_mods = get_mods();
+        clear_mods();
+    }
+}
+
+// Finishes the current job and hands its callback to the caller, so that the
+// engine is consistent before user code (which may queue more strings) runs.
+static send_string_async_callback_t ss_finish_job(void) {
+    send_string_async_callback_t callback = ss_jobs[ss_jobs_head].callback;
+    if (ss_job_started && ss_jobs[ss_jobs_head].clear_mods && ss_saved_mods) {
+        set_mods(ss_saved_mods);
+        send_keyboard_report();
+    }
+    ss_job_started = false;
+    ss_jobs_head   = (ss_jobs_head + 1) % SEND_STRING_ASYNC_JOBS;
+    ss_jobs_count--;
+    return callback;
+}
+
+// Turns the next token of the current job into steps. Returns false once the
+// job's terminator has been consumed.
+static bool ss_load_token(void) {
+    uint8_t interval = ss_jobs[ss_jobs_head].interval;
+    char    ascii    = ss_pop();
+
+    ss_step_index = 0;
+    ss_step_count = 0;
+
+    if (!ascii) {
+        return false;
+    }
+    if (ascii == SS_QMK_PREFIX) {
+        if (ss_at_end()) {
+            return false;
+        }
+        ascii = ss_pop();
+        if (ascii == SS_TAP_CODE || ascii == SS_DOWN_CODE || ascii == SS_UP_CODE) {
+            if (ss_at_end()) {
+                return false;
+            }
+            uint8_t keycode = ss_pop();
+            if (ascii != SS_UP_CODE) ss_add_step(keycode, true);
+            if (ascii != SS_DOWN_CODE) ss_add_step(keycode, false);
+        } else if (ascii == SS_DELAY_CODE) {
+            uint32_t ms = 0;
+            while (isdigit((uint8_t)ss_peek())) {
+                ms = ms * 10 + (ss_pop() - '0');
+            }
+            // Skip the '|' closing SS_DELAY()
+            if (ss_peek()) {
+                ss_pop();
+            }
+            ss_wait(ms + interval);
+        }
+        return true;
+    }
+
+#if defined(AUDIO_ENABLE) && defined(SENDSTRING_BELL)
+    if (ascii == '\a') {
+        send_char(ascii);
+        ss_wait(interval);
+        return true;
+    }
+#endif
+
+    uint8_t keycode    = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii]);
+    bool    is_shifted = (pgm_read_byte(&ascii_to_shift_lut[(uint8_t)ascii / 8]) >> ((uint8_t)ascii % 8)) & 0x01;
+    bool    is_altgred = (pgm_read_byte(&ascii_to_altgr_lut[(uint8_t)ascii / 8]) >> ((uint8_t)ascii % 8)) & 0x01;
+
+    if (is_shifted) ss_add_step(KC_LSFT, true);
+    if (is_altgred) ss_add_step(KC_RALT, true);
+    ss_add_step(keycode, true);
+    ss_add_step(keycode, false);
+    if (is_altgred) ss_add_step(KC_RALT, false);
+    if (is_shifted) ss_add_step(KC_LSFT, false);
+    return true;
+}
+
+static void ss_run_step(void) {
+    ss_step_t *step = &ss_steps[ss_step_index++];
+    uint8_t    bit  = 1 << (step->keycode % 8);
+    if (step->pressed) {
+        ss_held[step->keycode / 8] |= bit;
+        register_code(step->keycode);
+    } else {
+        ss_held[step->keycode / 8] &= ~bit;
+        unregister_code(step->keycode);
+    }
+    if (ss_step_index == ss_step_count) {
+        ss_wait(ss_jobs[ss_jobs_head].interval);
+    }
+}
+
+void send_string_async_task(void) {
+    if (ss_waiting) {
+        if (!timer_expired32(timer_read32(), ss_deadline)) {
+            return;
+        }
+        ss_waiting = false;
+    }
+
+    // Tokens that produce no report (delays, job boundaries) do not use up a
+    // call, so every call that has work to do sends exactly one transition.
+    while (ss_step_index == ss_step_count) {
+        if (!ss_jobs_count) {
+            return;
+        }
+        if (!ss_job_started) {
+            ss_start_job();
+        }
+        if (!ss_load_token()) {
+            send_string_async_callback_t callback = ss_finish_job();
+            if (callback) {
+                callback(true);
+            }
+            continue;
+        }
+        if (ss_waiting) {
+            return;
+        }
+    }
+    ss_run_step();
+}
+
+void send_string_async_flush(void) {
+    while (send_string_async_busy()) {
+        if (ss_waiting && !timer_expired32(timer_read32(), ss_deadline)) {
+            wait_ms(1);
+            continue;
+        }
+        send_string_async_task();
+    }
+}
+
+void send_string_async_cancel(void) {
+    // Release every key the engine still holds, including SS_DOWN() of
+    // earlier tokens
+    for (uint16_t keycode = 0; keycode < 256; keycode++) {
+        if (ss_held[keycode / 8] & (1 << (keycode % 8))) {
+            ss_held[keycode / 8] &= ~(1 << (keycode % 8));
+            unregister_code(keycode);
+        }
+    }
+    ss_step_index = 0;
+    ss_step_count = 0;
+
+    send_string_async_callback_t callbacks[SEND_STRING_ASYNC_JOBS];
+    uint8_t                      dropped = 0;
+    while (ss_jobs_count) {
+        callbacks[dropped++] = ss_finish_job();
+    }
+    ss_head    = 0;
+    ss_count   = 0;
+    ss_waiting = false;
+
+    for (uint8_t i = 0; i < dropped; i++) {
+        if (callbacks[i]) {
+            callbacks[i](false);
+        }
+    }
+}
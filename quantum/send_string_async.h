@@ -0,0 +1,62 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Bytes of string data that can be queued at once, terminators included. */
+#ifndef SEND_STRING_ASYNC_BUFFER_SIZE
+#    define SEND_STRING_ASYNC_BUFFER_SIZE 128
+#endif
+
+/* Number of strings that can be queued at once. */
+#ifndef SEND_STRING_ASYNC_JOBS
+#    define SEND_STRING_ASYNC_JOBS 4
+#endif
+
+/* Called once a queued string has been fully typed (completed == true),
+ * or when it is dropped by send_string_async_cancel() (completed == false).
+ */
+typedef void (*send_string_async_callback_t)(bool completed);
+
+/* Queue a string to be typed from send_string_async_task(), one report
+ * transition per call. Delays (SS_DELAY() and interval) are timestamps,
+ * the caller never blocks. The string is copied, so it may live on the
+ * stack. Returns false without queueing anything if it does not fit.
+ */
+bool send_string_async(const char *str, uint8_t interval, send_string_async_callback_t callback);
+bool send_string_async_P(const char *str, uint8_t interval, send_string_async_callback_t callback);
+
+/* Like send_string_async(), but the mods held when the string starts are
+ * released while it is typed and pressed again afterwards, as
+ * unicode_input_start() and unicode_input_finish() do.
+ */
+bool send_string_async_clear_mods(const char *str, uint8_t interval, send_string_async_callback_t callback);
+
+/* Drop every queued string. Every key the engine pressed and has not
+ * released yet is released; the callbacks of dropped strings are called
+ * with false.
+ */
+void send_string_async_cancel(void);
+
+/* Type everything queued, blocking like send_string(). */
+void send_string_async_flush(void);
+
+bool send_string_async_busy(void);
+
+void send_string_async_task(void);
@@ -20,6 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "matrix.h"
 #include "debounce.h"
 #include "quantum.h"
+#ifdef MATRIX_IDLE_ENABLE
+#    include "matrix_idle.h"
+#endif
 #include "split_util.h"
 #include "config.h"
 #include "transport.h"
@@ -194,6 +197,83 @@ static bool read_rows_on_col(matrix_row_t current_matrix[], uint8_t current_col)
 #    error DIODE_DIRECTION is not defined!
 #endif
 
+#ifdef MATRIX_IDLE_ENABLE
+// While idle every row is selected at once, so any key press pulls its column low
+
+#    if defined(DIRECT_PINS)
+
+static void idle_select_all(void) {}
+
+static void idle_unselect_all(void) {}
+
+static bool idle_key_down(void) {
+    for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            pin_t pin = direct_pins[row][col];
+            if (pin != NO_PIN && !readPin(pin)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void idle_enter(void) { matrix_idle_enter(&direct_pins[0][0], ROWS_PER_HAND * MATRIX_COLS); }
+
+#    elif (DIODE_DIRECTION == COL2ROW)
+
+static void idle_select_all(void) {
+    for (uint8_t x = 0; x < ROWS_PER_HAND; x++) {
+        select_row(x);
+    }
+}
+
+static void idle_unselect_all(void) { unselect_rows(); }
+
+static bool idle_key_down(void) {
+    for (uint8_t x = 0; x < MATRIX_COLS; x++) {
+        if (!readPin(col_pins[x])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void idle_enter(void) { matrix_idle_enter(col_pins, MATRIX_COLS); }
+
+#    elif (DIODE_DIRECTION == ROW2COL)
+
+static void idle_select_all(void) {
+    for (uint8_t x = 0; x < MATRIX_COLS; x++) {
+        select_col(x);
+    }
+}
+
+static void idle_unselect_all(void) { unselect_cols(); }
+
+static bool idle_key_down(void) {
+    for (uint8_t x = 0; x < ROWS_PER_HAND; x++) {
+        if (!readPin(row_pins[x])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void idle_enter(void) { matrix_idle_enter(row_pins, ROWS_PER_HAND); }
+
+#    endif
+
+static bool matrix_active(matrix_row_t cooked[]) {
+    for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+        if (raw_matrix[row] || cooked[row]) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
 void matrix_init(void) {
     split_pre_init();
 
@@ -244,7 +324,11 @@ void matrix_post_scan(void) {
     if (is_keyboard_master()) {
         static uint8_t error_count;
 
-        if (!transport_master(matrix + thatHand)) {
+        PROFILER_BEGIN(transport);
+        bool connected = transport_master(matrix + thatHand);
+        PROFILER_END(PROFILER_TRANSPORT, transport);
+
+        if (!connected) {
             error_count++;
 
             if (error_count > ERROR_DISCONNECT_COUNT) {
@@ -268,6 +352,23 @@ void matrix_post_scan(void) {
 uint8_t matrix_scan(void) {
     bool changed = false;
 
+#ifdef MATRIX_IDLE_ENABLE
+    if (matrix_is_idle()) {
+        // The master keeps polling the other half, so only the slave sleeps
+        if (!is_keyboard_master() && !idle_key_down()) {
+            matrix_idle_wait();
+        }
+        if (!idle_key_down()) {
+            matrix_post_scan();
+            return 0;
+        }
+        // Scan right away, so the key that woke us is seen in this call
+        matrix_idle_leave();
+        idle_unselect_all();
+        matrix_io_delay();
+    }
+#endif
+
 #if defined(DIRECT_PINS) || (DIODE_DIRECTION == COL2ROW)
     // Set row, read cols
     for (uint8_t current_row = 0; current_row < ROWS_PER_HAND; current_row++) {
@@ -280,7 +381,16 @@ uint8_t matrix_scan(void) {
     }
 #endif
 
+    PROFILER_BEGIN(debounce);
     debounce(raw_matrix, matrix + thisHand, ROWS_PER_HAND, changed);
+    PROFILER_END(PROFILER_DEBOUNCE, debounce);
+
+#ifdef MATRIX_IDLE_ENABLE
+    if (matrix_idle_update(changed || matrix_active(matrix + thisHand))) {
+        idle_select_all();
+        idle_enter();
+    }
+#endif
 
     matrix_post_scan();
     return (uint8_t)changed;
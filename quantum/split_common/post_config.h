@@ -8,12 +8,21 @@
 #        define F_SCL 100000UL  // SCL frequency
 #    endif
 
+// The slave's registers hold the transport state and the split sync channels,
+// transport.c checks that they fit
+#    ifndef SPLIT_SYNC_BUFFER_SIZE
+#        define SPLIT_SYNC_BUFFER_SIZE 32
+#    endif
+#    ifndef I2C_SLAVE_REG_COUNT
+#        define I2C_SLAVE_REG_COUNT (30 + SPLIT_SYNC_BUFFER_SIZE)
+#    endif
+
 #else  // use serial
 // When using serial, the user must define RGBLIGHT_SPLIT explicitly
 //  in config.h as needed.
 //      see quantum/rgblight_post_config.h
-#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
-// When using serial and RGBLIGHT_SPLIT need separate transaction
+// The split transport fetches the matrix with a header and a payload transaction
+#    ifndef SERIAL_USE_MULTI_TRANSACTION
 #        define SERIAL_USE_MULTI_TRANSACTION
 #    endif
 #endif
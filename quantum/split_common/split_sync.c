@@ -0,0 +1,145 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "quantum.h"
+#include "split_sync.h"
+
+#if SPLIT_SYNC_MAX_CHANNELS > 16
+#    error "SPLIT_SYNC_MAX_CHANNELS can be at most 16"
+#endif
+
+static split_sync_channel_t channels[SPLIT_SYNC_MAX_CHANNELS];
+static uint8_t              channel_count;
+static uint8_t              buffer_used;
+static uint8_t              sync_buffer[SPLIT_SYNC_BUFFER_SIZE];
+static uint16_t             dirty;
+
+int8_t split_sync_register(uint8_t size, split_sync_get_t get, split_sync_set_t set) {
+    if (channel_count >= SPLIT_SYNC_MAX_CHANNELS || size == 0 || size > SPLIT_SYNC_BUFFER_SIZE - buffer_used) {
+        return -1;
+    }
+    channels[channel_count] = (split_sync_channel_t){.size = size, .offset = buffer_used, .get = get, .set = set};
+    buffer_used += size;
+    dirty |= (uint16_t)1U << channel_count;
+    return channel_count++;
+}
+
+__attribute__((weak)) void split_sync_register_user(void) {}
+
+__attribute__((weak)) void split_sync_register_kb(void) { split_sync_register_user(); }
+
+#ifdef SPLIT_LAYER_STATE_ENABLE
+typedef struct {
+    layer_state_t layer_state;
+    layer_state_t default_layer_state;
+} split_layers_t;
+
+static void split_layers_get(void *data) { *(split_layers_t *)data = (split_layers_t){.layer_state = layer_state, .default_layer_state = default_layer_state}; }
+
+static void split_layers_set(const void *data) {
+    const split_layers_t *layers = data;
+    default_layer_set(layers->default_layer_state);
+    layer_state_set(layers->layer_state);
+}
+#endif
+
+#ifdef SPLIT_MODS_ENABLE
+typedef struct {
+    uint8_t real;
+    uint8_t weak;
+#    ifndef NO_ACTION_ONESHOT
+    uint8_t oneshot;
+#    endif
+} split_mods_t;
+
+static void split_mods_get(void *data) {
+    split_mods_t *mods = data;
+    mods->real         = get_mods();
+    mods->weak         = get_weak_mods();
+#    ifndef NO_ACTION_ONESHOT
+    mods->oneshot = get_oneshot_mods();
+#    endif
+}
+
+static void split_mods_set(const void *data) {
+    const split_mods_t *mods = data;
+    set_mods(mods->real);
+    set_weak_mods(mods->weak);
+#    ifndef NO_ACTION_ONESHOT
+    set_oneshot_mods(mods->oneshot);
+#    endif
+}
+#endif
+
+#ifdef SPLIT_LED_STATE_ENABLE
+static void split_leds_get(void *data) { *(uint8_t *)data = host_keyboard_leds(); }
+
+static void split_leds_set(const void *data) { host_set_slave_keyboard_leds(*(const uint8_t *)data); }
+#endif
+
+#if defined(RGB_MATRIX_ENABLE) && defined(SPLIT_RGB_MATRIX_ENABLE)
+static void split_rgb_matrix_get(void *data) { memcpy(data, &rgb_matrix_config, sizeof(rgb_matrix_config)); }
+
+static void split_rgb_matrix_set(const void *data) { memcpy(&rgb_matrix_config, data, sizeof(rgb_matrix_config)); }
+#endif
+
+void split_sync_init(void) {
+    channel_count = 0;
+    buffer_used   = 0;
+    dirty         = 0;
+
+#ifdef SPLIT_LAYER_STATE_ENABLE
+    split_sync_register(sizeof(split_layers_t), split_layers_get, split_layers_set);
+#endif
+#ifdef SPLIT_MODS_ENABLE
+    split_sync_register(sizeof(split_mods_t), split_mods_get, split_mods_set);
+#endif
+#ifdef SPLIT_LED_STATE_ENABLE
+    split_sync_register(sizeof(uint8_t), split_leds_get, split_leds_set);
+#endif
+#if defined(RGB_MATRIX_ENABLE) && defined(SPLIT_RGB_MATRIX_ENABLE)
+    split_sync_register(sizeof(rgb_matrix_config), split_rgb_matrix_get, split_rgb_matrix_set);
+#endif
+
+    split_sync_register_kb();
+}
+
+uint8_t split_sync_count(void) { return channel_count; }
+
+const split_sync_channel_t *split_sync_channel(uint8_t channel) { return &channels[channel]; }
+
+uint8_t *split_sync_data(uint8_t channel) { return &sync_buffer[channels[channel].offset]; }
+
+uint16_t split_sync_master_update(void) {
+    uint8_t current[SPLIT_SYNC_BUFFER_SIZE];
+    for (uint8_t i = 0; i < channel_count; i++) {
+        split_sync_channel_t *channel = &channels[i];
+        channel->get(current);
+        if (memcmp(current, &sync_buffer[channel->offset], channel->size)) {
+            memcpy(&sync_buffer[channel->offset], current, channel->size);
+            dirty |= (uint16_t)1U << i;
+        }
+    }
+    return dirty;
+}
+
+void split_sync_master_sent(uint8_t channel) { dirty &= ~((uint16_t)1U << channel); }
+
+void split_sync_master_invalidate(void) { dirty = (uint16_t)((1UL << channel_count) - 1); }
+
+void split_sync_slave_received(uint8_t channel) { channels[channel].set(&sync_buffer[channels[channel].offset]); }
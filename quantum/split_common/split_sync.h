@@ -0,0 +1,73 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Split sync channels
+ *
+ * Small pieces of master state mirrored to the slave half, so that it can
+ * render OLEDs and LEDs from them locally. Each channel is a blob of up to
+ * SPLIT_SYNC_BUFFER_SIZE bytes: on the master the getter fills it in every
+ * scan, and the transport sends it only when it differs from what the slave
+ * last received, where the setter applies it.
+ *
+ * Channels must be registered in the same order on both halves, from
+ * split_sync_register_user() or split_sync_register_kb().
+ */
+
+#ifndef SPLIT_SYNC_MAX_CHANNELS
+#    define SPLIT_SYNC_MAX_CHANNELS 8
+#endif
+
+// Total size of all the channels' blobs
+#ifndef SPLIT_SYNC_BUFFER_SIZE
+#    define SPLIT_SYNC_BUFFER_SIZE 32
+#endif
+
+typedef void (*split_sync_get_t)(void *data);
+typedef void (*split_sync_set_t)(const void *data);
+
+typedef struct {
+    uint8_t          size;
+    uint8_t          offset;  // into the sync buffer
+    split_sync_get_t get;     // master, fills in the current value
+    split_sync_set_t set;     // slave, applies a received value
+} split_sync_channel_t;
+
+// Returns the channel number, or -1 if there is no room left
+int8_t split_sync_register(uint8_t size, split_sync_get_t get, split_sync_set_t set);
+
+void split_sync_register_kb(void);
+void split_sync_register_user(void);
+
+// Drops all channels and registers the built in ones followed by the keyboard's
+void split_sync_init(void);
+
+uint8_t                     split_sync_count(void);
+const split_sync_channel_t *split_sync_channel(uint8_t channel);
+uint8_t *                   split_sync_data(uint8_t channel);
+
+// Master: reads every channel and returns a bitmask of the ones the slave doesn't have yet
+uint16_t split_sync_master_update(void);
+void     split_sync_master_sent(uint8_t channel);
+// Master: the slave lost its state, send every channel again
+void split_sync_master_invalidate(void);
+
+// Slave: the channel's data has been replaced by the master's
+void split_sync_slave_received(uint8_t channel);
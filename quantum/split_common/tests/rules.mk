@@ -0,0 +1,14 @@
+SPLIT_TESTS_PATH := $(QUANTUM_PATH)/split_common/tests
+
+split_transport_DEFS := -DNO_PRINT -DSERIAL_USE_MULTI_TRANSACTION -DRGBLIGHT_ENABLE -DRGBLIGHT_SPLIT -DBACKLIGHT_ENABLE -DWPM_ENABLE
+split_transport_INC := $(SPLIT_TESTS_PATH) $(QUANTUM_PATH)/split_common $(QUANTUM_PATH)/backlight
+split_transport_SRC := \
+	$(SPLIT_TESTS_PATH)/transport_tests.cpp \
+	$(SPLIT_TESTS_PATH)/serial_loopback.c \
+	$(SPLIT_TESTS_PATH)/transport_master.c \
+	$(SPLIT_TESTS_PATH)/transport_slave.c \
+	$(TMK_PATH)/common/test/timer.c
+
+split_transport_wide_DEFS := $(split_transport_DEFS) -DMATRIX_COLS=20
+split_transport_wide_INC := $(split_transport_INC)
+split_transport_wide_SRC := $(split_transport_SRC)
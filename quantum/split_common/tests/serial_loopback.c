@@ -0,0 +1,70 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "serial.h"
+#include "serial_loopback.h"
+
+loopback_stats_t loopback_stats;
+int              loopback_corrupt_transaction = -1;
+bool             loopback_disconnected;
+
+static SSTD_t *initiator_table;
+static int     initiator_table_size;
+static SSTD_t *target_table;
+static int     target_table_size;
+
+void soft_serial_initiator_init(SSTD_t *sstd_table, int sstd_table_size) {
+    initiator_table      = sstd_table;
+    initiator_table_size = sstd_table_size;
+}
+
+void soft_serial_target_init(SSTD_t *sstd_table, int sstd_table_size) {
+    target_table      = sstd_table;
+    target_table_size = sstd_table_size;
+}
+
+int soft_serial_transaction(int sstd_index) {
+    if (loopback_disconnected) {
+        return TRANSACTION_NO_RESPONSE;
+    }
+    if (sstd_index >= initiator_table_size || sstd_index >= target_table_size) {
+        return TRANSACTION_TYPE_ERROR;
+    }
+
+    SSTD_t *initiator = &initiator_table[sstd_index];
+    SSTD_t *target    = &target_table[sstd_index];
+    // Both sides have to agree on the sizes, the wire has no length field
+    if (initiator->initiator2target_buffer_size != target->initiator2target_buffer_size || initiator->target2initiator_buffer_size != target->target2initiator_buffer_size) {
+        *target->status = TRANSACTION_DATA_ERROR;
+        return TRANSACTION_DATA_ERROR;
+    }
+
+    loopback_stats.transactions++;
+    loopback_stats.bytes += 1 + initiator->initiator2target_buffer_size + initiator->target2initiator_buffer_size;
+
+    memcpy(target->initiator2target_buffer, initiator->initiator2target_buffer, initiator->initiator2target_buffer_size);
+    *target->status = TRANSACTION_ACCEPTED;
+
+    if (loopback_corrupt_transaction == sstd_index) {
+        loopback_corrupt_transaction = -1;
+        memset(initiator->target2initiator_buffer, 0xA5, initiator->target2initiator_buffer_size);
+        return TRANSACTION_DATA_ERROR;
+    }
+    memcpy(initiator->target2initiator_buffer, target->target2initiator_buffer, initiator->target2initiator_buffer_size);
+    return TRANSACTION_END;
+}
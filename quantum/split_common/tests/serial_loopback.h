@@ -0,0 +1,32 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;  // transaction ids and buffer contents in both directions
+} loopback_stats_t;
+
+extern loopback_stats_t loopback_stats;
+
+// The next transaction with this index reaches the slave but the master sees a data error, -1 for none
+extern int loopback_corrupt_transaction;
+// The slave is not answering
+extern bool loopback_disconnected;
@@ -0,0 +1,34 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The slave half of the loopback pair, transport.c and split_sync.c under their own names
+
+#define transport_master_init slave_transport_master_init
+#define transport_slave_init slave_transport_slave_init
+#define transport_master slave_transport_master
+#define transport_slave slave_transport_slave
+#define split_sync_register slave_split_sync_register
+#define split_sync_init slave_split_sync_init
+#define split_sync_count slave_split_sync_count
+#define split_sync_channel slave_split_sync_channel
+#define split_sync_data slave_split_sync_data
+#define split_sync_master_update slave_split_sync_master_update
+#define split_sync_master_sent slave_split_sync_master_sent
+#define split_sync_master_invalidate slave_split_sync_master_invalidate
+#define split_sync_slave_received slave_split_sync_slave_received
+
+#include "transport.c"
+#include "split_sync.c"
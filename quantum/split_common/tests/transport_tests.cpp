@@ -0,0 +1,335 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <random>
+
+extern "C" {
+#include "config.h"
+#include "quantum.h"
+#include "serial_loopback.h"
+#include "split_sync.h"
+
+void master_transport_master_init(void);
+bool master_transport_master(matrix_row_t matrix[]);
+void slave_transport_slave_init(void);
+void slave_transport_slave(matrix_row_t matrix[]);
+int8_t master_split_sync_register(uint8_t size, split_sync_get_t get, split_sync_set_t set);
+int8_t slave_split_sync_register(uint8_t size, split_sync_get_t get, split_sync_set_t set);
+
+// Master side features
+static uint8_t rgblight_change_flags;
+static uint8_t master_backlight_level;
+static uint8_t current_wpm;
+
+uint8_t rgblight_get_change_flags(void) { return rgblight_change_flags; }
+void    rgblight_clear_change_flags(void) { rgblight_change_flags = 0; }
+void    rgblight_get_syncinfo(rgblight_syncinfo_t *syncinfo) { memset(syncinfo, 0x11, sizeof(*syncinfo)); }
+bool    is_backlight_enabled(void) { return true; }
+uint8_t get_backlight_level(void) { return master_backlight_level; }
+uint8_t get_current_wpm(void) { return current_wpm; }
+
+// Slave side features
+static uint32_t rgblight_syncs;
+static uint8_t  slave_backlight_level;
+static uint32_t backlight_sets;
+static uint8_t  slave_wpm;
+
+void rgblight_update_sync(rgblight_syncinfo_t *syncinfo, bool write_to_eeprom) { rgblight_syncs++; }
+void backlight_set(uint8_t level) {
+    slave_backlight_level = level;
+    backlight_sets++;
+}
+void set_current_wpm(uint8_t wpm) { slave_wpm = wpm; }
+
+// Sync channels, registered on whichever half is being initialised
+static int8_t (*sync_register)(uint8_t size, split_sync_get_t get, split_sync_set_t set);
+static uint32_t master_layers, slave_layers;
+static uint8_t  master_mods[3], slave_mods[3];
+static uint32_t slave_layer_updates;
+
+static void layers_get(void *data) { memcpy(data, &master_layers, sizeof(master_layers)); }
+static void layers_set(const void *data) {
+    memcpy(&slave_layers, data, sizeof(slave_layers));
+    slave_layer_updates++;
+}
+static void mods_get(void *data) { memcpy(data, master_mods, sizeof(master_mods)); }
+static void mods_set(const void *data) { memcpy(slave_mods, data, sizeof(slave_mods)); }
+
+void split_sync_register_user(void) {
+    sync_register(sizeof(master_layers), layers_get, layers_set);
+    sync_register(sizeof(master_mods), mods_get, mods_set);
+}
+}
+
+#define ROWS_PER_HAND (MATRIX_ROWS / 2)
+
+class SplitTransport : public testing::Test {
+   protected:
+    void SetUp() override {
+        memset(&loopback_stats, 0, sizeof(loopback_stats));
+        loopback_corrupt_transaction = -1;
+        loopback_disconnected = false;
+        rgblight_change_flags = 0;
+        rgblight_syncs        = 0;
+        master_backlight_level       = 0;
+        backlight_sets        = 0;
+        current_wpm           = 0;
+        memset(slave_matrix, 0, sizeof(slave_matrix));
+        memset(master_matrix, 0, sizeof(master_matrix));
+        master_layers       = 0;
+        slave_layers        = 0;
+        slave_layer_updates = 0;
+        memset(master_mods, 0, sizeof(master_mods));
+        memset(slave_mods, 0, sizeof(slave_mods));
+        sync_register = slave_split_sync_register;
+        slave_transport_slave_init();
+        sync_register = master_split_sync_register;
+        master_transport_master_init();
+    }
+
+    // One pass of the slave's main loop followed by one of the master's
+    bool scan(void) {
+        slave_transport_slave(slave_matrix);
+        return master_transport_master(master_matrix);
+    }
+
+    void sync(void) {
+        for (int i = 0; i < 4; i++) {
+            scan();
+        }
+        ASSERT_TRUE(scan());
+        memset(&loopback_stats, 0, sizeof(loopback_stats));
+    }
+
+    void expect_matrix_eq(void) {
+        for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+            EXPECT_EQ(slave_matrix[row], master_matrix[row]) << "row " << (int)row;
+        }
+    }
+
+    // Bytes per scan the previous format sent: every row and all master state each scan
+    double legacy_bytes_per_scan(void) { return 1 + sizeof(matrix_row_t) * ROWS_PER_HAND + 2; }
+
+    void report(const char *scenario, uint32_t scans, uint32_t extra_legacy_bytes) {
+        printf("[   INFO   ] %s, %dx%d per half: %.2f bytes/scan in %.2f transactions, was %.2f\n", scenario, ROWS_PER_HAND, MATRIX_COLS, (double)loopback_stats.bytes / scans, (double)loopback_stats.transactions / scans, legacy_bytes_per_scan() + (double)extra_legacy_bytes / scans);
+    }
+
+    matrix_row_t slave_matrix[ROWS_PER_HAND];
+    matrix_row_t master_matrix[ROWS_PER_HAND];
+};
+
+TEST_F(SplitTransport, SyncsAFullFrameFirst) {
+    slave_matrix[1] = 0x05;
+    slave_matrix[4] = MATRIX_ROW_SHIFTER << (MATRIX_COLS - 1);
+    // The slave waits for the master to ask for a resync
+    EXPECT_FALSE(scan());
+    EXPECT_TRUE(scan());
+    expect_matrix_eq();
+}
+
+TEST_F(SplitTransport, IdleScansOnlyExchangeTheHeader) {
+    sync();
+    const uint32_t scans = 1000;
+    for (uint32_t i = 0; i < scans; i++) {
+        ASSERT_TRUE(scan());
+    }
+    EXPECT_EQ(scans, loopback_stats.transactions);
+    EXPECT_EQ(scans * 4, loopback_stats.bytes);
+    report("idle", scans, 0);
+}
+
+TEST_F(SplitTransport, TypingSendsOnlyChangedRows) {
+    sync();
+    std::mt19937   rng(7);
+    const uint32_t scans = 20000;
+    for (uint32_t i = 0; i < scans; i++) {
+        // a key goes down or up every 30 scans or so
+        if (rng() % 30 == 0) {
+            slave_matrix[rng() % ROWS_PER_HAND] ^= MATRIX_ROW_SHIFTER << (rng() % MATRIX_COLS);
+        }
+        ASSERT_TRUE(scan());
+        for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+            ASSERT_EQ(slave_matrix[row], master_matrix[row]) << "scan " << i << " row " << (int)row;
+        }
+    }
+    EXPECT_LT(loopback_stats.bytes, scans * 5);
+    report("typing", scans, 0);
+}
+
+TEST_F(SplitTransport, EveryRowChangingEveryScan) {
+    sync();
+    std::mt19937 rng(11);
+    for (uint32_t i = 0; i < 2000; i++) {
+        for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+            slave_matrix[row] = rng() & ((MATRIX_ROW_SHIFTER << (MATRIX_COLS - 1)) * 2 - 1);
+        }
+        ASSERT_TRUE(scan());
+        for (uint8_t row = 0; row < ROWS_PER_HAND; row++) {
+            ASSERT_EQ(slave_matrix[row], master_matrix[row]) << "scan " << i << " row " << (int)row;
+        }
+    }
+}
+
+TEST_F(SplitTransport, HeavyRGB) {
+    sync();
+    std::mt19937   rng(3);
+    const uint32_t scans = 5000;
+    for (uint32_t i = 0; i < scans; i++) {
+        // an animation changing the sync info on every scan while typing
+        rgblight_change_flags = 1;
+        if (rng() % 30 == 0) {
+            slave_matrix[rng() % ROWS_PER_HAND] ^= MATRIX_ROW_SHIFTER << (rng() % MATRIX_COLS);
+        }
+        ASSERT_TRUE(scan());
+    }
+    slave_transport_slave(slave_matrix);
+    expect_matrix_eq();
+    EXPECT_EQ(scans, rgblight_syncs);
+    report("heavy RGB", scans, scans * (1 + sizeof(rgblight_syncinfo_t)));
+}
+
+TEST_F(SplitTransport, MasterStateIsSentWhenItChanges) {
+    sync();
+    // the full sync sent the initial state
+    EXPECT_EQ(1u, backlight_sets);
+    backlight_sets = 0;
+    master_backlight_level = 3;
+    current_wpm     = 42;
+    scan();
+    scan();
+    EXPECT_EQ(3, slave_backlight_level);
+    EXPECT_EQ(42, slave_wpm);
+    EXPECT_EQ(1u, backlight_sets);
+
+    for (int i = 0; i < 10; i++) {
+        scan();
+    }
+    EXPECT_EQ(1u, backlight_sets);
+
+    current_wpm = 43;
+    scan();
+    scan();
+    EXPECT_EQ(43, slave_wpm);
+    EXPECT_EQ(1u, backlight_sets);
+}
+
+TEST_F(SplitTransport, CorruptPayloadResyncs) {
+    sync();
+    slave_matrix[2] = 0x10;
+    // the slave takes the frame as delivered, the master never got it
+    loopback_corrupt_transaction = 1;
+    EXPECT_FALSE(scan());
+    EXPECT_EQ(-1, loopback_corrupt_transaction);
+
+    slave_matrix[3] = 0x01;
+    for (int i = 0; i < 3; i++) {
+        scan();
+    }
+    EXPECT_TRUE(scan());
+    expect_matrix_eq();
+}
+
+TEST_F(SplitTransport, SlaveRestartResyncs) {
+    sync();
+    master_backlight_level = 2;
+    slave_matrix[0] = 0x01;
+    scan();
+    scan();
+    expect_matrix_eq();
+
+    // the slave comes back with nothing the master knows about
+    slave_backlight_level = 0;
+    slave_matrix[0]       = 0;
+    slave_matrix[1]       = 0x80;
+    sync_register         = slave_split_sync_register;
+    slave_transport_slave_init();
+    for (int i = 0; i < 4; i++) {
+        scan();
+    }
+    EXPECT_TRUE(scan());
+    expect_matrix_eq();
+    EXPECT_EQ(2, slave_backlight_level);
+}
+
+TEST_F(SplitTransport, ChangesMadeWhileDisconnectedArrive) {
+    sync();
+    loopback_disconnected = true;
+    slave_matrix[4]       = 0x01;
+    EXPECT_FALSE(scan());
+    slave_matrix[4] = 0x03;
+    EXPECT_FALSE(scan());
+    loopback_disconnected = false;
+    // the frame published before the link dropped goes first
+    EXPECT_TRUE(scan());
+    EXPECT_EQ(0x01, master_matrix[4]);
+    EXPECT_TRUE(scan());
+    expect_matrix_eq();
+}
+
+TEST_F(SplitTransport, SyncChannelsReachTheSlave) {
+    master_layers  = 0x0005;
+    master_mods[0] = 0x02;
+    master_mods[2] = 0x10;
+    sync();
+    scan();
+    EXPECT_EQ(0x0005u, slave_layers);
+    EXPECT_EQ(0, memcmp(master_mods, slave_mods, sizeof(master_mods)));
+
+    master_layers = 0x0001;
+    scan();
+    scan();
+    EXPECT_EQ(0x0001u, slave_layers);
+}
+
+TEST_F(SplitTransport, UnchangedSyncChannelsCostNothing) {
+    sync();
+    scan();
+    memset(&loopback_stats, 0, sizeof(loopback_stats));
+    slave_layer_updates = 0;
+
+    const uint32_t scans = 1000;
+    for (uint32_t i = 0; i < scans; i++) {
+        scan();
+    }
+    EXPECT_EQ(scans * 4, loopback_stats.bytes);
+    EXPECT_EQ(0u, slave_layer_updates);
+
+    // a layer change costs one transaction with the layer blob, once
+    master_layers = 0x0002;
+    for (uint32_t i = 0; i < scans; i++) {
+        scan();
+    }
+    EXPECT_EQ(scans * 8 + 1 + sizeof(master_layers), loopback_stats.bytes);
+    EXPECT_EQ(1u, slave_layer_updates);
+    report("idle with sync channels", scans * 2, 0);
+}
+
+TEST_F(SplitTransport, SyncChannelsAreResentAfterSlaveRestart) {
+    master_layers = 0x0008;
+    sync();
+    scan();
+    EXPECT_EQ(0x0008u, slave_layers);
+
+    slave_layers  = 0;
+    sync_register = slave_split_sync_register;
+    slave_transport_slave_init();
+    for (int i = 0; i < 5; i++) {
+        scan();
+    }
+    EXPECT_EQ(0x0008u, slave_layers);
+}
@@ -4,6 +4,7 @@
 #include "config.h"
 #include "matrix.h"
 #include "quantum.h"
+#include "split_sync.h"
 
 #define ROWS_PER_HAND (MATRIX_ROWS / 2)
 
@@ -28,6 +29,7 @@ static pin_t encoders_pad[] = ENCODERS_PAD_A;
 
 typedef struct _I2C_slave_buffer_t {
     matrix_row_t smatrix[ROWS_PER_HAND];
+    uint8_t      sync_valid;  // zero after the slave restarts, read with the matrix
     uint8_t      backlight_level;
 #    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
     rgblight_syncinfo_t rgblight_sync;
@@ -38,15 +40,21 @@ typedef struct _I2C_slave_buffer_t {
 #    ifdef WPM_ENABLE
     uint8_t current_wpm;
 #    endif
+    uint8_t sync[SPLIT_SYNC_BUFFER_SIZE];
 } I2C_slave_buffer_t;
 
+_Static_assert(sizeof(I2C_slave_buffer_t) <= I2C_SLAVE_REG_COUNT, "The split transport does not fit in the I2C slave registers, increase I2C_SLAVE_REG_COUNT");
+_Static_assert(I2C_SLAVE_REG_COUNT <= 256, "I2C register addresses are one byte");
+
 static I2C_slave_buffer_t *const i2c_buffer = (I2C_slave_buffer_t *)i2c_slave_reg;
 
 #    define I2C_BACKLIGHT_START offsetof(I2C_slave_buffer_t, backlight_level)
 #    define I2C_RGB_START offsetof(I2C_slave_buffer_t, rgblight_sync)
 #    define I2C_KEYMAP_START offsetof(I2C_slave_buffer_t, smatrix)
+#    define I2C_SYNC_VALID_START offsetof(I2C_slave_buffer_t, sync_valid)
 #    define I2C_ENCODER_START offsetof(I2C_slave_buffer_t, encoder_state)
 #    define I2C_WPM_START offsetof(I2C_slave_buffer_t, current_wpm)
+#    define I2C_SYNC_START offsetof(I2C_slave_buffer_t, sync)
 
 #    define TIMEOUT 100
 
@@ -56,7 +64,18 @@ static I2C_slave_buffer_t *const i2c_buffer = (I2C_slave_buffer_t *)i2c_slave_re
 
 // Get rows from other half over i2c
 bool transport_master(matrix_row_t matrix[]) {
-    i2c_readReg(SLAVE_I2C_ADDRESS, I2C_KEYMAP_START, (void *)matrix, sizeof(i2c_buffer->smatrix), TIMEOUT);
+    // The matrix and sync_valid in one read
+    if (i2c_readReg(SLAVE_I2C_ADDRESS, I2C_KEYMAP_START, (void *)i2c_buffer->smatrix, I2C_SYNC_VALID_START + 1, TIMEOUT) >= 0) {
+        memcpy((void *)matrix, (void *)i2c_buffer->smatrix, sizeof(i2c_buffer->smatrix));
+
+        // A restarted slave has lost the split sync channels, send them all again
+        if (!i2c_buffer->sync_valid) {
+            uint8_t valid = 1;
+            if (i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_SYNC_VALID_START, &valid, sizeof(valid), TIMEOUT) >= 0) {
+                split_sync_master_invalidate();
+            }
+        }
+    }
 
     // write backlight info
 #    ifdef BACKLIGHT_ENABLE
@@ -91,6 +110,16 @@ bool transport_master(matrix_row_t matrix[]) {
         }
     }
 #    endif
+
+    uint16_t dirty = split_sync_master_update();
+    for (uint8_t i = 0; dirty; i++, dirty >>= 1) {
+        if (dirty & 1) {
+            const split_sync_channel_t *channel = split_sync_channel(i);
+            if (i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_SYNC_START + channel->offset, split_sync_data(i), channel->size, TIMEOUT) >= 0) {
+                split_sync_master_sent(i);
+            }
+        }
+    }
     return true;
 }
 
@@ -118,35 +147,95 @@ void transport_slave(matrix_row_t matrix[]) {
 #    ifdef WPM_ENABLE
     set_current_wpm(i2c_buffer->current_wpm);
 #    endif
+
+    for (uint8_t i = 0; i < split_sync_count(); i++) {
+        const split_sync_channel_t *channel = split_sync_channel(i);
+        if (memcmp(&i2c_buffer->sync[channel->offset], split_sync_data(i), channel->size)) {
+            memcpy(split_sync_data(i), &i2c_buffer->sync[channel->offset], channel->size);
+            split_sync_slave_received(i);
+        }
+    }
 }
 
-void transport_master_init(void) { i2c_init(); }
+void transport_master_init(void) {
+    split_sync_init();
+    i2c_init();
+}
 
-void transport_slave_init(void) { i2c_slave_init(SLAVE_I2C_ADDRESS); }
+void transport_slave_init(void) {
+    split_sync_init();
+    i2c_slave_init(SLAVE_I2C_ADDRESS);
+}
 
 #else  // USE_SERIAL
 
 #    include "serial.h"
 
-typedef struct _Serial_s2m_buffer_t {
-    // TODO: if MATRIX_COLS > 8 change to uint8_t packed_matrix[] for pack/unpack
-    matrix_row_t smatrix[ROWS_PER_HAND];
+// The slave publishes a two byte header every scan: a 4 bit sequence number,
+// FRAME_* flags and the payload length. Only when the sequence number moves
+// does the master fetch the payload, which carries the rows and encoder
+// state that changed since the last frame the master acknowledged, with the
+// rows bit packed to MATRIX_COLS bits each. An idle scan costs three bytes.
+//
+// The master echoes the last sequence number it received back in every
+// header transaction and asks for a full frame with MASTER_RESYNC whenever it
+// may have lost track, eg. after a failed payload or a restarted slave.
+//
+// Master to slave state is only sent when it changes, each feature flagged
+// in the first byte. RGB sync and every split_sync channel have their own
+// transaction.
+
+#    define SPLIT_TRANSPORT_VERSION 1
+
+#    define FRAME_MATRIX 0x01    // row mask and the changed rows follow
+#    define FRAME_ENCODER 0x02   // encoder state follows
+#    define FRAME_FULL 0x04      // version, every row and the encoder state follow
+#    define FRAME_UNSYNCED 0x08  // slave is waiting for MASTER_RESYNC
+#    define FRAME_SEQ(frame) ((frame) >> 4)
+#    define SEQ_MASK 0x0F
+
+#    define MASTER_RESYNC 0x80
 
+#    define ROW_MASK_BYTES ((ROWS_PER_HAND + 7) / 8)
+#    define PACKED_ROW_BYTES(rows) (((rows)*MATRIX_COLS + 7) / 8)
 #    ifdef ENCODER_ENABLE
-    uint8_t      encoder_state[NUMBER_OF_ENCODERS];
+#        define ENCODER_BYTES NUMBER_OF_ENCODERS
+#    else
+#        define ENCODER_BYTES 0
 #    endif
+#    define PAYLOAD_SIZE (ROW_MASK_BYTES + PACKED_ROW_BYTES(ROWS_PER_HAND) + ENCODER_BYTES)
+
+typedef struct _Serial_s2m_header_t {
+    uint8_t frame;   // sequence number << 4 | FRAME_* flags
+    uint8_t length;  // payload bytes
+} Serial_s2m_header_t;
 
-} Serial_s2m_buffer_t;
+static volatile Serial_s2m_header_t serial_s2m_header = {.frame = FRAME_UNSYNCED};
+static volatile uint8_t             serial_s2m_payload[PAYLOAD_SIZE];
+static volatile uint8_t             serial_m2s_sync;  // last sequence number received | MASTER_RESYNC
+static volatile uint8_t             serial_m2s_ack;   // sequence number of the payload fetched
+static uint8_t volatile status_header                 = 0;
+static uint8_t volatile status_payload                = 0;
+
+#    if defined(BACKLIGHT_ENABLE) || defined(WPM_ENABLE)
+#        define STATE_BACKLIGHT 0x01
+#        define STATE_WPM 0x02
+#        define STATE_ALL 0xFF
 
 typedef struct _Serial_m2s_buffer_t {
-#    ifdef BACKLIGHT_ENABLE
+    uint8_t flags;  // STATE_* fields that changed
+#        ifdef BACKLIGHT_ENABLE
     uint8_t backlight_level;
-#    endif
-#    ifdef WPM_ENABLE
+#        endif
+#        ifdef WPM_ENABLE
     uint8_t current_wpm;
-#    endif
+#        endif
 } Serial_m2s_buffer_t;
 
+static volatile Serial_m2s_buffer_t serial_m2s_buffer = {};
+static uint8_t volatile status_state                  = 0;
+#    endif
+
 #    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
 // When MCUs on both sides drive their respective RGB LED chains,
 // it is necessary to synchronize, so it is necessary to communicate RGB
@@ -160,30 +249,54 @@ typedef struct _Serial_rgblight_t {
     rgblight_syncinfo_t rgblight_sync;
 } Serial_rgblight_t;
 
-volatile Serial_rgblight_t serial_rgblight = {};
-uint8_t volatile status_rgblight           = 0;
+static volatile Serial_rgblight_t serial_rgblight = {};
+static uint8_t volatile status_rgblight           = 0;
 #    endif
 
-volatile Serial_s2m_buffer_t serial_s2m_buffer = {};
-volatile Serial_m2s_buffer_t serial_m2s_buffer = {};
-uint8_t volatile status0                       = 0;
+static uint8_t volatile status_sync[SPLIT_SYNC_MAX_CHANNELS] = {};
 
 enum serial_transaction_id {
-    GET_SLAVE_MATRIX = 0,
+    GET_SLAVE_HEADER = 0,
+    GET_SLAVE_PAYLOAD,
+#    if defined(BACKLIGHT_ENABLE) || defined(WPM_ENABLE)
+    PUT_MASTER_STATE,
+#    endif
 #    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
     PUT_RGBLIGHT,
 #    endif
+    PUT_SYNC,  // one per split_sync channel, filled in at init
+    NUM_TRANSACTIONS = PUT_SYNC + SPLIT_SYNC_MAX_CHANNELS,
 };
 
-SSTD_t transactions[] = {
-    [GET_SLAVE_MATRIX] =
+#    ifdef __AVR__
+// The soft serial driver sends the transaction index in 4 bits
+_Static_assert(NUM_TRANSACTIONS <= 16, "Too many split transactions for the AVR serial driver, lower SPLIT_SYNC_MAX_CHANNELS");
+#    endif
+
+static SSTD_t transactions[NUM_TRANSACTIONS] = {
+    [GET_SLAVE_HEADER] =
+        {
+            (uint8_t *)&status_header,
+            sizeof(serial_m2s_sync),
+            (uint8_t *)&serial_m2s_sync,
+            sizeof(serial_s2m_header),
+            (uint8_t *)&serial_s2m_header,
+        },
+    // target2initiator_buffer_size is set from the header on both sides
+    [GET_SLAVE_PAYLOAD] =
+        {
+            (uint8_t *)&status_payload,
+            sizeof(serial_m2s_ack),
+            (uint8_t *)&serial_m2s_ack,
+            0,
+            (uint8_t *)serial_s2m_payload,
+        },
+#    if defined(BACKLIGHT_ENABLE) || defined(WPM_ENABLE)
+    [PUT_MASTER_STATE] =
         {
-            (uint8_t *)&status0,
-            sizeof(serial_m2s_buffer),
-            (uint8_t *)&serial_m2s_buffer,
-            sizeof(serial_s2m_buffer),
-            (uint8_t *)&serial_s2m_buffer,
+            (uint8_t *)&status_state, sizeof(serial_m2s_buffer), (uint8_t *)&serial_m2s_buffer, 0, NULL  // no slave to master transfer
         },
+#    endif
 #    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
     [PUT_RGBLIGHT] =
         {
@@ -192,15 +305,88 @@ SSTD_t transactions[] = {
 #    endif
 };
 
-void transport_master_init(void) { soft_serial_initiator_init(transactions, TID_LIMIT(transactions)); }
+static void pack_row(uint8_t *data, uint16_t bit, matrix_row_t row) {
+#    if MATRIX_COLS % 8 == 0
+    for (uint8_t i = 0; i < MATRIX_COLS / 8; i++) {
+        data[bit / 8 + i] = row >> (i * 8);
+    }
+#    else
+    for (uint8_t col = 0; col < MATRIX_COLS; col++, bit++) {
+        if (row & (MATRIX_ROW_SHIFTER << col)) {
+            data[bit / 8] |= 1 << (bit % 8);
+        }
+    }
+#    endif
+}
+
+static matrix_row_t unpack_row(const uint8_t *data, uint16_t bit) {
+    matrix_row_t row = 0;
+#    if MATRIX_COLS % 8 == 0
+    for (uint8_t i = 0; i < MATRIX_COLS / 8; i++) {
+        row |= (matrix_row_t)data[bit / 8 + i] << (i * 8);
+    }
+#    else
+    for (uint8_t col = 0; col < MATRIX_COLS; col++, bit++) {
+        if (data[bit / 8] & (1 << (bit % 8))) {
+            row |= MATRIX_ROW_SHIFTER << col;
+        }
+    }
+#    endif
+    return row;
+}
+
+// Slave side: what the master has, and what the frame waiting for its acknowledgement holds
+static matrix_row_t slave_base[ROWS_PER_HAND];
+static matrix_row_t slave_sent[ROWS_PER_HAND];
+#    ifdef ENCODER_ENABLE
+static uint8_t slave_base_encoders[NUMBER_OF_ENCODERS];
+static uint8_t slave_sent_encoders[NUMBER_OF_ENCODERS];
+#    endif
+static uint8_t slave_seq;
+static bool    slave_synced;
+static bool    slave_resync;
+static bool    slave_pending;
+
+// Master side: the other half as last received
+static matrix_row_t master_matrix[ROWS_PER_HAND];
+#    ifdef ENCODER_ENABLE
+static uint8_t master_encoders[NUMBER_OF_ENCODERS];
+#    endif
+static uint8_t master_seq;
+static bool    master_resync;
+#    if defined(BACKLIGHT_ENABLE) || defined(WPM_ENABLE)
+static uint8_t master_state_dirty;
+#    endif
+
+static void transport_sync_init(void) {
+    split_sync_init();
+    for (uint8_t i = 0; i < split_sync_count(); i++) {
+        transactions[PUT_SYNC + i] = (SSTD_t){(uint8_t *)&status_sync[i], split_sync_channel(i)->size, split_sync_data(i), 0, NULL};
+    }
+}
+
+void transport_master_init(void) {
+    master_seq    = 0;
+    master_resync = true;
+    transport_sync_init();
+    soft_serial_initiator_init(transactions, TID_LIMIT(transactions));
+}
 
-void transport_slave_init(void) { soft_serial_target_init(transactions, TID_LIMIT(transactions)); }
+void transport_slave_init(void) {
+    slave_synced             = false;
+    slave_resync             = false;
+    slave_pending            = false;
+    serial_s2m_header.frame  = FRAME_UNSYNCED;
+    serial_s2m_header.length = 0;
+    transport_sync_init();
+    soft_serial_target_init(transactions, TID_LIMIT(transactions));
+}
 
 #    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
 
 // rgblight synchronization information communication.
 
-void transport_rgblight_master(void) {
+static void transport_rgblight_master(void) {
     if (rgblight_get_change_flags()) {
         rgblight_get_syncinfo((rgblight_syncinfo_t *)&serial_rgblight.rgblight_sync);
         if (soft_serial_transaction(PUT_RGBLIGHT) == TRANSACTION_END) {
@@ -209,7 +395,7 @@ void transport_rgblight_master(void) {
     }
 }
 
-void transport_rgblight_slave(void) {
+static void transport_rgblight_slave(void) {
     if (status_rgblight == TRANSACTION_ACCEPTED) {
         rgblight_update_sync((rgblight_syncinfo_t *)&serial_rgblight.rgblight_sync, false);
         status_rgblight = TRANSACTION_END;
@@ -221,56 +407,242 @@ void transport_rgblight_slave(void) {
 #        define transport_rgblight_slave()
 #    endif
 
-bool transport_master(matrix_row_t matrix[]) {
-#    ifndef SERIAL_USE_MULTI_TRANSACTION
-    if (soft_serial_transaction() != TRANSACTION_END) {
-        return false;
+#    if defined(BACKLIGHT_ENABLE) || defined(WPM_ENABLE)
+
+static void transport_state_master(void) {
+#        ifdef BACKLIGHT_ENABLE
+    uint8_t level = is_backlight_enabled() ? get_backlight_level() : 0;
+    if (level != serial_m2s_buffer.backlight_level) {
+        serial_m2s_buffer.backlight_level = level;
+        master_state_dirty |= STATE_BACKLIGHT;
     }
+#        endif
+
+#        ifdef WPM_ENABLE
+    uint8_t current_wpm = get_current_wpm();
+    if (current_wpm != serial_m2s_buffer.current_wpm) {
+        serial_m2s_buffer.current_wpm = current_wpm;
+        master_state_dirty |= STATE_WPM;
+    }
+#        endif
+
+    if (master_state_dirty) {
+        serial_m2s_buffer.flags = master_state_dirty;
+        if (soft_serial_transaction(PUT_MASTER_STATE) == TRANSACTION_END) {
+            master_state_dirty = 0;
+        }
+    }
+}
+
+static void transport_state_slave(void) {
+    if (status_state == TRANSACTION_ACCEPTED) {
+#        ifdef BACKLIGHT_ENABLE
+        if (serial_m2s_buffer.flags & STATE_BACKLIGHT) {
+            backlight_set(serial_m2s_buffer.backlight_level);
+        }
+#        endif
+
+#        ifdef WPM_ENABLE
+        if (serial_m2s_buffer.flags & STATE_WPM) {
+            set_current_wpm(serial_m2s_buffer.current_wpm);
+        }
+#        endif
+        status_state = TRANSACTION_END;
+    }
+}
+
 #    else
+#        define transport_state_master()
+#        define transport_state_slave()
+#    endif
+
+static void transport_sync_master(void) {
+    uint16_t dirty = split_sync_master_update();
+    for (uint8_t i = 0; dirty; i++, dirty >>= 1) {
+        if ((dirty & 1) && soft_serial_transaction(PUT_SYNC + i) == TRANSACTION_END) {
+            split_sync_master_sent(i);
+        }
+    }
+}
+
+static void transport_sync_slave(void) {
+    for (uint8_t i = 0; i < split_sync_count(); i++) {
+        if (status_sync[i] == TRANSACTION_ACCEPTED) {
+            split_sync_slave_received(i);
+            status_sync[i] = TRANSACTION_END;
+        }
+    }
+}
+
+bool transport_master(matrix_row_t matrix[]) {
     transport_rgblight_master();
-    if (soft_serial_transaction(GET_SLAVE_MATRIX) != TRANSACTION_END) {
+
+    serial_m2s_sync = master_seq | (master_resync ? MASTER_RESYNC : 0);
+    if (soft_serial_transaction(GET_SLAVE_HEADER) != TRANSACTION_END) {
         return false;
     }
-#    endif
 
-    // TODO:  if MATRIX_COLS > 8 change to unpack()
-    for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        matrix[i] = serial_s2m_buffer.smatrix[i];
+    uint8_t frame = serial_s2m_header.frame;
+    if (frame & FRAME_UNSYNCED) {
+        master_resync = true;
+        return false;
     }
 
-#    ifdef BACKLIGHT_ENABLE
-    // Write backlight level for slave to read
-    serial_m2s_buffer.backlight_level = is_backlight_enabled() ? get_backlight_level() : 0;
-#    endif
+    if (FRAME_SEQ(frame) != master_seq) {
+        uint8_t *payload                                             = (uint8_t *)serial_s2m_payload;
+        transactions[GET_SLAVE_PAYLOAD].target2initiator_buffer_size = serial_s2m_header.length;
+        serial_m2s_ack                                               = FRAME_SEQ(frame);
+        if (soft_serial_transaction(GET_SLAVE_PAYLOAD) != TRANSACTION_END) {
+            master_resync = true;
+            return false;
+        }
 
+        if (frame & FRAME_FULL) {
+            if (payload[0] != SPLIT_TRANSPORT_VERSION) {
+                return false;
+            }
+            for (uint8_t i = 0; i < ROWS_PER_HAND; i++) {
+                master_matrix[i] = unpack_row(&payload[1], i * MATRIX_COLS);
+            }
+#    ifdef ENCODER_ENABLE
+            memcpy(master_encoders, &payload[1 + PACKED_ROW_BYTES(ROWS_PER_HAND)], sizeof(master_encoders));
+#    endif
+            master_resync = false;
+#    if defined(BACKLIGHT_ENABLE) || defined(WPM_ENABLE)
+            master_state_dirty = STATE_ALL;
+#    endif
+            split_sync_master_invalidate();
+        } else if (master_resync) {
+            // a delta against rows we no longer trust, wait for the full frame
+            return false;
+        } else {
+            uint8_t *data = payload;
+            if (frame & FRAME_MATRIX) {
+                uint16_t bit = 0;
+                for (uint8_t i = 0; i < ROWS_PER_HAND; i++) {
+                    if (payload[i / 8] & (1 << (i % 8))) {
+                        master_matrix[i] = unpack_row(&payload[ROW_MASK_BYTES], bit);
+                        bit += MATRIX_COLS;
+                    }
+                }
+                data += ROW_MASK_BYTES + (bit + 7) / 8;
+            }
 #    ifdef ENCODER_ENABLE
-    encoder_update_raw((uint8_t *)serial_s2m_buffer.encoder_state);
+            if (frame & FRAME_ENCODER) {
+                memcpy(master_encoders, data, sizeof(master_encoders));
+            }
 #    endif
+        }
+        master_seq = FRAME_SEQ(frame);
+    }
 
-#    ifdef WPM_ENABLE
-    // Write wpm to slave
-    serial_m2s_buffer.current_wpm = get_current_wpm();
+    for (uint8_t i = 0; i < ROWS_PER_HAND; i++) {
+        matrix[i] = master_matrix[i];
+    }
+
+#    ifdef ENCODER_ENABLE
+    encoder_update_raw(master_encoders);
 #    endif
+
+    transport_state_master();
+    transport_sync_master();
     return true;
 }
 
+static void slave_commit_frame(void) {
+    memcpy(slave_base, slave_sent, sizeof(slave_base));
+#    ifdef ENCODER_ENABLE
+    memcpy(slave_base_encoders, slave_sent_encoders, sizeof(slave_base_encoders));
+#    endif
+    slave_synced  = true;
+    slave_pending = false;
+}
+
+static void slave_publish_frame(uint8_t flags, uint8_t length) {
+    slave_seq     = (slave_seq + 1) & SEQ_MASK;
+    slave_pending = true;
+    // the header goes last, the master only fetches the payload once the sequence number moves
+    transactions[GET_SLAVE_PAYLOAD].target2initiator_buffer_size = length;
+    serial_s2m_header.length                                     = length;
+    serial_s2m_header.frame                                      = slave_seq << 4 | flags;
+}
+
 void transport_slave(matrix_row_t matrix[]) {
     transport_rgblight_slave();
-    // TODO: if MATRIX_COLS > 8 change to pack()
-    for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        serial_s2m_buffer.smatrix[i] = matrix[i];
+    transport_state_slave();
+    transport_sync_slave();
+
+    if (status_header == TRANSACTION_ACCEPTED) {
+        uint8_t sync = serial_m2s_sync;
+        if (sync & MASTER_RESYNC) {
+            // keep a full frame already on its way, anything else is dropped
+            if (!(slave_pending && (serial_s2m_header.frame & FRAME_FULL))) {
+                slave_synced  = false;
+                slave_resync  = true;
+                slave_pending = false;
+                slave_seq     = sync & SEQ_MASK;
+            }
+        } else if (slave_pending && (sync & SEQ_MASK) == slave_seq) {
+            slave_commit_frame();
+        }
+        status_header = TRANSACTION_END;
     }
-#    ifdef BACKLIGHT_ENABLE
-    backlight_set(serial_m2s_buffer.backlight_level);
+
+    if (status_payload == TRANSACTION_ACCEPTED) {
+        if (slave_pending && serial_m2s_ack == slave_seq) {
+            slave_commit_frame();
+        }
+        status_payload = TRANSACTION_END;
+    }
+
+    if (slave_pending || (!slave_synced && !slave_resync)) {
+        return;
+    }
+
+    uint8_t *payload = (uint8_t *)serial_s2m_payload;
+    memset(payload, 0, PAYLOAD_SIZE);
+    memcpy(slave_sent, matrix, sizeof(slave_sent));
+#    ifdef ENCODER_ENABLE
+    encoder_state_raw(slave_sent_encoders);
 #    endif
 
+    if (slave_resync) {
+        slave_resync = false;
+        payload[0]   = SPLIT_TRANSPORT_VERSION;
+        for (uint8_t i = 0; i < ROWS_PER_HAND; i++) {
+            pack_row(&payload[1], i * MATRIX_COLS, slave_sent[i]);
+        }
 #    ifdef ENCODER_ENABLE
-    encoder_state_raw((uint8_t *)serial_s2m_buffer.encoder_state);
+        memcpy(&payload[1 + PACKED_ROW_BYTES(ROWS_PER_HAND)], slave_sent_encoders, sizeof(slave_sent_encoders));
 #    endif
+        slave_publish_frame(FRAME_FULL, 1 + PACKED_ROW_BYTES(ROWS_PER_HAND) + ENCODER_BYTES);
+        return;
+    }
 
-#    ifdef WPM_ENABLE
-    set_current_wpm(serial_m2s_buffer.current_wpm);
+    uint8_t  flags = 0;
+    uint8_t *data  = payload;
+    uint16_t bit   = 0;
+    for (uint8_t i = 0; i < ROWS_PER_HAND; i++) {
+        if (slave_sent[i] != slave_base[i]) {
+            payload[i / 8] |= 1 << (i % 8);
+            pack_row(&payload[ROW_MASK_BYTES], bit, slave_sent[i]);
+            bit += MATRIX_COLS;
+        }
+    }
+    if (bit) {
+        flags |= FRAME_MATRIX;
+        data += ROW_MASK_BYTES + (bit + 7) / 8;
+    }
+#    ifdef ENCODER_ENABLE
+    if (memcmp(slave_sent_encoders, slave_base_encoders, sizeof(slave_sent_encoders))) {
+        flags |= FRAME_ENCODER;
+        memcpy(data, slave_sent_encoders, sizeof(slave_sent_encoders));
+        data += sizeof(slave_sent_encoders);
+    }
 #    endif
+    if (flags) {
+        slave_publish_frame(flags, data - payload);
+    }
 }
 
 #endif
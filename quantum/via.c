@@ -47,6 +47,187 @@
 #include "tmk_core/common/eeprom.h"
 #include "version.h"  // for QMK_BUILDDATE used in EEPROM magic
 
+#include <string.h>
+
+#ifdef PROFILER_ENABLE
+static void via_put_uint32(uint8_t *data, uint32_t value) {
+    data[0] = (value >> 24) & 0xFF;
+    data[1] = (value >> 16) & 0xFF;
+    data[2] = (value >> 8) & 0xFF;
+    data[3] = value & 0xFF;
+}
+#endif
+
+// The size of raw HID packets, RAW_EPSIZE
+#define VIA_RAW_EPSIZE 32
+
+#define VIA_MATRIX_ROW_BYTES ((MATRIX_COLS + 7) / 8)
+
+#if MATRIX_ROWS > 128
+#    error id_switch_matrix_event packets only have 7 bits for the row
+#endif
+
+// Writes a matrix row most significant byte first, returns the number of bytes
+static uint8_t via_put_matrix_row(uint8_t *data, matrix_row_t value) {
+    uint8_t i = 0;
+#if (MATRIX_COLS > 24)
+    data[i++] = (value >> 24) & 0xFF;
+#endif
+#if (MATRIX_COLS > 16)
+    data[i++] = (value >> 16) & 0xFF;
+#endif
+#if (MATRIX_COLS > 8)
+    data[i++] = (value >> 8) & 0xFF;
+#endif
+    data[i++] = value & 0xFF;
+    return i;
+}
+
+// The matrix as last sent to the host, while id_switch_matrix_stream is on
+static bool         via_matrix_stream;
+static uint8_t      via_matrix_sequence;
+static matrix_row_t via_matrix_sent[MATRIX_ROWS];
+
+static void via_matrix_stream_start(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        via_matrix_sent[row] = matrix_get_row(row);
+    }
+    via_matrix_sequence = 0;
+    via_matrix_stream   = true;
+}
+
+// Collects up to max changes since the last packet as row (bit 7 set when pressed) and column pairs.
+// Changes that don't fit are left for the next packet.
+static uint8_t via_matrix_collect_changes(uint8_t *events, uint8_t max) {
+    uint8_t count = 0;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix_row_t change = matrix_get_row(row) ^ via_matrix_sent[row];
+        for (uint8_t col = 0; change && col < MATRIX_COLS; col++) {
+            matrix_row_t col_mask = MATRIX_ROW_SHIFTER << col;
+            if (change & col_mask) {
+                if (count == max) {
+                    return count;
+                }
+                change ^= col_mask;
+                via_matrix_sent[row] ^= col_mask;
+                *events++ = row | ((via_matrix_sent[row] & col_mask) ? 0x80 : 0);
+                *events++ = col;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// Puts changes that could not be sent back, so that they go out with the next packet
+static void via_matrix_restore_changes(const uint8_t *events, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++, events += 2) {
+        via_matrix_sent[events[0] & 0x7F] ^= MATRIX_ROW_SHIFTER << events[1];
+    }
+}
+
+// Called by QMK core once per scan, sends matrix changes to a subscribed host.
+// At most one packet is sent per scan, and only if the endpoint has room, so a
+// host that stops reading never stalls the scan. The sequence number lets the
+// host check that no packet was lost.
+void via_task(void) {
+    if (!via_matrix_stream) {
+        return;
+    }
+    // [0] id, [1] sequence, [2..3] time, [4] count of the row and column pairs that follow
+    uint8_t data[VIA_RAW_EPSIZE] = {id_switch_matrix_event};
+    uint8_t count                = via_matrix_collect_changes(&data[5], (VIA_RAW_EPSIZE - 5) / 2);
+    if (count) {
+        uint16_t time = timer_read();
+        data[1]       = via_matrix_sequence;
+        data[2]       = time >> 8;
+        data[3]       = time & 0xFF;
+        data[4]       = count;
+        if (raw_hid_send_nonblocking(data, VIA_RAW_EPSIZE)) {
+            via_matrix_sequence++;
+        } else {
+            via_matrix_restore_changes(&data[5], count);
+        }
+    }
+}
+
+// The host has to subscribe again after a USB reset or suspend
+void raw_hid_reset(void) { via_matrix_stream = false; }
+
+#ifdef VIA_BULK_BUFFER_SIZE
+#    if VIA_BULK_BUFFER_SIZE > 65535
+#        error VIA_BULK_BUFFER_SIZE must be less than 65536
+#    endif
+
+// A bulk keymap upload is opened by id_dynamic_keymap_bulk_begin with the offset and size,
+// followed by id_dynamic_keymap_bulk_data packets that are staged in RAM and not replied to,
+// and closed by id_dynamic_keymap_bulk_commit, which checks the CRC and writes the whole
+// block to EEPROM at once.
+static struct {
+    uint16_t offset;
+    uint16_t size;
+    uint16_t received;
+    uint8_t  sequence;
+    bool     active;
+} via_bulk;
+
+static uint8_t via_bulk_buffer[VIA_BULK_BUFFER_SIZE];
+
+// CRC-16/CCITT-FALSE
+static uint16_t via_bulk_crc16(const uint8_t *data, uint16_t size) {
+    uint16_t crc = 0xFFFF;
+    while (size--) {
+        crc ^= *data++ << 8;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static uint8_t via_bulk_begin(uint16_t offset, uint16_t size) {
+    via_bulk.active = false;
+    if (size == 0 || size > VIA_BULK_BUFFER_SIZE || offset >= dynamic_keymap_get_buffer_size() || size > dynamic_keymap_get_buffer_size() - offset) {
+        return via_bulk_error_size;
+    }
+    via_bulk.offset   = offset;
+    via_bulk.size     = size;
+    via_bulk.received = 0;
+    via_bulk.sequence = 0;
+    via_bulk.active   = true;
+    return via_bulk_ok;
+}
+
+// A packet out of sequence ends the session, so that the commit fails
+static void via_bulk_data(uint8_t sequence, const uint8_t *data, uint8_t length) {
+    if (!via_bulk.active || sequence != via_bulk.sequence) {
+        via_bulk.active = false;
+        return;
+    }
+    via_bulk.sequence++;
+    if (length > via_bulk.size - via_bulk.received) {
+        length = via_bulk.size - via_bulk.received;
+    }
+    memcpy(&via_bulk_buffer[via_bulk.received], data, length);
+    via_bulk.received += length;
+}
+
+static uint8_t via_bulk_commit(uint16_t crc) {
+    if (!via_bulk.active) {
+        return via_bulk_error_sequence;
+    }
+    via_bulk.active = false;
+    if (via_bulk.received != via_bulk.size) {
+        return via_bulk_error_length;
+    }
+    if (via_bulk_crc16(via_bulk_buffer, via_bulk.size) != crc) {
+        return via_bulk_error_crc;
+    }
+    dynamic_keymap_set_buffer(via_bulk.offset, via_bulk.size, via_bulk_buffer);
+    return via_bulk_ok;
+}
+#endif
+
 // Forward declare some helpers.
 #if defined(VIA_QMK_BACKLIGHT_ENABLE)
 void via_qmk_backlight_set_value(uint8_t *data);
@@ -230,21 +411,60 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
 #if ((MATRIX_COLS / 8 + 1) * MATRIX_ROWS <= 28)
                     uint8_t i = 1;
                     for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-                        matrix_row_t value = matrix_get_row(row);
-#    if (MATRIX_COLS > 24)
-                        command_data[i++] = (value >> 24) & 0xFF;
-#    endif
-#    if (MATRIX_COLS > 16)
-                        command_data[i++] = (value >> 16) & 0xFF;
-#    endif
-#    if (MATRIX_COLS > 8)
-                        command_data[i++] = (value >> 8) & 0xFF;
-#    endif
-                        command_data[i++] = value & 0xFF;
+                        i += via_put_matrix_row(&command_data[i], matrix_get_row(row));
+                    }
+#else
+                    // Paged, command_data[1] is the first row and as many rows as fit follow
+                    uint8_t i = 2;
+                    for (uint8_t row = command_data[1]; row < MATRIX_ROWS && i + VIA_MATRIX_ROW_BYTES < length; row++) {
+                        i += via_put_matrix_row(&command_data[i], matrix_get_row(row));
                     }
 #endif
                     break;
                 }
+                case id_switch_matrix_stream: {
+                    command_data[1] = via_matrix_stream;
+                    break;
+                }
+#ifdef PROFILER_ENABLE
+                case id_profiler_stats: {
+                    // command_data[1] is the stage
+                    if (command_data[1] >= PROFILER_STAGE_COUNT) {
+                        command_data[1] = 0xFF;
+                        break;
+                    }
+                    const profiler_stats_t *stats = profiler_get_stats(command_data[1]);
+                    via_put_uint32(&command_data[2], stats->count);
+                    via_put_uint32(&command_data[6], stats->total_us);
+                    via_put_uint32(&command_data[10], stats->min_cycles);
+                    via_put_uint32(&command_data[14], stats->max_cycles);
+                    via_put_uint32(&command_data[18], profiler_counter_frequency());
+                    break;
+                }
+                case id_profiler_histogram: {
+                    // command_data[1] is the stage, command_data[2] the first bucket, up to 14 follow
+                    if (command_data[1] >= PROFILER_STAGE_COUNT) {
+                        command_data[1] = 0xFF;
+                        break;
+                    }
+                    const profiler_stats_t *stats = profiler_get_stats(command_data[1]);
+                    for (uint8_t i = 0, bucket = command_data[2]; i < 14 && bucket < PROFILER_BUCKETS; i++, bucket++) {
+                        command_data[3 + i * 2] = stats->histogram[bucket] >> 8;
+                        command_data[4 + i * 2] = stats->histogram[bucket] & 0xFF;
+                    }
+                    break;
+                }
+                case id_profiler_latency: {
+                    profiler_latency_t latency;
+                    profiler_get_latency(&latency);
+                    via_put_uint32(&command_data[1], latency.count);
+                    via_put_uint32(&command_data[5], latency.p50_us);
+                    via_put_uint32(&command_data[9], latency.p90_us);
+                    via_put_uint32(&command_data[13], latency.p99_us);
+                    via_put_uint32(&command_data[17], latency.max_us);
+                    break;
+                }
+#endif
                 default: {
                     raw_hid_receive_kb(data, length);
                     break;
@@ -259,6 +479,21 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
                     via_set_layout_options(value);
                     break;
                 }
+                case id_switch_matrix_stream: {
+                    // command_data[1] turns the stream on or off
+                    if (command_data[1]) {
+                        via_matrix_stream_start();
+                    } else {
+                        via_matrix_stream = false;
+                    }
+                    break;
+                }
+#ifdef PROFILER_ENABLE
+                case id_profiler_stats: {
+                    profiler_reset();
+                    break;
+                }
+#endif
                 default: {
                     raw_hid_receive_kb(data, length);
                     break;
@@ -370,6 +605,28 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
             dynamic_keymap_set_buffer(offset, size, &command_data[3]);
             break;
         }
+#ifdef VIA_BULK_BUFFER_SIZE
+        case id_dynamic_keymap_bulk_begin: {
+            // command_data[4] returns the status, command_data[5..6] the largest size of a session
+            uint16_t offset = (command_data[0] << 8) | command_data[1];
+            uint16_t size   = (command_data[2] << 8) | command_data[3];
+            command_data[4] = via_bulk_begin(offset, size);
+            command_data[5] = VIA_BULK_BUFFER_SIZE >> 8;
+            command_data[6] = VIA_BULK_BUFFER_SIZE & 0xFF;
+            break;
+        }
+        case id_dynamic_keymap_bulk_data: {
+            // command_data[0] is the sequence number, the rest of the packet is data.
+            // Not replied to, so the host can send the next packet right away.
+            via_bulk_data(command_data[0], &command_data[1], length - 2);
+            return;
+        }
+        case id_dynamic_keymap_bulk_commit: {
+            uint16_t crc    = (command_data[0] << 8) | command_data[1];
+            command_data[2] = via_bulk_commit(crc);
+            break;
+        }
+#endif
         case id_eeprom_reset: {
             via_eeprom_reset();
             break;
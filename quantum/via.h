@@ -78,13 +78,34 @@ enum via_command_id {
     id_dynamic_keymap_get_layer_count       = 0x11,
     id_dynamic_keymap_get_buffer            = 0x12,
     id_dynamic_keymap_set_buffer            = 0x13,
+    // Bulk keymap upload, with VIA_BULK_BUFFER_SIZE defined
+    id_dynamic_keymap_bulk_begin  = 0x14,
+    id_dynamic_keymap_bulk_data   = 0x15,
+    id_dynamic_keymap_bulk_commit = 0x16,
+    // Sent by the keyboard while id_switch_matrix_stream is on, see via_task()
+    id_switch_matrix_event = 0x17,
     id_unhandled                            = 0xFF,
 };
 
 enum via_keyboard_value_id {
     id_uptime              = 0x01,  //
     id_layout_options      = 0x02,
-    id_switch_matrix_state = 0x03
+    id_switch_matrix_state = 0x03,
+    // Scan loop profiler, see profiler.h
+    id_profiler_stats     = 0x40,
+    id_profiler_histogram = 0x41,
+    id_profiler_latency   = 0x42,
+    // Pushes id_switch_matrix_event packets on matrix changes
+    id_switch_matrix_stream = 0x50,
+};
+
+// Status returned by id_dynamic_keymap_bulk_begin and id_dynamic_keymap_bulk_commit
+enum via_bulk_status {
+    via_bulk_ok             = 0x00,
+    via_bulk_error_size     = 0x01,  // offset and size are outside the keymap or larger than the buffer
+    via_bulk_error_sequence = 0x02,  // a data packet was lost, or sent without a session
+    via_bulk_error_length   = 0x03,  // fewer bytes were received than announced
+    via_bulk_error_crc      = 0x04,
 };
 
 enum via_lighting_value {
@@ -164,5 +185,8 @@ void via_init(void);
 uint32_t via_get_layout_options(void);
 void     via_set_layout_options(uint32_t value);
 
+// Called by QMK core once per scan, sends matrix changes to a subscribed host.
+void via_task(void);
+
 // Called by QMK core to process VIA-specific keycodes.
 bool process_record_via(uint16_t keycode, keyrecord_t *record);
@@ -16,6 +16,7 @@
  */
 
 #include "wpm.h"
+#include "deadline.h"
 
 // WPM Stuff
 static uint8_t  current_wpm = 0;
@@ -25,6 +26,20 @@ static uint16_t wpm_timer   = 0;
 // This smoothing is 40 keystrokes
 static const float wpm_smoothing = 0.0487;
 
+// Without typing the WPM decays towards 0 once a second
+#define WPM_DECAY_INTERVAL 1000
+static deadline_token_t wpm_decay_token;
+
+static uint32_t wpm_decay(uint32_t trigger_time, void *arg) {
+    current_wpm = (0 - current_wpm) * wpm_smoothing + current_wpm;
+    wpm_timer   = timer_read();
+    if (!current_wpm) {
+        wpm_decay_token = 0;
+        return 0;
+    }
+    return WPM_DECAY_INTERVAL;
+}
+
 void set_current_wpm(uint8_t new_wpm) { current_wpm = new_wpm; }
 
 uint8_t get_current_wpm(void) { return current_wpm; }
@@ -53,11 +68,15 @@ void update_wpm(uint16_t keycode) {
             current_wpm = (latest_wpm - current_wpm) * wpm_smoothing + current_wpm;
         }
         wpm_timer = timer_read();
+        if (!deadline_extend(wpm_decay_token, WPM_DECAY_INTERVAL)) {
+            wpm_decay_token = deadline_schedule(WPM_DECAY_INTERVAL, wpm_decay, NULL);
+        }
     }
 }
 
+// The decay is scheduled by update_wpm(), this is kept for keymaps that call it themselves
 void decay_wpm(void) {
-    if (timer_elapsed(wpm_timer) > 1000) {
+    if (timer_elapsed(wpm_timer) > WPM_DECAY_INTERVAL) {
         current_wpm = (0 - current_wpm) * wpm_smoothing + current_wpm;
         wpm_timer   = timer_read();
     }
@@ -2,6 +2,13 @@ TEST_LIST = $(notdir $(patsubst %/rules.mk,%,$(wildcard $(ROOT_DIR)/tests/*/rule
 FULL_TESTS := $(TEST_LIST)
 
 include $(ROOT_DIR)/quantum/serial_link/tests/testlist.mk
+include $(ROOT_DIR)/quantum/debounce/tests/testlist.mk
+include $(ROOT_DIR)/quantum/split_common/tests/testlist.mk
+include $(ROOT_DIR)/quantum/rgb_matrix_animations/tests/testlist.mk
+include $(ROOT_DIR)/tmk_core/common/test/testlist.mk
+include $(ROOT_DIR)/drivers/issi/tests/testlist.mk
+include $(ROOT_DIR)/drivers/chibios/tests/testlist.mk
+include $(ROOT_DIR)/drivers/oled/tests/testlist.mk
 
 define VALIDATE_TEST_LIST
     ifneq ($1,)
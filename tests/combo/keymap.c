@@ -0,0 +1,63 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] =
+        {
+            // 0    1     2     3     4     5     6     7      8      9
+            {KC_A, KC_B, KC_C, KC_D, KC_E, KC_Q, KC_W, KC_NO, KC_NO, KC_NO},
+            {KC_F, KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_NO, KC_NO, KC_NO},
+            {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+            {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+        },
+};
+
+const uint16_t PROGMEM ab_combo[]  = {KC_A, KC_B, COMBO_END};
+const uint16_t PROGMEM bcd_combo[] = {KC_B, KC_C, KC_D, COMBO_END};
+const uint16_t PROGMEM ac_combo[]  = {KC_A, KC_C, COMBO_END};
+const uint16_t PROGMEM ae_combo[]  = {KC_A, KC_E, COMBO_END};
+
+// The remaining 136 combos are pairs (and some triples) of F-L and 1-0, filled in at init
+static const uint16_t filler_keys[] = {KC_F, KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_1, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0};
+static uint16_t       filler_combos[COMBO_COUNT][4];
+
+combo_t key_combos[COMBO_COUNT] = {
+    COMBO(ab_combo, KC_X),
+    COMBO(bcd_combo, KC_Y),
+    COMBO(ac_combo, KC_Z),
+    COMBO_ACTION(ae_combo),
+};
+
+uint16_t combo_events[2];
+
+void process_combo_event(uint16_t combo_index, bool pressed) { combo_events[pressed]++; }
+
+void keyboard_post_init_user(void) {
+    const uint8_t n     = sizeof(filler_keys) / sizeof(filler_keys[0]);
+    uint16_t      combo = 4;
+
+    for (uint8_t i = 0; i < n && combo < COMBO_COUNT; i++) {
+        for (uint8_t j = i + 1; j < n && combo < COMBO_COUNT; j++, combo++) {
+            filler_combos[combo][0] = filler_keys[i];
+            filler_combos[combo][1] = filler_keys[j];
+            filler_combos[combo][2] = (j + 1 < n && (i + j) % 8 == 0) ? filler_keys[j + 1] : COMBO_END;
+            filler_combos[combo][3] = COMBO_END;
+            key_combos[combo]       = (combo_t)COMBO(filler_combos[combo], KC_F1 + combo % 12);
+        }
+    }
+}
@@ -0,0 +1,178 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <chrono>
+#include <iostream>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+extern "C" uint16_t combo_events[2];
+
+class Combo : public TestFixture {
+   protected:
+    void SetUp() override {
+        // Combos only become active once no combo key is held, after a non-combo key
+        TestDriver driver;
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        press_key(5, 0);
+        run_one_scan_loop();
+        release_key(5, 0);
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(Combo, NonComboKeyIsSentImmediately) {
+    TestDriver driver;
+    InSequence s;
+    press_key(5, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Q)));
+    run_one_scan_loop();
+    release_key(5, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, TwoKeyComboSendsComboKeycode) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    run_one_scan_loop();
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ThreeKeyComboSendsComboKeycode) {
+    TestDriver driver;
+    InSequence s;
+    press_key(1, 0);
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    run_one_scan_loop();
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    run_one_scan_loop();
+    release_key(1, 0);
+    release_key(2, 0);
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    idle_for(3);
+}
+
+TEST_F(Combo, OverlappingComboPicksTheCompletedOne) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    release_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    idle_for(2);
+}
+
+TEST_F(Combo, ComboActionCallsProcessComboEvent) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    uint16_t pressed = combo_events[true], released = combo_events[false];
+    press_key(0, 0);
+    press_key(4, 0);
+    idle_for(2);
+    EXPECT_EQ(combo_events[true], pressed + 1);
+    release_key(0, 0);
+    release_key(4, 0);
+    idle_for(2);
+    EXPECT_EQ(combo_events[false], released + 1);
+}
+
+TEST_F(Combo, HeldComboKeyIsSentAfterComboTerm) {
+    TestDriver driver;
+
+    InSequence s;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(COMBO_TERM);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).Times(2);
+    idle_for(2);
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, TappedComboKeyIsSentOnRelease) {
+    TestDriver driver;
+    InSequence s;
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    release_key(1, 0);
+    // The buffered press is reported twice, once by register_code16() and once explicitly
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B))).Times(2);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, FillerComboSendsComboKeycode) {
+    TestDriver driver;
+    InSequence s;
+    // F + G is the first generated combo
+    press_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F1 + 4 % 12)));
+    run_one_scan_loop();
+    release_key(0, 1);
+    release_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    idle_for(2);
+}
+
+TEST_F(Combo, Benchmark) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    const int rounds = 20000;
+
+    struct {
+        const char* name;
+        uint16_t    keycode;
+    } streams[] = {{"non-combo key", KC_Q}, {"combo key", KC_H}};
+
+    for (auto& stream : streams) {
+        keyrecord_t record = {};
+        auto        start  = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            record.event.pressed = !(i & 1);
+            record.event.time    = timer_read() | 1;
+            process_combo(stream.keycode, &record);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "[   INFO   ] " << COMBO_COUNT << " combos, " << stream.name << ": " << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / rounds << " ns per event" << std::endl;
+    }
+}
@@ -0,0 +1,131 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "eeprom.h"
+}
+
+using testing::AnyNumber;
+using testing::InSequence;
+
+class DynamicKeymapCache : public TestFixture {
+   protected:
+    void SetUp() override {
+        dynamic_keymap_reset();
+        dynamic_keymap_macro_reset();
+    }
+
+    static uint16_t eeprom_keycode(uint8_t layer, uint8_t row, uint8_t column) {
+        uint8_t *address = (uint8_t *)dynamic_keymap_key_to_eeprom_address(layer, row, column);
+        return eeprom_read_byte(address) << 8 | eeprom_read_byte(address + 1);
+    }
+
+    // Every key, cached or not, has to read back what EEPROM holds
+    static void expect_cache_matches_eeprom() {
+        for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+            for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                for (uint8_t column = 0; column < MATRIX_COLS; column++) {
+                    EXPECT_EQ(eeprom_keycode(layer, row, column), dynamic_keymap_get_keycode(layer, row, column)) << "layer " << +layer << " row " << +row << " column " << +column;
+                }
+            }
+        }
+    }
+};
+
+TEST_F(DynamicKeymapCache, InitLoadsWhatIsInEeprom) {
+    // Written behind the cache's back, as another firmware would have
+    uint8_t *address = (uint8_t *)dynamic_keymap_key_to_eeprom_address(1, 2, 3);
+    eeprom_update_byte(address, KC_LCTL >> 8);
+    eeprom_update_byte(address + 1, KC_LCTL & 0xFF);
+
+    dynamic_keymap_init();
+    EXPECT_EQ(KC_LCTL, dynamic_keymap_get_keycode(1, 2, 3));
+    expect_cache_matches_eeprom();
+}
+
+TEST_F(DynamicKeymapCache, SetKeycodeUpdatesCacheAndEeprom) {
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+    dynamic_keymap_set_keycode(1, 3, 9, LCTL(KC_C));
+    dynamic_keymap_set_keycode(2, 1, 4, KC_F12);
+
+    EXPECT_EQ(KC_Z, eeprom_keycode(0, 0, 0));
+    EXPECT_EQ(LCTL(KC_C), eeprom_keycode(1, 3, 9));
+    EXPECT_EQ(KC_F12, eeprom_keycode(2, 1, 4));
+    expect_cache_matches_eeprom();
+}
+
+TEST_F(DynamicKeymapCache, SetBufferAcrossTheCacheEdgeAtAnOddOffset) {
+    // The last byte of layer 1 up to the first keycodes of the uncached layer 2
+    const uint16_t layer_size = MATRIX_ROWS * MATRIX_COLS * 2;
+    const uint16_t offset     = 2 * layer_size - 3;
+    uint8_t        data[]     = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE};
+
+    dynamic_keymap_set_buffer(offset, sizeof(data), data);
+
+    // Only the low byte of the KC_NO before it changes
+    EXPECT_EQ(0x0012, dynamic_keymap_get_keycode(1, 3, 8));
+    EXPECT_EQ(0x3456, dynamic_keymap_get_keycode(1, 3, 9));
+    EXPECT_EQ(0x789A, dynamic_keymap_get_keycode(2, 0, 0));
+    EXPECT_EQ(0xBCDE, dynamic_keymap_get_keycode(2, 0, 1));
+    expect_cache_matches_eeprom();
+}
+
+TEST_F(DynamicKeymapCache, ResetRestoresTheFlashKeymap) {
+    dynamic_keymap_set_keycode(0, 0, 1, KC_X);
+    dynamic_keymap_set_keycode(2, 0, 0, KC_Y);
+    dynamic_keymap_reset();
+
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t column = 0; column < MATRIX_COLS; column++) {
+                EXPECT_EQ(pgm_read_word(&keymaps[layer][row][column]), dynamic_keymap_get_keycode(layer, row, column));
+            }
+        }
+    }
+    expect_cache_matches_eeprom();
+}
+
+TEST_F(DynamicKeymapCache, KeyPressesSeeChangedKeycodes) {
+    TestDriver driver;
+    InSequence s;
+
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+    dynamic_keymap_set_keycode(2, 0, 1, KC_Y);
+
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+
+    // Layer 2 is not cached, the layer change itself sends an empty report
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    run_one_scan_loop();
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    run_one_scan_loop();
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    run_one_scan_loop();
+}
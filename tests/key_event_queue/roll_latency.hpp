@@ -0,0 +1,45 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "test_common.hpp"
+#include <iostream>
+
+class RollLatency : public TestFixture {
+   protected:
+    // Presses the first `keys` positions of the matrix in a single scan and
+    // returns the number of scans until every press has produced a report.
+    unsigned roll_latency_in_scans(TestDriver& driver, unsigned keys) {
+        unsigned reports = 0;
+        EXPECT_CALL(driver, send_keyboard_mock(testing::_)).WillRepeatedly(testing::Invoke([&reports](report_keyboard_t&) { reports++; }));
+        for (unsigned i = 0; i < keys; i++) {
+            press_key(i % MATRIX_COLS, i / MATRIX_COLS);
+        }
+        unsigned scans = 0;
+        while (reports < keys && scans < keys + 1) {
+            run_one_scan_loop();
+            scans++;
+        }
+#ifdef QMK_KEY_EVENT_QUEUE
+        std::cout << "[   INFO   ] " << keys << "-key roll: " << scans << " scan(s) with QMK_KEY_EVENT_QUEUE" << std::endl;
+#else
+        std::cout << "[   INFO   ] " << keys << "-key roll: " << scans << " scan(s) without QMK_KEY_EVENT_QUEUE" << std::endl;
+#endif
+        return scans;
+    }
+};
@@ -0,0 +1,60 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "roll_latency.hpp"
+
+using testing::InSequence;
+
+class KeyEventQueue : public RollLatency {};
+
+TEST_F(KeyEventQueue, TwoKeyRollIsProcessedInOneScan) {
+    TestDriver driver;
+    EXPECT_EQ(roll_latency_in_scans(driver, 2), 1u);
+}
+
+TEST_F(KeyEventQueue, SixKeyRollIsProcessedInOneScan) {
+    TestDriver driver;
+    EXPECT_EQ(roll_latency_in_scans(driver, 6), 1u);
+}
+
+TEST_F(KeyEventQueue, TenKeyRollIsProcessedInOneScan) {
+    TestDriver driver;
+    EXPECT_EQ(roll_latency_in_scans(driver, 10), 1u);
+}
+
+TEST_F(KeyEventQueue, EventsAreProcessedInMatrixOrder) {
+    TestDriver driver;
+    InSequence s;
+    press_key(1, 0);
+    press_key(0, 3);
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B, KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B, KC_D, KC_5)));
+    run_one_scan_loop();
+    release_key(1, 0);
+    release_key(0, 3);
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_D, KC_5)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_5)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(KeyEventQueue, OverflowingEventsAreProcessedOnTheNextScan) {
+    TestDriver driver;
+    EXPECT_EQ(roll_latency_in_scans(driver, QMK_KEY_EVENT_QUEUE_SIZE + 4), 2u);
+}
@@ -0,0 +1,36 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "../key_event_queue/roll_latency.hpp"
+
+// Without the queue keyboard_task() processes one changed key per scan
+class KeyEventQueueBaseline : public RollLatency {};
+
+TEST_F(KeyEventQueueBaseline, TwoKeyRollTakesTwoScans) {
+    TestDriver driver;
+    EXPECT_EQ(roll_latency_in_scans(driver, 2), 2u);
+}
+
+TEST_F(KeyEventQueueBaseline, SixKeyRollTakesSixScans) {
+    TestDriver driver;
+    EXPECT_EQ(roll_latency_in_scans(driver, 6), 6u);
+}
+
+TEST_F(KeyEventQueueBaseline, TenKeyRollTakesTenScans) {
+    TestDriver driver;
+    EXPECT_EQ(roll_latency_in_scans(driver, 10), 10u);
+}
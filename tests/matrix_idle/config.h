@@ -0,0 +1,34 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define MATRIX_ROWS 4
+#define MATRIX_COLS 10
+
+// The real matrix scans simulated pins, rows first
+#define MATRIX_ROW_PINS \
+    { 0, 1, 2, 3 }
+#define MATRIX_COL_PINS \
+    { 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 }
+#define DIODE_DIRECTION COL2ROW
+
+#define DEBOUNCE 5
+#define MATRIX_IDLE_GRACE_MS 20
+// Long enough that a missed wake up would show in the latency
+#define MATRIX_IDLE_MAX_SLEEP 50
+
+#include "matrix_sim.h"
@@ -0,0 +1,171 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Build the real matrix under other names, test_common/matrix.c feeds the keyboard
+#define matrix_init matrix_sim_init
+#define matrix_scan matrix_sim_matrix_scan
+#define matrix_init_quantum matrix_sim_init_quantum
+#define matrix_scan_quantum matrix_sim_scan_quantum
+
+#include "../../quantum/matrix.c"
+
+#include <string.h>
+#include "timer.h"
+
+void set_time(uint32_t t);
+
+#define SIM_PINS 16
+#define SIM_MAX_EVENTS 512
+
+typedef struct {
+    uint32_t time;
+    uint8_t  row;
+    uint8_t  col;
+    bool     closed;
+} sim_event_t;
+
+matrix_row_t raw_matrix[MATRIX_ROWS];
+matrix_row_t matrix[MATRIX_ROWS];
+
+static bool         pin_output[SIM_PINS];
+static bool         pin_level[SIM_PINS];
+static bool         pin_armed[SIM_PINS];
+static matrix_row_t switches[MATRIX_ROWS];
+static sim_event_t  events[SIM_MAX_EVENTS];
+static uint16_t     event_count;
+static uint16_t     event_next;
+static bool         wake_pending;
+static uint32_t     wake_count;
+static uint32_t     sleep_count;
+static uint32_t     full_scan_count;
+
+void matrix_sim_init_quantum(void) {}
+void matrix_sim_scan_quantum(void) {}
+void matrix_io_delay(void) {}
+
+void gpio_sim_set_input_high(pin_t pin) { pin_output[pin] = false; }
+void gpio_sim_set_output(pin_t pin) { pin_output[pin] = true; }
+void gpio_sim_write(pin_t pin, bool level) { pin_level[pin] = level; }
+
+static bool row_driven(uint8_t row) { return pin_output[row_pins[row]] && !pin_level[row_pins[row]]; }
+
+static bool col_low(uint8_t col) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if ((switches[row] & (MATRIX_ROW_SHIFTER << col)) && row_driven(row)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool gpio_sim_read(pin_t pin) {
+    if (pin_output[pin]) {
+        return pin_level[pin];
+    }
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        if (col_pins[col] == pin) {
+            // Column 0 read with only row 0 driven is the start of a full scan
+            if (col == 0 && row_driven(0) && !row_driven(1)) {
+                full_scan_count++;
+            }
+            return !col_low(col);
+        }
+    }
+    return true;
+}
+
+void matrix_sim_reset(void) {
+    memset(pin_output, 0, sizeof(pin_output));
+    memset(pin_level, 0, sizeof(pin_level));
+    memset(pin_armed, 0, sizeof(pin_armed));
+    memset(switches, 0, sizeof(switches));
+    event_count     = 0;
+    event_next      = 0;
+    wake_pending    = false;
+    wake_count      = 0;
+    sleep_count     = 0;
+    full_scan_count = 0;
+}
+
+void matrix_sim_set_switch(uint8_t row, uint8_t col, bool closed) {
+    bool was_low[MATRIX_COLS];
+    for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+        was_low[c] = col_low(c);
+    }
+
+    if (closed) {
+        switches[row] |= MATRIX_ROW_SHIFTER << col;
+    } else {
+        switches[row] &= ~(MATRIX_ROW_SHIFTER << col);
+    }
+
+    // Armed inputs interrupt on a falling edge
+    for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+        if (pin_armed[col_pins[c]] && !was_low[c] && col_low(c)) {
+            wake_pending = true;
+            wake_count++;
+        }
+    }
+}
+
+void matrix_sim_schedule(uint32_t time, uint8_t row, uint8_t col, bool closed) {
+    if (event_count < SIM_MAX_EVENTS) {
+        events[event_count++] = (sim_event_t){time, row, col, closed};
+    }
+}
+
+static void run_events(void) {
+    while (event_next < event_count && events[event_next].time <= timer_read32()) {
+        sim_event_t *event = &events[event_next++];
+        matrix_sim_set_switch(event->row, event->col, event->closed);
+    }
+}
+
+uint32_t matrix_sim_wake_count(void) { return wake_count; }
+uint32_t matrix_sim_sleep_count(void) { return sleep_count; }
+uint32_t matrix_sim_full_scan_count(void) { return full_scan_count; }
+
+uint8_t matrix_sim_scan(void) {
+    run_events();
+    return matrix_sim_matrix_scan();
+}
+
+bool matrix_sim_is_on(uint8_t row, uint8_t col) { return matrix[row] & (MATRIX_ROW_SHIFTER << col); }
+
+void matrix_idle_arm_pins(const pin_t *pins, uint8_t count) {
+    wake_pending = false;
+    for (uint8_t i = 0; i < count; i++) {
+        pin_armed[pins[i]] = true;
+    }
+}
+
+void matrix_idle_disarm_pins(void) { memset(pin_armed, 0, sizeof(pin_armed)); }
+
+// Time passes until a scheduled switch change wakes the matrix, or the timeout
+void matrix_idle_sleep(uint32_t timeout_ms) {
+    uint32_t end = timer_read32() + timeout_ms;
+    sleep_count++;
+    while (!wake_pending) {
+        if (event_next < event_count && events[event_next].time <= end) {
+            set_time(events[event_next].time);
+            run_events();
+        } else {
+            set_time(end);
+            break;
+        }
+    }
+    wake_pending = false;
+}
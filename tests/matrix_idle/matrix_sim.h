@@ -0,0 +1,58 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulated GPIO and key switches for the real quantum/matrix.c. A column
+ * reads low when a closed switch connects it to a row driven low.
+ */
+
+typedef uint8_t pin_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void gpio_sim_set_input_high(pin_t pin);
+void gpio_sim_set_output(pin_t pin);
+void gpio_sim_write(pin_t pin, bool level);
+bool gpio_sim_read(pin_t pin);
+
+void matrix_sim_reset(void);
+void matrix_sim_set_switch(uint8_t row, uint8_t col, bool closed);
+// Flips the switch once the simulated time reaches time
+void matrix_sim_schedule(uint32_t time, uint8_t row, uint8_t col, bool closed);
+
+uint32_t matrix_sim_wake_count(void);
+uint32_t matrix_sim_sleep_count(void);
+uint32_t matrix_sim_full_scan_count(void);
+
+void    matrix_sim_init(void);
+uint8_t matrix_sim_scan(void);
+bool    matrix_sim_is_on(uint8_t row, uint8_t col);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define setPinInputHigh(pin) gpio_sim_set_input_high(pin)
+#define setPinOutput(pin) gpio_sim_set_output(pin)
+#define writePinHigh(pin) gpio_sim_write(pin, true)
+#define writePinLow(pin) gpio_sim_write(pin, false)
+#define readPin(pin) gpio_sim_read(pin)
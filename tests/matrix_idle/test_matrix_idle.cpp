@@ -0,0 +1,205 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "matrix_idle.h"
+#include "deadline.h"
+
+void advance_time(uint32_t ms);
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+struct KeyEvent {
+    uint32_t time;
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+};
+
+class MatrixIdle : public TestFixture {
+   protected:
+    MatrixIdle() {
+        if (matrix_is_idle()) {
+            matrix_idle_leave();
+        }
+        matrix_sim_reset();
+        matrix_sim_init();
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    }
+
+    // One pass of the main loop: the real matrix feeds the test matrix, then the keyboard runs
+    void scan_once() {
+        uint32_t before = timer_read32();
+        matrix_sim_scan();
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                bool on = matrix_sim_is_on(row, col);
+                if (on != state[row][col]) {
+                    state[row][col] = on;
+                    observed.push_back({timer_read32(), row, col, on});
+                    on ? press_key(col, row) : release_key(col, row);
+                }
+            }
+        }
+        keyboard_task();
+        // A scan that did not sleep takes a millisecond
+        if (timer_read32() == before) {
+            advance_time(1);
+        }
+        if (matrix_is_idle()) {
+            idle_with_key_down |= key_down();
+        }
+    }
+
+    void scan_for(uint32_t ms) {
+        uint32_t end = timer_read32() + ms;
+        while ((int32_t)(timer_read32() - end) < 0) {
+            scan_once();
+        }
+    }
+
+    bool key_down() {
+        for (auto& row : state) {
+            for (bool on : row) {
+                if (on) return true;
+            }
+        }
+        return false;
+    }
+
+    void schedule(uint32_t delay, uint8_t row, uint8_t col, bool pressed) {
+        uint32_t time = timer_read32() + delay;
+        matrix_sim_schedule(time, row, col, pressed);
+        expected.push_back({time, row, col, pressed});
+    }
+
+    TestDriver            driver;
+    bool                  state[MATRIX_ROWS][MATRIX_COLS] = {};
+    bool                  idle_with_key_down              = false;
+    std::vector<KeyEvent> observed;
+    std::vector<KeyEvent> expected;
+};
+
+TEST_F(MatrixIdle, GoesIdleAfterGracePeriod) {
+    scan_for(MATRIX_IDLE_GRACE_MS - 1);
+    EXPECT_FALSE(matrix_is_idle());
+    scan_for(2);
+    EXPECT_TRUE(matrix_is_idle());
+
+    // Nothing is scanned while idle, the loop sleeps instead
+    uint32_t scans = matrix_sim_full_scan_count();
+    scan_for(1000);
+    EXPECT_EQ(matrix_sim_full_scan_count(), scans);
+    EXPECT_LE(matrix_sim_sleep_count(), 1000 / MATRIX_IDLE_MAX_SLEEP + 1);
+}
+
+TEST_F(MatrixIdle, StaysActiveWhileKeyHeld) {
+    matrix_sim_set_switch(1, 2, true);
+    scan_for(500);
+    EXPECT_FALSE(matrix_is_idle());
+    EXPECT_TRUE(state[1][2]);
+
+    matrix_sim_set_switch(1, 2, false);
+    scan_for(DEBOUNCE + MATRIX_IDLE_GRACE_MS + 2);
+    EXPECT_FALSE(state[1][2]);
+    EXPECT_TRUE(matrix_is_idle());
+}
+
+TEST_F(MatrixIdle, WakeUpIsAsFastAsActiveScanning) {
+    // Reference latency with the matrix scanning at full rate
+    schedule(5, 0, 0, true);
+    scan_for(100);
+    schedule(5, 0, 0, false);
+    scan_for(5);
+    ASSERT_EQ(observed.size(), 1u);
+    uint32_t active_latency = observed[0].time - expected[0].time;
+    scan_for(MATRIX_IDLE_GRACE_MS + 50);
+    ASSERT_TRUE(matrix_is_idle());
+
+    schedule(7, 2, 5, true);
+    scan_for(100);
+    ASSERT_EQ(observed.size(), 3u);
+    EXPECT_EQ(observed[2].time - expected[2].time, active_latency);
+    EXPECT_EQ(matrix_sim_wake_count(), 1u);
+}
+
+TEST_F(MatrixIdle, KeyReachesHostAfterIdle) {
+    scan_for(MATRIX_IDLE_GRACE_MS + 100);
+    ASSERT_TRUE(matrix_is_idle());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    schedule(3, 2, 3, true);
+    schedule(30, 2, 3, false);
+    scan_for(60);
+}
+
+TEST_F(MatrixIdle, SleepIsBoundedByDeadlines) {
+    scan_for(MATRIX_IDLE_GRACE_MS + 10);
+    ASSERT_TRUE(matrix_is_idle());
+
+    static bool fired;
+    fired = false;
+    deadline_schedule(
+        3, [](uint32_t, void*) -> uint32_t {
+            fired = true;
+            return 0;
+        },
+        nullptr);
+    uint32_t start = timer_read32();
+    while (!fired) {
+        scan_once();
+        deadline_task();
+    }
+    EXPECT_EQ(timer_read32() - start, 3u);
+}
+
+// Random typing with pauses on both sides of the grace period, no press or release may go missing
+TEST_F(MatrixIdle, NoEventsLostAcrossTransitions) {
+    std::mt19937                            rng(1234);
+    std::uniform_int_distribution<uint32_t> gap(DEBOUNCE + 2, 3 * MATRIX_IDLE_GRACE_MS);
+    std::uniform_int_distribution<uint8_t>  row(0, MATRIX_ROWS - 1), col(0, MATRIX_COLS - 1);
+
+    uint32_t delay = 0;
+    for (int i = 0; i < 200; i++) {
+        // Every change outlasts the debounce time, so each one has to come out of the matrix
+        uint8_t r = row(rng), c = col(rng);
+        delay += gap(rng);
+        schedule(delay, r, c, true);
+        delay += gap(rng);
+        schedule(delay, r, c, false);
+    }
+    scan_for(delay + 100);
+
+    ASSERT_EQ(observed.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(observed[i].row, expected[i].row) << "event " << i;
+        EXPECT_EQ(observed[i].col, expected[i].col) << "event " << i;
+        EXPECT_EQ(observed[i].pressed, expected[i].pressed) << "event " << i;
+        EXPECT_LE(observed[i].time - expected[i].time, DEBOUNCE + 2u) << "event " << i;
+    }
+    EXPECT_FALSE(idle_with_key_down);
+    EXPECT_GT(matrix_sim_wake_count(), 10u);
+}
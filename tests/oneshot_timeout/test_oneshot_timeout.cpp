@@ -0,0 +1,89 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "action_util.h"
+#include "action_layer.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+class OneshotTimeout : public TestFixture {
+   protected:
+    void tap_key(uint8_t col, uint8_t row) {
+        press_key(col, row);
+        run_one_scan_loop();
+        release_key(col, row);
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(OneshotTimeout, ModAppliesBeforeTimeout) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    tap_key(0, 0);
+    idle_for(ONESHOT_TIMEOUT - 10);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    tap_key(1, 0);
+}
+
+TEST_F(OneshotTimeout, ModIsClearedWithoutKeyPress) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    tap_key(0, 0);
+    EXPECT_EQ(MOD_BIT(KC_LSFT), get_oneshot_mods());
+    idle_for(ONESHOT_TIMEOUT);
+    // No key event happened, the deadline cleared it
+    EXPECT_EQ(0, get_oneshot_mods());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    tap_key(1, 0);
+}
+
+TEST_F(OneshotTimeout, LayerIsClearedWithoutKeyPress) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    tap_key(2, 0);
+    EXPECT_TRUE(layer_state_is(1));
+    idle_for(ONESHOT_TIMEOUT);
+    EXPECT_FALSE(layer_state_is(1));
+    EXPECT_EQ(0, get_oneshot_layer_state());
+}
+
+TEST_F(OneshotTimeout, EachOneshotTimesOutOnItsOwn) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    tap_key(0, 0);
+    idle_for(ONESHOT_TIMEOUT / 2);
+    tap_key(2, 0);
+    idle_for(ONESHOT_TIMEOUT / 2);
+    EXPECT_EQ(0, get_oneshot_mods());
+    EXPECT_TRUE(layer_state_is(1));
+
+    idle_for(ONESHOT_TIMEOUT / 2);
+    EXPECT_FALSE(layer_state_is(1));
+}
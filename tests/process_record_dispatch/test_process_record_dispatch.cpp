@@ -0,0 +1,135 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "action_tapping.h"
+#include <iostream>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::AtLeast;
+using testing::InSequence;
+
+extern "C" uint16_t blocked_keycode;
+
+class ProcessRecordDispatch : public TestFixture {
+   protected:
+    ~ProcessRecordDispatch() { blocked_keycode = KC_NO; }
+
+    // Handler calls made for one press and release of a key
+    uint32_t calls_for_tap(uint8_t col, uint8_t row) {
+        TestDriver driver;
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        uint32_t before = process_record_handler_calls;
+        press_key(col, row);
+        run_one_scan_loop();
+        release_key(col, row);
+        run_one_scan_loop();
+        uint32_t calls = process_record_handler_calls - before;
+        idle_for(TAPPING_TERM + 10);
+        return calls;
+    }
+};
+
+// kb/user, combo and space cadet see every event, tap dance, magic and grave escape only their own keycodes
+#define ALL_HANDLERS 3
+
+TEST_F(ProcessRecordDispatch, RangedHandlersOnlySeeTheirKeycodes) {
+    EXPECT_EQ(process_record_handler_count, 6);
+    EXPECT_EQ(calls_for_tap(6, 0), 2 * ALL_HANDLERS);
+    EXPECT_EQ(calls_for_tap(2, 0), 2 * (ALL_HANDLERS + 1));
+    EXPECT_EQ(calls_for_tap(3, 0), 2 * (ALL_HANDLERS + 1));
+    EXPECT_EQ(calls_for_tap(5, 0), 2 * (ALL_HANDLERS + 1));
+
+    // Without routing every handler was called for every event that nothing swallowed
+    std::cout << "[   INFO   ] handler calls per event: " << (unsigned)process_record_handler_count << " before, " << calls_for_tap(6, 0) / 2 << " for a basic key, " << calls_for_tap(2, 0) / 2 << " for a tap dance" << std::endl;
+}
+
+TEST_F(ProcessRecordDispatch, UserRunsBeforeRangedHandlers) {
+    TestDriver driver;
+    blocked_keycode = KC_GESC;
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    uint32_t before = process_record_handler_calls;
+    press_key(3, 0);
+    run_one_scan_loop();
+    release_key(3, 0);
+    run_one_scan_loop();
+    // Only process_record_kb was called, grave escape never saw the key
+    EXPECT_EQ(process_record_handler_calls - before, 2u);
+}
+
+TEST_F(ProcessRecordDispatch, RangedHandlerStillHandlesItsKeycode) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ESC)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(3, 0);
+    run_one_scan_loop();
+    release_key(3, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(ProcessRecordDispatch, TapDanceIsRouted) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AtLeast(1));
+    for (int i = 0; i < 2; i++) {
+        press_key(2, 0);
+        run_one_scan_loop();
+        release_key(2, 0);
+        run_one_scan_loop();
+    }
+    idle_for(TAPPING_TERM + 1);
+}
+
+TEST_F(ProcessRecordDispatch, EveryEventHandlersSeeOtherKeys) {
+    TestDriver driver;
+    InSequence s;
+
+    // Space cadet sees D, so releasing it afterwards is no longer a tap
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(4, 0);
+    run_one_scan_loop();
+    press_key(6, 0);
+    run_one_scan_loop();
+    release_key(6, 0);
+    run_one_scan_loop();
+    release_key(4, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(ProcessRecordDispatch, CombosSeeBasicKeys) {
+    TestDriver driver;
+    InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AtLeast(1));
+    press_key(0, 0);
+    press_key(1, 0);
+    run_one_scan_loop();
+    run_one_scan_loop();
+    release_key(0, 0);
+    release_key(1, 0);
+    run_one_scan_loop();
+    run_one_scan_loop();
+}
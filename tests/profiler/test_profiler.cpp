@@ -0,0 +1,188 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "action_tapping.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+extern "C" {
+// Time spent inside a stage, on top of the millisecond test timer
+static uint32_t extra_us = 0;
+
+uint32_t profiler_counter(void) { return timer_read32() * 1000 + extra_us; }
+}
+
+class Profiler : public TestFixture {
+   protected:
+    void SetUp() override {
+        extra_us = 0;
+        profiler_reset();
+    }
+
+    profiler_latency_t latency() {
+        profiler_latency_t latency;
+        profiler_get_latency(&latency);
+        return latency;
+    }
+};
+
+TEST_F(Profiler, ProbesRunEveryScan) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(10);
+
+    EXPECT_EQ(10u, profiler_get_stats(PROFILER_MATRIX_SCAN)->count);
+    // Ticks without a key event are not action_exec calls worth timing
+    EXPECT_EQ(0u, profiler_get_stats(PROFILER_ACTION_EXEC)->count);
+    EXPECT_EQ(0u, profiler_get_stats(PROFILER_PROCESS_RECORD)->count);
+    EXPECT_EQ(0u, profiler_get_stats(PROFILER_HOST_SEND)->count);
+    EXPECT_EQ(10u, profiler_get_stats(PROFILER_MATRIX_SCAN)->histogram[0]);
+}
+
+TEST_F(Profiler, KeyPressIsFollowedToTheReport) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+
+    EXPECT_EQ(2u, profiler_get_stats(PROFILER_ACTION_EXEC)->count);
+    EXPECT_EQ(2u, profiler_get_stats(PROFILER_PROCESS_RECORD)->count);
+    EXPECT_EQ(2u, profiler_get_stats(PROFILER_HOST_SEND)->count);
+    // Only the press is a latency sample, the report went out in the same scan
+    EXPECT_EQ(1u, latency().count);
+    EXPECT_EQ(0u, latency().max_us);
+}
+
+TEST_F(Profiler, ModTapLatencyIncludesTappingTerm) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(TAPPING_TERM);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+
+    EXPECT_EQ(1u, latency().count);
+    EXPECT_EQ(TAPPING_TERM * 1000u, latency().max_us);
+}
+
+TEST_F(Profiler, LatencyIsTimedFromTheLatestPress) {
+    TestDriver driver;
+    InSequence s;
+
+    // The layer change itself flushes empty reports, which close the MO(1) press
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    idle_for(50);
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    release_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    run_one_scan_loop();
+    run_one_scan_loop();
+
+    EXPECT_EQ(0u, latency().max_us);
+}
+
+TEST_F(Profiler, HistogramBucketsArePowersOfTwo) {
+    const uint32_t durations[] = {0, 1, 5, 7, 8, 1000, 40000};
+    for (uint32_t duration : durations) {
+        uint32_t start = profiler_counter();
+        extra_us += duration;
+        profiler_record(PROFILER_OLED, start);
+    }
+
+    const profiler_stats_t *stats = profiler_get_stats(PROFILER_OLED);
+    EXPECT_EQ(7u, stats->count);
+    EXPECT_EQ(41021u, stats->total_us);
+    EXPECT_EQ(0u, stats->min_cycles);
+    EXPECT_EQ(40000u, stats->max_cycles);
+    EXPECT_EQ(1, stats->histogram[0]);
+    EXPECT_EQ(1, stats->histogram[1]);
+    EXPECT_EQ(2, stats->histogram[3]);
+    EXPECT_EQ(1, stats->histogram[4]);
+    EXPECT_EQ(1, stats->histogram[10]);
+    EXPECT_EQ(1, stats->histogram[PROFILER_BUCKETS - 1]);
+}
+
+TEST_F(Profiler, NestedStagesAreDisjoint) {
+    profiler_probe_t scan, debounce, rgb_matrix;
+
+    profiler_begin(&scan);
+    extra_us += 10;
+    profiler_begin(&debounce);
+    extra_us += 3;
+    profiler_end(PROFILER_DEBOUNCE, &debounce);
+    extra_us += 5;
+    profiler_begin(&rgb_matrix);
+    extra_us += 100;
+    profiler_end(PROFILER_RGB_MATRIX, &rgb_matrix);
+    extra_us += 2;
+    profiler_end(PROFILER_MATRIX_SCAN, &scan);
+
+    EXPECT_EQ(17u, profiler_get_stats(PROFILER_MATRIX_SCAN)->total_us);
+    EXPECT_EQ(3u, profiler_get_stats(PROFILER_DEBOUNCE)->total_us);
+    EXPECT_EQ(100u, profiler_get_stats(PROFILER_RGB_MATRIX)->total_us);
+
+    // A following top level probe only counts its own time
+    profiler_begin(&scan);
+    extra_us += 4;
+    profiler_end(PROFILER_MATRIX_SCAN, &scan);
+    EXPECT_EQ(21u, profiler_get_stats(PROFILER_MATRIX_SCAN)->total_us);
+    EXPECT_EQ(4u, profiler_get_stats(PROFILER_MATRIX_SCAN)->min_cycles);
+}
+
+TEST_F(Profiler, LatencyPercentilesCoverRecentPresses) {
+    for (uint32_t i = 1; i <= 100; i++) {
+        uint32_t start = profiler_counter();
+        profiler_record(PROFILER_MATRIX_SCAN, start);
+        profiler_key_pressed();
+        extra_us += i;
+        profiler_report_sent();
+    }
+
+    // The last 32 samples are 69 to 100
+    EXPECT_EQ(100u, latency().count);
+    EXPECT_EQ(84u, latency().p50_us);
+    EXPECT_EQ(96u, latency().p90_us);
+    EXPECT_EQ(99u, latency().p99_us);
+    EXPECT_EQ(100u, latency().max_us);
+}
+
+TEST_F(Profiler, ResetClearsEverything) {
+    TestDriver driver;
+    idle_for(5);
+    profiler_key_pressed();
+    profiler_reset();
+    profiler_report_sent();
+
+    EXPECT_EQ(0u, profiler_get_stats(PROFILER_MATRIX_SCAN)->count);
+    EXPECT_EQ(0u, latency().count);
+}
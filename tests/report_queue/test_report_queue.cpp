@@ -0,0 +1,181 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test_common.hpp"
+
+#include <vector>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+// An endpoint the host polls every interval ms, which takes one report per poll
+class SlowEndpoint {
+   public:
+    SlowEndpoint(TestDriver& driver, uint16_t interval) : m_interval(interval) {
+        EXPECT_CALL(driver, keyboard_ready_mock()).WillRepeatedly(Invoke([this]() { return m_polled; }));
+        EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(Invoke([this](report_keyboard_t& report) {
+            EXPECT_TRUE(m_polled) << "report sent while the endpoint is busy";
+            sent.push_back(report);
+            m_polled = false;
+            m_time   = timer_read();
+        }));
+    }
+
+    // Called once per scan, a poll frees the endpoint again
+    void tick(void) {
+        if (TIMER_DIFF_16(timer_read(), m_time) >= m_interval) {
+            m_polled = true;
+        }
+    }
+
+    std::vector<report_keyboard_t> sent;
+
+   private:
+    uint16_t m_interval;
+    uint16_t m_time   = 0;
+    bool     m_polled = true;
+};
+
+class ReportQueue : public TestFixture {
+   protected:
+    void run_scans(SlowEndpoint& endpoint, unsigned count) {
+        for (unsigned i = 0; i < count; i++) {
+            endpoint.tick();
+            run_one_scan_loop();
+        }
+    }
+};
+
+static report_keyboard_t report_with(std::vector<uint8_t> keys) {
+    report_keyboard_t report = {};
+    for (auto k : keys) {
+        add_key_to_report(&report, k);
+    }
+    return report;
+}
+
+TEST_F(ReportQueue, ReadyEndpointGetsReportInTheSameScan) {
+    TestDriver driver;
+    testing::InSequence s;
+
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(ReportQueue, IdenticalReportsAreSentOnce) {
+    TestDriver driver;
+    testing::InSequence s;
+
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    send_keyboard_report();
+    send_keyboard_report();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(ReportQueue, BusyEndpointDelaysReportsInOrder) {
+    TestDriver driver;
+    bool       ready = false;
+    EXPECT_CALL(driver, keyboard_ready_mock()).WillRepeatedly(Invoke([&]() { return ready; }));
+    testing::InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(1, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+
+    ready = true;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(ReportQueue, TenKeyRollOverSlowEndpointLosesNoTransition) {
+    TestDriver   driver;
+    SlowEndpoint endpoint(driver, 10);
+
+    // Each key goes down before the previous one comes up, a transition every 8 ms
+    std::vector<report_keyboard_t> expected;
+    for (uint8_t k = 0; k < 10; k++) {
+        press_key(k, 0);
+        run_scans(endpoint, 8);
+        expected.push_back(k ? report_with({(uint8_t)(KC_A + k - 1), (uint8_t)(KC_A + k)}) : report_with({KC_A}));
+        if (k) {
+            release_key(k - 1, 0);
+            run_scans(endpoint, 8);
+            expected.push_back(report_with({(uint8_t)(KC_A + k)}));
+        }
+    }
+    release_key(9, 0);
+    run_scans(endpoint, 8);
+    expected.push_back(report_with({}));
+    // Let the queue drain
+    run_scans(endpoint, 20 * 10);
+
+    EXPECT_EQ(expected.size(), 20u);
+    ASSERT_EQ(endpoint.sent.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(endpoint.sent[i], expected[i]) << "transition " << i;
+    }
+}
+
+TEST_F(ReportQueue, FullQueueStillEndsInTheCurrentState) {
+    TestDriver driver;
+    bool       ready = false;
+    EXPECT_CALL(driver, keyboard_ready_mock()).WillRepeatedly(Invoke([&]() { return ready; }));
+    testing::InSequence s;
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    // Ten transitions, two more than the queue holds
+    for (uint8_t k = 0; k < 5; k++) {
+        press_key(k, 0);
+        run_one_scan_loop();
+        release_key(k, 0);
+        run_one_scan_loop();
+    }
+    press_key(5, 0);
+    run_one_scan_loop();
+
+    ready = true;
+    for (uint8_t k = 0; k < 3; k++) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A + k)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_D)));
+    // The newest queued report is replaced by the current one
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F)));
+    run_one_scan_loop();
+    release_key(5, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
@@ -0,0 +1,33 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {{KC_A}},
+};
+
+// Changes the upper layers, to test cache invalidation
+uint8_t test_keymap_seed = 1;
+
+// 32 layers: layer 0 is fully mapped, every other layer maps a layer dependent subset of the keys
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
+    uint16_t key_number = key.row * MATRIX_COLS + key.col;
+    if (layer == 0) {
+        return KC_A + key_number % 26;
+    }
+    return (key_number * (layer + test_keymap_seed)) % 7 == 0 ? KC_1 + layer % 10 : KC_TRNS;
+}
@@ -0,0 +1,115 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using testing::_;
+using testing::AnyNumber;
+
+extern "C" uint8_t test_keymap_seed;
+
+class ResolvedLayerCache : public TestFixture {
+   protected:
+    // The uncached lookup, walking every enabled layer
+    static uint8_t walk_layers(keypos_t key) {
+        layer_state_t layers = layer_state | default_layer_state;
+        for (int8_t i = MAX_LAYER - 1; i >= 0; i--) {
+            if ((layers & (1UL << i)) && action_for_key(i, key).code != ACTION_TRANSPARENT) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    static void expect_all_keys_resolved(void) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keypos_t key = {.col = col, .row = row};
+                ASSERT_EQ(layer_switch_get_layer(key), walk_layers(key)) << "layers " << std::hex << (layer_state | default_layer_state) << " row " << std::dec << (int)row << " col " << (int)col;
+            }
+        }
+    }
+};
+
+TEST_F(ResolvedLayerCache, MatchesLayerWalkForRandomLayerChanges) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    std::mt19937 rng(42);
+
+    for (int i = 0; i < 500; i++) {
+        switch (rng() % 4) {
+            case 0:
+                layer_on(rng() % MAX_LAYER);
+                break;
+            case 1:
+                layer_off(rng() % MAX_LAYER);
+                break;
+            case 2:
+                layer_state_set(rng());
+                break;
+            case 3:
+                default_layer_set(1UL << (rng() % MAX_LAYER));
+                break;
+        }
+        expect_all_keys_resolved();
+    }
+    default_layer_set(0);
+}
+
+TEST_F(ResolvedLayerCache, KeymapChangesNeedInvalidation) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    layer_state_set(0xFFFFFFFF);
+    expect_all_keys_resolved();
+    test_keymap_seed = 2;
+    invalidate_resolved_layers_cache();
+    expect_all_keys_resolved();
+    test_keymap_seed = 1;
+    invalidate_resolved_layers_cache();
+}
+
+TEST_F(ResolvedLayerCache, Benchmark) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    const int rounds = 1000;
+
+    // Only the lowest layer is on, so most keys fall through every layer
+    layer_state_set(0xFFFFFFFE);
+    default_layer_set(1);
+
+    auto     start    = std::chrono::steady_clock::now();
+    unsigned checksum = 0;
+    for (int i = 0; i < rounds; i++) {
+        for (uint8_t k = 0; k < MATRIX_ROWS * MATRIX_COLS; k++) {
+            checksum += walk_layers((keypos_t){.col = (uint8_t)(k % MATRIX_COLS), .row = (uint8_t)(k / MATRIX_COLS)});
+        }
+    }
+    auto walked = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        for (uint8_t k = 0; k < MATRIX_ROWS * MATRIX_COLS; k++) {
+            checksum -= layer_switch_get_layer((keypos_t){.col = (uint8_t)(k % MATRIX_COLS), .row = (uint8_t)(k / MATRIX_COLS)});
+        }
+    }
+    auto cached = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(checksum, 0u);
+    std::cout << "[   INFO   ] 32 layers, " << MATRIX_ROWS * MATRIX_COLS << " keys, per lookup: layer walk " << std::chrono::duration_cast<std::chrono::nanoseconds>(walked).count() / (rounds * MATRIX_ROWS * MATRIX_COLS) << " ns, resolved layer cache " << std::chrono::duration_cast<std::chrono::nanoseconds>(cached).count() / (rounds * MATRIX_ROWS * MATRIX_COLS) << " ns" << std::endl;
+}
@@ -0,0 +1,309 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+using testing::InvokeWithoutArgs;
+
+extern "C" {
+#include "process_unicode_common.h"
+#include "dynamic_keymap.h"
+}
+
+class SendStringAsync : public TestFixture {
+   protected:
+    static std::vector<bool> completions;
+
+    static void on_done(bool completed) { completions.push_back(completed); }
+
+    void SetUp() override {
+        completions.clear();
+        dynamic_keymap_reset();
+        dynamic_keymap_macro_reset();
+    }
+
+    void TearDown() override { send_string_async_cancel(); }
+};
+
+std::vector<bool> SendStringAsync::completions;
+
+// Expects the report to be sent exactly `t` ms after `start`
+#define AT_TIME(t) WillOnce(InvokeWithoutArgs([start]() { EXPECT_EQ(timer_elapsed32(start), t); }))
+
+TEST_F(SendStringAsync, SendsOneReportPerScan) {
+    TestDriver driver;
+    InSequence s;
+    uint32_t   start = timer_read32();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT))).AT_TIME(0u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_H))).AT_TIME(1u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT))).AT_TIME(2u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(3u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_I))).AT_TIME(4u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(5u);
+    EXPECT_TRUE(send_string_async("Hi", 0, on_done));
+    EXPECT_TRUE(send_string_async_busy());
+    idle_for(6);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    EXPECT_FALSE(send_string_async_busy());
+    EXPECT_EQ(completions, std::vector<bool>({true}));
+}
+
+TEST_F(SendStringAsync, DelaysDoNotBlockTheScanLoop) {
+    TestDriver driver;
+    InSequence s;
+    uint32_t   start = timer_read32();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B))).AT_TIME(0u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(1u);
+    // A real key pressed during the delay is reported straight away
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).AT_TIME(10u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(20u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C))).AT_TIME(52u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(53u);
+    EXPECT_TRUE(send_string_async("b" SS_DELAY(50) "c", 0, NULL));
+    idle_for(10);
+    press_key(0, 0);
+    idle_for(10);
+    release_key(0, 0);
+    idle_for(40);
+}
+
+TEST_F(SendStringAsync, IntervalIsAppliedBetweenCharacters) {
+    TestDriver driver;
+    InSequence s;
+    uint32_t   start = timer_read32();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).AT_TIME(0u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(1u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B))).AT_TIME(21u);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).AT_TIME(22u);
+    EXPECT_TRUE(send_string_async_P("ab", 20, on_done));
+    idle_for(50);
+    EXPECT_EQ(completions, std::vector<bool>({true}));
+}
+
+TEST_F(SendStringAsync, QueuedStringsAreTypedInOrder) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_TRUE(send_string_async("x", 0, on_done));
+    EXPECT_TRUE(send_string_async(SS_DOWN(X_LCTL) SS_UP(X_LCTL), 0, on_done));
+    idle_for(10);
+    EXPECT_EQ(completions, std::vector<bool>({true, true}));
+}
+
+TEST_F(SendStringAsync, TruncatedEscapeEndsItsJob) {
+    TestDriver driver;
+    InSequence s;
+    // The job cut short is done before the next one starts typing
+    auto first_job_done = InvokeWithoutArgs([]() { EXPECT_EQ(completions.size(), 1u); });
+    const char prefix_only[] = {'x', SS_QMK_PREFIX, 0};
+    const char tap_only[]    = {SS_QMK_PREFIX, SS_TAP_CODE, 0};
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y))).WillOnce(first_job_done);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_TRUE(send_string_async(prefix_only, 0, on_done));
+    EXPECT_TRUE(send_string_async("y", 0, on_done));
+    idle_for(10);
+    EXPECT_EQ(completions, std::vector<bool>({true, true}));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    completions.clear();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y))).WillOnce(first_job_done);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_TRUE(send_string_async(tap_only, 0, on_done));
+    EXPECT_TRUE(send_string_async("y", 0, on_done));
+    idle_for(10);
+    EXPECT_EQ(completions, std::vector<bool>({true, true}));
+}
+
+TEST_F(SendStringAsync, KeycodeQueuesAString) {
+    TestDriver driver;
+    InSequence s;
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_H)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_I)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(10);
+    release_key(1, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(SendStringAsync, CancelReleasesHeldKeys) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_Z)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_TRUE(send_string_async("Zzz", 0, on_done));
+    EXPECT_TRUE(send_string_async("more", 0, on_done));
+    idle_for(2);
+    send_string_async_cancel();
+    EXPECT_FALSE(send_string_async_busy());
+    EXPECT_EQ(completions, std::vector<bool>({false, false}));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(10);
+}
+
+TEST_F(SendStringAsync, RejectsStringsThatDoNotFit) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    // 48 bytes of buffer, terminators included
+    EXPECT_FALSE(send_string_async("012345678901234567890123456789012345678901234567", 0, on_done));
+    EXPECT_TRUE(send_string_async("01234567890123456789012", 0, on_done));
+    EXPECT_FALSE(send_string_async("012345678901234567890123", 0, on_done));
+    EXPECT_TRUE(send_string_async("01234567890123456789012", 0, on_done));
+    // Out of job slots
+    EXPECT_FALSE(send_string_async("", 0, on_done));
+    idle_for(200);
+    EXPECT_EQ(completions, std::vector<bool>({true, true}));
+    EXPECT_TRUE(send_string_async("01234567890123456789012345678901234567890123456", 0, on_done));
+}
+
+TEST_F(SendStringAsync, UnicodeIsQueued) {
+    TestDriver driver;
+    InSequence s;
+    unicode_config.input_mode = UC_LNX;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT, KC_U)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    for (uint8_t keycode : {KC_0, KC_0, KC_E, KC_9}) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(keycode)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_SPC)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_TRUE(send_unicode_string_async("\xC3\xA9", on_done));
+    idle_for(40);
+    EXPECT_EQ(completions, std::vector<bool>({true}));
+}
+
+TEST_F(SendStringAsync, CancelReleasesKeysOfEarlierTokens) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_TRUE(send_string_async(SS_DOWN(X_LCTL) "ab" SS_UP(X_LCTL), 0, on_done));
+    idle_for(2);
+    send_string_async_cancel();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(10);
+}
+
+TEST_F(SendStringAsync, UnicodeStringIsOneJob) {
+    TestDriver driver;
+    InSequence s;
+    unicode_config.input_mode = UC_MAC;
+    for (int i = 0; i < 2; i++) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+        for (uint8_t keycode : {KC_0, KC_0, KC_E, KC_9}) {
+            EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, keycode)));
+            EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+        }
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    // One job slot is left, the two code points share it
+    EXPECT_TRUE(send_string_async("", 0, NULL));
+    EXPECT_TRUE(send_unicode_string_async("\xC3\xA9\xC3\xA9", on_done));
+    idle_for(60);
+    EXPECT_EQ(completions, std::vector<bool>({true}));
+}
+
+TEST_F(SendStringAsync, UnicodeStringThatDoesNotFitQueuesNothing) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    unicode_config.input_mode = UC_MAC;
+    EXPECT_FALSE(send_unicode_string_async("\xC3\xA9\xC3\xA9\xC3\xA9", on_done));
+    EXPECT_FALSE(send_string_async_busy());
+}
+
+TEST_F(SendStringAsync, UnicodeReleasesHeldMods) {
+    TestDriver driver;
+    InSequence s;
+    unicode_config.input_mode = UC_WINC;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    press_key(2, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_RALT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_U)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    for (uint8_t keycode : {KC_0, KC_0, KC_E, KC_9}) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(keycode)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ENT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_TRUE(register_unicode_async(0xE9, on_done));
+    idle_for(40);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(2, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(SendStringAsync, LongMacroWaitsForTheQueue) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    // Longer than the whole queue, so it is typed blocking
+    char macro[64];
+    memset(macro, 'x', sizeof(macro) - 2);
+    macro[sizeof(macro) - 2] = 'y';
+    macro[sizeof(macro) - 1] = 0;
+    dynamic_keymap_macro_set_buffer(0, sizeof(macro), (uint8_t *)macro);
+
+    EXPECT_TRUE(send_string_async("a" SS_DELAY(100) "b", 0, NULL));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // The queued "b" goes out before the macro
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    for (int i = 0; i < 62; i++) {
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_macro_send(0);
+    EXPECT_FALSE(send_string_async_busy());
+}
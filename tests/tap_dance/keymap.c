@@ -0,0 +1,46 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+enum tap_dances {
+    TD_AB,
+    TD_CD,
+    TD_FAST,
+    TD_LAST = 63,
+};
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] =
+        {
+            // 0         1          2            3     4          5      6      7      8      9
+            {TD(TD_AB), TD(TD_CD), TD(TD_FAST), KC_X, TD(TD_LAST), KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+            {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+            {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+            {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+        },
+};
+
+static void fast_finished(qk_tap_dance_state_t *state, void *user_data) { register_code(KC_F); }
+static void fast_reset(qk_tap_dance_state_t *state, void *user_data) { unregister_code(KC_F); }
+
+// Most of the 64 dances are filler, so that scans have a large table to skip over
+qk_tap_dance_action_t tap_dance_actions[] = {
+    [TD_AB]                 = ACTION_TAP_DANCE_DOUBLE(KC_A, KC_B),
+    [TD_CD]                 = ACTION_TAP_DANCE_DOUBLE(KC_C, KC_D),
+    [TD_FAST]               = ACTION_TAP_DANCE_FN_ADVANCED_TIME(NULL, fast_finished, fast_reset, 100),
+    [TD_FAST + 1 ... TD_LAST] = ACTION_TAP_DANCE_DOUBLE(KC_1, KC_2),
+};
@@ -0,0 +1,162 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "action_tapping.h"
+#include <chrono>
+#include <iostream>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::AtLeast;
+using testing::InSequence;
+
+class TapDance : public TestFixture {
+   protected:
+    void tap_key(uint8_t col, uint8_t row) {
+        press_key(col, row);
+        run_one_scan_loop();
+        release_key(col, row);
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(TapDance, SingleTapFinishesAfterTappingTerm) {
+    TestDriver driver;
+    InSequence s;
+
+    tap_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(TAPPING_TERM - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AtLeast(1));
+    run_one_scan_loop();
+}
+
+TEST_F(TapDance, DoubleTapSendsSecondKey) {
+    TestDriver driver;
+    InSequence s;
+
+    tap_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // Nothing is left waiting for the tapping term
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(TAPPING_TERM + 10);
+}
+
+TEST_F(TapDance, OtherKeyInterruptsDance) {
+    TestDriver driver;
+    InSequence s;
+
+    tap_key(0, 0);
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AtLeast(1));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    run_one_scan_loop();
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(TapDance, DanceInterruptsDance) {
+    TestDriver driver;
+    InSequence s;
+
+    tap_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AtLeast(1));
+    tap_key(4, 0);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(TAPPING_TERM - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_1)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AtLeast(1));
+    run_one_scan_loop();
+}
+
+TEST_F(TapDance, CustomTappingTerm) {
+    TestDriver driver;
+    InSequence s;
+
+    tap_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(99);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AtLeast(1));
+    run_one_scan_loop();
+}
+
+TEST_F(TapDance, HeldDanceStaysRegisteredUntilRelease) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    idle_for(TAPPING_TERM + 2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // Keys pressed while the finished dance is held do not release it
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_X)));
+    run_one_scan_loop();
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AtLeast(1));
+    run_one_scan_loop();
+}
+
+TEST_F(TapDance, Benchmark) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    const int rounds = 100000;
+
+    // Leave a dance in flight, as is the case while typing
+    tap_key(4, 0);
+
+    keyrecord_t record   = {};
+    record.event.pressed = true;
+    auto start           = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        matrix_scan_tap_dance();
+        preprocess_tap_dance(TD(63), &record);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "[   INFO   ] 64 tap dances, one in flight: " << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / rounds << " ns per scan and key press" << std::endl;
+}
@@ -0,0 +1,190 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+extern "C" {
+#include "action_tapping.h"
+}
+
+#include <chrono>
+#include <iostream>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+extern "C" unsigned tapping_term_calls;
+
+class TappingTerm : public TestFixture {};
+TEST_F(TappingTerm, RollWithinTappingTermReportsShift) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(1, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+    release_key(1, 0);
+    run_one_scan_loop();
+    release_key(7, 0);
+    // The other keys interrupted the tap, so the release registers shift
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    // And the buffered keys are replayed with it once the tapping term is over
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(TAPPING_TERM);
+}
+
+TEST_F(TappingTerm, BufferedKeysAreReplayedAfterTappingTerm) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    idle_for(TAPPING_TERM);
+    release_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(TappingTerm, WaitingBufferOverflowClearsAllStates) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    // The waiting buffer holds WAITING_BUFFER_SIZE - 1 events
+    for (int i = 0; i < (WAITING_BUFFER_SIZE - 1) / 2; i++) {
+        press_key(i, 3);
+        run_one_scan_loop();
+        release_key(i, 3);
+        run_one_scan_loop();
+    }
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(2);
+    run_one_scan_loop();
+    release_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(TAPPING_TERM + 1);
+}
+
+TEST_F(TappingTerm, RepeatedRollsWrapTheWaitingBuffer) {
+    TestDriver driver;
+    InSequence s;
+
+    for (int round = 0; round < 3 * WAITING_BUFFER_SIZE; round++) {
+        press_key(7, 0);
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+        run_one_scan_loop();
+        press_key(0, 0);
+        run_one_scan_loop();
+        release_key(0, 0);
+        run_one_scan_loop();
+        release_key(7, 0);
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT))).Times(2);
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+        run_one_scan_loop();
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+        idle_for(TAPPING_TERM + 1);
+        testing::Mock::VerifyAndClearExpectations(&driver);
+    }
+}
+
+TEST_F(TappingTerm, TapThenRollStartsNewTap) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    release_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P)));
+    run_one_scan_loop();
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P, KC_A)));
+    run_one_scan_loop();
+    release_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(TappingTerm, TappingTermIsResolvedOncePerKeyEvent) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    press_key(7, 0);
+    run_one_scan_loop();
+    tapping_term_calls = 0;
+    idle_for(TAPPING_TERM - 10);
+    EXPECT_LE(tapping_term_calls, 1u);
+    release_key(7, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(TappingTerm, Benchmark) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    const int rounds = 200;
+
+    tapping_term_calls = 0;
+    auto start         = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        // A fast typist rolling over a mod-tap key
+        press_key(7, 0);
+        run_one_scan_loop();
+        for (int k = 0; k < 2; k++) {
+            press_key(k, 0);
+            idle_for(5);
+            release_key(k, 0);
+            idle_for(5);
+        }
+        release_key(7, 0);
+        idle_for(TAPPING_TERM + 1);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    unsigned scans = rounds * (TAPPING_TERM + 22);
+    std::cout << "[   INFO   ] mod-tap rolls: " << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / scans << " ns per scan, " << tapping_term_calls << " get_tapping_term() calls in " << scans << " scans" << std::endl;
+}
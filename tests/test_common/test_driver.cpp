@@ -18,9 +18,11 @@
 
 TestDriver* TestDriver::m_this = nullptr;
 
-TestDriver::TestDriver() : m_driver{&TestDriver::keyboard_leds, &TestDriver::send_keyboard, &TestDriver::send_mouse, &TestDriver::send_system, &TestDriver::send_consumer} {
+TestDriver::TestDriver() : m_driver{&TestDriver::keyboard_leds, &TestDriver::send_keyboard, &TestDriver::send_mouse, &TestDriver::send_system, &TestDriver::send_consumer, &TestDriver::keyboard_ready} {
     host_set_driver(&m_driver);
     m_this = this;
+    // An endpoint that is always ready, unless a test says otherwise
+    EXPECT_CALL(*this, keyboard_ready_mock()).Times(testing::AnyNumber()).WillRepeatedly(testing::Return(true));
 }
 
 TestDriver::~TestDriver() { m_this = nullptr; }
@@ -34,3 +36,5 @@ void TestDriver::send_mouse(report_mouse_t* report) { m_this->send_mouse_mock(*r
 void TestDriver::send_system(uint16_t data) { m_this->send_system_mock(data); }
 
 void TestDriver::send_consumer(uint16_t data) { m_this->send_consumer(data); }
+
+bool TestDriver::keyboard_ready(void) { return m_this->keyboard_ready_mock(); }
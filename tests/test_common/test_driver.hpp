@@ -33,12 +33,15 @@ public:
     MOCK_METHOD1(send_mouse_mock, void (report_mouse_t&));
     MOCK_METHOD1(send_system_mock, void (uint16_t));
     MOCK_METHOD1(send_consumer_mock, void (uint16_t));
+    // Only asked with KEYBOARD_REPORT_QUEUE
+    MOCK_METHOD0(keyboard_ready_mock, bool ());
 private:
     static uint8_t keyboard_leds(void);
     static void send_keyboard(report_keyboard_t *report);
     static void send_mouse(report_mouse_t* report);
     static void send_system(uint16_t data);
     static void send_consumer(uint16_t data);
+    static bool keyboard_ready(void);
     host_driver_t m_driver;
     uint8_t m_leds = 0;
     static TestDriver* m_this;
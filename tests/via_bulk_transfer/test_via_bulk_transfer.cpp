@@ -0,0 +1,212 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test_common.hpp"
+
+#include <vector>
+
+extern "C" {
+#include "via.h"
+#include "raw_hid.h"
+#include "dynamic_keymap.h"
+
+void eeprom_test_get_writes(uint32_t *calls, uint32_t *bytes);
+
+static unsigned replies;
+
+// The host reads every reply as a round trip
+void raw_hid_send(uint8_t *data, uint8_t length) { replies++; }
+
+bool raw_hid_send_nonblocking(uint8_t *data, uint8_t length) { return false; }
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+#define PACKET_SIZE 32
+
+// CRC-16/CCITT-FALSE, as the host computes it
+static uint16_t crc16(const std::vector<uint8_t> &data) {
+    uint16_t crc = 0xFFFF;
+    for (uint8_t byte : data) {
+        crc ^= byte << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+class ViaBulkTransfer : public TestFixture {
+   public:
+    ViaBulkTransfer() {
+        for (uint16_t i = 0; i < dynamic_keymap_get_buffer_size() / 2; i++) {
+            uint16_t keycode = KC_A + i % 100 + (i / (MATRIX_ROWS * MATRIX_COLS) << 8);
+            keymap.push_back(keycode >> 8);
+            keymap.push_back(keycode & 0xFF);
+        }
+        dynamic_keymap_reset();
+        replies = 0;
+        eeprom_test_get_writes(&write_calls, &write_bytes);
+    }
+
+    // Returns true if the packet was replied to
+    bool send(std::vector<uint8_t> packet) {
+        unsigned before = replies;
+        packet.resize(PACKET_SIZE);
+        raw_hid_receive(packet.data(), PACKET_SIZE);
+        last_reply = packet;
+        return replies != before;
+    }
+
+    uint8_t begin(uint16_t offset, uint16_t size) {
+        EXPECT_TRUE(send({id_dynamic_keymap_bulk_begin, (uint8_t)(offset >> 8), (uint8_t)offset, (uint8_t)(size >> 8), (uint8_t)size}));
+        EXPECT_EQ((last_reply[6] << 8) | last_reply[7], VIA_BULK_BUFFER_SIZE);
+        return last_reply[5];
+    }
+
+    void data(uint8_t sequence, std::vector<uint8_t>::const_iterator first, std::vector<uint8_t>::const_iterator last) {
+        std::vector<uint8_t> packet = {id_dynamic_keymap_bulk_data, sequence};
+        packet.insert(packet.end(), first, last);
+        EXPECT_FALSE(send(packet));
+    }
+
+    uint8_t commit(uint16_t crc) {
+        EXPECT_TRUE(send({id_dynamic_keymap_bulk_commit, (uint8_t)(crc >> 8), (uint8_t)crc}));
+        return last_reply[3];
+    }
+
+    // Uploads the keymap in data packets of PACKET_SIZE - 2 bytes, skipping the packet number skip
+    void send_data(int skip = -1) {
+        uint8_t sequence = 0;
+        for (size_t offset = 0; offset < keymap.size(); offset += PACKET_SIZE - 2, sequence++) {
+            if (sequence != skip) {
+                data(sequence, keymap.begin() + offset, keymap.begin() + std::min(offset + PACKET_SIZE - 2, keymap.size()));
+            }
+        }
+    }
+
+    void upload_legacy(void) {
+        for (uint16_t offset = 0; offset < keymap.size(); offset += 28) {
+            uint8_t size = std::min<size_t>(28, keymap.size() - offset);
+            std::vector<uint8_t> packet = {id_dynamic_keymap_set_buffer, (uint8_t)(offset >> 8), (uint8_t)offset, size};
+            packet.insert(packet.end(), keymap.begin() + offset, keymap.begin() + offset + size);
+            EXPECT_TRUE(send(packet));
+        }
+    }
+
+    void upload_bulk(void) {
+        EXPECT_EQ(begin(0, keymap.size()), via_bulk_ok);
+        send_data();
+        EXPECT_EQ(commit(crc16(keymap)), via_bulk_ok);
+    }
+
+    void expect_keymap(bool uploaded) {
+        std::vector<uint8_t> stored(keymap.size());
+        for (uint16_t offset = 0; offset < keymap.size(); offset += 28) {
+            dynamic_keymap_get_buffer(offset, std::min<size_t>(28, keymap.size() - offset), &stored[offset]);
+        }
+        if (uploaded) {
+            EXPECT_EQ(stored, keymap);
+            EXPECT_EQ(keymap_key_to_keycode(3, (keypos_t){.col = 19, .row = 4}), (keymap[keymap.size() - 2] << 8) | keymap.back());
+        } else {
+            EXPECT_NE(stored, keymap);
+            EXPECT_EQ(keymap_key_to_keycode(0, (keypos_t){.col = 1, .row = 0}), KC_B);
+        }
+    }
+
+    std::vector<uint8_t> keymap;
+    std::vector<uint8_t> last_reply;
+    uint32_t             write_calls;
+    uint32_t             write_bytes;
+};
+
+TEST_F(ViaBulkTransfer, UploadsTheKeymapInOneBlockWrite) {
+    upload_bulk();
+    expect_keymap(true);
+    EXPECT_EQ(replies, 2);
+    eeprom_test_get_writes(&write_calls, &write_bytes);
+    EXPECT_EQ(write_calls, 1);
+    EXPECT_EQ(write_bytes, keymap.size());
+}
+
+TEST_F(ViaBulkTransfer, UploadsPartOfTheKeymap) {
+    std::vector<uint8_t> layer(keymap.begin() + keymap.size() / 2, keymap.begin() + keymap.size() * 3 / 4);
+    EXPECT_EQ(begin(keymap.size() / 2, layer.size()), via_bulk_ok);
+    for (size_t offset = 0, sequence = 0; offset < layer.size(); offset += PACKET_SIZE - 2, sequence++) {
+        data(sequence, layer.begin() + offset, layer.begin() + std::min(offset + PACKET_SIZE - 2, layer.size()));
+    }
+    EXPECT_EQ(commit(crc16(layer)), via_bulk_ok);
+    EXPECT_EQ(dynamic_keymap_get_keycode(2, 0, 0), (layer[0] << 8) | layer[1]);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 1), KC_B);
+}
+
+TEST_F(ViaBulkTransfer, RejectsABadCrc) {
+    EXPECT_EQ(begin(0, keymap.size()), via_bulk_ok);
+    send_data();
+    EXPECT_EQ(commit(crc16(keymap) ^ 1), via_bulk_error_crc);
+    expect_keymap(false);
+}
+
+TEST_F(ViaBulkTransfer, RejectsALostPacket) {
+    EXPECT_EQ(begin(0, keymap.size()), via_bulk_ok);
+    send_data(3);
+    EXPECT_EQ(commit(crc16(keymap)), via_bulk_error_sequence);
+    expect_keymap(false);
+}
+
+TEST_F(ViaBulkTransfer, RejectsAShortUpload) {
+    EXPECT_EQ(begin(0, keymap.size()), via_bulk_ok);
+    data(0, keymap.begin(), keymap.begin() + PACKET_SIZE - 2);
+    EXPECT_EQ(commit(crc16(keymap)), via_bulk_error_length);
+    expect_keymap(false);
+}
+
+TEST_F(ViaBulkTransfer, RejectsSessionsOutsideTheKeymap) {
+    EXPECT_EQ(begin(0, 0), via_bulk_error_size);
+    EXPECT_EQ(begin(0, keymap.size() + 2), via_bulk_error_size);
+    EXPECT_EQ(begin(keymap.size() - 2, 4), via_bulk_error_size);
+    EXPECT_EQ(begin(0xFFFF, 2), via_bulk_error_size);
+    // The failed begin leaves no session to commit
+    EXPECT_EQ(commit(0), via_bulk_error_sequence);
+}
+
+TEST_F(ViaBulkTransfer, DataWithoutASessionIsIgnored) {
+    data(0, keymap.begin(), keymap.begin() + PACKET_SIZE - 2);
+    EXPECT_EQ(commit(0), via_bulk_error_sequence);
+    expect_keymap(false);
+}
+
+TEST_F(ViaBulkTransfer, SetBufferStillWorks) {
+    upload_legacy();
+    expect_keymap(true);
+}
+
+TEST_F(ViaBulkTransfer, Benchmark) {
+    upload_legacy();
+    unsigned legacy_replies = replies;
+    eeprom_test_get_writes(&write_calls, &write_bytes);
+    printf("[   INFO   ] set_buffer upload of %u bytes: %u round trips, %u EEPROM write calls, %u bytes written\n", (unsigned)keymap.size(), legacy_replies, (unsigned)write_calls, (unsigned)write_bytes);
+
+    dynamic_keymap_reset();
+    replies = 0;
+    eeprom_test_get_writes(&write_calls, &write_bytes);
+    upload_bulk();
+    eeprom_test_get_writes(&write_calls, &write_bytes);
+    printf("[   INFO   ] bulk upload of %u bytes: %u round trips, %u packets, %u EEPROM write calls, %u bytes written\n", (unsigned)keymap.size(), replies, (unsigned)(keymap.size() + PACKET_SIZE - 3) / (PACKET_SIZE - 2) + 2, (unsigned)write_calls, (unsigned)write_bytes);
+    expect_keymap(true);
+}
@@ -0,0 +1,190 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test_common.hpp"
+
+#include <vector>
+
+extern "C" {
+#include "via.h"
+#include "raw_hid.h"
+
+static std::vector<std::vector<uint8_t>> sent;
+static bool                              endpoint_busy;
+
+void raw_hid_send(uint8_t *data, uint8_t length) { sent.push_back(std::vector<uint8_t>(data, data + length)); }
+
+bool raw_hid_send_nonblocking(uint8_t *data, uint8_t length) {
+    if (endpoint_busy) {
+        return false;
+    }
+    raw_hid_send(data, length);
+    return true;
+}
+}
+
+#define PACKET_SIZE 32
+
+class ViaSwitchMatrix : public TestFixture {
+   public:
+    ViaSwitchMatrix() {
+        sent.clear();
+        endpoint_busy = false;
+    }
+
+    ~ViaSwitchMatrix() { subscribe(false); }
+
+    std::vector<uint8_t> send(std::vector<uint8_t> packet) {
+        packet.resize(PACKET_SIZE);
+        raw_hid_receive(packet.data(), PACKET_SIZE);
+        std::vector<uint8_t> reply = sent.back();
+        sent.clear();
+        return reply;
+    }
+
+    void subscribe(bool on) { send({id_set_keyboard_value, id_switch_matrix_stream, on}); }
+
+    TestDriver driver;
+
+    // Checks a packet against its sequence number and row and column pairs, pressed rows have bit 7 set
+    void expect_event(const std::vector<uint8_t> &packet, uint8_t sequence, std::vector<uint8_t> events) {
+        ASSERT_EQ(packet.size(), PACKET_SIZE);
+        EXPECT_EQ(packet[0], id_switch_matrix_event);
+        EXPECT_EQ(packet[1], sequence);
+        EXPECT_EQ(packet[4], events.size() / 2);
+        EXPECT_EQ(std::vector<uint8_t>(packet.begin() + 5, packet.begin() + 5 + events.size()), events);
+    }
+};
+
+TEST_F(ViaSwitchMatrix, NothingIsSentWithoutASubscription) {
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+    EXPECT_TRUE(sent.empty());
+}
+
+TEST_F(ViaSwitchMatrix, StreamsPressAndRelease) {
+    subscribe(true);
+    EXPECT_EQ(send({id_get_keyboard_value, id_switch_matrix_stream})[2], 1);
+    run_one_scan_loop();
+    EXPECT_TRUE(sent.empty());
+
+    press_key(23, 11);
+    run_one_scan_loop();
+    ASSERT_EQ(sent.size(), 1);
+    expect_event(sent[0], 0, {0x80 | 11, 23});
+    EXPECT_EQ((sent[0][2] << 8) | sent[0][3], (uint16_t)(timer_read() - 1));
+
+    release_key(23, 11);
+    run_one_scan_loop();
+    ASSERT_EQ(sent.size(), 2);
+    expect_event(sent[1], 1, {11, 23});
+}
+
+TEST_F(ViaSwitchMatrix, ChangesOfOneScanShareAPacket) {
+    subscribe(true);
+    press_key(1, 0);
+    press_key(2, 5);
+    press_key(16, 5);
+    run_one_scan_loop();
+    ASSERT_EQ(sent.size(), 1);
+    expect_event(sent[0], 0, {0x80 | 0, 1, 0x80 | 5, 2, 0x80 | 5, 16});
+}
+
+TEST_F(ViaSwitchMatrix, ManyChangesArePaged) {
+    subscribe(true);
+    std::vector<uint8_t> events;
+    for (uint8_t col = 0; col < 20; col++) {
+        press_key(col, 3);
+        events.push_back(0x80 | 3);
+        events.push_back(col);
+    }
+    run_one_scan_loop();
+    ASSERT_EQ(sent.size(), 1);
+    expect_event(sent[0], 0, std::vector<uint8_t>(events.begin(), events.begin() + 26));
+    run_one_scan_loop();
+    ASSERT_EQ(sent.size(), 2);
+    expect_event(sent[1], 1, std::vector<uint8_t>(events.begin() + 26, events.end()));
+    run_one_scan_loop();
+    EXPECT_EQ(sent.size(), 2);
+}
+
+TEST_F(ViaSwitchMatrix, KeysHeldWhenSubscribingAreNotSent) {
+    press_key(4, 4);
+    run_one_scan_loop();
+    subscribe(true);
+    run_one_scan_loop();
+    EXPECT_TRUE(sent.empty());
+    release_key(4, 4);
+    run_one_scan_loop();
+    ASSERT_EQ(sent.size(), 1);
+    expect_event(sent[0], 0, {4, 4});
+}
+
+TEST_F(ViaSwitchMatrix, UnsubscribingStopsTheStream) {
+    subscribe(true);
+    subscribe(false);
+    EXPECT_EQ(send({id_get_keyboard_value, id_switch_matrix_stream})[2], 0);
+    press_key(0, 0);
+    run_one_scan_loop();
+    EXPECT_TRUE(sent.empty());
+}
+
+TEST_F(ViaSwitchMatrix, LargeMatrixStateIsPaged) {
+    press_key(0, 0);
+    press_key(23, 8);
+    press_key(9, 9);
+    press_key(17, 11);
+
+    std::vector<uint8_t> reply = send({id_get_keyboard_value, id_switch_matrix_state, 0});
+    EXPECT_EQ(reply[2], 0);
+    // 9 rows of 3 bytes fit in a packet
+    std::vector<uint8_t> rows(27);
+    rows[2]  = 0x01;
+    rows[24] = 0x80;
+    EXPECT_EQ(std::vector<uint8_t>(reply.begin() + 3, reply.begin() + 30), rows);
+
+    reply = send({id_get_keyboard_value, id_switch_matrix_state, 9});
+    EXPECT_EQ(reply[2], 9);
+    EXPECT_EQ(std::vector<uint8_t>(reply.begin() + 3, reply.begin() + 12), std::vector<uint8_t>({0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00}));
+    EXPECT_EQ(std::vector<uint8_t>(reply.begin() + 12, reply.end()), std::vector<uint8_t>(20));
+}
+
+TEST_F(ViaSwitchMatrix, ChangesWaitForABusyEndpoint) {
+    subscribe(true);
+    endpoint_busy = true;
+    press_key(3, 1);
+    run_one_scan_loop();
+    press_key(4, 1);
+    run_one_scan_loop();
+    EXPECT_TRUE(sent.empty());
+
+    endpoint_busy = false;
+    run_one_scan_loop();
+    ASSERT_EQ(sent.size(), 1);
+    expect_event(sent[0], 0, {0x80 | 1, 3, 0x80 | 1, 4});
+}
+
+TEST_F(ViaSwitchMatrix, UsbResetStopsTheStream) {
+    subscribe(true);
+    raw_hid_reset();
+    EXPECT_EQ(send({id_get_keyboard_value, id_switch_matrix_stream})[2], 0);
+    press_key(0, 0);
+    run_one_scan_loop();
+    EXPECT_TRUE(sent.empty());
+}
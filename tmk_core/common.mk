@@ -16,6 +16,7 @@ TMK_COMMON_SRC +=	$(COMMON_DIR)/host.c \
 	$(COMMON_DIR)/util.c \
 	$(COMMON_DIR)/eeconfig.c \
 	$(COMMON_DIR)/report.c \
+	$(COMMON_DIR)/deadline.c \
 	$(PLATFORM_COMMON_DIR)/suspend.c \
 	$(PLATFORM_COMMON_DIR)/timer.c \
 	$(PLATFORM_COMMON_DIR)/bootloader.c \
@@ -87,12 +88,31 @@ ifeq ($(strip $(RAW_ENABLE)), yes)
 endif
 
 ifeq ($(strip $(CONSOLE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/console_buffer.c
     TMK_COMMON_DEFS += -DCONSOLE_ENABLE
 else
     TMK_COMMON_DEFS += -DNO_PRINT
     TMK_COMMON_DEFS += -DNO_DEBUG
 endif
 
+ifeq ($(strip $(TRACE_ENABLE)), yes)
+    ifneq ($(strip $(CONSOLE_ENABLE)), yes)
+        $(error TRACE_ENABLE requires CONSOLE_ENABLE)
+    endif
+    TMK_COMMON_SRC += $(COMMON_DIR)/trace.c
+    TMK_COMMON_DEFS += -DTRACE_ENABLE
+endif
+
+ifeq ($(strip $(PROFILER_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/profiler.c
+    TMK_COMMON_DEFS += -DPROFILER_ENABLE
+endif
+
+# The RGB Matrix render budget times itself with the profiler's counter
+ifneq ($(filter yes,$(strip $(PROFILER_ENABLE)))$(filter-out no,$(strip $(RGB_MATRIX_ENABLE))),)
+    TMK_COMMON_SRC += $(COMMON_DIR)/profiler_counter.c
+endif
+
 ifeq ($(strip $(COMMAND_ENABLE)), yes)
     TMK_COMMON_SRC += $(COMMON_DIR)/command.c
     TMK_COMMON_DEFS += -DCOMMAND_ENABLE
@@ -26,6 +26,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action_util.h"
 #include "action.h"
 #include "wait.h"
+#include "profiler.h"
+#include "trace.h"
 
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
@@ -62,7 +64,19 @@ __attribute__((weak)) bool get_ignore_mod_tap_interrupt(uint16_t keycode, keyrec
  * FIXME: Needs documentation.
  */
 void action_exec(keyevent_t event) {
+#ifdef PROFILER_ENABLE
+    // Only calls that carry a key event are timed, not the tick of every scan
+    profiler_probe_t profiler_probe;
     if (!IS_NOEVENT(event)) {
+        profiler_begin(&profiler_probe);
+    }
+    if (IS_PRESSED(event)) {
+        profiler_key_pressed();
+    }
+#endif
+
+    if (!IS_NOEVENT(event)) {
+        trace_event(event.pressed ? TRACE_KEY_PRESS : TRACE_KEY_RELEASE, event.key.row << 8 | event.key.col);
         dprint("\n---- action_exec: start -----\n");
         dprint("EVENT: ");
         debug_event(event);
@@ -90,20 +104,11 @@ void action_exec(keyevent_t event) {
 
     keyrecord_t record = {.event = event};
 
-#ifndef NO_ACTION_ONESHOT
-#    if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    if (has_oneshot_layer_timed_out()) {
-        clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
-    }
-    if (has_oneshot_mods_timed_out()) {
-        clear_oneshot_mods();
-    }
-#        ifdef SWAP_HANDS_ENABLE
-    if (has_oneshot_swaphands_timed_out()) {
-        clear_oneshot_swaphands();
+#if !defined(NO_ACTION_ONESHOT) && (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
+    // Between key events a deadline clears them
+    if (!IS_NOEVENT(event)) {
+        clear_timed_out_oneshots();
     }
-#        endif
-#    endif
 #endif
 
 #ifndef NO_ACTION_TAPPING
@@ -116,6 +121,12 @@ void action_exec(keyevent_t event) {
         dprintln();
     }
 #endif
+
+#ifdef PROFILER_ENABLE
+    if (!IS_NOEVENT(event)) {
+        profiler_end(PROFILER_ACTION_EXEC, &profiler_probe);
+    }
+#endif
 }
 
 #ifdef SWAP_HANDS_ENABLE
@@ -192,7 +203,11 @@ void process_record(keyrecord_t *record) {
         return;
     }
 
-    if (!process_record_quantum(record)) {
+    PROFILER_BEGIN(process_record);
+    bool process = process_record_quantum(record);
+    PROFILER_END(PROFILER_PROCESS_RECORD, process_record);
+
+    if (!process) {
 #ifndef NO_ACTION_ONESHOT
         if (is_oneshot_layer_active() && record->event.pressed) {
             clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
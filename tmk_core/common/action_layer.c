@@ -3,6 +3,7 @@
 #include "action.h"
 #include "util.h"
 #include "action_layer.h"
+#include "trace.h"
 
 #ifdef DEBUG_ACTION
 #    include "debug.h"
@@ -38,6 +39,7 @@ static void default_layer_state_set(layer_state_t state) {
     default_layer_state = state;
     default_layer_debug();
     debug("\n");
+    trace_event(TRACE_LAYER, get_highest_layer(default_layer_state) << 8 | get_highest_layer(layer_state));
 #ifdef STRICT_LAYER_RELEASE
     clear_keyboard_but_mods();  // To avoid stuck keys
 #else
@@ -104,6 +106,7 @@ void layer_state_set(layer_state_t state) {
     layer_state = state;
     layer_debug();
     dprintln();
+    trace_event(TRACE_LAYER, get_highest_layer(default_layer_state) << 8 | get_highest_layer(layer_state));
 #    ifdef STRICT_LAYER_RELEASE
     clear_keyboard_but_mods();  // To avoid stuck keys
 #    else
@@ -246,16 +249,15 @@ action_t store_or_get_action(bool pressed, keypos_t key) {
 #endif
 }
 
-/** \brief Layer switch get layer
+#ifndef NO_ACTION_LAYER
+/** \brief Resolve layer
  *
- * Gets the layer based on key info
+ * Returns the highest layer in `layers` with a non-transparent action for the key, or `fallback`
  */
-uint8_t layer_switch_get_layer(keypos_t key) {
-#ifndef NO_ACTION_LAYER
+static uint8_t resolve_layer(keypos_t key, layer_state_t layers, uint8_t fallback) {
     action_t action;
     action.code = ACTION_TRANSPARENT;
 
-    layer_state_t layers = layer_state | default_layer_state;
     /* check top layer first */
     for (int8_t i = MAX_LAYER - 1; i >= 0; i--) {
         if (layers & (1UL << i)) {
@@ -265,8 +267,90 @@ uint8_t layer_switch_get_layer(keypos_t key) {
             }
         }
     }
+    return fallback;
+}
+#endif
+
+#if !defined(NO_ACTION_LAYER) && defined(RESOLVED_LAYER_CACHE)
+/** \brief resolved layers cache
+ *
+ * The effective layer of every key for `resolved_layers_state`, packed like the source layers cache
+ */
+static uint8_t       resolved_layers_cache[(MATRIX_ROWS * MATRIX_COLS + 7) / 8][MAX_LAYER_BITS];
+static layer_state_t resolved_layers_state = 0;
+static bool          resolved_layers_valid = false;
+
+static void write_resolved_layers_cache(uint16_t key_number, uint8_t layer) {
+    const uint16_t storage_row = key_number / 8;
+    const uint8_t  storage_bit = key_number % 8;
+
+    for (uint8_t bit_number = 0; bit_number < MAX_LAYER_BITS; bit_number++) {
+        resolved_layers_cache[storage_row][bit_number] ^= (-((layer & (1U << bit_number)) != 0) ^ resolved_layers_cache[storage_row][bit_number]) & (1U << storage_bit);
+    }
+}
+
+static uint8_t read_resolved_layers_cache(uint16_t key_number) {
+    const uint16_t storage_row = key_number / 8;
+    const uint8_t  storage_bit = key_number % 8;
+    uint8_t        layer       = 0;
+
+    for (uint8_t bit_number = 0; bit_number < MAX_LAYER_BITS; bit_number++) {
+        layer |= ((resolved_layers_cache[storage_row][bit_number] & (1U << storage_bit)) != 0) << bit_number;
+    }
+    return layer;
+}
+
+/** \brief update resolved layers cache
+ *
+ * Brings the cache up to date with `layers`. A key only needs a full lookup when its
+ * resolved layer was turned off; otherwise only newly enabled layers above it can shadow it.
+ */
+static void update_resolved_layers_cache(layer_state_t layers) {
+    layer_state_t enabled  = resolved_layers_valid ? layers & ~resolved_layers_state : layers;
+    layer_state_t disabled = resolved_layers_valid ? resolved_layers_state & ~layers : 0;
+    uint16_t      key_number = 0;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++, key_number++) {
+            keypos_t key   = (keypos_t){.row = row, .col = col};
+            uint8_t  layer = resolved_layers_valid ? read_resolved_layers_cache(key_number) : 0;
+
+            if (!resolved_layers_valid || (disabled & (1UL << layer))) {
+                layer = resolve_layer(key, layers, 0);
+            } else {
+                layer = resolve_layer(key, enabled & ~((((layer_state_t)2) << layer) - 1), layer);
+            }
+            write_resolved_layers_cache(key_number, layer);
+        }
+    }
+    resolved_layers_state = layers;
+    resolved_layers_valid = true;
+}
+
+/** \brief invalidate resolved layers cache
+ *
+ * Must be called when the keymap itself changes, e.g. by dynamic keymaps
+ */
+void invalidate_resolved_layers_cache(void) { resolved_layers_valid = false; }
+#endif
+
+/** \brief Layer switch get layer
+ *
+ * Gets the layer based on key info
+ */
+uint8_t layer_switch_get_layer(keypos_t key) {
+#ifndef NO_ACTION_LAYER
+    layer_state_t layers = layer_state | default_layer_state;
+#    ifdef RESOLVED_LAYER_CACHE
+    if (key.row < MATRIX_ROWS && key.col < MATRIX_COLS) {
+        if (!resolved_layers_valid || layers != resolved_layers_state) {
+            update_resolved_layers_cache(layers);
+        }
+        return read_resolved_layers_cache(key.row * MATRIX_COLS + key.col);
+    }
+#    endif
     /* fall back to layer 0 */
-    return 0;
+    return resolve_layer(key, layers, 0);
 #else
     return get_highest_layer(default_layer_state);
 #endif
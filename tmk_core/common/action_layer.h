@@ -113,6 +113,11 @@ layer_state_t layer_state_set_kb(layer_state_t state);
 void    update_source_layers_cache(keypos_t key, uint8_t layer);
 uint8_t read_source_layers_cache(keypos_t key);
 #endif
+#if !defined(NO_ACTION_LAYER) && defined(RESOLVED_LAYER_CACHE)
+void invalidate_resolved_layers_cache(void);
+#else
+#    define invalidate_resolved_layers_cache()
+#endif
 action_t store_or_get_action(bool pressed, keypos_t key);
 
 /* return the topmost non-transparent layer currently associated with key */
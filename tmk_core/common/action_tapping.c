@@ -22,7 +22,7 @@
 __attribute__((weak)) uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) { return TAPPING_TERM; }
 
 #    ifdef TAPPING_TERM_PER_KEY
-#        define WITHIN_TAPPING_TERM(e) (TIMER_DIFF_16(e.time, tapping_key.event.time) < get_tapping_term(get_event_keycode(tapping_key.event, false), &tapping_key))
+#        define WITHIN_TAPPING_TERM(e) (TIMER_DIFF_16(e.time, tapping_key.event.time) < tapping_key_term())
 #    else
 #        define WITHIN_TAPPING_TERM(e) (TIMER_DIFF_16(e.time, tapping_key.event.time) < TAPPING_TERM)
 #    endif
@@ -35,13 +35,49 @@ __attribute__((weak)) bool get_tapping_force_hold(uint16_t keycode, keyrecord_t
 __attribute__((weak)) bool get_permissive_hold(uint16_t keycode, keyrecord_t *record) { return false; }
 #    endif
 
+_Static_assert((WAITING_BUFFER_SIZE & (WAITING_BUFFER_SIZE - 1)) == 0, "WAITING_BUFFER_SIZE must be a power of two");
+#    define WAITING_BUFFER_NEXT(i) (((i) + 1) & (WAITING_BUFFER_SIZE - 1))
+
 static keyrecord_t tapping_key                         = {};
 static keyrecord_t waiting_buffer[WAITING_BUFFER_SIZE] = {};
 static uint8_t     waiting_buffer_head                 = 0;
 static uint8_t     waiting_buffer_tail                 = 0;
+static uint8_t     waiting_buffer_pressed              = 0;  // number of press events in the waiting buffer
+
+#    ifdef TAPPING_TERM_PER_KEY
+/* The tapping term of tapping_key, so that the keymap lookup and get_tapping_term() don't run on every scan.
+ * It is resolved again whenever tapping_key changes, and after each processed record as that may change the layer
+ * cache or anything else the user callback depends on.
+ */
+static struct {
+    bool        valid;
+    keyrecord_t record;
+    uint16_t    term;
+} tapping_term_cache = {};
+
+static uint16_t tapping_key_term(void) {
+    keyrecord_t *cached = &tapping_term_cache.record;
+    if (!tapping_term_cache.valid || cached->event.time != tapping_key.event.time || !KEYEQ(cached->event.key, tapping_key.event.key) || cached->event.pressed != tapping_key.event.pressed || cached->tap.count != tapping_key.tap.count || cached->tap.interrupted != tapping_key.tap.interrupted) {
+        tapping_term_cache.term  = get_tapping_term(get_event_keycode(tapping_key.event, false), &tapping_key);
+        tapping_term_cache.valid = true;
+        *cached                  = tapping_key;
+    }
+    return tapping_term_cache.term;
+}
+#    endif
+
+static void tapping_process_record(keyrecord_t *record) {
+    process_record(record);
+#    ifdef TAPPING_TERM_PER_KEY
+    if (!IS_NOEVENT(record->event)) {
+        tapping_term_cache.valid = false;
+    }
+#    endif
+}
 
 static bool process_tapping(keyrecord_t *record);
 static bool waiting_buffer_enq(keyrecord_t record);
+static void waiting_buffer_deq(void);
 static void waiting_buffer_clear(void);
 static bool waiting_buffer_typed(keyevent_t event);
 static bool waiting_buffer_has_anykey_pressed(void);
@@ -74,7 +110,7 @@ void action_tapping_process(keyrecord_t record) {
     if (!IS_NOEVENT(record.event) && waiting_buffer_head != waiting_buffer_tail) {
         debug("---- action_exec: process waiting_buffer -----\n");
     }
-    for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail = (waiting_buffer_tail + 1) % WAITING_BUFFER_SIZE) {
+    for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_deq()) {
         if (process_tapping(&waiting_buffer[waiting_buffer_tail])) {
             debug("processed: waiting_buffer[");
             debug_dec(waiting_buffer_tail);
@@ -108,7 +144,7 @@ bool process_tapping(keyrecord_t *keyp) {
                     debug("Tapping: First tap(0->1).\n");
                     tapping_key.tap.count = 1;
                     debug_tapping_key();
-                    process_record(&tapping_key);
+                    tapping_process_record(&tapping_key);
 
                     // copy tapping state
                     keyp->tap = tapping_key.tap;
@@ -120,16 +156,17 @@ bool process_tapping(keyrecord_t *keyp) {
                  * useful for long TAPPING_TERM but may prevent fast typing.
                  */
 #    if defined(TAPPING_TERM_PER_KEY) || (TAPPING_TERM >= 500) || defined(PERMISSIVE_HOLD) || defined(PERMISSIVE_HOLD_PER_KEY)
-                else if (
+                // The per key callbacks come last, so they don't run on every tick
+                else if (IS_RELEASED(event) && waiting_buffer_typed(event)
 #        ifdef TAPPING_TERM_PER_KEY
-                    (get_tapping_term(get_event_keycode(tapping_key.event, false), keyp) >= 500) &&
+                         && (get_tapping_term(get_event_keycode(tapping_key.event, false), keyp) >= 500)
 #        endif
 #        ifdef PERMISSIVE_HOLD_PER_KEY
-                    !get_permissive_hold(get_event_keycode(tapping_key.event, false), keyp) &&
+                         && !get_permissive_hold(get_event_keycode(tapping_key.event, false), keyp)
 #        endif
-                    IS_RELEASED(event) && waiting_buffer_typed(event)) {
+                ) {
                     debug("Tapping: End. No tap. Interfered by typing key\n");
-                    process_record(&tapping_key);
+                    tapping_process_record(&tapping_key);
                     tapping_key = (keyrecord_t){};
                     debug_tapping_key();
                     // enqueue
@@ -157,7 +194,7 @@ bool process_tapping(keyrecord_t *keyp) {
                     }
                     // Release of key should be process immediately.
                     debug("Tapping: release event of a key pressed before tapping\n");
-                    process_record(keyp);
+                    tapping_process_record(keyp);
                     return true;
                 } else {
                     // set interrupted flag when other key preesed during tapping
@@ -175,7 +212,7 @@ bool process_tapping(keyrecord_t *keyp) {
                     debug_dec(tapping_key.tap.count);
                     debug(")\n");
                     keyp->tap = tapping_key.tap;
-                    process_record(keyp);
+                    tapping_process_record(keyp);
                     tapping_key = *keyp;
                     debug_tapping_key();
                     return true;
@@ -183,7 +220,7 @@ bool process_tapping(keyrecord_t *keyp) {
                     if (tapping_key.tap.count > 1) {
                         debug("Tapping: Start new tap with releasing last tap(>1).\n");
                         // unregister key
-                        process_record(&(keyrecord_t){.tap = tapping_key.tap, .event.key = tapping_key.event.key, .event.time = event.time, .event.pressed = false});
+                        tapping_process_record(&(keyrecord_t){.tap = tapping_key.tap, .event.key = tapping_key.event.key, .event.time = event.time, .event.pressed = false});
                     } else {
                         debug("Tapping: Start while last tap(1).\n");
                     }
@@ -195,7 +232,7 @@ bool process_tapping(keyrecord_t *keyp) {
                     if (!IS_NOEVENT(event)) {
                         debug("Tapping: key event while last tap(>0).\n");
                     }
-                    process_record(keyp);
+                    tapping_process_record(keyp);
                     return true;
                 }
             }
@@ -206,7 +243,7 @@ bool process_tapping(keyrecord_t *keyp) {
                 debug("Tapping: End. Timeout. Not tap(0): ");
                 debug_event(event);
                 debug("\n");
-                process_record(&tapping_key);
+                tapping_process_record(&tapping_key);
                 tapping_key = (keyrecord_t){};
                 debug_tapping_key();
                 return false;
@@ -214,14 +251,14 @@ bool process_tapping(keyrecord_t *keyp) {
                 if (IS_TAPPING_KEY(event.key) && !event.pressed) {
                     debug("Tapping: End. last timeout tap release(>0).");
                     keyp->tap = tapping_key.tap;
-                    process_record(keyp);
+                    tapping_process_record(keyp);
                     tapping_key = (keyrecord_t){};
                     return true;
                 } else if (is_tap_key(event.key) && event.pressed) {
                     if (tapping_key.tap.count > 1) {
                         debug("Tapping: Start new tap with releasing last timeout tap(>1).\n");
                         // unregister key
-                        process_record(&(keyrecord_t){.tap = tapping_key.tap, .event.key = tapping_key.event.key, .event.time = event.time, .event.pressed = false});
+                        tapping_process_record(&(keyrecord_t){.tap = tapping_key.tap, .event.key = tapping_key.event.key, .event.time = event.time, .event.pressed = false});
                     } else {
                         debug("Tapping: Start while last timeout tap(1).\n");
                     }
@@ -233,7 +270,7 @@ bool process_tapping(keyrecord_t *keyp) {
                     if (!IS_NOEVENT(event)) {
                         debug("Tapping: key event while last timeout tap(>0).\n");
                     }
-                    process_record(keyp);
+                    tapping_process_record(keyp);
                     return true;
                 }
             }
@@ -255,7 +292,7 @@ bool process_tapping(keyrecord_t *keyp) {
                         debug("Tapping: Tap press(");
                         debug_dec(keyp->tap.count);
                         debug(")\n");
-                        process_record(keyp);
+                        tapping_process_record(keyp);
                         tapping_key = *keyp;
                         debug_tapping_key();
                         return true;
@@ -275,12 +312,12 @@ bool process_tapping(keyrecord_t *keyp) {
                     // should none in buffer
                     // FIX: interrupted when other key is pressed
                     tapping_key.tap.interrupted = true;
-                    process_record(keyp);
+                    tapping_process_record(keyp);
                     return true;
                 }
             } else {
                 if (!IS_NOEVENT(event)) debug("Tapping: other key just after tap.\n");
-                process_record(keyp);
+                tapping_process_record(keyp);
                 return true;
             }
         } else {
@@ -304,7 +341,7 @@ bool process_tapping(keyrecord_t *keyp) {
             debug_tapping_key();
             return true;
         } else {
-            process_record(keyp);
+            tapping_process_record(keyp);
             return true;
         }
     }
@@ -319,26 +356,37 @@ bool waiting_buffer_enq(keyrecord_t record) {
         return true;
     }
 
-    if ((waiting_buffer_head + 1) % WAITING_BUFFER_SIZE == waiting_buffer_tail) {
+    if (WAITING_BUFFER_NEXT(waiting_buffer_head) == waiting_buffer_tail) {
         debug("waiting_buffer_enq: Over flow.\n");
         return false;
     }
 
     waiting_buffer[waiting_buffer_head] = record;
-    waiting_buffer_head                 = (waiting_buffer_head + 1) % WAITING_BUFFER_SIZE;
+    waiting_buffer_head                 = WAITING_BUFFER_NEXT(waiting_buffer_head);
+    if (record.event.pressed) waiting_buffer_pressed++;
 
     debug("waiting_buffer_enq: ");
     debug_waiting_buffer();
     return true;
 }
 
+/** \brief Waiting buffer deq
+ *
+ * Drops the oldest record of the waiting buffer, which must not be empty.
+ */
+void waiting_buffer_deq(void) {
+    if (waiting_buffer[waiting_buffer_tail].event.pressed) waiting_buffer_pressed--;
+    waiting_buffer_tail = WAITING_BUFFER_NEXT(waiting_buffer_tail);
+}
+
 /** \brief Waiting buffer clear
  *
  * FIXME: Needs docs
  */
 void waiting_buffer_clear(void) {
-    waiting_buffer_head = 0;
-    waiting_buffer_tail = 0;
+    waiting_buffer_head    = 0;
+    waiting_buffer_tail    = 0;
+    waiting_buffer_pressed = 0;
 }
 
 /** \brief Waiting buffer typed
@@ -346,7 +394,12 @@ void waiting_buffer_clear(void) {
  * FIXME: Needs docs
  */
 bool waiting_buffer_typed(keyevent_t event) {
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
+    // Only an event of the other kind can match, so skip the scan when there is none
+    uint8_t count = (waiting_buffer_head - waiting_buffer_tail) & (WAITING_BUFFER_SIZE - 1);
+    if ((event.pressed ? count - waiting_buffer_pressed : waiting_buffer_pressed) == 0) {
+        return false;
+    }
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = WAITING_BUFFER_NEXT(i)) {
         if (KEYEQ(event.key, waiting_buffer[i].event.key) && event.pressed != waiting_buffer[i].event.pressed) {
             return true;
         }
@@ -358,12 +411,7 @@ bool waiting_buffer_typed(keyevent_t event) {
  *
  * FIXME: Needs docs
  */
-__attribute__((unused)) bool waiting_buffer_has_anykey_pressed(void) {
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        if (waiting_buffer[i].event.pressed) return true;
-    }
-    return false;
-}
+__attribute__((unused)) bool waiting_buffer_has_anykey_pressed(void) { return waiting_buffer_pressed > 0; }
 
 /** \brief Scan buffer for tapping
  *
@@ -375,11 +423,11 @@ void waiting_buffer_scan_tap(void) {
     // invalid state: tapping_key released && tap.count == 0
     if (!tapping_key.event.pressed) return;
 
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = WAITING_BUFFER_NEXT(i)) {
         if (IS_TAPPING_KEY(waiting_buffer[i].event.key) && !waiting_buffer[i].event.pressed && WITHIN_TAPPING_TERM(waiting_buffer[i].event)) {
             tapping_key.tap.count       = 1;
             waiting_buffer[i].tap.count = 1;
-            process_record(&tapping_key);
+            tapping_process_record(&tapping_key);
 
             debug("waiting_buffer_scan_tap: found at [");
             debug_dec(i);
@@ -406,7 +454,7 @@ static void debug_tapping_key(void) {
  */
 static void debug_waiting_buffer(void) {
     debug("{ ");
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = WAITING_BUFFER_NEXT(i)) {
         debug("[");
         debug_dec(i);
         debug("]=");
@@ -14,12 +14,14 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <stddef.h>
 #include "host.h"
 #include "report.h"
 #include "debug.h"
 #include "action_util.h"
 #include "action_layer.h"
 #include "timer.h"
+#include "deadline.h"
 #include "keycode_config.h"
 
 extern keymap_config_t keymap_config;
@@ -28,16 +30,6 @@ static uint8_t real_mods  = 0;
 static uint8_t weak_mods  = 0;
 static uint8_t macro_mods = 0;
 
-#ifdef USB_6KRO_ENABLE
-#    define RO_ADD(a, b) ((a + b) % KEYBOARD_REPORT_KEYS)
-#    define RO_SUB(a, b) ((a - b + KEYBOARD_REPORT_KEYS) % KEYBOARD_REPORT_KEYS)
-#    define RO_INC(a) RO_ADD(a, 1)
-#    define RO_DEC(a) RO_SUB(a, 1)
-static int8_t cb_head  = 0;
-static int8_t cb_tail  = 0;
-static int8_t cb_count = 0;
-#endif
-
 // TODO: pointer variable is not needed
 // report_keyboard_t keyboard_report = {};
 report_keyboard_t *keyboard_report = &(report_keyboard_t){};
@@ -99,6 +91,57 @@ inline bool     has_oneshot_layer_timed_out() { return TIMER_DIFF_16(timer_read(
 static uint16_t oneshot_swaphands_time = 0;
 inline bool     has_oneshot_swaphands_timed_out() { return TIMER_DIFF_16(timer_read(), oneshot_swaphands_time) >= ONESHOT_TIMEOUT && (swap_hands_oneshot == SHO_ACTIVE); }
 #        endif
+
+/** \brief Clear the oneshot states that have timed out
+ *
+ * Runs before every key event, and from a deadline in between.
+ */
+void clear_timed_out_oneshots(void) {
+    if (has_oneshot_layer_timed_out()) {
+        clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
+    }
+    if (has_oneshot_mods_timed_out()) {
+        clear_oneshot_mods();
+    }
+#        ifdef SWAP_HANDS_ENABLE
+    if (has_oneshot_swaphands_timed_out()) {
+        clear_oneshot_swaphands();
+    }
+#        endif
+}
+
+static deadline_token_t oneshot_timeout_token;
+
+// Keeps the time left until the soonest active oneshot times out, those that already have are skipped
+static void oneshot_soonest_timeout(uint16_t *next, bool active, uint16_t time) {
+    uint16_t elapsed = TIMER_DIFF_16(timer_read(), time);
+    if (active && elapsed < ONESHOT_TIMEOUT && (!*next || ONESHOT_TIMEOUT - elapsed < *next)) {
+        *next = ONESHOT_TIMEOUT - elapsed;
+    }
+}
+
+static uint32_t oneshot_timeout(uint32_t trigger_time, void *arg) {
+    clear_timed_out_oneshots();
+
+    // Oneshots set after this deadline was scheduled time out later
+    uint16_t next = 0;
+    oneshot_soonest_timeout(&next, oneshot_mods, oneshot_time);
+    oneshot_soonest_timeout(&next, get_oneshot_layer_state() && !(get_oneshot_layer_state() & ONESHOT_TOGGLED), oneshot_layer_time);
+#        ifdef SWAP_HANDS_ENABLE
+    oneshot_soonest_timeout(&next, swap_hands_oneshot == SHO_PRESSED || swap_hands_oneshot == SHO_ACTIVE, oneshot_swaphands_time);
+#        endif
+    if (!next) {
+        oneshot_timeout_token = 0;
+    }
+    return next;
+}
+
+// A new oneshot always times out last, so an already scheduled deadline is early enough
+static void schedule_oneshot_timeout(void) {
+    if (!oneshot_timeout_token) {
+        oneshot_timeout_token = deadline_schedule(ONESHOT_TIMEOUT, oneshot_timeout, NULL);
+    }
+}
 #    endif
 
 #    ifdef SWAP_HANDS_ENABLE
@@ -111,12 +154,19 @@ void set_oneshot_swaphands(void) {
     if (oneshot_layer_time != 0) {
         oneshot_layer_time = oneshot_swaphands_time;
     }
+    schedule_oneshot_timeout();
 #        endif
 }
 
 void release_oneshot_swaphands(void) {
     if (swap_hands_oneshot == SHO_PRESSED) {
         swap_hands_oneshot = SHO_ACTIVE;
+#        if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
+        // Held past the timeout, its deadline has already run
+        if (has_oneshot_swaphands_timed_out()) {
+            clear_oneshot_swaphands();
+        }
+#        endif
     }
     if (swap_hands_oneshot == SHO_USED) {
         clear_oneshot_swaphands();
@@ -151,6 +201,7 @@ void set_oneshot_layer(uint8_t layer, uint8_t state) {
     layer_on(layer);
 #    if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
     oneshot_layer_time = timer_read();
+    schedule_oneshot_timeout();
 #    endif
     oneshot_layer_changed_kb(get_oneshot_layer());
 }
@@ -298,6 +349,7 @@ void set_oneshot_mods(uint8_t mods) {
     if (oneshot_mods != mods) {
 #    if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
         oneshot_time = timer_read();
+        schedule_oneshot_timeout();
 #    endif
         oneshot_mods = mods;
         oneshot_mods_changed_kb(mods);
@@ -16,6 +16,7 @@
  * Modifications for QMK and STM32F303 by Yiancar
  */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include "eeprom_stm32.h"
@@ -24,16 +25,118 @@
  * the functionality use the EEPROM_Init() function. Be sure that by reprogramming
  * of the controller just affected pages will be deleted. In other case the non
  * volatile data will be lost.
+ *
+ * The reserved pages are split into two banks. The active bank starts with a
+ * header (magic, sequence number), followed by a snapshot of the whole EEPROM
+ * and a log of (value, address) records. Writes only append a record to the
+ * log; when the log is full the contents are compacted into the other bank
+ * and the old bank is erased. Reads are served from a RAM mirror that is
+ * rebuilt from the snapshot and the log at boot.
  ******************************************************************************/
 
 /* Private macro -------------------------------------------------------------*/
+#ifdef FLASH_STM32_MOCKED
+extern uint8_t FlashBuf[];
+#    define FEE_FLASH_PTR(Address) (&FlashBuf[(Address)-FEE_PAGE_BASE_ADDRESS])
+#else
+#    define FEE_FLASH_PTR(Address) ((uint8_t *)(Address))
+#endif
+#define FEE_READ_HALFWORD(Address) (*(__IO uint16_t *)FEE_FLASH_PTR(Address))
+
+_Static_assert((FEE_DENSITY_PAGES % 2) == 0, "FEE_DENSITY_PAGES must be a multiple of 2");
+_Static_assert((FEE_DENSITY_BYTES % 2) == 0, "FEE_DENSITY_BYTES must be even");
+_Static_assert(FEE_LOG_RECORDS > 0, "FEE_DENSITY_BYTES leaves no room for the write log");
+
+// The emulated EEPROM is half of a bank, i.e. half of what the previous layout
+// offered. Catch keyboards whose dynamic keymap no longer fits instead of
+// letting writes past the end be dropped.
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#    ifdef DYNAMIC_KEYMAP_EEPROM_MAX_ADDR
+#        define FEE_REQUIRED_BYTES (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR + 1)
+#    else
+#        define FEE_REQUIRED_BYTES 1024  // default DYNAMIC_KEYMAP_EEPROM_MAX_ADDR in dynamic_keymap.c
+#    endif
+_Static_assert(FEE_DENSITY_BYTES >= FEE_REQUIRED_BYTES, "The dynamic keymap does not fit in the emulated EEPROM, lower DYNAMIC_KEYMAP_EEPROM_MAX_ADDR or raise FEE_DENSITY_BYTES");
+#endif
+
 /* Private variables ---------------------------------------------------------*/
+static uint8_t  ActiveBank;
+static uint16_t ActiveSequence;
+static uint32_t LogAddress;
 /* Functions -----------------------------------------------------------------*/
 
-uint8_t DataBuf[FEE_PAGE_SIZE];
+uint8_t DataBuf[FEE_DENSITY_BYTES];
+
+/*****************************************************************************
+ *  Erase every page of a bank that is not already blank
+ ******************************************************************************/
+static FLASH_Status EEPROM_EraseBank(uint8_t Bank) {
+    FLASH_Status FlashStatus = FLASH_COMPLETE;
+
+    for (uint32_t page = FEE_BANK_ADDRESS(Bank); page < FEE_BANK_ADDRESS(Bank) + FEE_BANK_SIZE; page += FEE_PAGE_SIZE) {
+        for (uint32_t addr = page; addr < page + FEE_PAGE_SIZE; addr += 2) {
+            if (FEE_READ_HALFWORD(addr) != FEE_EMPTY_WORD) {
+                FlashStatus = FLASH_ErasePage(page);
+                break;
+            }
+        }
+    }
+    return FlashStatus;
+}
+
+/*****************************************************************************
+ *  Write the RAM mirror as snapshot into an erased bank, and commit it by
+ *  writing the header last.
+ ******************************************************************************/
+static FLASH_Status EEPROM_WriteBank(uint8_t Bank, uint16_t Sequence) {
+    FLASH_Status FlashStatus = FLASH_COMPLETE;
+    uint32_t     base        = FEE_BANK_ADDRESS(Bank);
+
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i += 2) {
+        uint16_t data = DataBuf[i] | (DataBuf[i + 1] << 8);
+        if (data != FEE_EMPTY_WORD) {
+            FlashStatus = FLASH_ProgramHalfWord(base + FEE_BANK_HEADER_SIZE + i, data);
+            if (FlashStatus != FLASH_COMPLETE) {
+                return FlashStatus;
+            }
+        }
+    }
+    // a bank whose header didn't make it is never made active
+    FlashStatus = FLASH_ProgramHalfWord(base + 2, Sequence);
+    if (FlashStatus != FLASH_COMPLETE) {
+        return FlashStatus;
+    }
+    FlashStatus = FLASH_ProgramHalfWord(base, FEE_BANK_MAGIC);
+    if (FlashStatus != FLASH_COMPLETE) {
+        return FlashStatus;
+    }
+
+    ActiveBank     = Bank;
+    ActiveSequence = Sequence;
+    LogAddress     = base + FEE_LOG_OFFSET;
+    return FlashStatus;
+}
+
+/*****************************************************************************
+ *  Move the RAM mirror into the inactive bank and retire the active one
+ ******************************************************************************/
+static FLASH_Status EEPROM_Compact(void) {
+    uint8_t      OldBank     = ActiveBank;
+    FLASH_Status FlashStatus = EEPROM_EraseBank(!OldBank);
+
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = EEPROM_WriteBank(!OldBank, ActiveSequence + 1);
+    }
+    // keep the old bank unless the new one is committed
+    if (FlashStatus != FLASH_COMPLETE) {
+        return FlashStatus;
+    }
+    return EEPROM_EraseBank(OldBank);
+}
+
 /*****************************************************************************
- *  Delete Flash Space used for user Data, deletes the whole space between
- *  RW_PAGE_BASE_ADDRESS and the last uC Flash Page
+ *  Rebuild the RAM mirror from the newest valid bank. Banks without a valid
+ *  header are treated as blank, and a fresh bank is set up.
  ******************************************************************************/
 uint16_t EEPROM_Init(void) {
     // unlock flash
@@ -42,64 +145,85 @@ uint16_t EEPROM_Init(void) {
     // Clear Flags
     // FLASH_ClearFlag(FLASH_SR_EOP|FLASH_SR_PGERR|FLASH_SR_WRPERR);
 
+    bool     valid[2];
+    uint16_t sequence[2];
+    for (uint8_t bank = 0; bank < 2; bank++) {
+        valid[bank]    = FEE_READ_HALFWORD(FEE_BANK_ADDRESS(bank)) == FEE_BANK_MAGIC;
+        sequence[bank] = FEE_READ_HALFWORD(FEE_BANK_ADDRESS(bank) + 2);
+    }
+
+    memset(DataBuf, 0xFF, sizeof(DataBuf));
+
+    if (!valid[0] && !valid[1]) {
+        EEPROM_EraseBank(0);
+        EEPROM_WriteBank(0, 0);
+        return FEE_DENSITY_BYTES;
+    }
+
+    // if a compaction was interrupted before the old bank got erased, the newer one wins
+    ActiveBank     = valid[0] && (!valid[1] || (int16_t)(sequence[0] - sequence[1]) > 0) ? 0 : 1;
+    ActiveSequence = sequence[ActiveBank];
+
+    uint32_t base = FEE_BANK_ADDRESS(ActiveBank);
+    memcpy(DataBuf, FEE_FLASH_PTR(base + FEE_BANK_HEADER_SIZE), FEE_DENSITY_BYTES);
+
+    // replay the log, skipping records torn by a reset between their two halfwords
+    LogAddress = base + FEE_LOG_OFFSET;
+    while (LogAddress + FEE_LOG_RECORD_SIZE <= base + FEE_BANK_SIZE) {
+        uint16_t value   = FEE_READ_HALFWORD(LogAddress);
+        uint16_t address = FEE_READ_HALFWORD(LogAddress + 2);
+        if (value == FEE_EMPTY_WORD && address == FEE_EMPTY_WORD) {
+            break;
+        }
+        if (address < FEE_DENSITY_BYTES) {
+            DataBuf[address] = (uint8_t)value;
+        }
+        LogAddress += FEE_LOG_RECORD_SIZE;
+    }
+
+    if (valid[!ActiveBank]) {
+        EEPROM_EraseBank(!ActiveBank);
+    }
+
     return FEE_DENSITY_BYTES;
 }
 /*****************************************************************************
  *  Erase the whole reserved Flash Space used for user Data
  ******************************************************************************/
 void EEPROM_Erase(void) {
-    int page_num = 0;
-
-    // delete all pages from specified start page to the last page
-    do {
-        FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page_num * FEE_PAGE_SIZE));
-        page_num++;
-    } while (page_num < FEE_DENSITY_PAGES);
+    memset(DataBuf, 0xFF, sizeof(DataBuf));
+    EEPROM_EraseBank(!ActiveBank);
+    EEPROM_WriteBank(!ActiveBank, ActiveSequence + 1);
+    EEPROM_EraseBank(!ActiveBank);
 }
 /*****************************************************************************
- *  Writes once data byte to flash on specified address. If a byte is already
- *  written, the whole page must be copied to a buffer, the byte changed and
- *  the manipulated buffer written after PageErase.
+ *  Writes once data byte to flash on specified address. The byte is appended
+ *  to the write log of the active bank; only when the log is full the bank is
+ *  compacted, which costs the page erases.
  *******************************************************************************/
 uint16_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte) {
     FLASH_Status FlashStatus = FLASH_COMPLETE;
 
-    uint32_t page;
-    int      i;
-
     // exit if desired address is above the limit (e.G. under 2048 Bytes for 4 pages)
-    if (Address > FEE_DENSITY_BYTES) {
+    if (Address >= FEE_DENSITY_BYTES) {
         return 0;
     }
 
-    // calculate which page is affected (Pagenum1/Pagenum2...PagenumN)
-    page = FEE_ADDR_OFFSET(Address) / FEE_PAGE_SIZE;
-
-    // if current data is 0xFF, the byte is empty, just overwrite with the new one
-    if ((*(__IO uint16_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) == FEE_EMPTY_WORD) {
-        FlashStatus = FLASH_ProgramHalfWord(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address), (uint16_t)(0x00FF & DataByte));
-    } else {
-        // Copy Page to a buffer
-        memcpy(DataBuf, (uint8_t *)FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE), FEE_PAGE_SIZE);  // !!! Calculate base address for the desired page
-
-        // check if new data is differ to current data, return if not, proceed if yes
-        if (DataByte == *(__IO uint8_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) {
-            return 0;
-        }
+    // check if new data is differ to current data, return if not, proceed if yes
+    if (DataBuf[Address] == DataByte) {
+        return 0;
+    }
+    DataBuf[Address] = DataByte;
 
-        // manipulate desired data byte in temp data array if new byte is differ to the current
-        DataBuf[FEE_ADDR_OFFSET(Address) % FEE_PAGE_SIZE] = DataByte;
+    if (LogAddress + FEE_LOG_RECORD_SIZE > FEE_BANK_ADDRESS(ActiveBank) + FEE_BANK_SIZE) {
+        return EEPROM_Compact();
+    }
 
-        // Erase Page
-        FlashStatus = FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE));
+    // value first, the address commits the record
+    FLASH_ProgramHalfWord(LogAddress, DataByte);
+    FlashStatus = FLASH_ProgramHalfWord(LogAddress + 2, Address);
+    LogAddress += FEE_LOG_RECORD_SIZE;
 
-        // Write new data (whole page) to flash if data has been changed
-        for (i = 0; i < (FEE_PAGE_SIZE / 2); i++) {
-            if ((__IO uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]) != 0xFFFF) {
-                FlashStatus = FLASH_ProgramHalfWord((FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE)) + (i * 2), (uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]));
-            }
-        }
-    }
     return FlashStatus;
 }
 /*****************************************************************************
@@ -108,8 +232,10 @@ uint16_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte) {
 uint8_t EEPROM_ReadDataByte(uint16_t Address) {
     uint8_t DataByte = 0xFF;
 
-    // Get Byte from specified address
-    DataByte = (*(__IO uint8_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address)));
+    // Get Byte from the RAM mirror
+    if (Address < FEE_DENSITY_BYTES) {
+        DataByte = DataBuf[Address];
+    }
 
     return DataByte;
 }
@@ -118,44 +244,44 @@ uint8_t EEPROM_ReadDataByte(uint16_t Address) {
  *  Wrap library in AVR style functions.
  *******************************************************************************/
 uint8_t eeprom_read_byte(const uint8_t *Address) {
-    const uint16_t p = (const uint32_t)Address;
+    const uint16_t p = (uintptr_t)Address;
     return EEPROM_ReadDataByte(p);
 }
 
 void eeprom_write_byte(uint8_t *Address, uint8_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, Value);
 }
 
 void eeprom_update_byte(uint8_t *Address, uint8_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, Value);
 }
 
 uint16_t eeprom_read_word(const uint16_t *Address) {
-    const uint16_t p = (const uint32_t)Address;
+    const uint16_t p = (uintptr_t)Address;
     return EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8);
 }
 
 void eeprom_write_word(uint16_t *Address, uint16_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, (uint8_t)Value);
     EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
 }
 
 void eeprom_update_word(uint16_t *Address, uint16_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, (uint8_t)Value);
     EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
 }
 
 uint32_t eeprom_read_dword(const uint32_t *Address) {
-    const uint16_t p = (const uint32_t)Address;
+    const uint16_t p = (uintptr_t)Address;
     return EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8) | (EEPROM_ReadDataByte(p + 2) << 16) | (EEPROM_ReadDataByte(p + 3) << 24);
 }
 
 void eeprom_write_dword(uint32_t *Address, uint32_t Value) {
-    uint16_t p = (const uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, (uint8_t)Value);
     EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
     EEPROM_WriteDataByte(p + 2, (uint8_t)(Value >> 16));
@@ -163,7 +289,7 @@ void eeprom_write_dword(uint32_t *Address, uint32_t Value) {
 }
 
 void eeprom_update_dword(uint32_t *Address, uint32_t Value) {
-    uint16_t p             = (const uint32_t)Address;
+    uint16_t p             = (uintptr_t)Address;
     uint32_t existingValue = EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8) | (EEPROM_ReadDataByte(p + 2) << 16) | (EEPROM_ReadDataByte(p + 3) << 24);
     if (Value != existingValue) {
         EEPROM_WriteDataByte(p, (uint8_t)Value);
@@ -17,15 +17,18 @@
  *
  * This library assumes 8-bit data locations. To add a new MCU, please provide the flash
  * page size and the total flash size in Kb. The number of available pages must be a multiple
- * of 2. Only half of the pages account for the total EEPROM size.
+ * of 2. The pages are split into two banks, only one of which is active at a time. Half of
+ * a bank holds a snapshot of the EEPROM contents, the other half is a write log.
  * This library also assumes that the pages are not used by the firmware.
  */
 
 #ifndef __EEPROM_H
 #define __EEPROM_H
 
-#include "ch.h"
-#include "hal.h"
+#ifndef FLASH_STM32_MOCKED
+#    include "ch.h"
+#    include "hal.h"
+#endif
 #include "flash_stm32.h"
 
 // HACK ALERT. This definition may not match your processor
@@ -43,7 +46,11 @@
 #endif
 
 #ifndef EEPROM_PAGE_SIZE
-#    if defined(MCU_STM32F103RB) || defined(MCU_STM32F042K6)
+#    if defined(MCU_STM32F103RB)
+// Four pages below the top of 128KB, which is not checked against the part's actual flash size
+#        define FEE_PAGE_SIZE (uint16_t)0x400  // Page size = 1KByte
+#        define FEE_DENSITY_PAGES 4            // How many pages are used
+#    elif defined(MCU_STM32F042K6)
 #        define FEE_PAGE_SIZE (uint16_t)0x400  // Page size = 1KByte
 #        define FEE_DENSITY_PAGES 2            // How many pages are used
 #    elif defined(MCU_STM32F103ZE) || defined(MCU_STM32F103RE) || defined(MCU_STM32F103RD) || defined(MCU_STM32F303CC) || defined(MCU_STM32F072CB)
@@ -73,10 +80,23 @@
 // DONT CHANGE
 // Choose location for the first EEPROM Page address on the top of flash
 #define FEE_PAGE_BASE_ADDRESS ((uint32_t)(0x8000000 + FEE_MCU_FLASH_SIZE * 1024 - FEE_DENSITY_PAGES * FEE_PAGE_SIZE))
-#define FEE_DENSITY_BYTES ((FEE_PAGE_SIZE / 2) * FEE_DENSITY_PAGES - 1)
 #define FEE_LAST_PAGE_ADDRESS (FEE_PAGE_BASE_ADDRESS + (FEE_PAGE_SIZE * FEE_DENSITY_PAGES))
 #define FEE_EMPTY_WORD ((uint16_t)0xFFFF)
-#define FEE_ADDR_OFFSET(Address) (Address * 2)  // 1Byte per Word will be saved to preserve Flash
+
+// Bank layout: header, snapshot of FEE_DENSITY_BYTES, then 4 byte (value, address) log records
+#define FEE_BANK_PAGES (FEE_DENSITY_PAGES / 2)
+#define FEE_BANK_SIZE (FEE_BANK_PAGES * FEE_PAGE_SIZE)
+#define FEE_BANK_ADDRESS(Bank) (FEE_PAGE_BASE_ADDRESS + (Bank)*FEE_BANK_SIZE)
+#define FEE_BANK_HEADER_SIZE 4
+#define FEE_BANK_MAGIC ((uint16_t)0xEE51)
+#define FEE_LOG_RECORD_SIZE 4
+
+// Half of a bank, so half the capacity of the previous one byte per halfword layout
+#ifndef FEE_DENSITY_BYTES
+#    define FEE_DENSITY_BYTES (FEE_BANK_SIZE / 2)
+#endif
+#define FEE_LOG_OFFSET (FEE_BANK_HEADER_SIZE + FEE_DENSITY_BYTES)
+#define FEE_LOG_RECORDS ((FEE_BANK_SIZE - FEE_LOG_OFFSET) / FEE_LOG_RECORD_SIZE)
 
 // Use this function to initialize the functionality
 uint16_t EEPROM_Init(void);
@@ -23,8 +23,13 @@
 extern "C" {
 #endif
 
-#include "ch.h"
-#include "hal.h"
+#ifdef FLASH_STM32_MOCKED
+#    include <stdint.h>
+#    define __IO volatile
+#else
+#    include "ch.h"
+#    include "hal.h"
+#endif
 
 typedef enum { FLASH_BUSY = 1, FLASH_ERROR_PG, FLASH_ERROR_WRP, FLASH_ERROR_OPT, FLASH_COMPLETE, FLASH_TIMEOUT, FLASH_BAD_ADDRESS } FLASH_Status;
 
@@ -0,0 +1,98 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "console_buffer.h"
+
+#ifdef CONSOLE_BUFFER_SIZE
+
+_Static_assert((CONSOLE_BUFFER_SIZE & (CONSOLE_BUFFER_SIZE - 1)) == 0 && CONSOLE_BUFFER_SIZE <= 32768, "CONSOLE_BUFFER_SIZE must be a power of two, at most 32768");
+#    define CONSOLE_BUFFER_MASK (CONSOLE_BUFFER_SIZE - 1)
+
+/* USB event interrupts print too (e.g. "[R]" on reset), so the indices are
+ * only touched with interrupts off.
+ */
+#    if defined(__AVR__)
+#        include <avr/interrupt.h>
+typedef uint8_t console_buffer_status_t;
+static inline console_buffer_status_t console_buffer_lock(void) {
+    uint8_t sreg = SREG;
+    cli();
+    return sreg;
+}
+static inline void console_buffer_unlock(console_buffer_status_t sreg) { SREG = sreg; }
+#    elif defined(PROTOCOL_CHIBIOS)
+#        include "ch.h"
+typedef syssts_t console_buffer_status_t;
+static inline console_buffer_status_t console_buffer_lock(void) { return chSysGetStatusAndLockX(); }
+static inline void                    console_buffer_unlock(console_buffer_status_t sts) { chSysRestoreStatusX(sts); }
+#    else
+typedef uint8_t console_buffer_status_t;
+static inline console_buffer_status_t console_buffer_lock(void) { return 0; }
+static inline void                    console_buffer_unlock(console_buffer_status_t sts) {}
+#    endif
+
+static uint8_t  console_buffer[CONSOLE_BUFFER_SIZE];
+static uint16_t console_buffer_head          = 0;  // free running, masked on access
+static uint16_t console_buffer_tail          = 0;
+static uint16_t console_buffer_dropped_count = 0;
+
+uint16_t console_buffer_count(void) {
+    console_buffer_status_t sts   = console_buffer_lock();
+    uint16_t                count = console_buffer_head - console_buffer_tail;
+    console_buffer_unlock(sts);
+    return count;
+}
+
+bool console_buffer_write(const uint8_t *data, uint8_t length) {
+    console_buffer_status_t sts  = console_buffer_lock();
+    bool                    fits = CONSOLE_BUFFER_SIZE - (uint16_t)(console_buffer_head - console_buffer_tail) >= length;
+    if (fits) {
+        for (uint8_t i = 0; i < length; i++) {
+            console_buffer[console_buffer_head++ & CONSOLE_BUFFER_MASK] = data[i];
+        }
+    } else {
+        console_buffer_dropped_count = (UINT16_MAX - console_buffer_dropped_count < length) ? UINT16_MAX : console_buffer_dropped_count + length;
+    }
+    console_buffer_unlock(sts);
+    return fits;
+}
+
+// Only the main loop removes bytes, so the waiting ones can be copied without the lock
+uint8_t console_buffer_peek(uint8_t *data, uint8_t length) {
+    uint16_t count = console_buffer_count();
+    if (count < length) length = count;
+    for (uint8_t i = 0; i < length; i++) {
+        data[i] = console_buffer[(console_buffer_tail + i) & CONSOLE_BUFFER_MASK];
+    }
+    return length;
+}
+
+void console_buffer_skip(uint8_t length) {
+    console_buffer_status_t sts   = console_buffer_lock();
+    uint16_t                count = console_buffer_head - console_buffer_tail;
+    console_buffer_tail += length < count ? length : count;
+    console_buffer_unlock(sts);
+}
+
+uint16_t console_buffer_dropped(void) {
+    console_buffer_status_t sts     = console_buffer_lock();
+    uint16_t                dropped = console_buffer_dropped_count;
+    console_buffer_unlock(sts);
+    return dropped;
+}
+
+#endif
@@ -0,0 +1,47 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Buffered console
+ *
+ * With CONSOLE_BUFFER_SIZE defined, sendchar() only copies into this RAM
+ * ring, and the USB task sends whatever is waiting when the console endpoint
+ * is free. Output that doesn't fit is dropped and counted, so printing never
+ * holds up the scan loop. Writing is safe from interrupts, reading only
+ * from the main loop.
+ */
+
+#if defined(TRACE_ENABLE) && !defined(CONSOLE_BUFFER_SIZE)
+#    define CONSOLE_BUFFER_SIZE 256
+#endif
+
+#ifdef CONSOLE_BUFFER_SIZE
+// Appends all of data, or nothing if it doesn't fit
+bool console_buffer_write(const uint8_t *data, uint8_t length);
+// Bytes waiting to be sent
+uint16_t console_buffer_count(void);
+// Copies up to length of the oldest waiting bytes, without removing them
+uint8_t console_buffer_peek(uint8_t *data, uint8_t length);
+// Removes length bytes once they have been sent
+void console_buffer_skip(uint8_t length);
+// Bytes dropped because the buffer was full, saturating
+uint16_t console_buffer_dropped(void);
+#endif
@@ -0,0 +1,149 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include "deadline.h"
+#include "timer.h"
+
+typedef struct {
+    deadline_token_t    token;
+    uint32_t            trigger_time;
+    deadline_callback_t callback;
+    void *              arg;
+} deadline_slot_t;
+
+static deadline_slot_t  deadline_slots[DEADLINE_MAX_SLOTS];
+static deadline_token_t deadline_last_token;
+// Soonest trigger time, so that a scan with nothing due costs one comparison
+static uint32_t deadline_soonest;
+static bool     deadline_pending;
+
+static void deadline_update_soonest(void) {
+    deadline_pending = false;
+    for (uint8_t i = 0; i < DEADLINE_MAX_SLOTS; i++) {
+        deadline_slot_t *slot = &deadline_slots[i];
+        if (!slot->token) {
+            continue;
+        }
+        if (!deadline_pending || (int32_t)(slot->trigger_time - deadline_soonest) < 0) {
+            deadline_soonest = slot->trigger_time;
+            deadline_pending = true;
+        }
+    }
+}
+
+static deadline_slot_t *deadline_find(deadline_token_t token) {
+    if (!token) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < DEADLINE_MAX_SLOTS; i++) {
+        if (deadline_slots[i].token == token) {
+            return &deadline_slots[i];
+        }
+    }
+    return NULL;
+}
+
+deadline_token_t deadline_schedule(uint32_t delay_ms, deadline_callback_t callback, void *arg) {
+    deadline_slot_t *slot = NULL;
+    for (uint8_t i = 0; i < DEADLINE_MAX_SLOTS && !slot; i++) {
+        if (!deadline_slots[i].token) {
+            slot = &deadline_slots[i];
+        }
+    }
+    if (!slot || !callback) {
+        return 0;
+    }
+
+    // Skip 0 and any token still in use after wrapping around
+    do {
+        deadline_last_token++;
+    } while (!deadline_last_token || deadline_find(deadline_last_token));
+
+    slot->token        = deadline_last_token;
+    slot->trigger_time = timer_read32() + delay_ms;
+    slot->callback     = callback;
+    slot->arg          = arg;
+
+    if (!deadline_pending || (int32_t)(slot->trigger_time - deadline_soonest) < 0) {
+        deadline_soonest = slot->trigger_time;
+        deadline_pending = true;
+    }
+    return slot->token;
+}
+
+bool deadline_extend(deadline_token_t token, uint32_t delay_ms) {
+    deadline_slot_t *slot = deadline_find(token);
+    if (!slot) {
+        return false;
+    }
+    slot->trigger_time = timer_read32() + delay_ms;
+    deadline_update_soonest();
+    return true;
+}
+
+bool deadline_cancel(deadline_token_t token) {
+    deadline_slot_t *slot = deadline_find(token);
+    if (!slot) {
+        return false;
+    }
+    slot->token = 0;
+    deadline_update_soonest();
+    return true;
+}
+
+uint32_t deadline_next(void) {
+    if (!deadline_pending) {
+        return DEADLINE_NONE;
+    }
+    uint32_t now = timer_read32();
+    return timer_expired32(now, deadline_soonest) ? 0 : deadline_soonest - now;
+}
+
+void deadline_task(void) {
+    if (!deadline_pending) {
+        return;
+    }
+    uint32_t now = timer_read32();
+    if (!timer_expired32(now, deadline_soonest)) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < DEADLINE_MAX_SLOTS; i++) {
+        deadline_slot_t *slot  = &deadline_slots[i];
+        deadline_token_t token = slot->token;
+        if (!token || !timer_expired32(now, slot->trigger_time)) {
+            continue;
+        }
+
+        uint32_t delay = slot->callback(slot->trigger_time, slot->arg);
+        // The callback may have cancelled or extended its own deadline
+        if (slot->token != token || !timer_expired32(now, slot->trigger_time)) {
+            continue;
+        }
+        if (!delay) {
+            slot->token = 0;
+            continue;
+        }
+        // Periodic deadlines keep their phase, unless they have fallen a whole period behind
+        slot->trigger_time += delay;
+        if (timer_expired32(now, slot->trigger_time)) {
+            slot->trigger_time = now + delay;
+        }
+    }
+
+    deadline_update_soonest();
+}
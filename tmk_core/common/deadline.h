@@ -0,0 +1,54 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Deadline service
+ *
+ * Features register a callback to run once a number of milliseconds has
+ * passed, instead of polling a timer of their own on every scan. The
+ * callback returns the delay until it should run again, or 0 to stop.
+ * Expired deadlines all run from deadline_task() in one pass, and
+ * deadline_next() tells the main loop how long it may sleep.
+ */
+
+#ifndef DEADLINE_MAX_SLOTS
+#    define DEADLINE_MAX_SLOTS 8
+#endif
+
+// Returned by deadline_next() when nothing is scheduled
+#define DEADLINE_NONE UINT32_MAX
+
+// 0 is never handed out, so it can mark an unused token
+typedef uint8_t deadline_token_t;
+
+// trigger_time is the timer_read32() value the deadline was due at
+typedef uint32_t (*deadline_callback_t)(uint32_t trigger_time, void *arg);
+
+// Runs callback once delay_ms has passed, returns 0 if every slot is taken
+deadline_token_t deadline_schedule(uint32_t delay_ms, deadline_callback_t callback, void *arg);
+// Moves a scheduled deadline to delay_ms from now, returns false if it is no longer scheduled
+bool deadline_extend(deadline_token_t token, uint32_t delay_ms);
+// Returns false if the deadline was not scheduled
+bool deadline_cancel(deadline_token_t token);
+
+// Milliseconds until the next deadline is due, 0 if one is overdue
+uint32_t deadline_next(void);
+
+void deadline_task(void);
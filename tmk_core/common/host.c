@@ -16,11 +16,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdint.h>
+#include <string.h>
 //#include <avr/interrupt.h>
 #include "keycode.h"
 #include "host.h"
 #include "util.h"
 #include "debug.h"
+#include "profiler.h"
+#include "trace.h"
+#ifdef SPLIT_KEYBOARD
+#    include "keyboard.h"
+#endif
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
@@ -31,18 +37,65 @@ static host_driver_t *driver;
 static uint16_t       last_system_report   = 0;
 static uint16_t       last_consumer_report = 0;
 
-void host_set_driver(host_driver_t *d) { driver = d; }
+#ifdef KEYBOARD_REPORT_QUEUE
+#    ifndef KEYBOARD_REPORT_QUEUE_SIZE
+#        define KEYBOARD_REPORT_QUEUE_SIZE 8
+#    endif
+
+/* Keyboard reports waiting for the driver, oldest first.
+ * last_keyboard_report is the newest report handed to host_keyboard_send(), queued or sent, so that repeats of it
+ * can be dropped. Nothing is dropped until the current driver has been given a report.
+ */
+static report_keyboard_t keyboard_report_queue[KEYBOARD_REPORT_QUEUE_SIZE];
+static uint8_t           keyboard_report_queue_tail  = 0;
+static uint8_t           keyboard_report_queue_count = 0;
+static report_keyboard_t last_keyboard_report;
+static bool              last_keyboard_report_valid = false;
+#endif
+
+void host_set_driver(host_driver_t *d) {
+    driver = d;
+#ifdef KEYBOARD_REPORT_QUEUE
+    // A new host hasn't seen any of the reports
+    keyboard_report_queue_count = 0;
+    last_keyboard_report_valid  = false;
+#endif
+}
 
 host_driver_t *host_get_driver(void) { return driver; }
 
+#ifdef SPLIT_KEYBOARD
+static uint8_t slave_keyboard_leds = 0;
+
+void host_set_slave_keyboard_leds(uint8_t leds) { slave_keyboard_leds = leds; }
+#endif
+
 uint8_t host_keyboard_leds(void) {
+#ifdef SPLIT_KEYBOARD
+    if (!is_keyboard_master()) return slave_keyboard_leds;
+#endif
     if (!driver) return 0;
     return (*driver->keyboard_leds)();
 }
 
-led_t host_keyboard_led_state(void) {
-    if (!driver) return (led_t){0};
-    return (led_t)((*driver->keyboard_leds)());
+led_t host_keyboard_led_state(void) { return (led_t)host_keyboard_leds(); }
+
+static void driver_send_keyboard(report_keyboard_t *report) {
+    PROFILER_BEGIN(host_send);
+    (*driver->send_keyboard)(report);
+    PROFILER_END(PROFILER_HOST_SEND, host_send);
+#ifdef PROFILER_ENABLE
+    profiler_report_sent();
+#endif
+    trace_event(TRACE_REPORT, report->keys[0] << 8 | report->mods);
+
+    if (debug_keyboard) {
+        dprint("keyboard_report: ");
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_SIZE; i++) {
+            dprintf("%02X ", report->raw[i]);
+        }
+        dprint("\n");
+    }
 }
 
 /* send report */
@@ -62,16 +115,34 @@ void host_keyboard_send(report_keyboard_t *report) {
         report->report_id = REPORT_ID_KEYBOARD;
 #endif
     }
-    (*driver->send_keyboard)(report);
+#ifdef KEYBOARD_REPORT_QUEUE
+    if (last_keyboard_report_valid && memcmp(report, &last_keyboard_report, sizeof(report_keyboard_t)) == 0) return;
+    last_keyboard_report       = *report;
+    last_keyboard_report_valid = true;
+
+    if (keyboard_report_queue_count < KEYBOARD_REPORT_QUEUE_SIZE) {
+        keyboard_report_queue_count++;
+    } else {
+        dprint("keyboard_report: queue full\n");
+    }
+    // When the queue is full the newest report is replaced, so the host still ends up in the current state
+    keyboard_report_queue[(keyboard_report_queue_tail + keyboard_report_queue_count - 1) % KEYBOARD_REPORT_QUEUE_SIZE] = *report;
+    host_keyboard_flush();
+#else
+    driver_send_keyboard(report);
+#endif
+}
 
-    if (debug_keyboard) {
-        dprint("keyboard_report: ");
-        for (uint8_t i = 0; i < KEYBOARD_REPORT_SIZE; i++) {
-            dprintf("%02X ", report->raw[i]);
-        }
-        dprint("\n");
+#ifdef KEYBOARD_REPORT_QUEUE
+/* Hand queued keyboard reports to the driver for as long as it can take them without waiting */
+void host_keyboard_flush(void) {
+    while (driver && keyboard_report_queue_count && (!driver->keyboard_ready || driver->keyboard_ready())) {
+        driver_send_keyboard(&keyboard_report_queue[keyboard_report_queue_tail]);
+        keyboard_report_queue_tail = (keyboard_report_queue_tail + 1) % KEYBOARD_REPORT_QUEUE_SIZE;
+        keyboard_report_queue_count--;
     }
 }
+#endif
 
 void host_mouse_send(report_mouse_t *report) {
     if (!driver) return;
@@ -43,7 +43,14 @@ host_driver_t *host_get_driver(void);
 /* host driver interface */
 uint8_t host_keyboard_leds(void);
 led_t   host_keyboard_led_state(void);
+#ifdef SPLIT_KEYBOARD
+// The slave half has no host, the split transport hands it the master's LED state
+void host_set_slave_keyboard_leds(uint8_t leds);
+#endif
 void    host_keyboard_send(report_keyboard_t *report);
+#ifdef KEYBOARD_REPORT_QUEUE
+void host_keyboard_flush(void);
+#endif
 void    host_mouse_send(report_mouse_t *report);
 void    host_system_send(uint16_t data);
 void    host_consumer_send(uint16_t data);
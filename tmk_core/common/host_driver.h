@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define HOST_DRIVER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "report.h"
 #ifdef MIDI_ENABLE
 #    include "midi.h"
@@ -30,6 +31,8 @@ typedef struct {
     void (*send_mouse)(report_mouse_t *);
     void (*send_system)(uint16_t);
     void (*send_consumer)(uint16_t);
+    /* Optional, whether send_keyboard can take a report without waiting. Only used with KEYBOARD_REPORT_QUEUE */
+    bool (*keyboard_ready)(void);
 } host_driver_t;
 
 #endif
@@ -30,6 +30,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "sendchar.h"
 #include "eeconfig.h"
 #include "action_layer.h"
+#include "profiler.h"
+#include "deadline.h"
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
 #endif
@@ -92,6 +94,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef VIA_ENABLE
 #    include "via.h"
 #endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#    include "dynamic_keymap.h"
+#endif
 #ifdef DIP_SWITCH_ENABLE
 #    include "dip_switch.h"
 #endif
@@ -172,6 +177,52 @@ void disable_jtag(void) {
 #endif
 }
 
+#ifdef QMK_KEY_EVENT_QUEUE
+#    ifndef QMK_KEY_EVENT_QUEUE_SIZE
+#        define QMK_KEY_EVENT_QUEUE_SIZE 16
+#    endif
+
+static keyevent_t key_event_queue[QMK_KEY_EVENT_QUEUE_SIZE];
+
+/** \brief Collect matrix changes into the key event queue
+ *
+ * Compares the current matrix against `matrix_prev` and appends one event per
+ * changed key, in matrix order, all stamped with the same scan time. Keys that
+ * don't fit in the queue are left unacknowledged in `matrix_prev` so they are
+ * picked up by the next scan.
+ */
+static uint8_t matrix_collect_events(matrix_row_t *matrix_prev) {
+    uint8_t  count = 0;
+    uint16_t time  = timer_read() | 1; /* time should not be 0 */
+
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        matrix_row_t matrix_row    = matrix_get_row(r);
+        matrix_row_t matrix_change = matrix_row ^ matrix_prev[r];
+        if (!matrix_change) {
+            continue;
+        }
+#    ifdef MATRIX_HAS_GHOST
+        if (has_ghost_in_row(r, matrix_row)) {
+            continue;
+        }
+#    endif
+        if (debug_matrix) matrix_print();
+        matrix_row_t col_mask = 1;
+        for (uint8_t c = 0; c < MATRIX_COLS; c++, col_mask <<= 1) {
+            if (matrix_change & col_mask) {
+                if (count >= QMK_KEY_EVENT_QUEUE_SIZE) {
+                    return count;
+                }
+                key_event_queue[count++] = (keyevent_t){.key = (keypos_t){.row = r, .col = c}, .pressed = (matrix_row & col_mask), .time = time};
+                // record a queued key
+                matrix_prev[r] ^= col_mask;
+            }
+        }
+    }
+    return count;
+}
+#endif
+
 /** \brief matrix_setup
  *
  * FIXME: needs doc
@@ -239,6 +290,9 @@ void keyboard_init(void) {
 #ifdef VIA_ENABLE
     via_init();
 #endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    dynamic_keymap_init();
+#endif
 #ifdef QWIIC_ENABLE
     qwiic_init();
 #endif
@@ -303,18 +357,34 @@ void keyboard_init(void) {
 void keyboard_task(void) {
     static matrix_row_t matrix_prev[MATRIX_ROWS];
     static uint8_t      led_status    = 0;
-    matrix_row_t        matrix_row    = 0;
-    matrix_row_t        matrix_change = 0;
+#ifndef QMK_KEY_EVENT_QUEUE
+    matrix_row_t matrix_row    = 0;
+    matrix_row_t matrix_change = 0;
+#endif
 #ifdef QMK_KEYS_PER_SCAN
     uint8_t keys_processed = 0;
 #endif
 
+    PROFILER_BEGIN(matrix_scan);
 #if defined(OLED_DRIVER_ENABLE) && !defined(OLED_DISABLE_TIMEOUT)
     uint8_t ret = matrix_scan();
 #else
     matrix_scan();
 #endif
+    PROFILER_END(PROFILER_MATRIX_SCAN, matrix_scan);
 
+#ifdef QMK_KEY_EVENT_QUEUE
+    if (should_process_keypress()) {
+        // drain every change seen by this scan in one pass
+        uint8_t event_count = matrix_collect_events(matrix_prev);
+        for (uint8_t i = 0; i < event_count; i++) {
+            action_exec(key_event_queue[i]);
+        }
+        if (event_count) {
+            goto MATRIX_LOOP_END;
+        }
+    }
+#else
     if (should_process_keypress()) {
         for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
             matrix_row    = matrix_get_row(r);
@@ -345,6 +415,7 @@ void keyboard_task(void) {
             }
         }
     }
+#endif
     // call with pseudo tick event when no real key event.
 #ifdef QMK_KEYS_PER_SCAN
     // we can get here with some keys processed now.
@@ -354,10 +425,25 @@ void keyboard_task(void) {
 
 MATRIX_LOOP_END:
 
+    deadline_task();
+
+#ifdef KEYBOARD_REPORT_QUEUE
+    // Reports held back while the endpoint was busy
+    host_keyboard_flush();
+#endif
+
+#ifdef VIA_ENABLE
+    via_task();
+#endif
+
 #ifdef DEBUG_MATRIX_SCAN_RATE
     matrix_scan_perf_task();
 #endif
 
+#ifdef PROFILER_ENABLE
+    profiler_task();
+#endif
+
 #if defined(RGBLIGHT_ENABLE)
     rgblight_task();
 #endif
@@ -377,7 +463,9 @@ MATRIX_LOOP_END:
 #endif
 
 #ifdef OLED_DRIVER_ENABLE
+    PROFILER_BEGIN(oled);
     oled_task();
+    PROFILER_END(PROFILER_OLED, oled);
 #    ifndef OLED_DISABLE_TIMEOUT
     // Wake up oled if user is using those fabulous keys!
     if (ret) oled_on();
@@ -0,0 +1,177 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "profiler.h"
+#include "timer.h"
+#include "print.h"
+
+static profiler_stats_t profiler_stats[PROFILER_STAGE_COUNT];
+static uint32_t         profiler_nested;  // spent in nested probes by the innermost open probe
+
+static uint32_t profiler_scan_start;
+static bool     profiler_latency_pending;
+static uint32_t profiler_latency_start;
+static uint32_t profiler_latency_count;
+static uint32_t profiler_latency_samples[PROFILER_LATENCY_SAMPLES];
+
+static uint8_t histogram_bucket(uint32_t us) {
+    uint8_t bucket = 0;
+    while (us && bucket < PROFILER_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void profiler_record_cycles(profiler_stage_t stage, uint32_t start, uint32_t cycles) {
+    uint32_t          us     = profiler_cycles_to_us(cycles);
+    profiler_stats_t *stats  = &profiler_stats[stage];
+
+    if (stats->count == 0 || cycles < stats->min_cycles) {
+        stats->min_cycles = cycles;
+    }
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+    stats->count++;
+    stats->total_us += us;
+
+    uint16_t *bucket = &stats->histogram[histogram_bucket(us)];
+    if (*bucket < UINT16_MAX) {
+        (*bucket)++;
+    }
+
+    // Presses are timed from the start of the scan that saw them
+    if (stage == PROFILER_MATRIX_SCAN) {
+        profiler_scan_start = start;
+    }
+}
+
+void profiler_record(profiler_stage_t stage, uint32_t start) { profiler_record_cycles(stage, start, profiler_counter() - start); }
+
+void profiler_begin(profiler_probe_t *probe) {
+    probe->nested   = profiler_nested;
+    profiler_nested = 0;
+    probe->start    = profiler_counter();
+}
+
+void profiler_end(profiler_stage_t stage, profiler_probe_t *probe) {
+    uint32_t elapsed = profiler_counter() - probe->start;
+    profiler_record_cycles(stage, probe->start, elapsed - profiler_nested);
+    // The whole call is nested time for the enclosing probe
+    profiler_nested = probe->nested + elapsed;
+}
+
+void profiler_key_pressed(void) {
+    // Timed from the latest press, so that a layer key held before it is not counted
+    profiler_latency_pending = true;
+    profiler_latency_start   = profiler_scan_start;
+}
+
+void profiler_report_sent(void) {
+    if (!profiler_latency_pending) {
+        return;
+    }
+    profiler_latency_pending = false;
+
+    profiler_latency_samples[profiler_latency_count % PROFILER_LATENCY_SAMPLES] = profiler_cycles_to_us(profiler_counter() - profiler_latency_start);
+    profiler_latency_count++;
+}
+
+const profiler_stats_t *profiler_get_stats(profiler_stage_t stage) { return &profiler_stats[stage]; }
+
+void profiler_get_latency(profiler_latency_t *latency) {
+    uint32_t sorted[PROFILER_LATENCY_SAMPLES];
+    uint8_t  samples = profiler_latency_count < PROFILER_LATENCY_SAMPLES ? profiler_latency_count : PROFILER_LATENCY_SAMPLES;
+
+    // Insertion sort, the window is small
+    for (uint8_t i = 0; i < samples; i++) {
+        uint32_t value = profiler_latency_samples[i];
+        uint8_t  j     = i;
+        for (; j > 0 && sorted[j - 1] > value; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+
+    memset(latency, 0, sizeof(profiler_latency_t));
+    latency->count = profiler_latency_count;
+    if (samples) {
+        latency->p50_us = sorted[(samples - 1) * 50 / 100];
+        latency->p90_us = sorted[(samples - 1) * 90 / 100];
+        latency->p99_us = sorted[(samples - 1) * 99 / 100];
+        latency->max_us = sorted[samples - 1];
+    }
+}
+
+const char *profiler_stage_name(profiler_stage_t stage) {
+    switch (stage) {
+        case PROFILER_MATRIX_SCAN:
+            return "matrix_scan";
+        case PROFILER_DEBOUNCE:
+            return "debounce";
+        case PROFILER_ACTION_EXEC:
+            return "action_exec";
+        case PROFILER_PROCESS_RECORD:
+            return "process_record";
+        case PROFILER_RGB_MATRIX:
+            return "rgb_matrix";
+        case PROFILER_OLED:
+            return "oled";
+        case PROFILER_TRANSPORT:
+            return "transport";
+        case PROFILER_HOST_SEND:
+            return "host_send";
+        default:
+            return "";
+    }
+}
+
+void profiler_reset(void) {
+    memset(profiler_stats, 0, sizeof(profiler_stats));
+    profiler_nested          = 0;
+    profiler_latency_pending = false;
+    profiler_latency_count   = 0;
+}
+
+void profiler_print(void) {
+    for (uint8_t stage = 0; stage < PROFILER_STAGE_COUNT; stage++) {
+        const profiler_stats_t *stats = &profiler_stats[stage];
+        if (!stats->count) {
+            continue;
+        }
+        xprintf("%s: %lu calls, avg %luus, min %lu max %lu cycles, hist", profiler_stage_name(stage), (unsigned long)stats->count, (unsigned long)(stats->total_us / stats->count), (unsigned long)stats->min_cycles, (unsigned long)stats->max_cycles);
+        for (uint8_t i = 0; i < PROFILER_BUCKETS; i++) {
+            xprintf(" %u", stats->histogram[i]);
+        }
+        xprintf("\n");
+    }
+
+    profiler_latency_t latency;
+    profiler_get_latency(&latency);
+    xprintf("latency: %lu presses, p50 %luus, p90 %luus, p99 %luus, max %luus\n", (unsigned long)latency.count, (unsigned long)latency.p50_us, (unsigned long)latency.p90_us, (unsigned long)latency.p99_us, (unsigned long)latency.max_us);
+}
+
+void profiler_task(void) {
+#if PROFILER_PRINT_INTERVAL > 0
+    static uint32_t last_print = 0;
+    if (timer_elapsed32(last_print) >= PROFILER_PRINT_INTERVAL) {
+        last_print = timer_read32();
+        profiler_print();
+    }
+#endif
+}
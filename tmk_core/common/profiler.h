@@ -0,0 +1,111 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Scan loop profiler
+ *
+ * Probes around the main loop stages record how long each call took, from
+ * a free running platform counter, into a per stage histogram. Time spent in
+ * a nested probe is only counted for the inner stage, so the stages are
+ * disjoint and add up to the time spent in probes. Key presses are also
+ * followed to the next keyboard report to measure latency.
+ *
+ * The probes compile to nothing unless PROFILER_ENABLE is defined.
+ */
+
+typedef enum {
+    PROFILER_MATRIX_SCAN,
+    PROFILER_DEBOUNCE,
+    PROFILER_ACTION_EXEC,
+    PROFILER_PROCESS_RECORD,
+    PROFILER_RGB_MATRIX,
+    PROFILER_OLED,
+    PROFILER_TRANSPORT,
+    PROFILER_HOST_SEND,
+    PROFILER_STAGE_COUNT,
+} profiler_stage_t;
+
+// Histogram bucket 0 counts calls under 1us, bucket n calls of [2^(n-1), 2^n) us,
+// and the last bucket everything longer
+#ifndef PROFILER_BUCKETS
+#    define PROFILER_BUCKETS 16
+#endif
+
+// Number of recent keypress latencies the percentiles are taken over
+#ifndef PROFILER_LATENCY_SAMPLES
+#    define PROFILER_LATENCY_SAMPLES 32
+#endif
+
+// Prints the results to the console this often, in milliseconds, 0 to disable
+#ifndef PROFILER_PRINT_INTERVAL
+#    define PROFILER_PRINT_INTERVAL 0
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint16_t histogram[PROFILER_BUCKETS];  // saturating
+} profiler_stats_t;
+
+typedef struct {
+    uint32_t count;  // keypresses measured since the last reset
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} profiler_latency_t;
+
+typedef struct {
+    uint32_t start;
+    uint32_t nested;  // time the enclosing probe had spent in nested probes
+} profiler_probe_t;
+
+// Free running counter the probes read, weak so that it can be replaced
+uint32_t profiler_counter(void);
+// Counter ticks per second
+uint32_t profiler_counter_frequency(void);
+uint32_t profiler_cycles_to_us(uint32_t cycles);
+
+// Files a call that started at start, from the outside of any probe
+void profiler_record(profiler_stage_t stage, uint32_t start);
+void profiler_begin(profiler_probe_t *probe);
+void profiler_end(profiler_stage_t stage, profiler_probe_t *probe);
+void profiler_key_pressed(void);
+void profiler_report_sent(void);
+
+const profiler_stats_t *profiler_get_stats(profiler_stage_t stage);
+void                    profiler_get_latency(profiler_latency_t *latency);
+const char *            profiler_stage_name(profiler_stage_t stage);
+
+void profiler_reset(void);
+void profiler_print(void);
+void profiler_task(void);
+
+#ifdef PROFILER_ENABLE
+#    define PROFILER_BEGIN(name)                \
+        profiler_probe_t profiler_probe_##name; \
+        profiler_begin(&profiler_probe_##name)
+#    define PROFILER_END(stage, name) profiler_end(stage, &profiler_probe_##name)
+#else
+#    define PROFILER_BEGIN(name)
+#    define PROFILER_END(stage, name)
+#endif
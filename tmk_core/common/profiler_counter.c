@@ -0,0 +1,111 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "profiler.h"
+#include "timer.h"
+
+// Only the profiler and the RGB Matrix render budget read the counter
+#if defined(PROFILER_ENABLE) || defined(RGB_MATRIX_RENDER_BUDGET_US)
+
+#    if defined(__AVR__)
+#        include <avr/io.h>
+#        include <util/atomic.h>
+#        include "avr/timer_avr.h"
+
+// Timer0 ticks, below the 1ms tick of the system timer
+#        define PROFILER_COUNTER_FREQUENCY TIMER_RAW_FREQ
+
+extern volatile uint32_t timer_count;
+
+__attribute__((weak)) uint32_t profiler_counter(void) {
+    uint32_t ms;
+    uint8_t  raw;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms  = timer_count;
+        raw = TIMER_RAW;
+#        if defined(TIFR0) && defined(OCF0A)
+        // The counter wrapped but the interrupt has not run yet
+        if (TIFR0 & _BV(OCF0A)) {
+            ms++;
+            raw = TIMER_RAW;
+        }
+#        endif
+    }
+    return ms * (TIMER_RAW_TOP + 1) + raw;
+}
+#    elif defined(PROTOCOL_CHIBIOS)
+#        include "ch.h"
+#        include "hal.h"
+
+#        if PORT_SUPPORTS_RT == TRUE
+// Core cycle counter
+#            ifndef PROFILER_COUNTER_FREQUENCY
+#                ifdef STM32_HCLK
+#                    define PROFILER_COUNTER_FREQUENCY STM32_HCLK
+#                else
+#                    error "Please define PROFILER_COUNTER_FREQUENCY as the core clock frequency"
+#                endif
+#            endif
+__attribute__((weak)) uint32_t profiler_counter(void) { return chSysGetRealtimeCounterX(); }
+#        else
+// No cycle counter on this core, fall back to the system tick
+#            define PROFILER_COUNTER_FREQUENCY CH_CFG_ST_FREQUENCY
+__attribute__((weak)) uint32_t profiler_counter(void) { return chVTGetSystemTimeX(); }
+#        endif
+#    elif defined(PROTOCOL_ARM_ATSAM)
+#        include "arm_atsam_protocol.h"
+
+// TC4 counts microseconds, below the 1ms tick of the system timer
+#        define PROFILER_COUNTER_FREQUENCY FREQ_TC45_DEFAULT
+
+__attribute__((weak)) uint32_t profiler_counter(void) {
+    uint32_t irqflags = __get_PRIMASK();
+    __disable_irq();
+
+    TC4->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_READSYNC;
+    while (TC4->COUNT16.SYNCBUSY.bit.CTRLB) {
+    }
+    uint32_t ms  = ms_clk;
+    uint16_t raw = TC4->COUNT16.COUNT.reg;
+    // The counter wrapped but the interrupt has not run yet
+    if (TC4->COUNT16.INTFLAG.bit.MC0) {
+        ms++;
+        TC4->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_READSYNC;
+        while (TC4->COUNT16.SYNCBUSY.bit.CTRLB) {
+        }
+        raw = TC4->COUNT16.COUNT.reg;
+    }
+
+    __set_PRIMASK(irqflags);
+    return ms * (PROFILER_COUNTER_FREQUENCY / 1000) + raw;
+}
+#    else
+// Test platform, the counter follows the millisecond timer
+#        define PROFILER_COUNTER_FREQUENCY 1000000
+__attribute__((weak)) uint32_t profiler_counter(void) { return timer_read32() * 1000; }
+#    endif
+
+uint32_t profiler_counter_frequency(void) { return PROFILER_COUNTER_FREQUENCY; }
+
+uint32_t profiler_cycles_to_us(uint32_t cycles) {
+#    if PROFILER_COUNTER_FREQUENCY >= 1000000
+    return cycles / (PROFILER_COUNTER_FREQUENCY / 1000000);
+#    else
+    return cycles * (1000000 / PROFILER_COUNTER_FREQUENCY);
+#    endif
+}
+
+#endif  // defined(PROFILER_ENABLE) || defined(RGB_MATRIX_RENDER_BUDGET_US)
@@ -1,8 +1,18 @@
 #ifndef _RAW_HID_H_
 #define _RAW_HID_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
 void raw_hid_receive(uint8_t *data, uint8_t length);
 
 void raw_hid_send(uint8_t *data, uint8_t length);
 
+// Like raw_hid_send(), but returns false instead of waiting when the endpoint is busy
+bool raw_hid_send_nonblocking(uint8_t *data, uint8_t length);
+
+// Called by the USB stack on bus reset and suspend, the host has to
+// reopen the device afterwards
+void raw_hid_reset(void);
+
 #endif
@@ -18,54 +18,74 @@
 #include "host.h"
 #include "keycode_config.h"
 #include "debug.h"
-#include "util.h"
 #include <string.h>
 
+#ifdef NKRO_ENABLE
+// The NKRO bitmap is scanned a word at a time, or a byte at a time on AVR
+// where wider words are no faster and on big endian targets.
+#    if defined(__AVR__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+typedef uint8_t nkro_word_t;
+#    else
+typedef uint32_t nkro_word_t;
+#    endif
+
+// Returns the word of the bitmap starting at byte i, zero padded past the end
+static inline nkro_word_t nkro_word(const uint8_t* bits, uint8_t i) {
+    nkro_word_t word = 0;
+    if (KEYBOARD_REPORT_BITS - i >= sizeof(word)) {
+        memcpy(&word, &bits[i], sizeof(word));
+    } else {
+        memcpy(&word, &bits[i], KEYBOARD_REPORT_BITS - i);
+    }
+    return word;
+}
+#endif
+
+// The byte report keeps its keys packed at the start of keys[] in the order
+// they were pressed, so the first free slot is the number of keys.
+static uint8_t key_byte_count(report_keyboard_t* keyboard_report) {
+    uint8_t i = 0;
+    while (i < KEYBOARD_REPORT_KEYS && keyboard_report->keys[i]) {
+        i++;
+    }
+    return i;
+}
+
 /** \brief has_anykey
  *
- * FIXME: Needs doc
+ * Returns the number of keys in the report, not counting modifiers
  */
 uint8_t has_anykey(report_keyboard_t* keyboard_report) {
-    uint8_t  cnt = 0;
-    uint8_t* p   = keyboard_report->keys;
-    uint8_t  lp  = sizeof(keyboard_report->keys);
 #ifdef NKRO_ENABLE
     if (keyboard_protocol && keymap_config.nkro) {
-        p  = keyboard_report->nkro.bits;
-        lp = sizeof(keyboard_report->nkro.bits);
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i += sizeof(nkro_word_t)) {
+            count += __builtin_popcount(nkro_word(keyboard_report->nkro.bits, i));
+        }
+        return count;
     }
 #endif
-    while (lp--) {
-        if (*p++) cnt++;
-    }
-    return cnt;
+    return key_byte_count(keyboard_report);
 }
 
 /** \brief get_first_key
  *
- * FIXME: Needs doc
+ * Returns the lowest keycode in NKRO mode, otherwise the key pressed first,
+ * or KC_NO if there are no keys in the report
  */
 uint8_t get_first_key(report_keyboard_t* keyboard_report) {
 #ifdef NKRO_ENABLE
     if (keyboard_protocol && keymap_config.nkro) {
-        uint8_t i = 0;
-        for (; i < KEYBOARD_REPORT_BITS && !keyboard_report->nkro.bits[i]; i++)
-            ;
-        return i << 3 | biton(keyboard_report->nkro.bits[i]);
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i += sizeof(nkro_word_t)) {
+            nkro_word_t word = nkro_word(keyboard_report->nkro.bits, i);
+            if (word) {
+                return i << 3 | __builtin_ctz(word);
+            }
+        }
+        return KC_NO;
     }
 #endif
-#ifdef USB_6KRO_ENABLE
-    uint8_t i = cb_head;
-    do {
-        if (keyboard_report->keys[i] != 0) {
-            break;
-        }
-        i = RO_INC(i);
-    } while (i != cb_tail);
-    return keyboard_report->keys[i];
-#else
     return keyboard_report->keys[0];
-#endif
 }
 
 /** \brief Checks if a key is pressed in the report
@@ -86,7 +106,7 @@ bool is_key_pressed(report_keyboard_t* keyboard_report, uint8_t key) {
         }
     }
 #endif
-    for (int i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS && keyboard_report->keys[i]; i++) {
         if (keyboard_report->keys[i] == key) {
             return true;
         }
@@ -96,108 +116,41 @@ bool is_key_pressed(report_keyboard_t* keyboard_report, uint8_t key) {
 
 /** \brief add key byte
  *
- * FIXME: Needs doc
+ * Appends the key after the keys already pressed. When the report is full the
+ * key is dropped, or with USB_6KRO_ENABLE the oldest key is dropped instead.
  */
 void add_key_byte(report_keyboard_t* keyboard_report, uint8_t code) {
-#ifdef USB_6KRO_ENABLE
-    int8_t i     = cb_head;
-    int8_t empty = -1;
-    if (cb_count) {
-        do {
-            if (keyboard_report->keys[i] == code) {
-                return;
-            }
-            if (empty == -1 && keyboard_report->keys[i] == 0) {
-                empty = i;
-            }
-            i = RO_INC(i);
-        } while (i != cb_tail);
-        if (i == cb_tail) {
-            if (cb_tail == cb_head) {
-                // buffer is full
-                if (empty == -1) {
-                    // pop head when has no empty space
-                    cb_head = RO_INC(cb_head);
-                    cb_count--;
-                } else {
-                    // left shift when has empty space
-                    uint8_t offset = 1;
-                    i              = RO_INC(empty);
-                    do {
-                        if (keyboard_report->keys[i] != 0) {
-                            keyboard_report->keys[empty] = keyboard_report->keys[i];
-                            keyboard_report->keys[i]     = 0;
-                            empty                        = RO_INC(empty);
-                        } else {
-                            offset++;
-                        }
-                        i = RO_INC(i);
-                    } while (i != cb_tail);
-                    cb_tail = RO_SUB(cb_tail, offset);
-                }
-            }
-        }
-    }
-    // add to tail
-    keyboard_report->keys[cb_tail] = code;
-    cb_tail                        = RO_INC(cb_tail);
-    cb_count++;
-#else
-    int8_t i     = 0;
-    int8_t empty = -1;
-    for (; i < KEYBOARD_REPORT_KEYS; i++) {
-        if (keyboard_report->keys[i] == code) {
-            break;
-        }
-        if (empty == -1 && keyboard_report->keys[i] == 0) {
-            empty = i;
+    uint8_t* keys = keyboard_report->keys;
+    uint8_t  i    = 0;
+    for (; i < KEYBOARD_REPORT_KEYS && keys[i]; i++) {
+        if (keys[i] == code) {
+            return;
         }
     }
     if (i == KEYBOARD_REPORT_KEYS) {
-        if (empty != -1) {
-            keyboard_report->keys[empty] = code;
-        }
-    }
+#ifdef USB_6KRO_ENABLE
+        memmove(&keys[0], &keys[1], KEYBOARD_REPORT_KEYS - 1);
+        i--;
+#else
+        return;
 #endif
+    }
+    keys[i] = code;
 }
 
 /** \brief del key byte
  *
- * FIXME: Needs doc
+ * Removes the key and moves the keys pressed after it up, so the keys stay packed
  */
 void del_key_byte(report_keyboard_t* keyboard_report, uint8_t code) {
-#ifdef USB_6KRO_ENABLE
-    uint8_t i = cb_head;
-    if (cb_count) {
-        do {
-            if (keyboard_report->keys[i] == code) {
-                keyboard_report->keys[i] = 0;
-                cb_count--;
-                if (cb_count == 0) {
-                    // reset head and tail
-                    cb_tail = cb_head = 0;
-                }
-                if (i == RO_DEC(cb_tail)) {
-                    // left shift when next to tail
-                    do {
-                        cb_tail = RO_DEC(cb_tail);
-                        if (keyboard_report->keys[RO_DEC(cb_tail)] != 0) {
-                            break;
-                        }
-                    } while (cb_tail != cb_head);
-                }
-                break;
-            }
-            i = RO_INC(i);
-        } while (i != cb_tail);
-    }
-#else
-    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-        if (keyboard_report->keys[i] == code) {
-            keyboard_report->keys[i] = 0;
+    uint8_t* keys = keyboard_report->keys;
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS && keys[i]; i++) {
+        if (keys[i] == code) {
+            memmove(&keys[i], &keys[i + 1], KEYBOARD_REPORT_KEYS - 1 - i);
+            keys[KEYBOARD_REPORT_KEYS - 1] = 0;
+            return;
         }
     }
-#endif
 }
 
 #ifdef NKRO_ENABLE
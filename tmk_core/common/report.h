@@ -268,6 +268,7 @@ static inline uint16_t KEYCODE2CONSUMER(uint8_t key) {
     }
 }
 
+// These keep the keys of the byte report packed at the start of keys[], in the order they were pressed
 uint8_t has_anykey(report_keyboard_t* keyboard_report);
 uint8_t get_first_key(report_keyboard_t* keyboard_report);
 bool    is_key_pressed(report_keyboard_t* keyboard_report, uint8_t key);
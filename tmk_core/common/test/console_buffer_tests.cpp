@@ -0,0 +1,104 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "gtest/gtest.h"
+#include <vector>
+
+extern "C" {
+#include "console_buffer.h"
+#include "trace.h"
+
+void set_time(uint32_t t);
+}
+
+class ConsoleBuffer : public testing::Test {
+   public:
+    ConsoleBuffer() { console_buffer_skip(console_buffer_count()); }
+
+    static std::vector<uint8_t> read_all(void) {
+        std::vector<uint8_t> data(console_buffer_count());
+        EXPECT_EQ(console_buffer_peek(data.data(), data.size()), data.size());
+        console_buffer_skip(data.size());
+        return data;
+    }
+};
+
+TEST_F(ConsoleBuffer, KeepsBytesInOrder) {
+    const uint8_t text[] = "hello";
+    EXPECT_TRUE(console_buffer_write(text, 5));
+    EXPECT_EQ(console_buffer_count(), 5);
+    EXPECT_EQ(read_all(), std::vector<uint8_t>(text, text + 5));
+    EXPECT_EQ(console_buffer_count(), 0);
+}
+
+TEST_F(ConsoleBuffer, PeekLeavesBytesUntilSkipped) {
+    const uint8_t text[] = "abcdef";
+    uint8_t       out[4];
+    console_buffer_write(text, 6);
+    EXPECT_EQ(console_buffer_peek(out, sizeof(out)), 4);
+    EXPECT_EQ(console_buffer_count(), 6);
+    console_buffer_skip(3);
+    EXPECT_EQ(console_buffer_peek(out, sizeof(out)), 3);
+    EXPECT_EQ(out[0], 'd');
+    EXPECT_EQ(out[2], 'f');
+}
+
+TEST_F(ConsoleBuffer, WrapsAround) {
+    uint8_t data[CONSOLE_BUFFER_SIZE - 3];
+    for (int round = 0; round < 5; round++) {
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = round * 31 + i;
+        }
+        ASSERT_TRUE(console_buffer_write(data, sizeof(data)));
+        EXPECT_EQ(read_all(), std::vector<uint8_t>(data, data + sizeof(data)));
+    }
+}
+
+TEST_F(ConsoleBuffer, DropsWritesThatDontFitAndCountsThem) {
+    uint8_t  data[CONSOLE_BUFFER_SIZE] = {1};
+    uint16_t dropped                   = console_buffer_dropped();
+    EXPECT_TRUE(console_buffer_write(data, CONSOLE_BUFFER_SIZE - 2));
+    // Nothing of a write that doesn't fit goes in
+    EXPECT_FALSE(console_buffer_write(data, 3));
+    EXPECT_EQ(console_buffer_count(), CONSOLE_BUFFER_SIZE - 2);
+    EXPECT_EQ(console_buffer_dropped(), dropped + 3);
+    EXPECT_TRUE(console_buffer_write(data, 2));
+    EXPECT_EQ(console_buffer_dropped(), dropped + 3);
+}
+
+TEST_F(ConsoleBuffer, TraceRecordIsFixedSizeAndHasNoZeroBytes) {
+    set_time(0x01020304);
+    trace_event(TRACE_KEY_PRESS, 0x0203);
+    // Also decoded by lib/python/qmk/tests/test_qmk_trace.py
+    std::vector<uint8_t> expected = {TRACE_SYNC, 0x81, 0x86, 0x88, 0xA0, 0xB0, 0xC0, 0xC0, 0x80};
+    EXPECT_EQ(read_all(), expected);
+
+    set_time(0xFFFFFFFF);
+    trace_event(0xFF, 0);
+    std::vector<uint8_t> record = read_all();
+    ASSERT_EQ(record.size(), TRACE_RECORD_SIZE);
+    for (size_t i = 1; i < record.size(); i++) {
+        EXPECT_GE(record[i], 0x80) << "byte " << i;
+    }
+}
+
+TEST_F(ConsoleBuffer, TraceRecordIsDroppedWhole) {
+    uint8_t data[CONSOLE_BUFFER_SIZE - TRACE_RECORD_SIZE + 1] = {};
+    console_buffer_write(data, sizeof(data));
+    trace_event(TRACE_LAYER, 1);
+    EXPECT_EQ(console_buffer_count(), sizeof(data));
+}
@@ -0,0 +1,182 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include <vector>
+
+extern "C" {
+#include "deadline.h"
+#include "timer.h"
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+struct Recorder {
+    std::vector<uint32_t> fired;
+    uint32_t              next_delay = 0;
+};
+
+static uint32_t record(uint32_t trigger_time, void *arg) {
+    Recorder *r = static_cast<Recorder *>(arg);
+    r->fired.push_back(trigger_time);
+    return r->next_delay;
+}
+
+class Deadline : public testing::Test {
+   public:
+    Deadline() { set_time(1000); }
+    ~Deadline() {
+        for (deadline_token_t token : tokens) {
+            deadline_cancel(token);
+        }
+    }
+
+    deadline_token_t schedule(uint32_t delay_ms, Recorder *r) {
+        deadline_token_t token = deadline_schedule(delay_ms, record, r);
+        tokens.push_back(token);
+        return token;
+    }
+
+    static void run_for(uint32_t ms) {
+        for (uint32_t i = 0; i < ms; i++) {
+            advance_time(1);
+            deadline_task();
+        }
+    }
+
+    std::vector<deadline_token_t> tokens;
+};
+
+TEST_F(Deadline, NothingScheduled) {
+    EXPECT_EQ(deadline_next(), DEADLINE_NONE);
+    deadline_task();
+}
+
+TEST_F(Deadline, OneShotFiresOnce) {
+    Recorder r;
+    EXPECT_NE(schedule(50, &r), 0);
+    EXPECT_EQ(deadline_next(), 50u);
+
+    run_for(49);
+    EXPECT_TRUE(r.fired.empty());
+    run_for(1);
+    ASSERT_EQ(r.fired.size(), 1u);
+    EXPECT_EQ(r.fired[0], 1050u);
+
+    run_for(200);
+    EXPECT_EQ(r.fired.size(), 1u);
+    EXPECT_EQ(deadline_next(), DEADLINE_NONE);
+}
+
+TEST_F(Deadline, PeriodicKeepsPhase) {
+    Recorder r;
+    r.next_delay = 10;
+    schedule(10, &r);
+
+    // A late task still reschedules relative to the trigger time
+    advance_time(13);
+    deadline_task();
+    EXPECT_EQ(deadline_next(), 7u);
+    run_for(27);
+    ASSERT_EQ(r.fired.size(), 4u);
+    EXPECT_EQ(r.fired[0], 1010u);
+    EXPECT_EQ(r.fired[1], 1020u);
+    EXPECT_EQ(r.fired[3], 1040u);
+}
+
+TEST_F(Deadline, PeriodicSkipsMissedPeriods) {
+    Recorder r;
+    r.next_delay = 10;
+    schedule(10, &r);
+
+    advance_time(100);
+    deadline_task();
+    EXPECT_EQ(r.fired.size(), 1u);
+    EXPECT_EQ(deadline_next(), 10u);
+}
+
+TEST_F(Deadline, CancelAndExtend) {
+    Recorder a, b;
+    deadline_token_t ta = schedule(10, &a);
+    deadline_token_t tb = schedule(20, &b);
+    EXPECT_NE(ta, tb);
+
+    EXPECT_TRUE(deadline_cancel(ta));
+    EXPECT_FALSE(deadline_cancel(ta));
+    EXPECT_FALSE(deadline_extend(ta, 10));
+    EXPECT_EQ(deadline_next(), 20u);
+
+    run_for(15);
+    EXPECT_TRUE(deadline_extend(tb, 20));
+    EXPECT_EQ(deadline_next(), 20u);
+    run_for(19);
+    EXPECT_TRUE(b.fired.empty());
+    run_for(1);
+    EXPECT_TRUE(a.fired.empty());
+    EXPECT_EQ(b.fired.size(), 1u);
+    EXPECT_FALSE(deadline_extend(tb, 10));
+}
+
+TEST_F(Deadline, RunsOnlyWhatIsDue) {
+    Recorder early, late;
+    schedule(5, &early);
+    schedule(30, &late);
+
+    run_for(10);
+    EXPECT_EQ(early.fired.size(), 1u);
+    EXPECT_TRUE(late.fired.empty());
+    EXPECT_EQ(deadline_next(), 20u);
+}
+
+TEST_F(Deadline, FullReturnsZero) {
+    Recorder r;
+    for (uint8_t i = 0; i < DEADLINE_MAX_SLOTS; i++) {
+        EXPECT_NE(schedule(100, &r), 0);
+    }
+    EXPECT_EQ(deadline_schedule(100, record, &r), 0);
+
+    // A freed slot can be used again
+    deadline_cancel(tokens[0]);
+    EXPECT_NE(schedule(100, &r), 0);
+}
+
+static deadline_token_t chained;
+
+static uint32_t reschedule_other(uint32_t trigger_time, void *arg) {
+    chained = deadline_schedule(5, record, arg);
+    return 0;
+}
+
+static uint32_t cancel_self(uint32_t trigger_time, void *arg) {
+    deadline_cancel(*static_cast<deadline_token_t *>(arg));
+    return 10;
+}
+
+TEST_F(Deadline, CallbackCanScheduleAndCancel) {
+    Recorder r;
+    tokens.push_back(deadline_schedule(10, reschedule_other, &r));
+    run_for(10);
+    EXPECT_NE(chained, 0);
+    tokens.push_back(chained);
+    run_for(5);
+    EXPECT_EQ(r.fired.size(), 1u);
+
+    deadline_token_t self = deadline_schedule(10, cancel_self, &self);
+    run_for(10);
+    EXPECT_FALSE(deadline_cancel(self));
+    EXPECT_EQ(deadline_next(), DEADLINE_NONE);
+}
@@ -16,18 +16,30 @@
 
 #include "eeprom.h"
 
-#define EEPROM_SIZE 32
+#ifndef EEPROM_SIZE
+#    define EEPROM_SIZE 64
+#endif
 
 static uint8_t buffer[EEPROM_SIZE];
 
+// Write statistics for tests, see eeprom_test_get_writes()
+static uint32_t write_calls;
+static uint32_t write_bytes;
+
 uint8_t eeprom_read_byte(const uint8_t *addr) {
     uintptr_t offset = (uintptr_t)addr;
     return buffer[offset];
 }
 
-void eeprom_write_byte(uint8_t *addr, uint8_t value) {
+static void write_byte(uint8_t *addr, uint8_t value) {
     uintptr_t offset = (uintptr_t)addr;
     buffer[offset]   = value;
+    write_bytes++;
+}
+
+void eeprom_write_byte(uint8_t *addr, uint8_t value) {
+    write_calls++;
+    write_byte(addr, value);
 }
 
 uint16_t eeprom_read_word(const uint16_t *addr) {
@@ -50,46 +62,41 @@ void eeprom_read_block(void *buf, const void *addr, size_t len) {
 
 void eeprom_write_word(uint16_t *addr, uint16_t value) {
     uint8_t *p = (uint8_t *)addr;
-    eeprom_write_byte(p++, value);
-    eeprom_write_byte(p, value >> 8);
+    write_calls++;
+    write_byte(p++, value);
+    write_byte(p, value >> 8);
 }
 
 void eeprom_write_dword(uint32_t *addr, uint32_t value) {
     uint8_t *p = (uint8_t *)addr;
-    eeprom_write_byte(p++, value);
-    eeprom_write_byte(p++, value >> 8);
-    eeprom_write_byte(p++, value >> 16);
-    eeprom_write_byte(p, value >> 24);
+    write_calls++;
+    write_byte(p++, value);
+    write_byte(p++, value >> 8);
+    write_byte(p++, value >> 16);
+    write_byte(p, value >> 24);
 }
 
 void eeprom_write_block(const void *buf, void *addr, size_t len) {
     uint8_t *      p   = (uint8_t *)addr;
     const uint8_t *src = (const uint8_t *)buf;
+    write_calls++;
     while (len--) {
-        eeprom_write_byte(p++, *src++);
+        write_byte(p++, *src++);
     }
 }
 
 void eeprom_update_byte(uint8_t *addr, uint8_t value) { eeprom_write_byte(addr, value); }
 
-void eeprom_update_word(uint16_t *addr, uint16_t value) {
-    uint8_t *p = (uint8_t *)addr;
-    eeprom_write_byte(p++, value);
-    eeprom_write_byte(p, value >> 8);
-}
+void eeprom_update_word(uint16_t *addr, uint16_t value) { eeprom_write_word(addr, value); }
 
-void eeprom_update_dword(uint32_t *addr, uint32_t value) {
-    uint8_t *p = (uint8_t *)addr;
-    eeprom_write_byte(p++, value);
-    eeprom_write_byte(p++, value >> 8);
-    eeprom_write_byte(p++, value >> 16);
-    eeprom_write_byte(p, value >> 24);
-}
+void eeprom_update_dword(uint32_t *addr, uint32_t value) { eeprom_write_dword(addr, value); }
 
-void eeprom_update_block(const void *buf, void *addr, size_t len) {
-    uint8_t *      p   = (uint8_t *)addr;
-    const uint8_t *src = (const uint8_t *)buf;
-    while (len--) {
-        eeprom_write_byte(p++, *src++);
-    }
+void eeprom_update_block(const void *buf, void *addr, size_t len) { eeprom_write_block(buf, addr, len); }
+
+// Returns the number of write and update calls and the bytes they wrote since the last call
+void eeprom_test_get_writes(uint32_t *calls, uint32_t *bytes) {
+    *calls      = write_calls;
+    *bytes      = write_bytes;
+    write_calls = 0;
+    write_bytes = 0;
 }
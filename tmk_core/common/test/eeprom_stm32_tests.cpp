@@ -0,0 +1,214 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include <cstring>
+#include <iostream>
+
+extern "C" {
+#include "flash_stm32_mock.h"
+#include "eeprom.h"
+}
+
+// STM32F303 datasheet typical values
+#define FLASH_PROGRAM_TIME_US 53
+#define FLASH_ERASE_TIME_US 30000
+
+class EepromStm32 : public testing::Test {
+   public:
+    EepromStm32() {
+        FLASH_Mock_Reset();
+        EEPROM_Init();
+    }
+
+    static void reboot(void) { EEPROM_Init(); }
+
+    static uint32_t flash_time_us(const flash_mock_stats_t& stats) { return stats.erases * FLASH_ERASE_TIME_US + stats.programs * FLASH_PROGRAM_TIME_US; }
+};
+
+// The page-rewrite scheme this backend replaced, kept to benchmark against
+static void legacy_write_byte(uint16_t address, uint8_t value) {
+    static uint8_t page_buf[FEE_PAGE_SIZE];
+    uint32_t       offset = address * 2;
+    uint32_t       page   = offset / FEE_PAGE_SIZE;
+    uint16_t*      word   = (uint16_t*)&FlashBuf[offset];
+
+    if (*word == FEE_EMPTY_WORD) {
+        FLASH_ProgramHalfWord(FEE_PAGE_BASE_ADDRESS + offset, value);
+        return;
+    }
+    if ((uint8_t)*word == value) {
+        return;
+    }
+    memcpy(page_buf, &FlashBuf[page * FEE_PAGE_SIZE], FEE_PAGE_SIZE);
+    page_buf[offset % FEE_PAGE_SIZE] = value;
+    FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + page * FEE_PAGE_SIZE);
+    for (uint32_t i = 0; i < FEE_PAGE_SIZE; i += 2) {
+        uint16_t data = 0xFF00 | page_buf[i];
+        if (data != FEE_EMPTY_WORD) {
+            FLASH_ProgramHalfWord(FEE_PAGE_BASE_ADDRESS + page * FEE_PAGE_SIZE + i, data);
+        }
+    }
+}
+
+// Writes a 4 layer, 100 key keymap twice over, like loading a layout through VIA
+template <typename F>
+static void keymap_upload_workload(F write_byte) {
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (uint16_t i = 0; i < 4 * 100 * 2; i++) {
+            write_byte(64 + i, (uint8_t)(i * 7 + pass));
+        }
+    }
+}
+
+// Steps through rgb matrix hues, like eeconfig_update_rgb_matrix() from RGB_HUI
+template <typename F>
+static void rgb_config_workload(F write_byte) {
+    for (uint16_t i = 0; i < 256; i++) {
+        write_byte(24, 1);
+        write_byte(25, 0x10);
+        write_byte(26, (uint8_t)i);
+        write_byte(27, 0x80);
+    }
+}
+
+TEST_F(EepromStm32, BlankFlashReadsErased) {
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+        EXPECT_EQ(EEPROM_ReadDataByte(i), 0xFF);
+    }
+    EXPECT_EQ(FlashStats.errors, 0u);
+}
+
+TEST_F(EepromStm32, WrittenDataSurvivesReboot) {
+    eeprom_update_word((uint16_t*)0, 0xFEED);
+    eeprom_update_dword((uint32_t*)10, 0x12345678);
+    eeprom_update_byte((uint8_t*)(FEE_DENSITY_BYTES - 1), 0x42);
+    reboot();
+    EXPECT_EQ(eeprom_read_word((uint16_t*)0), 0xFEED);
+    EXPECT_EQ(eeprom_read_dword((uint32_t*)10), 0x12345678u);
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)(FEE_DENSITY_BYTES - 1)), 0x42);
+    EXPECT_EQ(FlashStats.errors, 0u);
+}
+
+TEST_F(EepromStm32, UnchangedBytesAreNotWritten) {
+    eeprom_update_byte((uint8_t*)5, 0x55);
+    uint32_t programs = FlashStats.programs;
+    eeprom_update_byte((uint8_t*)5, 0x55);
+    eeprom_update_byte((uint8_t*)6, 0xFF);
+    EXPECT_EQ(FlashStats.programs, programs);
+}
+
+TEST_F(EepromStm32, WritesOnlyEraseWhenTheLogIsFull) {
+    flash_mock_stats_t before = FlashStats;
+    for (uint16_t i = 0; i < FEE_LOG_RECORDS; i++) {
+        eeprom_update_byte((uint8_t*)(i % 16), (uint8_t)i);
+    }
+    EXPECT_EQ(FlashStats.erases, before.erases);
+    eeprom_update_byte((uint8_t*)100, 0x01);
+    EXPECT_EQ(FlashStats.erases, before.erases + FEE_BANK_PAGES);
+    reboot();
+    for (uint16_t i = FEE_LOG_RECORDS - 16; i < FEE_LOG_RECORDS; i++) {
+        EXPECT_EQ(eeprom_read_byte((uint8_t*)(i % 16)), (uint8_t)i);
+    }
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)100), 0x01);
+    EXPECT_EQ(FlashStats.errors, 0u);
+}
+
+TEST_F(EepromStm32, EraseClearsEverything) {
+    eeprom_update_byte((uint8_t*)1, 0x11);
+    EEPROM_Erase();
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)1), 0xFF);
+    reboot();
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)1), 0xFF);
+    eeprom_update_byte((uint8_t*)1, 0x22);
+    reboot();
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)1), 0x22);
+    EXPECT_EQ(FlashStats.errors, 0u);
+}
+
+TEST_F(EepromStm32, TornLogRecordIsIgnored) {
+    eeprom_update_byte((uint8_t*)3, 0x33);
+    // simulate a reset between programming the value and the address of a record
+    uint32_t next = FEE_LOG_OFFSET + FEE_LOG_RECORD_SIZE;
+    FlashBuf[next]     = 0x44;
+    FlashBuf[next + 1] = 0x00;
+    reboot();
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)3), 0x33);
+    eeprom_update_byte((uint8_t*)4, 0x44);
+    reboot();
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)3), 0x33);
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)4), 0x44);
+    EXPECT_EQ(FlashStats.errors, 0u);
+}
+
+TEST_F(EepromStm32, InterruptedCompactionKeepsTheNewerBank) {
+    eeprom_update_byte((uint8_t*)7, 0x77);
+    // keep a copy of the old bank, as if the reset hit before it was erased
+    uint8_t old_bank[FEE_BANK_SIZE];
+    memcpy(old_bank, FlashBuf, FEE_BANK_SIZE);
+    for (uint16_t i = 0; i <= FEE_LOG_RECORDS; i++) {
+        eeprom_update_byte((uint8_t*)8, (uint8_t)i);
+    }
+    memcpy(FlashBuf, old_bank, FEE_BANK_SIZE);
+    reboot();
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)7), 0x77);
+    EXPECT_EQ(eeprom_read_byte((uint8_t*)8), (uint8_t)FEE_LOG_RECORDS);
+    EXPECT_EQ(FlashStats.errors, 0u);
+}
+
+TEST_F(EepromStm32, FailedCompactionKeepsTheOldBank) {
+    for (uint16_t i = 0; i < FEE_LOG_RECORDS; i++) {
+        eeprom_update_byte((uint8_t*)(i % 16), (uint8_t)i);
+    }
+    // the snapshot of bytes 0-15 and 100 takes 9 halfwords, the header then fails
+    flash_mock_stats_t before = FlashStats;
+    FLASH_Mock_FailPrograms(9);
+    EXPECT_NE(EEPROM_WriteDataByte(100, 0x01), FLASH_COMPLETE);
+    EXPECT_EQ(FlashStats.erases, before.erases);
+
+    reboot();
+    for (uint16_t i = FEE_LOG_RECORDS - 16; i < FEE_LOG_RECORDS; i++) {
+        EXPECT_EQ(eeprom_read_byte((uint8_t*)(i % 16)), (uint8_t)i);
+    }
+}
+
+TEST_F(EepromStm32, BenchmarkAgainstPageRewrite) {
+    struct {
+        const char* name;
+        void (*workload)(void (*)(uint16_t, uint8_t));
+    } workloads[] = {
+        {"keymap upload", keymap_upload_workload<void (*)(uint16_t, uint8_t)>},
+        {"rgb config", rgb_config_workload<void (*)(uint16_t, uint8_t)>},
+    };
+
+    for (auto& w : workloads) {
+        FLASH_Mock_Reset();
+        FLASH_Unlock();
+        w.workload(legacy_write_byte);
+        flash_mock_stats_t legacy = FlashStats;
+
+        FLASH_Mock_Reset();
+        EEPROM_Init();
+        memset(&FlashStats, 0, sizeof(FlashStats));
+        w.workload([](uint16_t address, uint8_t value) { EEPROM_WriteDataByte(address, value); });
+        flash_mock_stats_t logged = FlashStats;
+
+        std::cout << "[   INFO   ] " << w.name << ": page rewrite " << legacy.erases << " erases, " << flash_time_us(legacy) / 1000 << " ms; write log " << logged.erases << " erases, " << flash_time_us(logged) / 1000 << " ms" << std::endl;
+        EXPECT_LT(logged.erases, legacy.erases);
+        EXPECT_LT(flash_time_us(logged), flash_time_us(legacy));
+        EXPECT_EQ(logged.errors, 0u);
+    }
+}
@@ -0,0 +1,72 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include "flash_stm32_mock.h"
+
+uint8_t            FlashBuf[FEE_PAGE_SIZE * FEE_DENSITY_PAGES];
+flash_mock_stats_t FlashStats;
+
+static bool     flash_locked = true;
+static uint32_t flash_fail_programs;
+
+void FLASH_Mock_Reset(void) {
+    memset(FlashBuf, 0xFF, sizeof(FlashBuf));
+    memset(&FlashStats, 0, sizeof(FlashStats));
+    flash_locked        = true;
+    flash_fail_programs = 0;
+}
+
+void FLASH_Mock_FailPrograms(uint32_t after) { flash_fail_programs = FlashStats.programs + after + 1; }
+
+FLASH_Status FLASH_WaitForLastOperation(uint32_t Timeout) { return FLASH_COMPLETE; }
+
+FLASH_Status FLASH_ErasePage(uint32_t Page_Address) {
+    if (flash_locked || Page_Address < FEE_PAGE_BASE_ADDRESS || Page_Address >= FEE_LAST_PAGE_ADDRESS || (Page_Address - FEE_PAGE_BASE_ADDRESS) % FEE_PAGE_SIZE) {
+        FlashStats.errors++;
+        return FLASH_BAD_ADDRESS;
+    }
+    memset(&FlashBuf[Page_Address - FEE_PAGE_BASE_ADDRESS], 0xFF, FEE_PAGE_SIZE);
+    FlashStats.erases++;
+    return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data) {
+    if (flash_locked || Address < FEE_PAGE_BASE_ADDRESS || Address + 1 >= FEE_LAST_PAGE_ADDRESS || (Address & 1)) {
+        FlashStats.errors++;
+        return FLASH_BAD_ADDRESS;
+    }
+    if (flash_fail_programs && FlashStats.programs + 1 >= flash_fail_programs) {
+        FlashStats.errors++;
+        return FLASH_ERROR_PG;
+    }
+    uint16_t *halfword = (uint16_t *)&FlashBuf[Address - FEE_PAGE_BASE_ADDRESS];
+    // like the real thing, only an erased halfword can be programmed, or zeroed
+    if (*halfword != FEE_EMPTY_WORD && Data != 0) {
+        FlashStats.errors++;
+        return FLASH_ERROR_PG;
+    }
+    *halfword = Data;
+    FlashStats.programs++;
+    return FLASH_COMPLETE;
+}
+
+void FLASH_Unlock(void) { flash_locked = false; }
+
+void FLASH_Lock(void) { flash_locked = true; }
+
+void FLASH_ClearFlag(uint32_t FLASH_FLAG) {}
@@ -0,0 +1,42 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "eeprom_stm32.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Simulated flash backing the emulated EEPROM, in its erased state after FLASH_Mock_Reset()
+extern uint8_t FlashBuf[FEE_PAGE_SIZE * FEE_DENSITY_PAGES];
+
+typedef struct {
+    uint32_t erases;
+    uint32_t programs;
+    uint32_t errors;
+} flash_mock_stats_t;
+
+extern flash_mock_stats_t FlashStats;
+
+void FLASH_Mock_Reset(void);
+// Every halfword program after the next `after` ones fails
+void FLASH_Mock_FailPrograms(uint32_t after);
+
+#ifdef __cplusplus
+}
+#endif
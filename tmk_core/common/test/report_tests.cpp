@@ -0,0 +1,213 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include "report.h"
+#include "keycode_config.h"
+
+uint8_t         keyboard_protocol = 1;
+keymap_config_t keymap_config;
+}
+
+class Report : public testing::Test {
+   public:
+    Report() {
+        report            = {};
+        keyboard_protocol = 1;
+        keymap_config.raw = 0;
+    }
+
+    std::vector<uint8_t> keys(void) { return std::vector<uint8_t>(report.keys, report.keys + KEYBOARD_REPORT_KEYS); }
+
+    void add(std::vector<uint8_t> codes) {
+        for (uint8_t code : codes) {
+            add_key_to_report(&report, code);
+        }
+    }
+
+    // Runs op count times and prints the average time per call
+    template <typename F>
+    void benchmark(const char *name, F op) {
+        const int count = 1000000;
+        auto      start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++) {
+            op(i);
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        printf("[   INFO   ] %s: %.1f ns per call\n", name, (double)ns / count);
+    }
+
+    report_keyboard_t report;
+};
+
+TEST_F(Report, KeysArePackedInPressOrder) {
+    add({KC_C, KC_A, KC_B});
+    EXPECT_EQ(keys(), std::vector<uint8_t>({KC_C, KC_A, KC_B, 0, 0, 0}));
+    EXPECT_EQ(has_anykey(&report), 3);
+    EXPECT_EQ(get_first_key(&report), KC_C);
+}
+
+TEST_F(Report, AddingAKeyTwiceKeepsOne) {
+    add({KC_A, KC_B, KC_A});
+    EXPECT_EQ(keys(), std::vector<uint8_t>({KC_A, KC_B, 0, 0, 0, 0}));
+}
+
+TEST_F(Report, DeletingAKeyMovesTheLaterKeysUp) {
+    add({KC_A, KC_B, KC_C, KC_D});
+    del_key_from_report(&report, KC_B);
+    EXPECT_EQ(keys(), std::vector<uint8_t>({KC_A, KC_C, KC_D, 0, 0, 0}));
+    del_key_from_report(&report, KC_D);
+    del_key_from_report(&report, KC_Z);
+    EXPECT_EQ(keys(), std::vector<uint8_t>({KC_A, KC_C, 0, 0, 0, 0}));
+    add({KC_E});
+    EXPECT_EQ(keys(), std::vector<uint8_t>({KC_A, KC_C, KC_E, 0, 0, 0}));
+    EXPECT_EQ(has_anykey(&report), 3);
+}
+
+TEST_F(Report, FullReport) {
+    add({KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G});
+#ifdef USB_6KRO_ENABLE
+    // The oldest key rolls over
+    EXPECT_EQ(keys(), std::vector<uint8_t>({KC_B, KC_C, KC_D, KC_E, KC_F, KC_G}));
+#else
+    EXPECT_EQ(keys(), std::vector<uint8_t>({KC_A, KC_B, KC_C, KC_D, KC_E, KC_F}));
+#endif
+    EXPECT_EQ(has_anykey(&report), 6);
+    del_key_from_report(&report, KC_F);
+    add({KC_H});
+    EXPECT_TRUE(is_key_pressed(&report, KC_H));
+    EXPECT_EQ(has_anykey(&report), 6);
+}
+
+TEST_F(Report, IsKeyPressed) {
+    add({KC_A, KC_B});
+    EXPECT_TRUE(is_key_pressed(&report, KC_A));
+    EXPECT_TRUE(is_key_pressed(&report, KC_B));
+    EXPECT_FALSE(is_key_pressed(&report, KC_C));
+    EXPECT_FALSE(is_key_pressed(&report, KC_NO));
+}
+
+TEST_F(Report, EmptyReport) {
+    EXPECT_EQ(has_anykey(&report), 0);
+    EXPECT_EQ(get_first_key(&report), KC_NO);
+    add({KC_A, KC_B});
+    clear_keys_from_report(&report);
+    EXPECT_EQ(has_anykey(&report), 0);
+    EXPECT_EQ(get_first_key(&report), KC_NO);
+}
+
+// Random presses and releases against a model of the keys in press order
+TEST_F(Report, MatchesAModel) {
+    std::vector<uint8_t> model;
+    srand(1);
+    for (int i = 0; i < 10000; i++) {
+        uint8_t code = KC_A + rand() % 10;
+        auto    it   = std::find(model.begin(), model.end(), code);
+        if (rand() % 2) {
+            add_key_to_report(&report, code);
+            if (it == model.end()) {
+#ifdef USB_6KRO_ENABLE
+                if (model.size() == KEYBOARD_REPORT_KEYS) {
+                    model.erase(model.begin());
+                }
+#endif
+                if (model.size() < KEYBOARD_REPORT_KEYS) {
+                    model.push_back(code);
+                }
+            }
+        } else {
+            del_key_from_report(&report, code);
+            if (it != model.end()) {
+                model.erase(it);
+            }
+        }
+        std::vector<uint8_t> expected = model;
+        expected.resize(KEYBOARD_REPORT_KEYS);
+        ASSERT_EQ(keys(), expected);
+        ASSERT_EQ(has_anykey(&report), model.size());
+        ASSERT_EQ(get_first_key(&report), model.empty() ? KC_NO : model[0]);
+    }
+}
+
+TEST_F(Report, Benchmark) {
+    benchmark("6KRO add and delete", [this](int i) {
+        add_key_to_report(&report, KC_A + i % 8);
+        del_key_from_report(&report, KC_A + (i + 4) % 8);
+    });
+    benchmark("6KRO is_key_pressed", [this](int i) { is_key_pressed(&report, KC_A + i % 8); });
+    benchmark("6KRO has_anykey", [this](int i) { has_anykey(&report); });
+#ifdef NKRO_ENABLE
+    keymap_config.nkro = true;
+    report             = {};
+    add({KC_SPACE, KC_RIGHT});
+    benchmark("NKRO add and delete", [this](int i) {
+        add_key_to_report(&report, KC_A + i % 8);
+        del_key_from_report(&report, KC_A + (i + 4) % 8);
+    });
+    benchmark("NKRO has_anykey", [this](int i) { has_anykey(&report); });
+    del_key_from_report(&report, KC_SPACE);
+    benchmark("NKRO get_first_key, last word", [this](int i) { get_first_key(&report); });
+#endif
+}
+
+#ifdef NKRO_ENABLE
+class NkroReport : public Report {
+   public:
+    NkroReport() { keymap_config.nkro = true; }
+};
+
+TEST_F(NkroReport, CountsKeysInEveryWord) {
+    const uint8_t last = KEYBOARD_REPORT_BITS * 8 - 1;
+    add({KC_A, KC_B, KC_1, KC_F12, KC_RIGHT, KC_LANG1, last});
+    EXPECT_EQ(has_anykey(&report), 7);
+    EXPECT_TRUE(is_key_pressed(&report, last));
+    del_key_from_report(&report, KC_1);
+    EXPECT_EQ(has_anykey(&report), 6);
+}
+
+TEST_F(NkroReport, FirstKeyIsTheLowestKeycode) {
+    const uint8_t last = KEYBOARD_REPORT_BITS * 8 - 1;
+    add({last, KC_RIGHT, KC_F12});
+    EXPECT_EQ(get_first_key(&report), KC_F12);
+    del_key_from_report(&report, KC_F12);
+    EXPECT_EQ(get_first_key(&report), KC_RIGHT);
+    del_key_from_report(&report, KC_RIGHT);
+    EXPECT_EQ(get_first_key(&report), last);
+    del_key_from_report(&report, last);
+    EXPECT_EQ(get_first_key(&report), KC_NO);
+    EXPECT_EQ(has_anykey(&report), 0);
+}
+
+TEST_F(NkroReport, KeycodesPastTheBitmapAreIgnored) {
+    add_key_to_report(&report, KEYBOARD_REPORT_BITS * 8);
+    EXPECT_EQ(has_anykey(&report), 0);
+    EXPECT_FALSE(is_key_pressed(&report, KEYBOARD_REPORT_BITS * 8));
+}
+
+TEST_F(NkroReport, BootProtocolUsesTheByteReport) {
+    keyboard_protocol = 0;
+    add({KC_B, KC_A});
+    EXPECT_EQ(keys(), std::vector<uint8_t>({KC_B, KC_A, 0, 0, 0, 0}));
+    EXPECT_EQ(get_first_key(&report), KC_B);
+}
+#endif
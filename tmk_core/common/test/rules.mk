@@ -0,0 +1,34 @@
+eeprom_stm32_DEFS := -DFLASH_STM32_MOCKED -DEEPROM_EMU_STM32F303xC
+eeprom_stm32_INC := $(TMK_PATH)/common/chibios
+eeprom_stm32_SRC := \
+	$(TMK_PATH)/common/test/eeprom_stm32_tests.cpp \
+	$(TMK_PATH)/common/test/flash_stm32_mock.c \
+	$(TMK_PATH)/common/chibios/eeprom_stm32.c
+
+# The log doesn't end on a record boundary
+eeprom_stm32_odd_density_DEFS := $(eeprom_stm32_DEFS) -DFEE_DENSITY_BYTES=1026
+eeprom_stm32_odd_density_INC := $(eeprom_stm32_INC)
+eeprom_stm32_odd_density_SRC := $(eeprom_stm32_SRC)
+
+deadline_SRC := \
+	$(TMK_PATH)/common/test/deadline_tests.cpp \
+	$(TMK_PATH)/common/test/timer.c \
+	$(TMK_PATH)/common/deadline.c
+
+console_buffer_DEFS := -DCONSOLE_BUFFER_SIZE=32 -DTRACE_ENABLE
+console_buffer_SRC := \
+	$(TMK_PATH)/common/test/console_buffer_tests.cpp \
+	$(TMK_PATH)/common/test/timer.c \
+	$(TMK_PATH)/common/console_buffer.c \
+	$(TMK_PATH)/common/trace.c
+
+# NKRO is built as for ARM ATSAM, whose endpoint sizes don't need the USB stack
+report_DEFS := -DNKRO_ENABLE -DPROTOCOL_ARM_ATSAM -DNO_DEBUG -DNO_PRINT
+report_SRC := \
+	$(TMK_PATH)/common/test/report_tests.cpp \
+	$(TMK_PATH)/common/report.c
+
+report_6kro_DEFS := -DUSB_6KRO_ENABLE -DNO_DEBUG -DNO_PRINT
+report_6kro_SRC := \
+	$(TMK_PATH)/common/test/report_tests.cpp \
+	$(TMK_PATH)/common/report.c
@@ -0,0 +1,7 @@
+TEST_LIST +=\
+	eeprom_stm32 \
+	eeprom_stm32_odd_density \
+	deadline \
+	console_buffer \
+	report \
+	report_6kro
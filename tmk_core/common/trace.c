@@ -0,0 +1,43 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "trace.h"
+#include "console_buffer.h"
+#include "timer.h"
+
+void trace_event(uint8_t type, uint16_t data) {
+    uint32_t time       = timer_read32();
+    uint8_t  payload[7] = {type, data & 0xFF, data >> 8, time & 0xFF, (time >> 8) & 0xFF, (time >> 16) & 0xFF, time >> 24};
+    uint8_t  record[TRACE_RECORD_SIZE];
+
+    // 56 payload bits fill exactly eight groups
+    uint16_t bits  = 0;
+    uint8_t  count = 0;
+    uint8_t  out   = 0;
+    record[out++]  = TRACE_SYNC;
+    for (uint8_t i = 0; i < sizeof(payload); i++) {
+        bits |= (uint16_t)payload[i] << count;
+        count += 8;
+        while (count >= 7) {
+            record[out++] = 0x80 | (bits & 0x7F);
+            bits >>= 7;
+            count -= 7;
+        }
+    }
+
+    console_buffer_write(record, sizeof(record));
+}
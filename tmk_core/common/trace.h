@@ -0,0 +1,50 @@
+/* Copyright 2020
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+/* Binary event trace
+ *
+ * With TRACE_ENABLE, key events, layer changes and keyboard reports are
+ * written to the buffered console as fixed size records, cheap enough to
+ * leave on in daily use. `qmk trace` decodes a capture of the console output,
+ * text printed in between is kept.
+ *
+ * A record is TRACE_RECORD_SIZE bytes: TRACE_SYNC, then the type, data and
+ * millisecond timestamp (7 bytes, little endian) split into 7 bit groups, low
+ * bits first, each with the high bit set. A record never contains a zero
+ * byte, which would end a console report for hid_listen.
+ */
+
+#define TRACE_SYNC 0x1E
+#define TRACE_RECORD_SIZE 9
+
+typedef enum {
+    TRACE_KEY_PRESS = 1,  // data: row << 8 | col
+    TRACE_KEY_RELEASE,    // data: row << 8 | col
+    TRACE_LAYER,          // data: highest default layer << 8 | highest layer
+    TRACE_REPORT,         // data: first key << 8 | mods of the keyboard report sent
+    TRACE_USER = 0x80,    // and up, free for keyboards and keymaps
+} trace_type_t;
+
+#ifdef TRACE_ENABLE
+void trace_event(uint8_t type, uint16_t data);
+#else
+#    define trace_event(type, data)
+#endif
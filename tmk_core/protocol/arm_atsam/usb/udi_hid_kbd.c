@@ -56,6 +56,7 @@
 #include <string.h>
 #include "report.h"
 #include "usb_descriptor_common.h"
+#include "raw_hid.h"
 
 //***************************************************************************
 // KBD
@@ -675,7 +676,10 @@ bool udi_hid_raw_enable(void) {
     return UDI_HID_RAW_ENABLE_EXT();
 }
 
-void udi_hid_raw_disable(void) { UDI_HID_RAW_DISABLE_EXT(); }
+void udi_hid_raw_disable(void) {
+    raw_hid_reset();
+    UDI_HID_RAW_DISABLE_EXT();
+}
 
 bool udi_hid_raw_setup(void) { return udi_hid_setup(&udi_hid_raw_rate, &udi_hid_raw_protocol, (uint8_t *)&udi_hid_raw_report_desc, udi_hid_raw_setreport); }
 
@@ -720,13 +724,18 @@ static void udi_hid_raw_report_sent(udd_ep_status_t status, iram_size_t nb_sent,
 
 static void udi_hid_raw_setreport_valid(void) {}
 
-void raw_hid_send(uint8_t *data, uint8_t length) {
+bool raw_hid_send_nonblocking(uint8_t *data, uint8_t length) {
     if (main_b_raw_enable && !udi_hid_raw_b_report_trans_ongoing && length == UDI_HID_RAW_REPORT_SIZE) {
         memcpy(udi_hid_raw_report, data, UDI_HID_RAW_REPORT_SIZE);
-        udi_hid_raw_send_report();
+        return udi_hid_raw_send_report();
     }
+    return false;
 }
 
+void raw_hid_send(uint8_t *data, uint8_t length) { raw_hid_send_nonblocking(data, length); }
+
+__attribute__((weak)) void raw_hid_reset(void) {}
+
 bool udi_hid_raw_receive_report(void) {
     if (!main_b_raw_enable) {
         return false;
@@ -68,9 +68,16 @@ void    send_keyboard(report_keyboard_t *report);
 void    send_mouse(report_mouse_t *report);
 void    send_system(uint16_t data);
 void    send_consumer(uint16_t data);
+#ifdef KEYBOARD_REPORT_QUEUE
+bool keyboard_ready(void);
+#endif
 
 /* host struct */
+#ifdef KEYBOARD_REPORT_QUEUE
+host_driver_t chibios_driver = {keyboard_leds, send_keyboard, send_mouse, send_system, send_consumer, keyboard_ready};
+#else
 host_driver_t chibios_driver = {keyboard_leds, send_keyboard, send_mouse, send_system, send_consumer};
+#endif
 
 #ifdef VIRTSER_ENABLE
 void virtser_task(void);
@@ -40,6 +40,9 @@
 #include "wait.h"
 #include "usb_descriptor.h"
 #include "usb_driver.h"
+#ifdef CONSOLE_ENABLE
+#    include "console_buffer.h"
+#endif
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
@@ -51,6 +54,10 @@ extern keymap_config_t keymap_config;
 #    include "joystick.h"
 #endif
 
+#ifdef RAW_ENABLE
+#    include "raw_hid.h"
+#endif
+
 /* ---------------------------------------------------------
  *       Global interface variables and declarations
  * ---------------------------------------------------------
@@ -350,6 +357,9 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
                 qmkusbSuspendHookI(&drivers.array[i].driver);
                 chSysUnlockFromISR();
             }
+#ifdef RAW_ENABLE
+            raw_hid_reset();
+#endif
             return;
 
         case USB_EVENT_WAKEUP:
@@ -627,6 +637,24 @@ static void keyboard_idle_timer_cb(void *arg) {
 /* LED status */
 uint8_t keyboard_leds(void) { return keyboard_led_state; }
 
+#ifdef KEYBOARD_REPORT_QUEUE
+/* whether send_keyboard() can start a transfer without waiting for the previous one
+ * not callable from ISR or locked state */
+bool keyboard_ready(void) {
+    usbep_t ep = KEYBOARD_IN_EPNUM;
+#    ifdef NKRO_ENABLE
+    if (keymap_config.nkro && keyboard_protocol) {
+        ep = SHARED_IN_EPNUM;
+    }
+#    endif
+    osalSysLock();
+    /* reports that can't be sent are let through, send_keyboard() drops them */
+    bool ready = usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE || !usbGetTransmitStatusI(&USB_DRIVER, ep);
+    osalSysUnlock();
+    return ready;
+}
+#endif
+
 /* prepare and start sending a report IN
  * not callable from ISR or locked state */
 void send_keyboard(report_keyboard_t *report) {
@@ -780,11 +808,16 @@ void send_consumer(uint16_t data) {
 
 #ifdef CONSOLE_ENABLE
 
+#    ifdef CONSOLE_BUFFER_SIZE
+// Drops the character if the buffer is full, console_task() sends the buffer
+int8_t sendchar(uint8_t c) { return console_buffer_write(&c, 1) ? 0 : -1; }
+#    else
 int8_t sendchar(uint8_t c) {
     // The previous implmentation had timeouts, but I think it's better to just slow down
     // and make sure that everything is transferred, rather than dropping stuff
     return chnWrite(&drivers.console_driver.driver, &c, 1);
 }
+#    endif
 
 // Just a dummy function for now, this could be exposed as a weak function
 // Or connected to the actual QMK console
@@ -796,6 +829,15 @@ static void console_receive(uint8_t *data, uint8_t length) {
 void console_task(void) {
     uint8_t buffer[CONSOLE_EPSIZE];
     size_t  size = 0;
+#    ifdef CONSOLE_BUFFER_SIZE
+    // Hand over as much as the output queue takes without waiting
+    uint8_t length;
+    while ((length = console_buffer_peek(buffer, sizeof(buffer))) > 0) {
+        size_t written = chnWriteTimeout(&drivers.console_driver.driver, buffer, length, TIME_IMMEDIATE);
+        console_buffer_skip(written);
+        if (written < length) break;
+    }
+#    endif
     do {
         size_t size = chnReadTimeout(&drivers.console_driver.driver, buffer, sizeof(buffer), TIME_IMMEDIATE);
         if (size > 0) {
@@ -822,6 +864,19 @@ void raw_hid_send(uint8_t *data, uint8_t length) {
     chnWrite(&drivers.raw_driver.driver, data, length);
 }
 
+bool raw_hid_send_nonblocking(uint8_t *data, uint8_t length) {
+    if (length != RAW_EPSIZE) {
+        return false;
+    }
+    // A packet fills one buffer, so it is written whole or not at all
+    osalSysLock();
+    bool full = obqIsFullI(&drivers.raw_driver.driver.obqueue);
+    osalSysUnlock();
+    return !full && chnWriteTimeout(&drivers.raw_driver.driver, data, length, TIME_IMMEDIATE) == length;
+}
+
+__attribute__((weak)) void raw_hid_reset(void) {}
+
 __attribute__((weak)) void raw_hid_receive(uint8_t *data, uint8_t length) {
     // Users should #include "raw_hid.h" in their own code
     // and implement this function there. Leave this as weak linkage
@@ -44,6 +44,9 @@
 #include "led.h"
 #include "sendchar.h"
 #include "debug.h"
+#ifdef CONSOLE_ENABLE
+#    include "console_buffer.h"
+#endif
 #ifdef SLEEP_LED_ENABLE
 #    include "sleep_led.h"
 #endif
@@ -142,8 +145,14 @@ static void    send_keyboard(report_keyboard_t *report);
 static void    send_mouse(report_mouse_t *report);
 static void    send_system(uint16_t data);
 static void    send_consumer(uint16_t data);
+#ifdef KEYBOARD_REPORT_QUEUE
+static bool keyboard_ready(void);
+#endif
 host_driver_t  lufa_driver = {
     keyboard_leds, send_keyboard, send_mouse, send_system, send_consumer,
+#ifdef KEYBOARD_REPORT_QUEUE
+    keyboard_ready,
+#endif
 };
 
 #ifdef VIRTSER_ENABLE
@@ -175,18 +184,18 @@ USB_ClassInfo_CDC_Device_t cdc_device = {
 
 #ifdef RAW_ENABLE
 
-/** \brief Raw HID Send
+/** \brief Raw HID Send Nonblocking
  *
- * FIXME: Needs doc
+ * Returns false, sending nothing, when the endpoint is busy
  */
-void raw_hid_send(uint8_t *data, uint8_t length) {
+bool raw_hid_send_nonblocking(uint8_t *data, uint8_t length) {
     // TODO: implement variable size packet
     if (length != RAW_EPSIZE) {
-        return;
+        return false;
     }
 
     if (USB_DeviceState != DEVICE_STATE_Configured) {
-        return;
+        return false;
     }
 
     // TODO: decide if we allow calls to raw_hid_send() in the middle
@@ -196,7 +205,8 @@ void raw_hid_send(uint8_t *data, uint8_t length) {
     Endpoint_SelectEndpoint(RAW_IN_EPNUM);
 
     // Check to see if the host is ready to accept another packet
-    if (Endpoint_IsINReady()) {
+    bool ready = Endpoint_IsINReady();
+    if (ready) {
         // Write data
         Endpoint_Write_Stream_LE(data, RAW_EPSIZE, NULL);
         // Finalize the stream transfer to send the last packet
@@ -204,8 +214,17 @@ void raw_hid_send(uint8_t *data, uint8_t length) {
     }
 
     Endpoint_SelectEndpoint(ep);
+    return ready;
 }
 
+/** \brief Raw HID Send
+ *
+ * Drops the packet when the endpoint is busy
+ */
+void raw_hid_send(uint8_t *data, uint8_t length) { raw_hid_send_nonblocking(data, length); }
+
+__attribute__((weak)) void raw_hid_reset(void) {}
+
 /** \brief Raw HID Receive
  *
  * FIXME: Needs doc
@@ -252,7 +271,30 @@ static void raw_hid_task(void) {
 /*******************************************************************************
  * Console
  ******************************************************************************/
-#ifdef CONSOLE_ENABLE
+#if defined(CONSOLE_ENABLE) && defined(CONSOLE_BUFFER_SIZE)
+/** \brief Console Buffer Task
+ *
+ * Sends what sendchar() buffered, one report per free endpoint bank. Runs from the main loop and
+ * returns as soon as the bank is taken, the rest goes out on a later pass.
+ */
+static void Console_Buffer_Task(void) {
+    if (USB_DeviceState != DEVICE_STATE_Configured || !console_buffer_count()) return;
+
+    uint8_t ep = Endpoint_GetCurrentEndpoint();
+    Endpoint_SelectEndpoint(CONSOLE_IN_EPNUM);
+    if (Endpoint_IsEnabled() && Endpoint_IsConfigured()) {
+        while (console_buffer_count() && Endpoint_IsReadWriteAllowed()) {
+            // The host reads fixed size reports, so a short one is padded with zeros
+            uint8_t packet[CONSOLE_EPSIZE] = {0};
+            uint8_t size                   = console_buffer_peek(packet, sizeof(packet));
+            Endpoint_Write_Stream_LE(packet, sizeof(packet), NULL);
+            Endpoint_ClearIN();
+            console_buffer_skip(size);
+        }
+    }
+    Endpoint_SelectEndpoint(ep);
+}
+#elif defined(CONSOLE_ENABLE)
 /** \brief Console Task
  *
  * FIXME: Needs doc
@@ -416,7 +458,12 @@ void EVENT_USB_Device_Disconnect(void) {
  *
  * FIXME: Needs doc
  */
-void EVENT_USB_Device_Reset(void) { print("[R]"); }
+void EVENT_USB_Device_Reset(void) {
+    print("[R]");
+#ifdef RAW_ENABLE
+    raw_hid_reset();
+#endif
+}
 
 /** \brief Event USB Device Connect
  *
@@ -424,6 +471,9 @@ void EVENT_USB_Device_Reset(void) { print("[R]"); }
  */
 void EVENT_USB_Device_Suspend() {
     print("[S]");
+#ifdef RAW_ENABLE
+    raw_hid_reset();
+#endif
 #ifdef SLEEP_LED_ENABLE
     sleep_led_enable();
 #endif
@@ -444,7 +494,7 @@ void EVENT_USB_Device_WakeUp() {
 #endif
 }
 
-#ifdef CONSOLE_ENABLE
+#if defined(CONSOLE_ENABLE) && !defined(CONSOLE_BUFFER_SIZE)
 static bool console_flush = false;
 #    define CONSOLE_FLUSH_SET(b)                                     \
         do {                                                         \
@@ -666,7 +716,9 @@ static uint8_t keyboard_leds(void) { return keyboard_led_state; }
  * FIXME: Needs doc
  */
 static void send_keyboard(report_keyboard_t *report) {
+#ifndef KEYBOARD_REPORT_QUEUE
     uint8_t timeout = 255;
+#endif
 
 #ifdef BLUETOOTH_ENABLE
     uint8_t where = where_to_send();
@@ -701,8 +753,10 @@ static void send_keyboard(report_keyboard_t *report) {
     }
 #endif
     Endpoint_SelectEndpoint(ep);
+#ifndef KEYBOARD_REPORT_QUEUE
     /* Check if write ready for a polling interval around 10ms */
     while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
+#endif
     if (!Endpoint_IsReadWriteAllowed()) return;
 
     /* If we're in Boot Protocol, don't send any report ID or other funky fields */
@@ -718,6 +772,31 @@ static void send_keyboard(report_keyboard_t *report) {
     keyboard_report_sent = *report;
 }
 
+#ifdef KEYBOARD_REPORT_QUEUE
+/** \brief Keyboard Ready
+ *
+ * Whether send_keyboard() can write to the keyboard endpoint right away. The report queue holds on to
+ * reports until then, instead of send_keyboard() waiting for the host to poll.
+ * Reports that can't go out over USB at all are let through, for send_keyboard() to handle as before.
+ */
+static bool keyboard_ready(void) {
+    if (USB_DeviceState != DEVICE_STATE_Configured) return true;
+#    ifdef BLUETOOTH_ENABLE
+    uint8_t where = where_to_send();
+    if (where != OUTPUT_USB && where != OUTPUT_USB_AND_BT) return true;
+#    endif
+
+    uint8_t ep = KEYBOARD_IN_EPNUM;
+#    ifdef NKRO_ENABLE
+    if (keyboard_protocol && keymap_config.nkro) {
+        ep = SHARED_IN_EPNUM;
+    }
+#    endif
+    Endpoint_SelectEndpoint(ep);
+    return Endpoint_IsReadWriteAllowed();
+}
+#endif
+
 /** \brief Send Mouse
  *
  * FIXME: Needs doc
@@ -835,7 +914,13 @@ static void send_consumer(uint16_t data) {
 /*******************************************************************************
  * sendchar
  ******************************************************************************/
-#ifdef CONSOLE_ENABLE
+#if defined(CONSOLE_ENABLE) && defined(CONSOLE_BUFFER_SIZE)
+/** \brief Send Char
+ *
+ * Buffers the character for Console_Buffer_Task(), or drops it if the buffer is full
+ */
+int8_t sendchar(uint8_t c) { return console_buffer_write(&c, 1) ? 0 : -1; }
+#elif defined(CONSOLE_ENABLE)
 #    define SEND_TIMEOUT 5
 /** \brief Send Char
  *
@@ -1084,6 +1169,10 @@ int main(void) {
 
         keyboard_task();
 
+#if defined(CONSOLE_ENABLE) && defined(CONSOLE_BUFFER_SIZE)
+        Console_Buffer_Task();
+#endif
+
 #ifdef MIDI_ENABLE
         MIDI_Device_USBTask(&USB_MIDI_Interface);
 #endif
@@ -36,6 +36,7 @@ void console_task(void);
 #endif
 
 #ifdef RAW_ENABLE
+#    include "raw_hid.h"
 void raw_hid_task(void);
 #endif
 
@@ -123,6 +124,9 @@ int main(void) {
             // Suspend when no SOF in 3ms-10ms(7.1.7.4 Suspending of USB1.1)
             if (timer_elapsed(last_timer) > 5) {
                 suspended = true;
+#    ifdef RAW_ENABLE
+                raw_hid_reset();
+#    endif
 #    ifdef SLEEP_LED_ENABLE
                 sleep_led_enable();
 #    endif
@@ -132,6 +132,17 @@ void raw_hid_send(uint8_t *data, uint8_t length) {
     usbSetInterrupt4(0, 0);
 }
 
+bool raw_hid_send_nonblocking(uint8_t *data, uint8_t length) {
+    // Only the first chunk is checked, the rest follow within a few polls
+    if (length != RAW_BUFFER_SIZE || !usbInterruptIsReady4()) {
+        return false;
+    }
+    raw_hid_send(data, length);
+    return true;
+}
+
+__attribute__((weak)) void raw_hid_reset(void) {}
+
 __attribute__((weak)) void raw_hid_receive(uint8_t *data, uint8_t length) {
     // Users should #include "raw_hid.h" in their own code
     // and implement this function there. Leave this as weak linkage